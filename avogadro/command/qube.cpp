@@ -141,17 +141,20 @@ int main(int argc, char* argv[])
     cout << "1  " << orbitalNumber << endl;
 
   GaussianSetTools* m_tools = new GaussianSetTools(&mol);
+  if (density)
+    m_tools->calculateElectronDensity(*m_qube);
+  else
+    m_tools->calculateMolecularOrbital(*m_qube, orbitalNumber);
+  const std::vector<double>& values = *m_qube->data();
 
   // print the qube values
   int linecount = 0;
-  for (unsigned int i = 0; i < m_qube->data()->size(); i++) {
+  for (unsigned int i = 0; i < values.size(); i++) {
     if (i % points.z() == 0 && i > 0) {
       linecount = 0;
       printf("\n");
     }
-    double value =
-      m_tools->calculateMolecularOrbital(m_qube->position(i), orbitalNumber);
-    printf("%13.5E", value);
+    printf("%13.5E", values[i]);
     // line wrapping
     linecount++;
     if (linecount % 6 == 0 && i > 0)
@@ -32,7 +32,7 @@ Angle AngleIterator::operator++()
   Index a, b, c;
   std::tie(a, b, c) = m_current;
 
-  Graph graph = m_mol->graph();
+  const Graph& graph = m_mol->graph();
   Index count = m_mol->atomCount();
 
   // true if we have a valid current state
@@ -71,7 +71,7 @@ Angle AngleIterator::operator++()
     while(!valid && b + 1 < count) {
       ++b; // try going to the next atom
 
-      const auto neighbors = graph.neighbors(b);
+      const auto& neighbors = graph.neighbors(b);
       if (neighbors.size() < 2)
         continue;
       
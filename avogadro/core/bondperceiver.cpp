@@ -0,0 +1,215 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "bondperceiver.h"
+
+#include "elements.h"
+#include "neighborperceiver.h"
+#include "parallel_p.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace Avogadro {
+namespace Core {
+
+namespace {
+
+// Cells of the neighbor perceiver searched for bonds by a thread at a time.
+const Index BOND_CELLS = 256;
+// Candidate pairs checked by a thread at a time.
+const size_t BOND_CANDIDATES = 65536;
+
+} // namespace
+
+BondPerceiver::BondPerceiver(double tolerance, double minDistance)
+  : m_tolerance(tolerance), m_minDistance(minDistance), m_fallbackRadius(2.0),
+    m_periodic(false), m_skin(0.5)
+{}
+
+void BondPerceiver::setUnitCell(const UnitCell* unitCell)
+{
+  m_periodic = unitCell != nullptr;
+  if (unitCell)
+    m_unitCell = *unitCell;
+}
+
+void BondPerceiver::setAtomMask(const std::vector<bool>& mask)
+{
+  m_mask = mask;
+}
+
+void BondPerceiver::setFallbackRadius(double radius)
+{
+  m_fallbackRadius = std::max(0.0, radius);
+}
+
+void BondPerceiver::setProgressFunction(const ProgressFunction& progress)
+{
+  m_progress = progress;
+}
+
+void BondPerceiver::setSkin(double skin)
+{
+  m_skin = std::max(0.0, skin);
+  m_candidates.clear();
+  m_candidatePositions.clear();
+}
+
+bool BondPerceiver::perceive(const Array<Vector3>& positions,
+                             const Array<unsigned char>& atomicNumbers,
+                             Array<std::pair<Index, Index>>& bonds) const
+{
+  bonds.clear();
+  std::vector<Candidate> candidates;
+  if (!findCandidates(positions, atomicNumbers, 0.0, candidates))
+    return false;
+  checkCandidates(positions, candidates, bonds);
+  return true;
+}
+
+bool BondPerceiver::perceiveFrame(const Array<Vector3>& positions,
+                                  const Array<unsigned char>& atomicNumbers,
+                                  Array<std::pair<Index, Index>>& bonds)
+{
+  bonds.clear();
+
+  // search again once an atom could have come within range of another that
+  // is not a candidate, both moving half the skin towards each other
+  bool search = positions.size() != m_candidatePositions.size() ||
+                atomicNumbers.size() != m_candidateNumbers.size() ||
+                !std::equal(atomicNumbers.begin(), atomicNumbers.end(),
+                            m_candidateNumbers.begin());
+  const double maxSquared = 0.25 * m_skin * m_skin;
+  for (Index i = 0; i < positions.size() && !search; ++i) {
+    search =
+      (positions[i] - m_candidatePositions[i]).squaredNorm() > maxSquared;
+  }
+  if (search) {
+    m_candidatePositions.clear();
+    if (!findCandidates(positions, atomicNumbers, m_skin, m_candidates))
+      return false;
+    m_candidatePositions.assign(positions.begin(), positions.end());
+    m_candidateNumbers.assign(atomicNumbers.begin(), atomicNumbers.end());
+  }
+
+  checkCandidates(positions, m_candidates, bonds);
+  return true;
+}
+
+bool BondPerceiver::findCandidates(const Array<Vector3>& positions,
+                                   const Array<unsigned char>& atomicNumbers,
+                                   double skin,
+                                   std::vector<Candidate>& candidates) const
+{
+  candidates.clear();
+  if (positions.size() != atomicNumbers.size())
+    return true;
+
+  // the atoms to bond, only the masked ones are sorted into cells
+  std::vector<Index> atoms;
+  Array<Vector3> subset;
+  for (Index i = 0; i < positions.size(); ++i) {
+    if (m_mask.empty() || (i < m_mask.size() && m_mask[i])) {
+      atoms.push_back(i);
+      subset.push_back(positions[i]);
+    }
+  }
+  if (atoms.size() < 2)
+    return true;
+
+  // cache atomic radii
+  std::vector<double> radii(atoms.size());
+  std::vector<bool> hydrogen(atoms.size());
+  double max_radius = 0.0;
+  for (size_t i = 0; i < radii.size(); i++) {
+    unsigned char number = atomicNumbers[atoms[i]];
+    radii[i] = Elements::radiusCovalent(number);
+    if (radii[i] <= 0.0)
+      radii[i] = m_fallbackRadius;
+    if (radii[i] > max_radius)
+      max_radius = radii[i];
+    hydrogen[i] = number == 1;
+  }
+
+  float maxDistance = 2.0 * max_radius + m_tolerance + skin;
+  NeighborPerceiver perceiver(subset, maxDistance,
+                              m_periodic ? &m_unitCell : nullptr);
+
+  // Each pair is checked once. The cells are split into blocks searched in
+  // parallel, each collecting its own candidates.
+  const int blocks =
+    static_cast<int>((perceiver.cellCount() + BOND_CELLS - 1) / BOND_CELLS);
+  std::vector<std::vector<Candidate>> found(blocks);
+  std::atomic<int> done(0);
+  std::atomic<bool> canceled(false);
+  parallelFor(blocks, [&](int block) {
+    if (canceled)
+      return;
+    std::vector<Candidate>& pairs = found[block];
+    auto check = [&](Index i, Index j, const Vector3& diff) {
+      if (hydrogen[i] && hydrogen[j])
+        return;
+
+      double cutoff = radii[i] + radii[j] + m_tolerance;
+      double range = cutoff + skin;
+      if (diff.squaredNorm() < range * range) {
+        // the shift takes the second atom to the image that is in range
+        Index a = atoms[i];
+        Index b = atoms[j];
+        Vector3 shift = diff - (positions[b] - positions[a]);
+        if (a < b)
+          pairs.push_back(Candidate{ a, b, shift, cutoff });
+        else
+          pairs.push_back(Candidate{ b, a, -shift, cutoff });
+      }
+    };
+    perceiver.forEachPair(check, block * BOND_CELLS, (block + 1) * BOND_CELLS);
+    if (m_progress && !m_progress(++done, blocks))
+      canceled = true;
+  });
+  if (canceled)
+    return false;
+
+  // sorted, so the order of the bonds does not depend on the cells
+  for (const auto& pairs : found)
+    candidates.insert(candidates.end(), pairs.begin(), pairs.end());
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate& x, const Candidate& y) {
+              return std::make_pair(x.first, x.second) <
+                     std::make_pair(y.first, y.second);
+            });
+  return true;
+}
+
+void BondPerceiver::checkCandidates(const Array<Vector3>& positions,
+                                    const std::vector<Candidate>& candidates,
+                                    Array<std::pair<Index, Index>>& bonds) const
+{
+  const double minSq = m_minDistance * m_minDistance;
+  const int blocks = static_cast<int>(
+    (candidates.size() + BOND_CANDIDATES - 1) / BOND_CANDIDATES);
+  std::vector<std::vector<std::pair<Index, Index>>> found(blocks);
+  parallelFor(blocks, [&](int block) {
+    const size_t end =
+      std::min(candidates.size(), (block + 1) * BOND_CANDIDATES);
+    for (size_t c = block * BOND_CANDIDATES; c < end; ++c) {
+      const Candidate& pair = candidates[c];
+      Vector3 diff =
+        positions[pair.second] + pair.shift - positions[pair.first];
+      double diffsq = diff.squaredNorm();
+      if (diffsq < pair.cutoff * pair.cutoff && diffsq > minSq)
+        found[block].push_back(std::make_pair(pair.first, pair.second));
+    }
+  });
+
+  // without the pairs bonded through several images of a small unit cell
+  for (const auto& pairs : found)
+    bonds.insert(bonds.end(), pairs.begin(), pairs.end());
+  bonds.erase(std::unique(bonds.begin(), bonds.end()), bonds.end());
+}
+
+} // namespace Core
+} // namespace Avogadro
@@ -0,0 +1,137 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_BONDPERCEIVER_H
+#define AVOGADRO_CORE_BONDPERCEIVER_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "unitcell.h"
+#include "vector.h"
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+/**
+ * @class BondPerceiver bondperceiver.h <avogadro/core/bondperceiver.h>
+ * @brief Finds bonded atoms from the distances between them.
+ *
+ * Atoms are considered bonded if they are within the sum of their covalent
+ * radii plus a small tolerance. Candidate pairs come from a NeighborPerceiver,
+ * whose cells are searched in parallel. The perceiver only reads the arrays
+ * passed to perceive(), so it can work on a copy of a molecule's atoms in
+ * another thread.
+ */
+class AVOGADROCORE_EXPORT BondPerceiver
+{
+public:
+  /**
+   * Called with the number of blocks of cells searched so far and the total
+   * number of blocks, from whichever thread finished the block. Returning
+   * false cancels the search.
+   */
+  typedef std::function<bool(int, int)> ProgressFunction;
+
+  /**
+   * @param tolerance Added to the sum of the covalent radii.
+   * @param minDistance Atoms closer than this are not bonded.
+   */
+  explicit BondPerceiver(double tolerance = 0.45, double minDistance = 0.32);
+
+  /**
+   * Bond atoms to the periodic images of their neighbors in @p unitCell,
+   * or only directly if null, the default.
+   */
+  void setUnitCell(const UnitCell* unitCell);
+
+  /**
+   * Only bond atoms whose entry in @p mask is true, or all atoms if the mask
+   * is empty, the default.
+   */
+  void setAtomMask(const std::vector<bool>& mask);
+
+  /**
+   * Set the covalent radius used for atoms whose element has none, in
+   * Angstrom. The default is 2.0, zero only bonds them to atoms close enough
+   * by the other radius and the tolerance.
+   */
+  void setFallbackRadius(double radius);
+  double fallbackRadius() const { return m_fallbackRadius; }
+
+  /** Set the function called as the search progresses. */
+  void setProgressFunction(const ProgressFunction& progress);
+
+  /**
+   * Set how much further apart than bonded atoms may be for perceiveFrame()
+   * to keep them as candidates, in Angstrom. The default is 0.5.
+   */
+  void setSkin(double skin);
+  double skin() const { return m_skin; }
+
+  /**
+   * Find the bonded atoms.
+   * @param positions The positions of the atoms.
+   * @param atomicNumbers The atomic numbers of the atoms.
+   * @param bonds Set to the pairs of bonded atoms, with the lower index first,
+   * in increasing order.
+   * @return False if the progress function cancelled the search.
+   */
+  bool perceive(const Array<Vector3>& positions,
+                const Array<unsigned char>& atomicNumbers,
+                Array<std::pair<Index, Index>>& bonds) const;
+
+  /**
+   * Find the bonded atoms of successive frames of a trajectory, like
+   * perceive(). The pairs of atoms within bonding distance plus the skin are
+   * kept from one call to the next, and only they are checked again until an
+   * atom moved more than half the skin, or the atoms changed. The progress
+   * function is only called when the candidates are searched again.
+   */
+  bool perceiveFrame(const Array<Vector3>& positions,
+                     const Array<unsigned char>& atomicNumbers,
+                     Array<std::pair<Index, Index>>& bonds);
+
+private:
+  // Two atoms close enough to be bonded, where the second is at its position
+  // plus the shift, nonzero for periodic images.
+  struct Candidate
+  {
+    Index first;
+    Index second;
+    Vector3 shift;
+    double cutoff;
+  };
+
+  bool findCandidates(const Array<Vector3>& positions,
+                      const Array<unsigned char>& atomicNumbers,
+                      double skin, std::vector<Candidate>& candidates) const;
+  void checkCandidates(const Array<Vector3>& positions,
+                       const std::vector<Candidate>& candidates,
+                       Array<std::pair<Index, Index>>& bonds) const;
+
+  double m_tolerance;
+  double m_minDistance;
+  double m_fallbackRadius;
+  bool m_periodic;
+  UnitCell m_unitCell;
+  std::vector<bool> m_mask;
+  ProgressFunction m_progress;
+
+  // The candidates of perceiveFrame(), and the atoms they were found for.
+  double m_skin;
+  std::vector<Candidate> m_candidates;
+  Array<Vector3> m_candidatePositions;
+  Array<unsigned char> m_candidateNumbers;
+};
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_BONDPERCEIVER_H
@@ -169,6 +169,22 @@ bool Cube::addData(const std::vector<double>& values)
   return true;
 }
 
+void Cube::computeMinMax()
+{
+  if (m_data.empty()) {
+    m_minValue = m_maxValue = 0.0;
+    return;
+  }
+  m_minValue = m_maxValue = m_data[0];
+  for (std::vector<double>::const_iterator it = m_data.begin();
+       it != m_data.end(); ++it) {
+    if (*it < m_minValue)
+      m_minValue = *it;
+    else if (*it > m_maxValue)
+      m_maxValue = *it;
+  }
+}
+
 unsigned int Cube::closestIndex(const Vector3& pos) const
 {
   int i, j, k;
@@ -203,6 +203,22 @@ public:
    */
   bool setValue(unsigned int i, double value);
 
+  /**
+   * Recalculate the minimum and maximum values from the cube data. This is
+   * needed after the data has been written directly through data().
+   */
+  void computeMinMax();
+
+  /**
+   * Set the minimum and maximum values, when they were already found while
+   * writing the data directly through data().
+   */
+  void setMinMax(double minValue_, double maxValue_)
+  {
+    m_minValue = minValue_;
+    m_maxValue = maxValue_;
+  }
+
   /**
    * @return The minimum  value at any point in the Cube.
    */
@@ -25,7 +25,7 @@ Dihedral DihedralIterator::begin()
     return make_tuple(MaxIndex, MaxIndex, MaxIndex, MaxIndex);
 
   // Loop through bonds until we get one with a-b-c-d
-  Graph graph = m_mol->graph();
+  const Graph& graph = m_mol->graph();
   Index bondCount = m_mol->bondCount();
   if (bondCount > 3) {
     // need at least a-b-c-d to have a dihedral
@@ -71,7 +71,7 @@ Dihedral DihedralIterator::operator++()
   Index a, b, c, d;
   std::tie(a, b, c, d) = m_current;
 
-  Graph graph = m_mol->graph();
+  const Graph& graph = m_mol->graph();
   Index count = m_mol->atomCount();
 
   // we start at a good state (i.e., we have a valid dihedral)
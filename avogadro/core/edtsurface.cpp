@@ -0,0 +1,435 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "edtsurface.h"
+
+#include "cube.h"
+#include "elements.h"
+#include "molecule.h"
+#include "parallel_p.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Avogadro {
+namespace Core {
+
+namespace {
+
+// Planes per slab, and the size of the blocks the slabs are split into.
+const int SLAB_PLANES = 8;
+const int BLOCK_POINTS = 16;
+
+// Squared distance used for points not yet reached by the transform.
+const float FAR_AWAY = 1e20f;
+
+// Uniform grid of cells over the atoms, stored as one flat array of atom
+// indices sorted by cell, with the start of each cell in cellStart.
+class SpatialHash
+{
+public:
+  SpatialHash(const Array<Vector3>& points, double cellSize)
+    : m_cellSize(cellSize)
+  {
+    m_min = m_max = points[0];
+    for (const auto& p : points) {
+      m_min = m_min.cwiseMin(p);
+      m_max = m_max.cwiseMax(p);
+    }
+    for (int i = 0; i < 3; ++i)
+      m_dim[i] = static_cast<int>((m_max[i] - m_min[i]) / m_cellSize) + 1;
+
+    std::vector<size_t> cells(points.size());
+    m_cellStart.assign(static_cast<size_t>(m_dim[0]) * m_dim[1] * m_dim[2] + 1,
+                       0);
+    for (size_t i = 0; i < points.size(); ++i) {
+      cells[i] = cellIndex(cell(points[i], 0), cell(points[i], 1),
+                           cell(points[i], 2));
+      ++m_cellStart[cells[i] + 1];
+    }
+    for (size_t i = 1; i < m_cellStart.size(); ++i)
+      m_cellStart[i] += m_cellStart[i - 1];
+    std::vector<size_t> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+    m_atoms.resize(points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+      m_atoms[fill[cells[i]]++] = i;
+  }
+
+  // Call f(atom) for the atoms in all cells overlapping the box.
+  template <typename Function>
+  void forEachInBox(const Vector3& boxMin, const Vector3& boxMax,
+                    Function f) const
+  {
+    int lo[3], hi[3];
+    for (int i = 0; i < 3; ++i) {
+      if (boxMax[i] < m_min[i] || boxMin[i] > m_max[i])
+        return;
+      lo[i] = cell(boxMin, i);
+      hi[i] = cell(boxMax, i);
+    }
+    for (int x = lo[0]; x <= hi[0]; ++x) {
+      for (int y = lo[1]; y <= hi[1]; ++y) {
+        for (int z = lo[2]; z <= hi[2]; ++z) {
+          size_t c = cellIndex(x, y, z);
+          for (size_t i = m_cellStart[c]; i < m_cellStart[c + 1]; ++i)
+            f(m_atoms[i]);
+        }
+      }
+    }
+  }
+
+private:
+  int cell(const Vector3& p, int axis) const
+  {
+    int c = static_cast<int>(std::floor((p[axis] - m_min[axis]) / m_cellSize));
+    return std::max(0, std::min(c, m_dim[axis] - 1));
+  }
+
+  size_t cellIndex(int x, int y, int z) const
+  {
+    return (static_cast<size_t>(x) * m_dim[1] + y) * m_dim[2] + z;
+  }
+
+  double m_cellSize;
+  Vector3 m_min;
+  Vector3 m_max;
+  int m_dim[3];
+  std::vector<size_t> m_cellStart;
+  std::vector<size_t> m_atoms;
+};
+
+// Felzenszwalb-Huttenlocher lower envelope of parabolas along one grid line.
+// For each point q this finds the point p minimizing (h * (q - p))^2 + f(p),
+// storing the minimum in d and p in arg. v and z are scratch space of size n
+// and n + 1.
+void transformLine(const std::vector<double>& f, int n, double h,
+                   std::vector<double>& d, std::vector<int>& arg,
+                   std::vector<int>& v, std::vector<double>& z)
+{
+  const double inf = std::numeric_limits<double>::infinity();
+  int k = 0;
+  v[0] = 0;
+  z[0] = -inf;
+  z[1] = inf;
+  for (int q = 1; q < n; ++q) {
+    const double fq = f[q] + (h * q) * (h * q);
+    auto intersection = [&](int p) {
+      return (fq - (f[p] + (h * p) * (h * p))) / (2.0 * h * (q - p));
+    };
+    double s = intersection(v[k]);
+    while (s <= z[k]) {
+      --k;
+      s = intersection(v[k]);
+    }
+    ++k;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = inf;
+  }
+  k = 0;
+  for (int q = 0; q < n; ++q) {
+    while (z[k + 1] < h * q)
+      ++k;
+    const int p = v[k];
+    d[q] = (h * (q - p)) * (h * (q - p)) + f[p];
+    arg[q] = p;
+  }
+}
+
+} // namespace
+
+EDTSurface::EDTSurface() : m_probeRadius(1.4), m_threadCount(0) {}
+
+EDTSurface::~EDTSurface() {}
+
+bool EDTSurface::calculateCube(const Molecule& mol, Cube& cube, Type type,
+                               double spacing) const
+{
+  const Array<unsigned char>& atomicNumbers = mol.atomicNumbers();
+  std::vector<double> radii(atomicNumbers.size());
+  for (size_t i = 0; i < atomicNumbers.size(); ++i)
+    radii[i] = Elements::radiusVDW(atomicNumbers[i]);
+  return calculateCube(mol.atomPositions3d(), radii, cube, type, spacing);
+}
+
+bool EDTSurface::calculateCube(const Array<Vector3>& positions,
+                               const std::vector<double>& radii, Cube& cube,
+                               Type type, double spacing) const
+{
+  if (positions.empty() || positions.size() != radii.size() || spacing <= 0.0)
+    return false;
+
+  // The spheres are inflated by the probe, except for the van der Waals case
+  const double probe = type == VanDerWaals ? 0.0 : m_probeRadius;
+  std::vector<double> sphereRadii(radii.size());
+  for (size_t i = 0; i < radii.size(); ++i)
+    sphereRadii[i] = radii[i] + probe;
+  const double maxRadius =
+    *std::max_element(sphereRadii.begin(), sphereRadii.end());
+
+  // Distances are exact in a band around the spheres and clamped beyond it
+  const double reach = 3.0 * spacing;
+  const double padding = maxRadius + reach + spacing;
+  Vector3 min = positions[0];
+  Vector3 max = positions[0];
+  for (const auto& p : positions) {
+    min = min.cwiseMin(p);
+    max = max.cwiseMax(p);
+  }
+  min.array() -= padding;
+  max.array() += padding;
+  Vector3i dim;
+  for (int i = 0; i < 3; ++i)
+    dim[i] = static_cast<int>(std::ceil((max[i] - min[i]) / spacing)) + 1;
+
+  cube.setLimits(min, dim, spacing);
+  cube.setCubeType(Cube::VdW);
+
+  if (type == SolventExcluded) {
+    std::vector<int> nearest;
+    calculateSpheres(positions, sphereRadii, cube, reach, &nearest);
+    calculateExcluded(positions, sphereRadii, cube, nearest);
+  } else {
+    calculateSpheres(positions, sphereRadii, cube, reach, nullptr);
+  }
+  cube.computeMinMax();
+  return true;
+}
+
+void EDTSurface::calculateSpheres(const Array<Vector3>& positions,
+                                  const std::vector<double>& radii, Cube& cube,
+                                  double reach, std::vector<int>* nearest) const
+{
+  const Vector3i dim = cube.dimensions();
+  const Vector3 origin = cube.min();
+  const Vector3 h = cube.spacing();
+  double* data = cube.data()->data();
+  if (nearest)
+    nearest->assign(cube.data()->size(), -1);
+
+  const double maxReach = *std::max_element(radii.begin(), radii.end()) + reach;
+  SpatialHash hash(positions, maxReach);
+
+  const int slabs = (dim[0] + SLAB_PLANES - 1) / SLAB_PLANES;
+  parallelFor(threads(), slabs, [&](int slab) {
+    int lo[3], hi[3];
+    lo[0] = slab * SLAB_PLANES;
+    hi[0] = std::min(lo[0] + SLAB_PLANES, dim[0]);
+    for (lo[1] = 0; lo[1] < dim[1]; lo[1] += BLOCK_POINTS) {
+      hi[1] = std::min(lo[1] + BLOCK_POINTS, dim[1]);
+      for (lo[2] = 0; lo[2] < dim[2]; lo[2] += BLOCK_POINTS) {
+        hi[2] = std::min(lo[2] + BLOCK_POINTS, dim[2]);
+
+        for (int i = lo[0]; i < hi[0]; ++i) {
+          for (int j = lo[1]; j < hi[1]; ++j) {
+            size_t row = (static_cast<size_t>(i) * dim[1] + j) * dim[2];
+            std::fill(data + row + lo[2], data + row + hi[2], reach);
+          }
+        }
+
+        Vector3 blockMin, blockMax;
+        for (int a = 0; a < 3; ++a) {
+          blockMin[a] = origin[a] + lo[a] * h[a] - maxReach;
+          blockMax[a] = origin[a] + (hi[a] - 1) * h[a] + maxReach;
+        }
+        hash.forEachInBox(blockMin, blockMax, [&](size_t atom) {
+          const Vector3& c = positions[atom];
+          const double r = radii[atom];
+          const double r2 = (r + reach) * (r + reach);
+
+          // The range of points within reach along one axis
+          auto range = [&](int a, double extent, int& first, int& last) {
+            first = std::max(
+              lo[a],
+              static_cast<int>(std::ceil((c[a] - extent - origin[a]) / h[a])));
+            last = std::min(
+              hi[a] - 1,
+              static_cast<int>(std::floor((c[a] + extent - origin[a]) / h[a])));
+          };
+          int i0, i1;
+          range(0, r + reach, i0, i1);
+          for (int i = i0; i <= i1; ++i) {
+            const double dx = origin[0] + i * h[0] - c[0];
+            const double rx = r2 - dx * dx;
+            if (rx < 0.0)
+              continue;
+            int j0, j1;
+            range(1, std::sqrt(rx), j0, j1);
+            for (int j = j0; j <= j1; ++j) {
+              const double dy = origin[1] + j * h[1] - c[1];
+              const double ry = rx - dy * dy;
+              if (ry < 0.0)
+                continue;
+              int k0, k1;
+              range(2, std::sqrt(ry), k0, k1);
+              size_t row = (static_cast<size_t>(i) * dim[1] + j) * dim[2];
+              for (int k = k0; k <= k1; ++k) {
+                const double dz = origin[2] + k * h[2] - c[2];
+                const double d = std::sqrt(dx * dx + dy * dy + dz * dz) - r;
+                if (d < data[row + k]) {
+                  data[row + k] = d;
+                  if (nearest)
+                    (*nearest)[row + k] = static_cast<int>(atom);
+                }
+              }
+            }
+          }
+        });
+      }
+    }
+  });
+}
+
+void EDTSurface::calculateExcluded(const Array<Vector3>& positions,
+                                   const std::vector<double>& radii,
+                                   Cube& cube,
+                                   const std::vector<int>& nearest) const
+{
+  const Vector3i dim = cube.dimensions();
+  const Vector3 h = cube.spacing();
+  double* data = cube.data()->data();
+  const size_t size = cube.data()->size();
+  const size_t strides[3] = { static_cast<size_t>(dim[1]) * dim[2],
+                              static_cast<size_t>(dim[2]), 1 };
+  auto index = [&](int i, int j, int k) {
+    return i * strides[0] + j * strides[1] + k;
+  };
+
+  // The transform starts from the points just outside the accessible surface
+  std::vector<float> dist2(size, FAR_AWAY);
+  std::vector<int> sites(size, -1);
+  parallelFor(threads(), dim[0], [&](int i) {
+    for (int j = 0; j < dim[1]; ++j) {
+      for (int k = 0; k < dim[2]; ++k) {
+        const size_t p = index(i, j, k);
+        if (data[p] < 0.0)
+          continue;
+        const int ijk[3] = { i, j, k };
+        for (int a = 0; a < 3; ++a) {
+          if ((ijk[a] > 0 && data[p - strides[a]] < 0.0) ||
+              (ijk[a] < dim[a] - 1 && data[p + strides[a]] < 0.0)) {
+            dist2[p] = 0.0f;
+            sites[p] = static_cast<int>(p);
+            break;
+          }
+        }
+      }
+    }
+  });
+
+  // One pass of the separable transform along each axis, carrying the nearest
+  // site along with the squared distance to it.
+  for (int axis = 2; axis >= 0; --axis) {
+    const int n = dim[axis];
+    const int a = axis == 0 ? 1 : 0;
+    const int b = axis == 2 ? 1 : 2;
+    parallelFor(threads(), dim[a], [&](int first) {
+      std::vector<double> f(n), d(n), z(n + 1);
+      std::vector<int> arg(n), v(n), lineSites(n);
+      for (int second = 0; second < dim[b]; ++second) {
+        const size_t start = first * strides[a] + second * strides[b];
+        for (int q = 0; q < n; ++q) {
+          f[q] = dist2[start + q * strides[axis]];
+          lineSites[q] = sites[start + q * strides[axis]];
+        }
+        transformLine(f, n, h[axis], d, arg, v, z);
+        for (int q = 0; q < n; ++q) {
+          dist2[start + q * strides[axis]] = static_cast<float>(d[q]);
+          sites[start + q * strides[axis]] = lineSites[arg[q]];
+        }
+      }
+    });
+  }
+
+  // Inside the accessible surface, points further than the probe radius from
+  // it are excluded from the solvent. The distance is taken to the surface of
+  // the sphere that was nearest to the site, not to the grid point.
+  const Vector3 origin = cube.min();
+  const double probe = m_probeRadius;
+  parallelFor(threads(), dim[0], [&](int i) {
+    for (int j = 0; j < dim[1]; ++j) {
+      for (int k = 0; k < dim[2]; ++k) {
+        const size_t p = index(i, j, k);
+        if (data[p] >= 0.0) {
+          data[p] += probe;
+          continue;
+        }
+        const int site = sites[p];
+        if (site < 0 || nearest[site] < 0) {
+          data[p] = probe - std::sqrt(static_cast<double>(dist2[p]));
+          continue;
+        }
+        const size_t s = static_cast<size_t>(site);
+        const Vector3 sitePos(origin[0] + (s / strides[0]) * h[0],
+                              origin[1] + (s / strides[1] % dim[1]) * h[1],
+                              origin[2] + (s % strides[1]) * h[2]);
+        const Vector3& center = positions[nearest[site]];
+        Vector3 dir = sitePos - center;
+        const double length = dir.norm();
+        const Vector3 surface =
+          length > 0.0 ? Vector3(center + dir * (radii[nearest[site]] / length))
+                       : sitePos;
+        const Vector3 pos(origin[0] + i * h[0], origin[1] + j * h[1],
+                          origin[2] + k * h[2]);
+        data[p] = probe - (pos - surface).norm();
+      }
+    }
+  });
+}
+
+unsigned int EDTSurface::threads() const
+{
+  if (m_threadCount > 0)
+    return m_threadCount;
+  return threadCount();
+}
+
+double EDTSurface::volume(const Cube& cube)
+{
+  // Smoothed step function over a band of a few grid points
+  const Vector3 h = cube.spacing();
+  const double width = 1.5 * h.maxCoeff();
+  double sum = 0.0;
+  for (double d : *cube.data()) {
+    if (d <= -width)
+      sum += 1.0;
+    else if (d < width)
+      sum += 0.5 * (1.0 - d / width - std::sin(M_PI * d / width) / M_PI);
+  }
+  return sum * h[0] * h[1] * h[2];
+}
+
+double EDTSurface::surfaceArea(const Cube& cube)
+{
+  // Integral of a smoothed delta function times the gradient magnitude
+  const Vector3 h = cube.spacing();
+  const Vector3i dim = cube.dimensions();
+  const double width = 1.5 * h.maxCoeff();
+  const std::vector<double>& data = *cube.data();
+  const size_t strides[3] = { static_cast<size_t>(dim[1]) * dim[2],
+                              static_cast<size_t>(dim[2]), 1 };
+  double sum = 0.0;
+  for (int i = 1; i < dim[0] - 1; ++i) {
+    for (int j = 1; j < dim[1] - 1; ++j) {
+      for (int k = 1; k < dim[2] - 1; ++k) {
+        const size_t p = i * strides[0] + j * strides[1] + k;
+        const double d = data[p];
+        if (std::abs(d) >= width)
+          continue;
+        Vector3 gradient;
+        for (int a = 0; a < 3; ++a)
+          gradient[a] =
+            (data[p + strides[a]] - data[p - strides[a]]) / (2.0 * h[a]);
+        sum += (1.0 + std::cos(M_PI * d / width)) / (2.0 * width) *
+               gradient.norm();
+      }
+    }
+  }
+  return sum * h[0] * h[1] * h[2];
+}
+
+} // End Core namespace
+} // End Avogadro namespace
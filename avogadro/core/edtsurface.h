@@ -0,0 +1,118 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_EDTSURFACE_H
+#define AVOGADRO_CORE_EDTSURFACE_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "vector.h"
+
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+class Cube;
+class Molecule;
+
+/**
+ * @class EDTSurface edtsurface.h <avogadro/core/edtsurface.h>
+ * @brief Calculate molecular surfaces as distance fields on a grid.
+ *
+ * The cube is filled with the signed distance to the surface in Angstrom,
+ * negative inside and positive outside, so the surface itself is the zero
+ * isosurface. Van der Waals and solvent accessible surfaces are the union of
+ * the (probe inflated) atomic spheres. The solvent excluded surface is found
+ * with a Euclidean distance transform from the solvent accessible surface,
+ * points further than the probe radius from it lie inside.
+ *
+ * Atoms are looked up through a spatial hash, and the grid is split into slabs
+ * of planes that are processed in parallel, so the cost grows linearly with
+ * the number of atoms and grid points. The class does not depend on Qt, and
+ * volume() and surfaceArea() can be used on the result without a mesh.
+ */
+class AVOGADROCORE_EXPORT EDTSurface
+{
+public:
+  enum Type
+  {
+    VanDerWaals,
+    SolventAccessible,
+    SolventExcluded
+  };
+
+  EDTSurface();
+  ~EDTSurface();
+
+  /**
+   * @brief Set the radius of the solvent probe, 1.4 Angstrom (water) by
+   * default.
+   */
+  void setProbeRadius(double radius) { m_probeRadius = radius; }
+  double probeRadius() const { return m_probeRadius; }
+
+  /**
+   * @brief Set the number of threads to use, 0 (the default) uses one per
+   * hardware thread.
+   */
+  void setThreadCount(unsigned int threads) { m_threadCount = threads; }
+  unsigned int threadCount() const { return m_threadCount; }
+
+  /**
+   * @brief Calculate the surface of the molecule, using the van der Waals
+   * radii of the atoms.
+   * @param mol The molecule.
+   * @param cube The cube to be set up and populated with the distance field.
+   * @param type The type of surface.
+   * @param spacing The grid spacing in Angstrom.
+   * @return True on success, false on failure.
+   */
+  bool calculateCube(const Molecule& mol, Cube& cube, Type type,
+                     double spacing) const;
+
+  /**
+   * @brief Calculate the surface of a set of spheres.
+   * @param positions The centers of the spheres.
+   * @param radii The radii of the spheres, one per position.
+   * @param cube The cube to be set up and populated with the distance field.
+   * @param type The type of surface.
+   * @param spacing The grid spacing in Angstrom.
+   * @return True on success, false on failure.
+   */
+  bool calculateCube(const Array<Vector3>& positions,
+                     const std::vector<double>& radii, Cube& cube, Type type,
+                     double spacing) const;
+
+  /**
+   * @return The volume enclosed by the zero isosurface of a signed distance
+   * field cube, in cubic Angstrom.
+   */
+  static double volume(const Cube& cube);
+
+  /**
+   * @return The area of the zero isosurface of a signed distance field cube,
+   * in square Angstrom.
+   */
+  static double surfaceArea(const Cube& cube);
+
+private:
+  void calculateSpheres(const Array<Vector3>& positions,
+                        const std::vector<double>& radii, Cube& cube,
+                        double reach, std::vector<int>* nearest) const;
+  void calculateExcluded(const Array<Vector3>& positions,
+                         const std::vector<double>& radii, Cube& cube,
+                         const std::vector<int>& nearest) const;
+  unsigned int threads() const;
+
+  double m_probeRadius;
+  unsigned int m_threadCount;
+};
+
+} // End Core namespace
+} // End Avogadro namespace
+
+#endif // AVOGADRO_CORE_EDTSURFACE_H
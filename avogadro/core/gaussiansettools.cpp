@@ -22,6 +22,8 @@
 #include "gaussianset.h"
 #include "molecule.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 using std::cout;
@@ -32,6 +34,71 @@ using std::vector;
 namespace Avogadro {
 namespace Core {
 
+namespace {
+typedef Eigen::Matrix<Real, Eigen::Dynamic, 1> VectorX;
+
+// The number of grid points evaluated together when populating cubes.
+const size_t BLOCK_SIZE = 128;
+
+// The number of components and the angular momentum of the supported shells,
+// unsupported shells have no components.
+int shellComponents(int type)
+{
+  switch (type) {
+    case GaussianSet::S:
+      return 1;
+    case GaussianSet::P:
+      return 3;
+    case GaussianSet::D:
+      return 6;
+    case GaussianSet::D5:
+      return 5;
+    case GaussianSet::F:
+      return 10;
+    case GaussianSet::F7:
+      return 7;
+    default:
+      return 0;
+  }
+}
+
+int shellAngularMomentum(int type)
+{
+  switch (type) {
+    case GaussianSet::P:
+      return 1;
+    case GaussianSet::D:
+    case GaussianSet::D5:
+      return 2;
+    case GaussianSet::F:
+    case GaussianSet::F7:
+      return 3;
+    default:
+      return 0;
+  }
+}
+} // namespace
+
+/**
+ * The screening data for a cube calculation and the scratch space reused for
+ * each block of points. The basis function values of a block are stored with
+ * one column per point, and only hold the significant basis functions.
+ */
+struct GaussianSetTools::BlockData
+{
+  std::vector<Vector3> atoms;       //! Atom positions in Bohr
+  std::vector<double> cutoffs;      //! Squared cutoff radius of each primitive
+  std::vector<double> shellCutoffs; //! Largest squared cutoff of each shell
+  Eigen::Index functionCount = 0;   //! Number of basis functions
+
+  std::vector<Vector3> points;         //! Positions of the block in Bohr
+  std::vector<unsigned int> shells;    //! Significant shells in the block
+  std::vector<unsigned int> functions; //! Basis functions of those shells
+  std::vector<double> values;          //! Basis function values
+  std::vector<double> coefficients;    //! Gathered MO coefficients
+  std::vector<double> work; //! Gathered density matrix and products
+};
+
 GaussianSetTools::GaussianSetTools(Molecule* mol) : m_molecule(mol)
 {
   if (m_molecule)
@@ -44,10 +111,9 @@ GaussianSetTools::~GaussianSetTools()
 
 bool GaussianSetTools::calculateMolecularOrbital(Cube& cube, int moNumber) const
 {
-  for (size_t i = 0; i < cube.data()->size(); ++i) {
-    Vector3 pos = cube.position(i);
-    cube.setValue(i, calculateMolecularOrbital(pos, moNumber));
-  }
+  if (!calculateMolecularOrbital(cube, moNumber, 0, cube.data()->size()))
+    return false;
+  cube.computeMinMax();
   return true;
 }
 
@@ -72,10 +138,9 @@ double GaussianSetTools::calculateMolecularOrbital(const Vector3& position,
 
 bool GaussianSetTools::calculateElectronDensity(Cube& cube) const
 {
-  for (size_t i = 0; i < cube.data()->size(); ++i) {
-    Vector3 pos = cube.position(i);
-    cube.setValue(i, calculateElectronDensity(pos));
-  }
+  if (!calculateElectronDensity(cube, 0, cube.data()->size()))
+    return false;
+  cube.computeMinMax();
   return true;
 }
 
@@ -104,10 +169,9 @@ double GaussianSetTools::calculateElectronDensity(const Vector3& position) const
 
 bool GaussianSetTools::calculateSpinDensity(Cube& cube) const
 {
-  for (size_t i = 0; i < cube.data()->size(); ++i) {
-    Vector3 pos = cube.position(i);
-    cube.setValue(i, calculateSpinDensity(pos));
-  }
+  if (!calculateSpinDensity(cube, 0, cube.data()->size()))
+    return false;
+  cube.computeMinMax();
   return true;
 }
 
@@ -134,6 +198,90 @@ double GaussianSetTools::calculateSpinDensity(const Vector3& position) const
   return rho;
 }
 
+bool GaussianSetTools::calculateMolecularOrbital(Cube& cube, int mo,
+                                                 size_t first,
+                                                 size_t last) const
+{
+  BlockData block;
+  if (!initBlocks(block))
+    return false;
+
+  const MatrixX& matrix = m_basis->moMatrix(m_type);
+  if (mo < 0 || mo >= matrix.cols() || matrix.rows() < block.functionCount)
+    return false;
+
+  last = std::min(last, cube.data()->size());
+  double* data = cube.data()->data();
+  for (size_t start = first; start < last; start += BLOCK_SIZE) {
+    size_t end = std::min(start + BLOCK_SIZE, last);
+    calculateValues(cube, start, end, block);
+
+    Index rows = static_cast<Index>(block.functions.size());
+    Index points = static_cast<Index>(end - start);
+    if (rows == 0) {
+      std::fill(data + start, data + end, 0.0);
+      continue;
+    }
+
+    // Gather the coefficients of the significant basis functions, then the
+    // block of MO values is a single matrix-vector product.
+    block.coefficients.resize(rows);
+    for (Index i = 0; i < rows; ++i)
+      block.coefficients[i] = matrix(block.functions[i], mo);
+    Eigen::Map<const MatrixX> values(block.values.data(), rows, points);
+    Eigen::Map<const VectorX> coefficients(block.coefficients.data(), rows);
+    Eigen::Map<VectorX>(data + start, points).noalias() =
+      values.transpose() * coefficients;
+  }
+  return true;
+}
+
+bool GaussianSetTools::calculateElectronDensity(Cube& cube, size_t first,
+                                                size_t last) const
+{
+  BlockData block;
+  if (!initBlocks(block))
+    return false;
+
+  const MatrixX& matrix = m_basis->densityMatrix();
+  if (matrix.rows() < block.functionCount ||
+      matrix.cols() < block.functionCount) {
+    return false;
+  }
+
+  last = std::min(last, cube.data()->size());
+  double* data = cube.data()->data();
+  for (size_t start = first; start < last; start += BLOCK_SIZE) {
+    size_t end = std::min(start + BLOCK_SIZE, last);
+    calculateValues(cube, start, end, block);
+    calculateBlockDensity(matrix, block, data + start);
+  }
+  return true;
+}
+
+bool GaussianSetTools::calculateSpinDensity(Cube& cube, size_t first,
+                                            size_t last) const
+{
+  BlockData block;
+  if (!initBlocks(block))
+    return false;
+
+  const MatrixX& matrix = m_basis->spinDensityMatrix();
+  if (matrix.rows() < block.functionCount ||
+      matrix.cols() < block.functionCount) {
+    return false;
+  }
+
+  last = std::min(last, cube.data()->size());
+  double* data = cube.data()->data();
+  for (size_t start = first; start < last; start += BLOCK_SIZE) {
+    size_t end = std::min(start + BLOCK_SIZE, last);
+    calculateValues(cube, start, end, block);
+    calculateBlockDensity(matrix, block, data + start);
+  }
+  return true;
+}
+
 bool GaussianSetTools::isValid() const
 {
   if (m_molecule && dynamic_cast<GaussianSet*>(m_molecule->basisSet()))
@@ -179,25 +327,27 @@ inline vector<double> GaussianSetTools::calculateValues(
   values.resize(matrixSize, 0.0);
 
   // Now calculate the values at this point in space
+  const std::vector<unsigned int>& moIndices = m_basis->moIndices();
   for (unsigned int i = 0; i < basisSize; ++i) {
+    double* shellValues = &values[moIndices[i]];
     switch (basis[i]) {
       case GaussianSet::S:
-        pointS(i, dr2[atomIndices[i]], values);
+        pointS(i, dr2[atomIndices[i]], shellValues);
         break;
       case GaussianSet::P:
-        pointP(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
+        pointP(i, deltas[atomIndices[i]], dr2[atomIndices[i]], shellValues);
         break;
       case GaussianSet::D:
-        pointD(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
+        pointD(i, deltas[atomIndices[i]], dr2[atomIndices[i]], shellValues);
         break;
       case GaussianSet::D5:
-        pointD5(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
+        pointD5(i, deltas[atomIndices[i]], dr2[atomIndices[i]], shellValues);
         break;
       case GaussianSet::F:
-        pointF(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
+        pointF(i, deltas[atomIndices[i]], dr2[atomIndices[i]], shellValues);
         break;
       case GaussianSet::F7:
-        pointF7(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
+        pointF7(i, deltas[atomIndices[i]], dr2[atomIndices[i]], shellValues);
         break;
       default:
         // Not handled - return a zero contribution
@@ -208,32 +358,205 @@ inline vector<double> GaussianSetTools::calculateValues(
   return values;
 }
 
+bool GaussianSetTools::initBlocks(BlockData& block) const
+{
+  if (!m_molecule || !m_basis)
+    return false;
+
+  m_basis->initCalculation();
+  const vector<int>& basis = m_basis->symmetry();
+  const vector<unsigned int>& atomIndices = m_basis->atomIndices();
+  const vector<unsigned int>& moIndices = m_basis->moIndices();
+  const vector<unsigned int>& gtoIndices = m_basis->gtoIndices();
+  const vector<unsigned int>& cIndices = m_basis->cIndices();
+  const vector<double>& gtoA = m_basis->gtoA();
+  const vector<double>& gtoCN = m_basis->gtoCN();
+
+  const Array<Vector3>& positions = m_molecule->atomPositions3d();
+  block.atoms.resize(positions.size());
+  for (size_t i = 0; i < positions.size(); ++i)
+    block.atoms[i] = positions[i] * ANGSTROM_TO_BOHR;
+
+  // Find the radius beyond which each primitive falls below the cutoff, that
+  // is solve |c| r^l exp(-a r^2) = cutoff for r^2. The angular factors of the
+  // components can exceed r^l by a small factor, so allow for that too.
+  block.cutoffs.assign(gtoA.size(), 0.0);
+  block.shellCutoffs.assign(basis.size(), -1.0);
+  block.functionCount = 0;
+  for (size_t i = 0; i < basis.size(); ++i) {
+    int components = shellComponents(basis[i]);
+    if (components == 0)
+      continue;
+    if (m_molecule->atomCount() <= atomIndices[i])
+      return false;
+    int l = shellAngularMomentum(basis[i]);
+    block.functionCount = std::max(block.functionCount,
+                                   static_cast<Eigen::Index>(moIndices[i]) +
+                                     components);
+    unsigned int cIndex = cIndices[i];
+    for (unsigned int j = gtoIndices[i]; j < gtoIndices[i + 1]; ++j) {
+      double coefficient = 0.0;
+      for (int k = 0; k < components; ++k)
+        coefficient = std::max(coefficient, std::fabs(gtoCN[cIndex++]));
+      if (l > 0)
+        coefficient *= 4.0;
+      double r2 = 0.0;
+      if (coefficient > m_cutoff) {
+        double ratio = std::log(coefficient / m_cutoff);
+        r2 = ratio / gtoA[j];
+        for (int k = 0; k < 4 && l > 0; ++k)
+          r2 = (ratio + 0.5 * l * std::log(std::max(r2, 1.0))) / gtoA[j];
+      }
+      block.cutoffs[j] = r2;
+      block.shellCutoffs[i] = std::max(block.shellCutoffs[i], r2);
+    }
+  }
+  return true;
+}
+
+void GaussianSetTools::calculateValues(const Cube& cube, size_t first,
+                                       size_t last, BlockData& block) const
+{
+  const vector<int>& basis = m_basis->symmetry();
+  const vector<unsigned int>& atomIndices = m_basis->atomIndices();
+  const vector<unsigned int>& moIndices = m_basis->moIndices();
+
+  // Calculate the positions of the points in the block, and their bounds
+  const Vector3i dim = cube.dimensions();
+  const Vector3 min = cube.min();
+  const Vector3 spacing = cube.spacing();
+  const size_t yzSize = static_cast<size_t>(dim.y()) * dim.z();
+  const size_t count = last - first;
+  block.points.resize(count);
+  Vector3 low, high;
+  for (size_t p = 0; p < count; ++p) {
+    size_t index = first + p;
+    size_t x = index / yzSize;
+    size_t y = (index - x * yzSize) / dim.z();
+    size_t z = index % dim.z();
+    Vector3 point(x * spacing.x() + min.x(), y * spacing.y() + min.y(),
+                  z * spacing.z() + min.z());
+    block.points[p] = point * ANGSTROM_TO_BOHR;
+    if (p == 0) {
+      low = high = block.points[p];
+    } else {
+      low = low.cwiseMin(block.points[p]);
+      high = high.cwiseMax(block.points[p]);
+    }
+  }
+
+  // Keep the shells with a primitive that is significant in the block
+  block.shells.clear();
+  block.functions.clear();
+  for (unsigned int i = 0; i < basis.size(); ++i) {
+    if (block.shellCutoffs[i] < 0.0)
+      continue;
+    const Vector3& atom = block.atoms[atomIndices[i]];
+    Vector3 distance =
+      (low - atom).cwiseMax(atom - high).cwiseMax(Vector3::Zero());
+    if (distance.squaredNorm() > block.shellCutoffs[i])
+      continue;
+    block.shells.push_back(i);
+    int components = shellComponents(basis[i]);
+    for (int j = 0; j < components; ++j)
+      block.functions.push_back(moIndices[i] + j);
+  }
+
+  // Now calculate the values for each point in the block
+  const size_t rows = block.functions.size();
+  const double* cutoffs = block.cutoffs.data();
+  block.values.resize(rows * count);
+  for (size_t p = 0; p < count; ++p) {
+    double* values = block.values.data() + p * rows;
+    for (unsigned int i : block.shells) {
+      Vector3 delta = block.points[p] - block.atoms[atomIndices[i]];
+      double dr2 = delta.squaredNorm();
+      switch (basis[i]) {
+        case GaussianSet::S:
+          pointS(i, dr2, values, cutoffs);
+          break;
+        case GaussianSet::P:
+          pointP(i, delta, dr2, values, cutoffs);
+          break;
+        case GaussianSet::D:
+          pointD(i, delta, dr2, values, cutoffs);
+          break;
+        case GaussianSet::D5:
+          pointD5(i, delta, dr2, values, cutoffs);
+          break;
+        case GaussianSet::F:
+          pointF(i, delta, dr2, values, cutoffs);
+          break;
+        case GaussianSet::F7:
+          pointF7(i, delta, dr2, values, cutoffs);
+          break;
+        default:;
+      }
+      values += shellComponents(basis[i]);
+    }
+  }
+}
+
+void GaussianSetTools::calculateBlockDensity(const MatrixX& matrix,
+                                             BlockData& block,
+                                             double* out) const
+{
+  const Index rows = static_cast<Index>(block.functions.size());
+  const Index points = static_cast<Index>(block.points.size());
+  if (rows == 0) {
+    std::fill(out, out + points, 0.0);
+    return;
+  }
+
+  // Gather the lower triangle of the density matrix for the significant basis
+  // functions, the function indices are sorted so it stays lower triangular.
+  block.work.resize(rows * rows + rows * points);
+  Eigen::Map<MatrixX> density(block.work.data(), rows, rows);
+  for (Index j = 0; j < rows; ++j)
+    for (Index i = j; i < rows; ++i)
+      density(i, j) = matrix(block.functions[i], block.functions[j]);
+
+  // rho = v^T D v for each point, with D v for the block as one product
+  Eigen::Map<const MatrixX> values(block.values.data(), rows, points);
+  Eigen::Map<MatrixX> product(block.work.data() + rows * rows, rows, points);
+  product.noalias() = density.selfadjointView<Eigen::Lower>() * values;
+  for (Index p = 0; p < points; ++p)
+    out[p] = values.col(p).dot(product.col(p));
+}
+
 inline void GaussianSetTools::pointS(unsigned int moIndex, double dr2,
-                                     vector<double>& values) const
+                                     double* values,
+                                     const double* cutoffs) const
 {
   // S type orbitals - the simplest of the calculations with one component
   double tmp = 0.0;
   unsigned int cIndex = m_basis->cIndices()[moIndex];
   for (unsigned int i = m_basis->gtoIndices()[moIndex];
-       i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
-    tmp += m_basis->gtoCN()[cIndex++] * exp(-m_basis->gtoA()[i] * dr2);
+       i < m_basis->gtoIndices()[moIndex + 1]; ++i, ++cIndex) {
+    if (cutoffs && dr2 > cutoffs[i])
+      continue;
+    tmp += m_basis->gtoCN()[cIndex] * exp(-m_basis->gtoA()[i] * dr2);
   }
   // There is one MO coefficient per S shell basis.
-  values[m_basis->moIndices()[moIndex]] = tmp;
+  values[0] = tmp;
 }
 
 inline void GaussianSetTools::pointP(unsigned int moIndex, const Vector3& delta,
-                                     double dr2, vector<double>& values) const
+                                     double dr2, double* values,
+                                     const double* cutoffs) const
 {
   // P type orbitals have three components and each component has a different
   // independent MO weighting. Many things can be cached to save time though.
-  unsigned int baseIndex = m_basis->moIndices()[moIndex];
   Vector3 components(Vector3::Zero());
 
   // Now iterate through the P type GTOs and sum their contributions
   unsigned int cIndex = m_basis->cIndices()[moIndex];
   for (unsigned int i = m_basis->gtoIndices()[moIndex];
        i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
+    if (cutoffs && dr2 > cutoffs[i]) {
+      cIndex += 3;
+      continue;
+    }
     double tmpGTO = exp(-m_basis->gtoA()[i] * dr2);
     for (unsigned int j = 0; j < 3; ++j) {
       // m_values[baseIndex + i] = m_basis->gtoCN()[cIndex++] * tmpGTO;
@@ -241,16 +564,15 @@ inline void GaussianSetTools::pointP(unsigned int moIndex, const Vector3& delta,
     }
   }
   for (unsigned int i = 0; i < 3; ++i)
-    values[baseIndex + i] = components[i] * delta[i];
+    values[i] = components[i] * delta[i];
 }
 
 inline void GaussianSetTools::pointD(unsigned int moIndex, const Vector3& delta,
-                                     double dr2, vector<double>& values) const
+                                     double dr2, double* values,
+                                     const double* cutoffs) const
 {
   // D type orbitals have six components and each component has a different
   // independent MO weighting. Many things can be cached to save time though.
-  unsigned int baseIndex = m_basis->moIndices()[moIndex];
-
   double components[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 
   vector<double>& gtoA = m_basis->gtoA();
@@ -260,6 +582,10 @@ inline void GaussianSetTools::pointD(unsigned int moIndex, const Vector3& delta,
   unsigned int cIndex = m_basis->cIndices()[moIndex];
   for (unsigned int i = m_basis->gtoIndices()[moIndex];
        i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
+    if (cutoffs && dr2 > cutoffs[i]) {
+      cIndex += 6;
+      continue;
+    }
     // Calculate the common factor
     double tmpGTO = exp(-gtoA[i] * dr2);
     for (int j = 0; j < 6; ++j)
@@ -274,16 +600,16 @@ inline void GaussianSetTools::pointD(unsigned int moIndex, const Vector3& delta,
                             delta.y() * delta.z() }; // yz
 
   for (int i = 0; i < 6; ++i)
-    values[baseIndex + i] += components[i] * componentsD[i];
+    values[i] = components[i] * componentsD[i];
 }
 
 inline void GaussianSetTools::pointD5(unsigned int moIndex,
                                       const Vector3& delta, double dr2,
-                                      vector<double>& values) const
+                                      double* values,
+                                      const double* cutoffs) const
 {
   // D type orbitals have five components and each component has a different
   // MO weighting. Many things can be cached to save time.
-  unsigned int baseIndex = m_basis->moIndices()[moIndex];
   double components[5] = { 0.0, 0.0, 0.0, 0.0, 0.0 };
 
   vector<double>& gtoA = m_basis->gtoA();
@@ -293,6 +619,10 @@ inline void GaussianSetTools::pointD5(unsigned int moIndex,
   unsigned int cIndex = m_basis->cIndices()[moIndex];
   for (unsigned int i = m_basis->gtoIndices()[moIndex];
        i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
+    if (cutoffs && dr2 > cutoffs[i]) {
+      cIndex += 5;
+      continue;
+    }
     // Calculate the common factor
     double tmpGTO = exp(-gtoA[i] * dr2);
     for (int j = 0; j < 5; ++j)
@@ -314,15 +644,14 @@ inline void GaussianSetTools::pointD5(unsigned int moIndex,
                             xy };     // 2n
 
   for (int i = 0; i < 5; ++i)
-    values[baseIndex + i] += componentsD[i] * components[i];
+    values[i] = componentsD[i] * components[i];
 }
 inline void GaussianSetTools::pointF(unsigned int moIndex, const Vector3& delta,
-                                     double dr2, vector<double>& values) const
+                                     double dr2, double* values,
+                                     const double* cutoffs) const
 {
   // F type orbitals have 10 components and each component has a different
   // independent MO weighting. Many things can be cached to save time though.
-  unsigned int baseIndex = m_basis->moIndices()[moIndex];
-
   double components[10] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 
   vector<double>& gtoA = m_basis->gtoA();
@@ -332,6 +661,10 @@ inline void GaussianSetTools::pointF(unsigned int moIndex, const Vector3& delta,
   unsigned int cIndex = m_basis->cIndices()[moIndex];
   for (unsigned int i = m_basis->gtoIndices()[moIndex];
        i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
+    if (cutoffs && dr2 > cutoffs[i]) {
+      cIndex += 10;
+      continue;
+    }
     // Calculate the common factor
     double tmpGTO = exp(-gtoA[i] * dr2);
     for (int j = 0; j < 10; ++j)
@@ -365,17 +698,16 @@ inline void GaussianSetTools::pointF(unsigned int moIndex, const Vector3& delta,
   };
 
   for (int i = 0; i < 10; ++i)
-    values[baseIndex + i] += components[i] * componentsF[i];
+    values[i] = components[i] * componentsF[i];
 }
 
 inline void GaussianSetTools::pointF7(unsigned int moIndex,
                                       const Vector3& delta, double dr2,
-                                      vector<double>& values) const
+                                      double* values,
+                                      const double* cutoffs) const
 {
   // F type orbitals have 7 components and each component has a different
   // independent MO weighting. Many things can be cached to save time though.
-  unsigned int baseIndex = m_basis->moIndices()[moIndex];
-
   double components[7] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 
   vector<double>& gtoA = m_basis->gtoA();
@@ -385,6 +717,10 @@ inline void GaussianSetTools::pointF7(unsigned int moIndex,
   unsigned int cIndex = m_basis->cIndices()[moIndex];
   for (unsigned int i = m_basis->gtoIndices()[moIndex];
        i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
+    if (cutoffs && dr2 > cutoffs[i]) {
+      cIndex += 7;
+      continue;
+    }
     // Calculate the common factor
     double tmpGTO = exp(-gtoA[i] * dr2);
     for (int j = 0; j < 7; ++j)
@@ -431,7 +767,7 @@ final normalization
                             (45.0 * xxy - 15.0 * yyy) / root360 };
 
   for (int i = 0; i < 7; ++i)
-    values[baseIndex + i] += components[i] * componentsF[i];
+    values[i] = components[i] * componentsF[i];
 }
 
 } // End Core namespace
@@ -22,6 +22,7 @@
 #include "avogadrocore.h"
 
 #include "basisset.h"
+#include "matrix.h"
 #include "vector.h"
 
 #include <vector>
@@ -100,6 +101,48 @@ public:
    */
   double calculateSpinDensity(const Vector3& position) const;
 
+  /**
+   * @brief Populate the points [first, last) of the cube with values for the
+   * molecular orbital. Points are evaluated in blocks, skipping primitives
+   * that are negligible over the whole block.
+   *
+   * The values are written directly into the cube data, and the minimum and
+   * maximum values of the cube are not updated. This allows disjoint ranges
+   * of the same cube to be calculated concurrently.
+   * @param cube The cube to be populated with values.
+   * @param molecularOrbitalNumber The molecular orbital number.
+   * @param first The index of the first point to calculate.
+   * @param last One past the index of the last point to calculate.
+   * @return True on success, false on failure.
+   */
+  bool calculateMolecularOrbital(Cube& cube, int molecularOrbitalNumber,
+                                 size_t first, size_t last) const;
+
+  /**
+   * @brief Populate the points [first, last) of the cube with values for the
+   * electron density, see calculateMolecularOrbital() for the details.
+   * @return True on success, false on failure.
+   */
+  bool calculateElectronDensity(Cube& cube, size_t first, size_t last) const;
+
+  /**
+   * @brief Populate the points [first, last) of the cube with values for the
+   * spin density, see calculateMolecularOrbital() for the details.
+   * @return True on success, false on failure.
+   */
+  bool calculateSpinDensity(Cube& cube, size_t first, size_t last) const;
+
+  /**
+   * @brief Set the value below which primitive Gaussian contributions are
+   * neglected when populating cubes, the default is 1e-10.
+   */
+  void setCutoff(double cutoff) { m_cutoff = cutoff; }
+
+  /**
+   * @return The value below which primitive contributions are neglected.
+   */
+  double cutoff() const { return m_cutoff; }
+
   /**
    * @brief Check that the basis set is valid and can be used.
    * @return True if valid, false otherwise.
@@ -110,6 +153,9 @@ private:
   Molecule* m_molecule;
   GaussianSet* m_basis;
   BasisSet::ElectronType m_type = BasisSet::Paired;
+  double m_cutoff = 1e-10;
+
+  struct BlockData;
 
   bool isSmall(double value) const;
 
@@ -121,18 +167,43 @@ private:
    */
   std::vector<double> calculateValues(const Vector3& position) const;
 
-  void pointS(unsigned int index, double dr2,
-              std::vector<double>& values) const;
+  /**
+   * @brief Set up the screening data (cutoff radii and atom positions) shared
+   * by all blocks of a cube calculation.
+   * @return False if the basis set cannot be used.
+   */
+  bool initBlocks(BlockData& block) const;
+
+  /**
+   * @brief Calculate the basis function values for the points [first, last)
+   * of the cube. Only the shells that are significant somewhere in the block
+   * are evaluated, and their basis functions are recorded in the block.
+   */
+  void calculateValues(const Cube& cube, size_t first, size_t last,
+                       BlockData& block) const;
+
+  /**
+   * @brief Calculate the density for the current block with the supplied
+   * density matrix, writing the values to @p out.
+   */
+  void calculateBlockDensity(const MatrixX& matrix, BlockData& block,
+                             double* out) const;
+
+  // The point functions write the components of one shell to values, the
+  // primitives with a squared cutoff radius below dr2 are skipped if cutoffs
+  // are supplied.
+  void pointS(unsigned int index, double dr2, double* values,
+              const double* cutoffs = nullptr) const;
   void pointP(unsigned int index, const Vector3& delta, double dr2,
-              std::vector<double>& values) const;
+              double* values, const double* cutoffs = nullptr) const;
   void pointD(unsigned int index, const Vector3& delta, double dr2,
-              std::vector<double>& values) const;
+              double* values, const double* cutoffs = nullptr) const;
   void pointD5(unsigned int index, const Vector3& delta, double dr2,
-               std::vector<double>& values) const;
+               double* values, const double* cutoffs = nullptr) const;
   void pointF(unsigned int index, const Vector3& delta, double dr2,
-              std::vector<double>& values) const;
+              double* values, const double* cutoffs = nullptr) const;
   void pointF7(unsigned int index, const Vector3& delta, double dr2,
-               std::vector<double>& values) const;
+               double* values, const double* cutoffs = nullptr) const;
 };
 
 } // End Core namespace
@@ -18,42 +18,58 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <set>
-#include <stack>
 
 namespace Avogadro {
 namespace Core {
 
-Graph::Graph() {}
+namespace {
+// Revisions are unique across all graphs, so a copy of a graph keeps the
+// revision of the original until either of them changes.
+size_t nextRevision()
+{
+  static std::atomic<size_t> revision(0);
+  return ++revision;
+}
+} // namespace
+
+Graph::Graph()
+  : m_revision(nextRevision()), m_componentsInvalid(false),
+    m_subgraphsDirty(true)
+{
+}
 
 Graph::Graph(size_t n) :
     m_adjacencyList(n), m_edgeMap(n), m_edgePairs(),
-    m_vertexToSubgraph(n), m_subgraphToVertices(), m_subgraphDirty()
+    m_revision(nextRevision()), m_componentsInvalid(false),
+    m_subgraphsDirty(true)
 {
-  for (size_t i = 0; i < n; i++) {
-    m_vertexToSubgraph[i] = -1;
-    m_loneVertices.insert(i);
-  }
+  resetComponents();
 }
 
 Graph::~Graph() {}
 
 void Graph::setSize(size_t n)
 {
+  m_revision = nextRevision();
   // If the graph is being made smaller we first need to remove all of the edges
   // from the soon to be removed vertices.
-  for (size_t i = n; i < m_adjacencyList.size(); ++i) {
+  for (size_t i = n; i < m_adjacencyList.size(); ++i)
     removeEdges(i);
-    // Mark subgraph as dirty if vertex has one assigned
-    if (m_vertexToSubgraph[i] >= 0)
-      m_subgraphDirty[m_vertexToSubgraph[i]] = true;
-  }
-  m_vertexToSubgraph.resize(n);
-  // Mark the new nodes as isolated, with no explicit subgraph
-  for (size_t i = m_adjacencyList.size(); i < n; ++i) {
-    m_vertexToSubgraph[i] = -1;
-    m_loneVertices.insert(i);
+  m_subgraphsDirty = true;
+  if (n < m_adjacencyList.size()) {
+    // The remaining trees may still pass through the removed vertices
+    m_componentsInvalid = true;
+  } else if (!m_componentsInvalid) {
+    // The new vertices are not connected to anything
+    for (size_t i = m_adjacencyList.size(); i < n; ++i) {
+      m_componentParent.push_back(i);
+      m_componentSize.push_back(1);
+      m_nextMember.push_back(i);
+      m_componentDirty.push_back(false);
+    }
   }
 
   m_adjacencyList.resize(n);
@@ -72,12 +88,13 @@ bool Graph::isEmpty() const
 
 void Graph::clear()
 {
+  m_revision = nextRevision();
   m_adjacencyList.clear();
   m_edgeMap.clear();
   m_edgePairs.clear();
-  m_vertexToSubgraph.clear();
-  m_subgraphToVertices.clear();
-  m_subgraphDirty.clear();
+  m_componentsInvalid = false;
+  m_subgraphsDirty = true;
+  resetComponents();
 }
 
 size_t Graph::addVertex()
@@ -89,9 +106,10 @@ size_t Graph::addVertex()
 void Graph::removeVertex(size_t index)
 {
   assert(index < size());
-  // Mark the subgraph as dirty, leave the work for later
-  if (m_vertexToSubgraph[index] >= 0)
-      m_subgraphDirty[m_vertexToSubgraph[index]] = true;
+  m_revision = nextRevision();
+  // Vertices are renumbered, leave the components for the next query
+  m_componentsInvalid = true;
+  m_subgraphsDirty = true;
   // Remove the edges to the vertex.
   removeEdges(index);
 
@@ -114,21 +132,16 @@ void Graph::removeVertex(size_t index)
       if (m_edgePairs[edgeIndex].second == affectedIndex)
         m_edgePairs[edgeIndex].second = index;
     }
-    if (m_vertexToSubgraph[index] >= 0)
-      m_subgraphToVertices[m_vertexToSubgraph[index]].erase(index);
-    std::swap(m_vertexToSubgraph[index], m_vertexToSubgraph.back());
-    if (m_vertexToSubgraph[index] >= 0) {
-      m_subgraphToVertices[m_vertexToSubgraph[index]].erase(affectedIndex);
-      m_subgraphToVertices[m_vertexToSubgraph[index]].insert(index);
-    }
   }
   m_adjacencyList.pop_back();
   m_edgeMap.pop_back();
-  m_vertexToSubgraph.pop_back();
 }
 
 void Graph::swapVertexIndices(size_t a, size_t b)
 {
+  m_revision = nextRevision();
+  m_componentsInvalid = true;
+  m_subgraphsDirty = true;
   // Swap all references to a and b in m_adjacencyList
   for (size_t i = 0; i < m_adjacencyList[a].size(); i++) {
     size_t otherIndex = m_adjacencyList[a][i];
@@ -203,34 +216,10 @@ size_t Graph::addEdge(size_t a, size_t b)
     }
   }
 
-  // Merge subgraphs
-  int subgraphA = m_vertexToSubgraph[a];
-  int subgraphB = m_vertexToSubgraph[b];
-  if (subgraphA < 0 && subgraphB < 0) {
-    int newSubgraph = createNewSubgraph();
-    m_vertexToSubgraph[a] = newSubgraph;
-    m_vertexToSubgraph[b] = newSubgraph;
-    m_subgraphToVertices[newSubgraph].insert(a);
-    m_subgraphToVertices[newSubgraph].insert(b);
-    m_loneVertices.erase(a);
-    m_loneVertices.erase(b);
-  } else if (subgraphA < 0) {
-    m_vertexToSubgraph[a] = subgraphB;
-    m_subgraphToVertices[subgraphB].insert(a);
-    m_loneVertices.erase(a);
-  } else if (subgraphB < 0) {
-    m_vertexToSubgraph[b] = subgraphA;
-    m_subgraphToVertices[subgraphA].insert(b);
-    m_loneVertices.erase(b);
-  } else if (subgraphA != subgraphB) {
-    m_subgraphDirty[subgraphA] = m_subgraphDirty[subgraphA] || m_subgraphDirty[subgraphB];
-    for (size_t i: m_subgraphToVertices[subgraphB]) {
-      m_subgraphToVertices[subgraphA].insert(i);
-      m_vertexToSubgraph[i] = subgraphA;
-    }
-    // Just leave it empty, it could be reused
-    m_subgraphToVertices[subgraphB].clear();
-  }
+  m_revision = nextRevision();
+  m_subgraphsDirty = true;
+  if (!m_componentsInvalid)
+    joinComponents(a, b);
 
   // Add the edge to each vertex' adjacency list.
   neighborsA.push_back(b);
@@ -246,36 +235,30 @@ size_t Graph::addEdge(size_t a, size_t b)
   return newEdgeIndex;
 }
 
-std::set<size_t> Graph::checkConectivity(size_t a, size_t b) const
-{
-  if (a == b) {
-    return std::set<size_t>();
+size_t Graph::addEdges(const Array<std::pair<size_t, size_t>>& edges)
+{
+  size_t firstEdgeIndex = edgeCount();
+  if (edges.empty())
+    return firstEdgeIndex;
+
+  m_revision = nextRevision();
+  m_subgraphsDirty = true;
+  m_edgePairs.reserve(firstEdgeIndex + edges.size());
+  for (std::pair<size_t, size_t> edge : edges) {
+    size_t a = std::min(edge.first, edge.second);
+    size_t b = std::max(edge.first, edge.second);
+    assert(b < size());
+    if (!m_componentsInvalid)
+      joinComponents(a, b);
+
+    size_t newEdgeIndex = edgeCount();
+    m_adjacencyList[a].push_back(b);
+    m_adjacencyList[b].push_back(a);
+    m_edgeMap[a].push_back(newEdgeIndex);
+    m_edgeMap[b].push_back(newEdgeIndex);
+    m_edgePairs.push_back(std::pair<size_t, size_t>(a, b));
   }
-  std::set<size_t> visited;
-  bool connected = false;
-  std::stack<size_t> nextNeighbors;
-  visited.insert(a);
-  nextNeighbors.push(a);
-
-  while (!nextNeighbors.empty()) {
-    size_t visiting = nextNeighbors.top();
-    visited.insert(visiting);
-    nextNeighbors.pop();
-    const std::vector<size_t>& neighbors = m_adjacencyList[visiting];
-    for (const auto& n : neighbors) {
-      if (visiting == b) {
-        connected = true;
-      }
-      if (visited.find(n) == visited.end()) {
-        visited.insert(n);
-        nextNeighbors.push(n);
-      }
-    }
-  }
-  if (connected) {
-    return std::set<size_t>();
-  }
-  return visited;
+  return firstEdgeIndex;
 }
 
 void Graph::removeEdge(size_t a, size_t b)
@@ -291,6 +274,7 @@ void Graph::removeEdge(size_t a, size_t b)
 
   if (iter == neighborsA.end())
     return;
+  m_revision = nextRevision();
 
   std::swap(*iter, neighborsA.back());
   neighborsA.pop_back();
@@ -330,9 +314,15 @@ void Graph::removeEdge(size_t a, size_t b)
     *std::find(edgeList2.begin(), edgeList2.end(), affectedIndex) = edgeIndex;
   }
 
-  // Mark the subgraph as dirty, leave the work for later
-  if (m_vertexToSubgraph[a] >= 0)
-      m_subgraphDirty[m_vertexToSubgraph[a]] = true;
+  // The component may have split, leave the work for the next query
+  m_subgraphsDirty = true;
+  if (!m_componentsInvalid) {
+    size_t root = findRoot(a);
+    if (!m_componentDirty[root]) {
+      m_componentDirty[root] = true;
+      m_dirtyComponents.push_back(root);
+    }
+  }
 }
 
 void Graph::removeEdge(size_t edgeIndex)
@@ -344,32 +334,30 @@ void Graph::removeEdge(size_t edgeIndex)
 
 void Graph::removeEdges()
 {
+  m_revision = nextRevision();
   for (size_t i = 0; i < m_adjacencyList.size(); ++i) {
     m_adjacencyList[i].clear();
     m_edgeMap[i].clear();
-    m_vertexToSubgraph[i] = -1;
-    m_loneVertices.insert(i);
   }
   m_edgePairs.clear();
-  m_subgraphToVertices.clear();
-  m_subgraphDirty.clear();
+  m_componentsInvalid = false;
+  m_subgraphsDirty = true;
+  resetComponents();
 }
 
 void Graph::removeEdges(size_t index)
 {
-  m_vertexToSubgraph[index] = -1;
-  m_loneVertices.insert(index);
-  // Mark the subgraph as dirty, leave the work for later
-  if (m_vertexToSubgraph[index] >= 0)
-      m_subgraphDirty[m_vertexToSubgraph[index]] = true;
-
+  // Every removal shrinks the list, so always take the last edge
   const std::vector<size_t> &edges = m_edgeMap[index];
-  for (size_t i = 0; i < edges.size(); ++i)
-    removeEdge(edges[i]);
+  while (!edges.empty())
+    removeEdge(edges.back());
 }
 
 void Graph::editEdgeInPlace(size_t edgeIndex, size_t a, size_t b)
 {
+  m_revision = nextRevision();
+  m_componentsInvalid = true;
+  m_subgraphsDirty = true;
   auto &pair = m_edgePairs[edgeIndex];
 
   // Remove references to the deleted edge from both endpoints.
@@ -391,6 +379,7 @@ void Graph::editEdgeInPlace(size_t edgeIndex, size_t a, size_t b)
 
 void Graph::swapEdgeIndices(size_t edgeIndex1, size_t edgeIndex2)
 {
+  m_revision = nextRevision();
   // Find the 4 endpoints of both edges.
   const std::pair<size_t, size_t> &pair1 = m_edgePairs[edgeIndex1];
   std::array<size_t *, 2> changeTo2;
@@ -433,16 +422,16 @@ size_t Graph::edgeCount() const
   return m_edgePairs.size();
 }
 
-const std::vector<size_t> Graph::neighbors(size_t index) const
+const std::vector<size_t>& Graph::neighbors(size_t index) const
 {
   assert(index < size());
-  return std::vector<size_t>(m_adjacencyList[index]);
+  return m_adjacencyList[index];
 }
 
-const std::vector<size_t> Graph::edges(size_t index) const
+const std::vector<size_t>& Graph::edges(size_t index) const
 {
   assert(index < size());
-  return std::vector<size_t>(m_edgeMap[index]);
+  return m_edgeMap[index];
 }
 
 const std::pair<size_t, size_t> Graph::endpoints(size_t index) const
@@ -453,7 +442,8 @@ const std::pair<size_t, size_t> Graph::endpoints(size_t index) const
 
 size_t Graph::degree(size_t index) const
 {
-  return neighbors(index).size();
+  assert(index < size());
+  return m_adjacencyList[index].size();
 }
 
 bool Graph::containsEdge(size_t a, size_t b) const
@@ -461,7 +451,7 @@ bool Graph::containsEdge(size_t a, size_t b) const
   assert(a < size());
   assert(b < size());
 
-  const std::vector<size_t>& neighborsA = neighbors(a);
+  const std::vector<size_t>& neighborsA = m_adjacencyList[a];
 
   return std::find(neighborsA.begin(), neighborsA.end(), b) != neighborsA.end();
 }
@@ -471,122 +461,172 @@ const Array<std::pair<size_t, size_t>>& Graph::edgePairs() const
   return m_edgePairs;
 }
 
-int Graph::createNewSubgraph() const
+size_t Graph::findRoot(size_t index) const
 {
-  // Try to find an empty subgraph to reuse
-  for (size_t i = 0; i < m_subgraphToVertices.size(); i++) {
-    if (!m_subgraphToVertices[i].size()) {
-      m_subgraphDirty[i] = false;
-      return int(i);
-    }
+  size_t root = index;
+  while (m_componentParent[root] != root)
+    root = m_componentParent[root];
+  // Point the whole path at the root
+  while (m_componentParent[index] != root) {
+    size_t parent = m_componentParent[index];
+    m_componentParent[index] = root;
+    index = parent;
+  }
+  return root;
+}
+
+void Graph::joinComponents(size_t a, size_t b) const
+{
+  a = findRoot(a);
+  b = findRoot(b);
+  if (a == b)
+    return;
+  // Hang the smaller tree under the larger one, and splice the member lists
+  if (m_componentSize[a] < m_componentSize[b])
+    std::swap(a, b);
+  m_componentParent[b] = a;
+  m_componentSize[a] += m_componentSize[b];
+  std::swap(m_nextMember[a], m_nextMember[b]);
+  if (m_componentDirty[b] && !m_componentDirty[a]) {
+    m_componentDirty[a] = true;
+    m_dirtyComponents.push_back(a);
   }
-  // Otherwise, extend the list
-  int r = m_subgraphDirty.size();
-  m_subgraphToVertices.push_back(std::set<size_t>());
-  m_subgraphDirty.push_back(false);
-  return r;
 }
 
-void Graph::checkSplitSubgraph(int subgraph) const
-{
-  if (!m_subgraphDirty[subgraph]) return;
-  m_subgraphDirty[subgraph] = false;
-  // First, set all vertices to subgraph -1 (meaning not visited)
-  for (size_t i: m_subgraphToVertices[subgraph])
-    m_vertexToSubgraph[i] = -1;
-  // Then, try to classify all vertices in some subgraph
-  int currentSubgraph = subgraph;
-  std::set<size_t> inputVertices = m_subgraphToVertices[subgraph];
-  m_subgraphToVertices[subgraph] = std::set<size_t>();
-  for (size_t i: inputVertices) {
-    if (m_vertexToSubgraph[i] < 0) {
-      if (currentSubgraph < 0)
-        currentSubgraph = createNewSubgraph();
-      // Walk through all connected vertices
-      std::vector<size_t> verticesToVisit;
-      verticesToVisit.push_back(i);
-      do {
-        size_t currentVertex = verticesToVisit.back();
-        verticesToVisit.pop_back();
-        // Assign new vertices to the current subgraph
-        if(m_vertexToSubgraph[currentVertex] < 0) {
-          m_vertexToSubgraph[currentVertex] = currentSubgraph;
-          m_subgraphToVertices[currentSubgraph].insert(currentVertex);
-          const std::vector<size_t> neighborList = neighbors(currentVertex);
-          verticesToVisit.insert(verticesToVisit.end(), neighborList.begin(), neighborList.end());
-        }
-      } while (verticesToVisit.size());
-      currentSubgraph = -1;
+void Graph::resetComponents() const
+{
+  size_t n = m_adjacencyList.size();
+  m_componentParent.resize(n);
+  m_componentSize.assign(n, 1);
+  m_nextMember.resize(n);
+  m_componentDirty.assign(n, false);
+  m_dirtyComponents.clear();
+  for (size_t i = 0; i < n; ++i)
+    m_componentParent[i] = m_nextMember[i] = i;
+}
+
+void Graph::splitComponent(size_t root) const
+{
+  // Only the members of this component are labelled again
+  std::vector<size_t> members;
+  members.reserve(m_componentSize[root]);
+  size_t member = root;
+  do {
+    members.push_back(member);
+    member = m_nextMember[member];
+  } while (member != root);
+
+  for (size_t i : members) {
+    m_componentParent[i] = m_nextMember[i] = i;
+    m_componentSize[i] = 1;
+    m_componentDirty[i] = false;
+  }
+  for (size_t i : members) {
+    for (size_t j : m_adjacencyList[i]) {
+      if (j > i)
+        joinComponents(i, j);
     }
   }
 }
 
 void Graph::updateSubgraphs() const
 {
-  for (size_t v: m_loneVertices) {
-    int newSubgraph = createNewSubgraph();
-    m_vertexToSubgraph[v] = newSubgraph;
-    m_subgraphToVertices[newSubgraph].insert(v);
+  if (!m_subgraphsDirty)
+    return;
+
+  if (m_componentsInvalid) {
+    resetComponents();
+    for (const std::pair<size_t, size_t>& pair : m_edgePairs)
+      joinComponents(pair.first, pair.second);
+    m_componentsInvalid = false;
+  } else {
+    for (size_t root : m_dirtyComponents) {
+      root = findRoot(root);
+      if (m_componentDirty[root])
+        splitComponent(root);
+    }
+    m_dirtyComponents.clear();
   }
-  m_loneVertices.clear();
-  for (int i = 0; i < m_subgraphToVertices.size(); i++) {
-    checkSplitSubgraph(i);
+
+  // Number the subgraphs in the order of their lowest vertex, and list their
+  // vertices in ascending order
+  const size_t none = static_cast<size_t>(-1);
+  size_t n = m_adjacencyList.size();
+  size_t count = 0;
+  m_vertexToSubgraph.assign(n, none);
+  for (size_t i = 0; i < n; ++i) {
+    size_t& rootSubgraph = m_vertexToSubgraph[findRoot(i)];
+    if (rootSubgraph == none)
+      rootSubgraph = count++;
+    m_vertexToSubgraph[i] = rootSubgraph;
   }
+  m_subgraphOffsets.assign(count + 1, 0);
+  for (size_t i = 0; i < n; ++i)
+    ++m_subgraphOffsets[m_vertexToSubgraph[i] + 1];
+  for (size_t i = 0; i < count; ++i)
+    m_subgraphOffsets[i + 1] += m_subgraphOffsets[i];
+  m_subgraphVertices.resize(n);
+  std::vector<size_t> next(m_subgraphOffsets.begin(),
+                           m_subgraphOffsets.end() - 1);
+  for (size_t i = 0; i < n; ++i)
+    m_subgraphVertices[next[m_vertexToSubgraph[i]]++] = i;
+
+  m_subgraphsDirty = false;
 }
 
 std::vector<std::set<size_t>> Graph::connectedComponents() const
 {
   updateSubgraphs();
-  std::vector<std::set<size_t>> r;
-  for (std::set<size_t> s: m_subgraphToVertices) {
-    if (!s.empty()) r.push_back(s);
+  std::vector<std::set<size_t>> r(subgraphsCount());
+  for (size_t i = 0; i < r.size(); ++i) {
+    IndexView vertices = subgraphView(i);
+    r[i].insert(vertices.begin(), vertices.end());
   }
   return r;
 }
 
 std::set<size_t> Graph::connectedComponent(size_t index) const
 {
-  size_t subgraphIndex = subgraph(index);
-  return m_subgraphToVertices[subgraphIndex];
+  IndexView vertices = connectedComponentView(index);
+  return std::set<size_t>(vertices.begin(), vertices.end());
+}
+
+Graph::IndexView Graph::connectedComponentView(size_t index) const
+{
+  return subgraphView(subgraph(index));
+}
+
+Graph::IndexView Graph::subgraphView(size_t subgraphId) const
+{
+  updateSubgraphs();
+  assert(subgraphId < subgraphsCount());
+  const size_t* data = m_subgraphVertices.data();
+  return IndexView(data + m_subgraphOffsets[subgraphId],
+                   data + m_subgraphOffsets[subgraphId + 1]);
 }
 
 size_t Graph::subgraphsCount() const
 {
   updateSubgraphs();
-  size_t r = 0;
-  for (std::set<size_t> s: m_subgraphToVertices) {
-    if (!s.empty()) r++;
-  }
-  return r;
+  return m_subgraphOffsets.size() - 1;
 }
 
 size_t Graph::subgraph(size_t element) const
 {
-  int r = m_vertexToSubgraph[element];
-  // Index -1 means disconnected (its own subgraph)
-  if (r < 0) {
-    r = m_subgraphToVertices.size();
-    m_subgraphToVertices.push_back(std::set<size_t>());
-    m_subgraphToVertices[r].insert(element);
-    m_subgraphDirty[r] = false;
-    return r;
-  }
-  if (m_subgraphDirty[r]) {
-    checkSplitSubgraph(r);
-    r = m_vertexToSubgraph[element];
-  }
-  return r;
+  assert(element < size());
+  updateSubgraphs();
+  return m_vertexToSubgraph[element];
 }
 
 size_t Graph::subgraphCount(size_t element) const
 {
-  int subgraphIndex = subgraph(element);
-  return m_subgraphToVertices[subgraphIndex].size();
+  return connectedComponentView(element).size();
 }
 
 size_t Graph::getConnectedID(size_t index) const
 {
   return subgraph(index);
 }
+
 } // namespace Core
 } // namespace Avogadro
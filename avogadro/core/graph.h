@@ -38,6 +38,28 @@ namespace Core {
 class AVOGADROCORE_EXPORT Graph
 {
 public:
+  /**
+   * @brief A read only view of consecutive vertex or edge indices.
+   */
+  class IndexView
+  {
+  public:
+    IndexView(const size_t* first, const size_t* last)
+      : m_first(first), m_last(last)
+    {
+    }
+
+    const size_t* begin() const { return m_first; }
+    const size_t* end() const { return m_last; }
+    size_t size() const { return static_cast<size_t>(m_last - m_first); }
+    bool empty() const { return m_first == m_last; }
+    size_t operator[](size_t i) const { return m_first[i]; }
+
+  private:
+    const size_t* m_first;
+    const size_t* m_last;
+  };
+
   /** Creates a new, empty graph. */
   Graph();
 
@@ -101,6 +123,14 @@ public:
    */
   size_t addEdge(size_t a, size_t b);
 
+  /**
+   * Adds an edge between each pair of vertices in @p edges, in order, and
+   * returns the index of the first one. Unlike addEdge(), the pairs are not
+   * checked against the existing edges, so they must be distinct and not
+   * connected yet.
+   */
+  size_t addEdges(const Array<std::pair<size_t, size_t>>& edges);
+
   /**
    * Removes the edge between vertices @p a and @p b.
    * All vertices keep their indices. If the removed edge has an index lower
@@ -146,13 +176,19 @@ public:
    * @return a vector containing the indices of each vertex that the vertex at
    * index shares an edge with.
    */
-  const std::vector<size_t> neighbors(size_t index) const;
+  const std::vector<size_t>& neighbors(size_t index) const;
 
   /**
    * @return a vector containing the indices of each edge that the vertex at
    * @p index is an endpoint of; that is, the edges incident at it.
    */
-  const std::vector<size_t> edges(size_t index) const;
+  const std::vector<size_t>& edges(size_t index) const;
+
+  /**
+   * @return a number that changes whenever vertices or edges are added or
+   * removed, so results derived from the graph can be cached against it.
+   */
+  size_t revision() const { return m_revision; }
 
   /**
    * @return the indices of the two vertices that the edge at @p index connects;
@@ -178,6 +214,7 @@ public:
   /**
    * @return a vector of vector containing the indices of each vertex in each
    * connected component in the graph.
+   * @note This copies the components, subgraphView() does not.
    */
   std::vector<std::set<size_t>> connectedComponents() const;
 
@@ -187,10 +224,26 @@ public:
    */
   std::set<size_t> connectedComponent(size_t index) const;
 
+  /**
+   * @return a view of the vertices in the connected subgraph @p index lies in,
+   * in ascending order. Any change to the graph invalidates it.
+   */
+  IndexView connectedComponentView(size_t index) const;
+
+  /**
+   * @return a view of the vertices in the subgraph with ID @p subgraphId, in
+   * ascending order. Any change to the graph invalidates it.
+   */
+  IndexView subgraphView(size_t subgraphId) const;
+
   /** @return the number of connected subgraphs. */
   size_t subgraphsCount() const;
 
-  /** @return the subgraph ID of the connected subgraph @p index lies in. */
+  /**
+   * @return the subgraph ID of the connected subgraph @p index lies in. The
+   * IDs run from 0 to subgraphsCount() - 1, in the order of the lowest vertex
+   * index in each subgraph.
+   */
   size_t subgraph(size_t index) const;
 
   /**
@@ -205,32 +258,50 @@ public:
   size_t getConnectedID(size_t index) const;
 
 private:
-  std::set<size_t> checkConectivity(size_t a, size_t b) const;
   std::vector<std::vector<size_t>> m_adjacencyList;
   std::vector<std::vector<size_t>> m_edgeMap;
   Array<std::pair<size_t, size_t>> m_edgePairs;
-  
-  /** @return the (new or reused) index of a newly created empty subgraph. */
-  int createNewSubgraph() const;
+
+  size_t m_revision;
+
+  /** @return the root of the component tree that @p index is in. */
+  size_t findRoot(size_t index) const;
+
+  /** Join the components of vertices @p a and @p b. */
+  void joinComponents(size_t a, size_t b) const;
+
+  /** Make every vertex a component of its own. */
+  void resetComponents() const;
 
   /**
-   * If @p subgraph is marked as dirty, traverse it
-   * to check if it has split into many new subgraphs,
-   * and mark the resulting subgraph(s) as clean.
+   * Label the members of the component with root @p root again, after edges
+   * were removed from it.
    */
-  void checkSplitSubgraph(int subgraph) const;
+  void splitComponent(size_t root) const;
 
   /**
-   * Traverse and mark clean all dirty subgraphs,
-   * and create new subgraphs for all lone vertices.
-   * All subgraph data becomes synchronized as a result.
+   * Split the components that lost edges, or rebuild them all if vertices
+   * were renumbered, and number the subgraphs.
    */
   void updateSubgraphs() const;
 
-  mutable std::vector<int> m_vertexToSubgraph;
-  mutable std::vector<std::set<size_t>> m_subgraphToVertices;
-  mutable std::vector<bool> m_subgraphDirty;
-  mutable std::set<size_t> m_loneVertices;
+  // Connected components are kept in a union-find forest over the vertices,
+  // the members of each tree are linked in a circle through m_nextMember.
+  // Adding an edge joins two trees, removing one marks its tree as dirty so
+  // that only that tree is walked again by the next query.
+  mutable std::vector<size_t> m_componentParent;
+  mutable std::vector<size_t> m_componentSize;
+  mutable std::vector<size_t> m_nextMember;
+  mutable std::vector<bool> m_componentDirty;
+  mutable std::vector<size_t> m_dirtyComponents;
+  mutable bool m_componentsInvalid;
+
+  // The subgraph ID of every vertex, and the vertices of subgraph i at
+  // m_subgraphOffsets[i] up to m_subgraphOffsets[i + 1] in m_subgraphVertices.
+  mutable std::vector<size_t> m_vertexToSubgraph;
+  mutable std::vector<size_t> m_subgraphOffsets;
+  mutable std::vector<size_t> m_subgraphVertices;
+  mutable bool m_subgraphsDirty;
 };
 
 } // namespace Core
@@ -33,7 +33,8 @@ Mesh::Mesh() : m_stable(true), m_other(0), m_cube(0), m_lock(new Mutex)
 
 Mesh::Mesh(const Mesh& other)
   : m_vertices(other.m_vertices), m_normals(other.m_normals),
-    m_colors(other.m_colors), m_name(other.m_name), m_stable(true),
+    m_colors(other.m_colors), m_triangles(other.m_triangles),
+    m_name(other.m_name), m_stable(true),
     m_isoValue(other.m_isoValue), m_other(other.m_other), m_cube(other.m_cube),
     m_lock(new Mutex)
 {
@@ -124,6 +125,19 @@ bool Mesh::addNormals(const Core::Array<Vector3f>& values)
   }
 }
 
+const Core::Array<unsigned int>& Mesh::triangles() const
+{
+  return m_triangles;
+}
+
+bool Mesh::setTriangles(const Core::Array<unsigned int>& values)
+{
+  if (values.size() % 3 != 0)
+    return false;
+  m_triangles = values;
+  return true;
+}
+
 const Core::Array<Color3f>& Mesh::colors() const
 {
   return m_colors;
@@ -160,6 +174,8 @@ bool Mesh::addColors(const Core::Array<Color3f>& values)
 
 bool Mesh::valid() const
 {
+  if (m_triangles.size() % 3 != 0)
+    return false;
   if (m_vertices.size() == m_normals.size()) {
     if (m_colors.size() == 1 || m_colors.size() == m_vertices.size())
       return true;
@@ -175,14 +191,16 @@ bool Mesh::clear()
   m_vertices.clear();
   m_normals.clear();
   m_colors.clear();
+  m_triangles.clear();
   return true;
 }
 
 Mesh& Mesh::operator=(const Mesh& other)
 {
   m_vertices = other.m_vertices;
-  m_normals = other.m_vertices;
+  m_normals = other.m_normals;
   m_colors = other.m_colors;
+  m_triangles = other.m_triangles;
   m_name = other.m_name;
   m_isoValue = other.m_isoValue;
 
@@ -39,6 +39,10 @@ class Mutex;
  * meshes should be owned by a Molecule. It should also be removed by the
  * Molecule that owns it. Meshes encapsulate triangular meshes that can also
  * have colors associated with each vertex.
+ *
+ * If the triangles array is empty the mesh is a triangle soup, every three
+ * consecutive vertices form a triangle. Otherwise vertices are shared and the
+ * triangles array holds three vertex indices per triangle.
  */
 
 class MeshPrivate;
@@ -172,6 +176,27 @@ public:
    */
   bool addNormals(const Core::Array<Vector3f>& values);
 
+  /**
+   * @return Array containing the vertex indices of the triangles, three per
+   * triangle. This is empty if the vertices form explicit triangles.
+   */
+  const Core::Array<unsigned int>& triangles() const;
+
+  /**
+   * @return The number of triangles in the mesh, whether indexed or not.
+   */
+  unsigned int numTriangles() const
+  {
+    return static_cast<unsigned int>(
+      (m_triangles.empty() ? m_vertices.size() : m_triangles.size()) / 3);
+  }
+
+  /**
+   * Clear the triangles array and assign new values, three vertex indices per
+   * triangle.
+   */
+  bool setTriangles(const Core::Array<unsigned int>& values);
+
   /**
    * @return Array containing all of the colors in a one-dimensional array.
    */
@@ -232,6 +257,7 @@ private:
   Core::Array<Vector3f> m_vertices;
   Core::Array<Vector3f> m_normals;
   Core::Array<Color3f> m_colors;
+  Core::Array<unsigned int> m_triangles;
   std::string m_name;
   bool m_stable;
   float m_isoValue;
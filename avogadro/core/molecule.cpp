@@ -6,19 +6,21 @@
 #include "molecule.h"
 
 #include "basisset.h"
+#include "bondperceiver.h"
 #include "color3f.h"
 #include "cube.h"
 #include "elements.h"
 #include "layermanager.h"
 #include "mesh.h"
-#include "neighborperceiver.h"
 #include "residue.h"
+#include "trajectoryprovider.h"
 #include "unitcell.h"
 
 #include <algorithm>
 #include <array>
 #include <cassert>
 #include <iostream>
+#include <map>
 
 namespace Avogadro {
 namespace Core {
@@ -34,7 +36,8 @@ Molecule::Molecule(const Molecule& other)
   : m_data(other.m_data), m_customElementMap(other.m_customElementMap),
     m_positions2d(other.m_positions2d), m_positions3d(other.m_positions3d),
     m_label(other.m_label), m_coordinates3d(other.m_coordinates3d),
-    m_timesteps(other.m_timesteps), m_hybridizations(other.m_hybridizations),
+    m_trajectory(other.m_trajectory), m_timesteps(other.m_timesteps),
+    m_hybridizations(other.m_hybridizations),
     m_formalCharges(other.m_formalCharges), m_colors(other.m_colors),
     m_vibrationFrequencies(other.m_vibrationFrequencies),
     m_vibrationIntensities(other.m_vibrationIntensities),
@@ -77,6 +80,7 @@ Molecule::Molecule(Molecule&& other) noexcept
     m_positions3d(std::move(other.m_positions3d)),
     m_label(std::move(other.m_label)),
     m_coordinates3d(std::move(other.m_coordinates3d)),
+    m_trajectory(std::move(other.m_trajectory)),
     m_timesteps(std::move(other.m_timesteps)),
     m_hybridizations(std::move(other.m_hybridizations)),
     m_formalCharges(std::move(other.m_formalCharges)),
@@ -117,6 +121,7 @@ Molecule& Molecule::operator=(const Molecule& other)
     m_positions3d = other.m_positions3d;
     m_label = other.m_label;
     m_coordinates3d = other.m_coordinates3d;
+    m_trajectory = other.m_trajectory;
     m_timesteps = other.m_timesteps;
     m_hybridizations = other.m_hybridizations;
     m_formalCharges = other.m_formalCharges;
@@ -174,6 +179,7 @@ Molecule& Molecule::operator=(Molecule&& other) noexcept
     m_positions3d = std::move(other.m_positions3d);
     m_label = std::move(other.m_label);
     m_coordinates3d = std::move(other.m_coordinates3d);
+    m_trajectory = std::move(other.m_trajectory);
     m_timesteps = std::move(other.m_timesteps);
     m_hybridizations = std::move(other.m_hybridizations);
     m_formalCharges = std::move(other.m_formalCharges);
@@ -506,10 +512,10 @@ Molecule::BondType Molecule::bond(Index atomId1, Index atomId2) const
   assert(atomId1 < atomCount());
   assert(atomId2 < atomCount());
 
-  const std::vector<Index>& edgeIndices = m_graph.edges(atomId1);
-  for (Index i = 0; i < edgeIndices.size(); i++) {
-    Index index = edgeIndices[i];
-    const std::pair<Index, Index>& pair = m_graph.endpoints(index);
+  // Walk the incident edges rather than the compressed views, which would be
+  // rebuilt after every bond when bonds are added one at a time
+  for (size_t index : m_graph.edges(atomId1)) {
+    const std::pair<Index, Index> pair = m_graph.endpoints(index);
     if (pair.first == atomId2 || pair.second == atomId2)
       return BondType(const_cast<Molecule*>(this), index);
   }
@@ -528,14 +534,9 @@ Array<const Molecule::BondType*> Molecule::bonds(Index a) const
 {
   Array<const BondType*> atomBonds;
   if (a < atomCount()) {
-    const std::vector<Index>& edgeIndices = m_graph.edges(a);
-    for (Index i = 0; i < edgeIndices.size(); ++i) {
-      Index index = edgeIndices[i];
-      if (m_graph.endpoints(index).first == a ||
-          m_graph.endpoints(index).second == a) {
-        // work around to consult bonds without breaking constantness
-        atomBonds.push_back(new BondType(const_cast<Molecule*>(this), index));
-      }
+    for (Index index : m_graph.edges(a)) {
+      // work around to consult bonds without breaking constantness
+      atomBonds.push_back(new BondType(const_cast<Molecule*>(this), index));
     }
   }
 
@@ -550,13 +551,8 @@ Array<Molecule::BondType> Molecule::bonds(Index a)
 {
   Array<BondType> atomBonds;
   if (a < atomCount()) {
-    const std::vector<Index>& edgeIndices = m_graph.edges(a);
-    for (Index i = 0; i < edgeIndices.size(); ++i) {
-      Index index = edgeIndices[i];
-      auto bond = bondPair(index);
-      if (bond.first == a || bond.second == a)
-        atomBonds.push_back(BondType(this, index));
-    }
+    for (Index index : m_graph.edges(a))
+      atomBonds.push_back(BondType(this, index));
   }
 
   std::sort(atomBonds.begin(), atomBonds.end(),
@@ -770,51 +766,19 @@ void Molecule::setVibrationLx(const Array<Array<Vector3>>& lx)
   m_vibrationLx = lx;
 }
 
-void Molecule::perceiveBondsSimple(const double tolerance, const double min)
+void Molecule::perceiveBondsSimple(const double tolerance, const double min,
+                                   bool periodic)
 {
   // check for coordinates
   if (m_positions3d.size() != atomCount() || m_positions3d.size() < 2)
     return;
 
-  // cache atomic radii
-  std::vector<double> radii(atomCount());
-  double max_radius = 0.0;
-  for (size_t i = 0; i < radii.size(); i++) {
-    radii[i] = Elements::radiusCovalent(atomicNumber(i));
-    if (radii[i] <= 0.0)
-      radii[i] = 2.0;
-    if (radii[i] > max_radius)
-      max_radius = radii[i];
-  }
-
-  float maxDistance = 2.0 * max_radius + tolerance;
-  auto neighborPerceiver = NeighborPerceiver(m_positions3d, maxDistance);
-
-  // check for bonds
-  // O(n) average-case, O(n^2) worst-case
-  // note that the "worst case" here would need to be an invalid molecule
-  Array<Index> neighbors;
-  for (Index i = 0; i < atomCount(); i++) {
-    Vector3 ipos = m_positions3d[i];
-    neighborPerceiver.getNeighborsInclusiveInPlace(neighbors, ipos);
-    for (Index nj = 0; nj < neighbors.size(); ++nj) {
-      Index j = neighbors[nj];
-      double cutoff = radii[i] + radii[j] + tolerance;
-      Vector3 jpos = m_positions3d[j];
-      Vector3 diff = jpos - ipos;
-
-      if (std::fabs(diff[0]) > cutoff || std::fabs(diff[1]) > cutoff ||
-          std::fabs(diff[2]) > cutoff ||
-          (atomicNumber(i) == 1 && atomicNumber(j) == 1))
-        continue;
-
-      // check radius and add bond if needed
-      double cutoffSq = cutoff * cutoff;
-      double diffsq = diff.squaredNorm();
-      if (diffsq < cutoffSq && diffsq > min * min)
-        addBond(atom(i), atom(j), 1);
-    }
-  }
+  BondPerceiver perceiver(tolerance, min);
+  if (periodic)
+    perceiver.setUnitCell(m_unitCell);
+  Array<std::pair<Index, Index>> bonds;
+  perceiver.perceive(m_positions3d, m_atomicNumbers, bonds);
+  addBonds(bonds, Array<unsigned char>(bonds.size(), 1));
 }
 
 void Molecule::perceiveBondsFromResidueData()
@@ -824,23 +788,49 @@ void Molecule::perceiveBondsFromResidueData()
   }
 }
 
-int Molecule::coordinate3dCount()
+int Molecule::coordinate3dCount() const
 {
-  return static_cast<int>(m_coordinates3d.size());
+  int count = static_cast<int>(m_coordinates3d.size());
+  if (m_trajectory)
+    count = std::max(count, m_trajectory->frameCount());
+  return count;
 }
 
 bool Molecule::setCoordinate3d(int coord)
 {
-  if (coord >= 0 && coord < static_cast<int>(m_coordinates3d.size())) {
+  if (coord >= 0 && coord < static_cast<int>(m_coordinates3d.size()) &&
+      !m_coordinates3d[coord].empty()) {
     m_positions3d = m_coordinates3d[coord];
     return true;
   }
+  if (m_trajectory)
+    return m_trajectory->frame(coord, m_positions3d);
   return false;
 }
 
 Array<Vector3> Molecule::coordinate3d(int index) const
 {
-  return m_coordinates3d[index];
+  if (index >= 0 && index < static_cast<int>(m_coordinates3d.size()) &&
+      !m_coordinates3d[index].empty())
+    return m_coordinates3d[index];
+
+  Array<Vector3> positions;
+  if (m_trajectory)
+    m_trajectory->frame(index, positions);
+  return positions;
+}
+
+bool Molecule::coordinate3d(int index, Array<Vector3>& positions) const
+{
+  if (index >= 0 && index < static_cast<int>(m_coordinates3d.size()) &&
+      !m_coordinates3d[index].empty()) {
+    const Array<Vector3>& coords = m_coordinates3d[index];
+    positions.assign(coords.begin(), coords.end());
+    return true;
+  }
+  if (m_trajectory)
+    return m_trajectory->frame(index, positions);
+  return false;
 }
 
 bool Molecule::setCoordinate3d(const Array<Vector3>& coords, int index)
@@ -851,6 +841,12 @@ bool Molecule::setCoordinate3d(const Array<Vector3>& coords, int index)
   return true;
 }
 
+void Molecule::setTrajectoryProvider(
+  std::shared_ptr<TrajectoryProvider> provider)
+{
+  m_trajectory = provider;
+}
+
 double Molecule::timeStep(int index, bool& status)
 {
   if (static_cast<int>(m_timesteps.size()) <= index) {
@@ -1029,31 +1025,56 @@ bool Molecule::removeBonds(Index atom)
 Array<std::pair<Index, Index>> Molecule::getAtomBonds(Index index) const
 {
   Array<std::pair<Index, Index>> result;
-  const std::vector<Index>& edgeIndices = m_graph.edges(index);
-  for (Index i = 0; i < edgeIndices.size(); i++) {
-    result.push_back(m_graph.endpoints(edgeIndices[i]));
-  }
+  for (Index edgeIndex : m_graph.edges(index))
+    result.push_back(m_graph.endpoints(edgeIndex));
   return result;
 }
 
 Array<unsigned char> Molecule::getAtomOrders(Index index) const
 {
   Array<unsigned char> result;
-  const std::vector<Index>& edgeIndices = m_graph.edges(index);
-  for (Index i = 0; i < edgeIndices.size(); i++) {
-    result.push_back(m_bondOrders[edgeIndices[i]]);
-  }
+  for (Index edgeIndex : m_graph.edges(index))
+    result.push_back(m_bondOrders[edgeIndex]);
   return result;
 }
 
 void Molecule::addBonds(const Array<std::pair<Index, Index>>& bonds,
                         const Array<unsigned char>& orders)
 {
-  Index i = 0;
-  for (auto p : bonds) {
-    addBond(p.first, p.second, orders[i]);
-    ++i;
+  assert(orders.size() == bonds.size());
+
+  // Same result as calling addBond() for each pair in turn: a pair that is
+  // already bonded, before this call or earlier in the list, only gets the
+  // new order. The rest are appended to the graph in one pass.
+  Array<std::pair<Index, Index>> newBonds;
+  Array<unsigned char> newOrders;
+  std::map<std::pair<Index, Index>, Index> pending;
+  const Index atoms = atomCount();
+  const bool lookup = bondCount() > 0;
+  for (Index i = 0; i < bonds.size(); ++i) {
+    Index a = bonds[i].first;
+    Index b = bonds[i].second;
+    if (a >= atoms || b >= atoms || a == b)
+      continue;
+    if (lookup) {
+      Index index = bond(a, b).index();
+      if (index < bondCount()) {
+        m_bondOrders[index] = orders[i];
+        continue;
+      }
+    }
+    auto inserted = pending.insert(
+      std::make_pair(makeBondPair(a, b), static_cast<Index>(newBonds.size())));
+    if (inserted.second) {
+      newBonds.push_back(inserted.first->first);
+      newOrders.push_back(orders[i]);
+    } else {
+      newOrders[inserted.first->second] = orders[i];
+    }
   }
+
+  m_graph.addEdges(newBonds);
+  m_bondOrders.insert(m_bondOrders.end(), newOrders.begin(), newOrders.end());
 }
 
 std::list<Index> Molecule::getAtomsAtLayer(size_t layer)
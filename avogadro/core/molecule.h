@@ -18,6 +18,7 @@
 
 #include <list>
 #include <map>
+#include <memory>
 #include <string>
 
 namespace Avogadro {
@@ -26,6 +27,7 @@ class BasisSet;
 class Cube;
 class Mesh;
 class Residue;
+class TrajectoryProvider;
 class UnitCell;
 
 /** Concrete atom/bond proxy classes for Core::Molecule. @{ */
@@ -480,9 +482,12 @@ public:
    *  plus a small @p tolerance.
    * @param tolerance The calculation tolerance.
    * @param minDistance = atoms closer than the square of this are ignored
+   * @param periodic If true and the molecule has a unit cell, atoms are also
+   *   bonded to the periodic images of their neighbors across the cell.
    */
   void perceiveBondsSimple(const double tolerance = 0.45,
-                           const double minDistance = 0.32);
+                           const double minDistance = 0.32,
+                           bool periodic = false);
 
   /**
    * Perceives bonds in the molecule based on preset residue data.
@@ -495,11 +500,35 @@ public:
    */
   void perceiveSubstitutedCations();
 
-  int coordinate3dCount();
+  /**
+   * Coordinate sets are used for conformers and trajectory frames. Frames
+   * set explicitly take precedence over those of the trajectory provider.
+   */
+  int coordinate3dCount() const;
   bool setCoordinate3d(int coord);
   Array<Vector3> coordinate3d(int index) const;
+
+  /**
+   * Copy the coordinate set at @p index into @p positions, reusing its
+   * storage. Unlike the overload returning the set, the copy is never
+   * implicitly shared with the molecule, so frames can be read from several
+   * threads as long as the molecule is not modified meanwhile.
+   * @return False if there is no such coordinate set.
+   */
+  bool coordinate3d(int index, Array<Vector3>& positions) const;
   bool setCoordinate3d(const Array<Vector3>& coords, int index);
 
+  /**
+   * Set a provider to read trajectory frames on demand, instead of holding
+   * all of them in memory. The provider is shared with copies of the
+   * molecule, pass nullptr to remove it.
+   */
+  void setTrajectoryProvider(std::shared_ptr<TrajectoryProvider> provider);
+  std::shared_ptr<TrajectoryProvider> trajectoryProvider() const
+  {
+    return m_trajectory;
+  }
+
   /**
    * Timestep property is used when molecular dynamics trajectories are read
    */
@@ -659,7 +688,13 @@ public:
                                                      const Index& b);
   bool removeBonds(Index atom);
 
-  void addBonds(const Array<std::pair<Index, Index>>& bonds,
+  /**
+   * Add a bond of order @p orders[i] between each pair of atoms @p bonds[i],
+   * much faster than addBond() for many bonds. Pairs that are already bonded,
+   * or repeat earlier in the list, are given the new order, as with addBond().
+   * Pairs of an atom with itself or with an invalid index are skipped.
+   */
+  virtual void addBonds(const Array<std::pair<Index, Index>>& bonds,
                 const Array<unsigned char>& orders);
 
   // chenge the bond index position
@@ -679,6 +714,7 @@ protected:
   Array<Vector3> m_positions3d;
   Array<std::string> m_label;
   Array<Array<Vector3>> m_coordinates3d; // Used for conformers/trajectories.
+  std::shared_ptr<TrajectoryProvider> m_trajectory;
   Array<double> m_timesteps;
   Array<AtomHybridization> m_hybridizations;
   Array<signed char> m_formalCharges;
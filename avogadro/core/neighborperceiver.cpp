@@ -5,40 +5,140 @@
 
 #include "neighborperceiver.h"
 
+#include "unitcell.h"
+
+#include <cmath>
+
 namespace Avogadro {
 namespace Core {
 
-NeighborPerceiver::NeighborPerceiver(const Array<Vector3> points, float maxDistance)
- : m_maxDistance(maxDistance)
+namespace {
+// Cells are made larger than the maximum distance if there would otherwise be
+// many more cells than points, e.g. for a few molecules far apart.
+const Index cellsPerPoint = 8;
+const Index minimumCells = 64;
+} // namespace
+
+NeighborPerceiver::NeighborPerceiver(const Array<Vector3>& points,
+                                     float maxDistance,
+                                     const UnitCell* unitCell)
+  : m_maxDistance(maxDistance), m_periodic(unitCell != nullptr),
+    m_binCount({ { 1, 1, 1 } }), m_binRange({ { 1, 1, 1 } }), m_cellOffsets(2),
+    m_binSize(maxDistance), m_minPos(Vector3::Zero()),
+    m_maxPos(Vector3::Zero()), m_cellMatrix(Matrix3::Identity()),
+    m_fractionalMatrix(Matrix3::Identity())
 {
-  if (!points.size()) return;
+  if (!points.size())
+    return;
+
+  const Index maxCells =
+    std::max(minimumCells, static_cast<Index>(points.size()) * cellsPerPoint);
+  const Real distance = m_maxDistance > 0.0f ? m_maxDistance : 1.0;
 
-  // find bounding box
-  m_minPos = points[0];
-  m_maxPos = points[0];
-  for (Index i = 1; i < points.size(); i++) {
-    Vector3 ipos = points[i];
+  // the positions are stored in cell order, wrapped into the unit cell in
+  // periodic mode, so each cell reads a contiguous range
+  std::vector<Vector3> positions(points.begin(), points.end());
+  std::vector<std::array<int, 3>> bins(points.size());
+  if (m_periodic) {
+    m_cellMatrix = unitCell->cellMatrix();
+    m_fractionalMatrix = unitCell->fractionalMatrix();
+
+    // the fractional cells along each axis are at least the maximum distance
+    // apart, the stencil reaches further when the unit cell is thinner
+    const Real volume = std::fabs(m_cellMatrix.determinant());
+    Vector3 widths;
+    for (size_t c = 0; c < 3; c++) {
+      const Vector3 normal =
+        m_cellMatrix.col((c + 1) % 3).cross(m_cellMatrix.col((c + 2) % 3));
+      widths[c] = volume / normal.norm();
+    }
+    Real cellSize = distance;
+    for (;;) {
+      Index cells = 1;
+      for (size_t c = 0; c < 3; c++) {
+        m_binCount[c] = std::max(1, int(std::floor(widths[c] / cellSize)));
+        cells *= m_binCount[c];
+      }
+      if (cells <= maxCells)
+        break;
+      cellSize *= std::cbrt(Real(cells) / maxCells) * 1.01;
+    }
     for (size_t c = 0; c < 3; c++) {
-      m_minPos(c) = std::min(ipos(c), m_minPos(c));
-      m_maxPos(c) = std::max(ipos(c), m_maxPos(c));
+      m_binRange[c] =
+        int(std::ceil(distance * m_binCount[c] / widths[c] - 1.0e-8));
+      m_binRange[c] = std::max(1, m_binRange[c]);
+    }
+
+    for (Index i = 0; i < points.size(); i++) {
+      Vector3 frac = m_fractionalMatrix * points[i];
+      for (size_t c = 0; c < 3; c++) {
+        frac[c] -= std::floor(frac[c]);
+        if (!(frac[c] < 1.0) || !(frac[c] >= 0.0))
+          frac[c] = 0.0;
+        bins[i][c] = std::min(m_binCount[c] - 1, int(frac[c] * m_binCount[c]));
+      }
+      positions[i] = m_cellMatrix * frac;
+    }
+  } else {
+    // find bounding box
+    m_minPos = points[0];
+    m_maxPos = points[0];
+    for (Index i = 1; i < points.size(); i++) {
+      Vector3 ipos = points[i];
+      for (size_t c = 0; c < 3; c++) {
+        m_minPos(c) = std::min(ipos(c), m_minPos(c));
+        m_maxPos(c) = std::max(ipos(c), m_maxPos(c));
+      }
     }
+
+    // group points into cubic bins so that each point is only checked against
+    // other points inside bins within a 3-dimensional Moore neighborhood
+    m_binSize = distance;
+    for (;;) {
+      Index cells = 1;
+      for (size_t c = 0; c < 3; c++) {
+        m_binCount[c] =
+          std::floor((m_maxPos(c) + 0.1 - m_minPos(c)) / m_binSize) + 1;
+        cells *= m_binCount[c];
+      }
+      if (cells <= maxCells)
+        break;
+      m_binSize *= std::cbrt(Real(cells) / maxCells) * 1.01;
+    }
+    for (Index i = 0; i < points.size(); i++)
+      bins[i] = getBinIndex(points[i]);
   }
 
-  // group points into cubic bins so that each point is only checked against
-  // other points inside bins within a 3-dimensional Moore neighborhood
-  for (size_t c = 0; c < 3; c++)
-    m_binCount[c] = std::floor((m_maxPos(c) + 0.1 - m_minPos(c)) / m_maxDistance) + 1;
-  std::vector<std::vector<std::vector<std::vector<Index>>>> bins(
-    m_binCount[0], std::vector<std::vector<std::vector<Index>>>(
-      m_binCount[1], std::vector<std::vector<Index>>(
-        m_binCount[2], std::vector<Index>()
-      )
-    )
-  );
-  m_bins = bins;
+  // counting sort of the points into the cells
+  const Index cells = Index(m_binCount[0]) * m_binCount[1] * m_binCount[2];
+  m_cellOffsets.assign(cells + 1, 0);
+  std::vector<Index> cellOfPoint(points.size());
   for (Index i = 0; i < points.size(); i++) {
-    std::array<int, 3> bin_index = getBinIndex(points[i]);
-    m_bins.at(bin_index[0]).at(bin_index[1]).at(bin_index[2]).push_back(i);
+    const std::array<int, 3>& bin = bins[i];
+    cellOfPoint[i] = (Index(bin[0]) * m_binCount[1] + bin[1]) * m_binCount[2] +
+                     bin[2];
+    ++m_cellOffsets[cellOfPoint[i] + 1];
+  }
+  for (Index cell = 0; cell < cells; cell++)
+    m_cellOffsets[cell + 1] += m_cellOffsets[cell];
+  std::vector<Index> next(m_cellOffsets.begin(), m_cellOffsets.end() - 1);
+  m_cellPoints.resize(points.size());
+  m_cellPositions.resize(points.size());
+  for (Index i = 0; i < points.size(); i++) {
+    const Index slot = next[cellOfPoint[i]]++;
+    m_cellPoints[slot] = i;
+    m_cellPositions[slot] = positions[i];
+  }
+
+  // the half shell holds the neighboring cells that follow a cell, pairs with
+  // the cells that precede it are visited from those cells
+  for (int x = -m_binRange[0]; x <= m_binRange[0]; x++) {
+    for (int y = -m_binRange[1]; y <= m_binRange[1]; y++) {
+      for (int z = -m_binRange[2]; z <= m_binRange[2]; z++) {
+        if (x > 0 || (x == 0 && (y > 0 || (y == 0 && z > 0))))
+          m_halfShell.push_back({ { x, y, z } });
+      }
+    }
   }
 }
 
@@ -46,15 +146,26 @@ void NeighborPerceiver::getNeighborsInclusiveInPlace(
     Array<Index> &out, const Vector3 &point
 ) const {
   out.clear();
+  if (m_cellPoints.empty())
+    return;
+
   const std::array<int, 3> bin_index = getBinIndex(point);
-  for (int xi = std::max(int(1), bin_index[0]) - 1;
-      xi < std::min(m_binCount[0], bin_index[0] + 2); xi++) {
-    for (int yi = std::max(int(1), bin_index[1]) - 1;
-        yi < std::min(m_binCount[1], bin_index[1] + 2); yi++) {
-      for (int zi = std::max(int(1), bin_index[2]) - 1;
-          zi < std::min(m_binCount[2], bin_index[2] + 2); zi++) {
-        const std::vector<Index> &bin = m_bins[xi][yi][zi];
-        out.insert(out.end(), bin.begin(), bin.end());
+  std::vector<Index> visited;
+  for (int xi = -m_binRange[0]; xi <= m_binRange[0]; xi++) {
+    for (int yi = -m_binRange[1]; yi <= m_binRange[1]; yi++) {
+      for (int zi = -m_binRange[2]; zi <= m_binRange[2]; zi++) {
+        Index cell;
+        Vector3 shift;
+        if (!neighborCell(bin_index, { { xi, yi, zi } }, cell, shift))
+          continue;
+        // a small unit cell can be reached through several of its images
+        if (m_periodic) {
+          if (std::find(visited.begin(), visited.end(), cell) != visited.end())
+            continue;
+          visited.push_back(cell);
+        }
+        out.insert(out.end(), m_cellPoints.begin() + m_cellOffsets[cell],
+                   m_cellPoints.begin() + m_cellOffsets[cell + 1]);
       }
     }
   }
@@ -70,10 +181,19 @@ const Array<Index> NeighborPerceiver::getNeighborsInclusive(const Vector3 &point
 const std::array<int, 3> NeighborPerceiver::getBinIndex(const Vector3 &point) const
 {
   std::array<int, 3> r;
+  if (m_periodic) {
+    Vector3 frac = m_fractionalMatrix * point;
+    for (size_t c = 0; c < 3; c++) {
+      frac[c] -= std::floor(frac[c]);
+      r[c] = std::max(0, std::min(m_binCount[c] - 1,
+                                  int(frac[c] * m_binCount[c])));
+    }
+    return r;
+  }
   for (size_t c = 0; c < 3; c++) {
-    r[c] = std::floor((point(c) - m_minPos(c)) / m_maxDistance);
+    r[c] = std::floor((point(c) - m_minPos(c)) / m_binSize);
   }
-  return r; 
+  return r;
 }
 
 } // namespace Core
@@ -9,17 +9,26 @@
 #include "avogadrocore.h"
 
 #include "array.h"
+#include "matrix.h"
 #include "vector.h"
 
+#include <algorithm>
 #include <array>
 #include <vector>
 
 namespace Avogadro {
 namespace Core {
 
+class UnitCell;
+
 /**
  * @class NeighborPerceiver neighborperceiver.h <avogadro/core/neighborperceiver.h>
  * @brief This class can be used to find physically neighboring points in linear average time.
+ *
+ * The points are sorted into cells at least the maximum distance wide, stored
+ * as one contiguous array of point indices and the offset of each cell into
+ * it. If a unit cell is given, the cells tile the unit cell and pairs are
+ * found through the periodic images of the points.
  */
 class AVOGADROCORE_EXPORT NeighborPerceiver
 {
@@ -30,9 +39,12 @@ public:
    * @param points Positions in 3D space to detect neighbors among.
    * @param maxDistance All neighbors strictly within this distance will be detected.
    *                    Should be as low as possible for best performance.
+   * @param unitCell If not null, neighbors are also detected through the
+   *                 periodic images of the points.
    */
-  NeighborPerceiver(const Array<Vector3> points, float maxDistance);
-  
+  NeighborPerceiver(const Array<Vector3>& points, float maxDistance,
+                    const UnitCell* unitCell = nullptr);
+
   /**
    * Returns a list of neighboring points. Linear time to number of neighbors.
    * Can include some neighbors up to 2*sqrt(3) times the maximum distance.
@@ -42,26 +54,134 @@ public:
    * @param point Position to return neighbors of, can be located anywhere.
    */
   const Array<Index> getNeighborsInclusive(const Vector3 &point) const;
-  
+
   /**
    * Fills an array with all neighboring points. Linear time to number of neighbors.
    * Can include some neighbors up to 2*sqrt(3) times the maximum distance.
+   * In periodic mode the distances must be measured through the minimum image.
    *
    * @param out Array to output neighbor indices in.
    * @param point Position to return neighbors of, can be located anywhere.
    */
   void getNeighborsInclusiveInPlace(Array<Index> &out, const Vector3 &point) const;
-  
+
+  /** @return True if neighbors are detected through periodic images. */
+  bool isPeriodic() const { return m_periodic; }
+
+  /** @return The number of cells the points are sorted into. */
+  Index cellCount() const { return m_cellOffsets.size() - 1; }
+
+  /**
+   * Calls @p visit(i, j, delta) once for every pair of points strictly within
+   * the maximum distance, where delta is the vector from point i to point j.
+   * Each cell is only compared with itself and the half of its neighbors that
+   * follow it, so every pair is visited exactly once. In periodic mode delta
+   * points to the image of j, and a pair is visited once for every image of
+   * j within range of i; points are never paired with their own images.
+   */
+  template <typename Function>
+  void forEachPair(Function&& visit) const;
+
+  /**
+   * Visits the pairs whose first point lies in a cell from @p firstCell up to,
+   * but not including, @p lastCell. Disjoint cell ranges visit disjoint pairs,
+   * so they can be processed in parallel.
+   */
+  template <typename Function>
+  void forEachPair(Function&& visit, Index firstCell, Index lastCell) const;
+
 private:
   const std::array<int, 3> getBinIndex(const Vector3 &point) const;
+  bool neighborCell(const std::array<int, 3>& bin,
+                    const std::array<int, 3>& offset, Index& cell,
+                    Vector3& shift) const;
 protected:
   float m_maxDistance;
+  bool m_periodic;
   std::array<int, 3> m_binCount;
-  std::vector<std::vector<std::vector<std::vector<Index>>>> m_bins;
+  std::array<int, 3> m_binRange;
+  std::vector<Index> m_cellOffsets;
+  std::vector<Index> m_cellPoints;
+  std::vector<Vector3> m_cellPositions;
+  std::vector<std::array<int, 3>> m_halfShell;
+  Real m_binSize;
   Vector3 m_minPos;
   Vector3 m_maxPos;
+  Matrix3 m_cellMatrix;
+  Matrix3 m_fractionalMatrix;
 };
 
+inline bool NeighborPerceiver::neighborCell(const std::array<int, 3>& bin,
+                                            const std::array<int, 3>& offset,
+                                            Index& cell, Vector3& shift) const
+{
+  Vector3 image(0.0, 0.0, 0.0);
+  Index index = 0;
+  for (size_t c = 0; c < 3; c++) {
+    int i = bin[c] + offset[c];
+    if (i < 0 || i >= m_binCount[c]) {
+      if (!m_periodic)
+        return false;
+      int wrapped = ((i % m_binCount[c]) + m_binCount[c]) % m_binCount[c];
+      image[c] = (i - wrapped) / m_binCount[c];
+      i = wrapped;
+    }
+    index = index * m_binCount[c] + i;
+  }
+  cell = index;
+  shift = m_periodic ? Vector3(m_cellMatrix * image) : image;
+  return true;
+}
+
+template <typename Function>
+void NeighborPerceiver::forEachPair(Function&& visit) const
+{
+  forEachPair(visit, 0, cellCount());
+}
+
+template <typename Function>
+void NeighborPerceiver::forEachPair(Function&& visit, Index firstCell,
+                                    Index lastCell) const
+{
+  const Real cutoffSquared = Real(m_maxDistance) * m_maxDistance;
+  lastCell = std::min(lastCell, cellCount());
+  for (Index cell = firstCell; cell < lastCell; ++cell) {
+    const Index begin = m_cellOffsets[cell];
+    const Index end = m_cellOffsets[cell + 1];
+    if (begin == end)
+      continue;
+
+    for (Index a = begin; a < end; ++a) {
+      for (Index b = a + 1; b < end; ++b) {
+        Vector3 delta = m_cellPositions[b] - m_cellPositions[a];
+        if (delta.squaredNorm() < cutoffSquared)
+          visit(m_cellPoints[a], m_cellPoints[b], delta);
+      }
+    }
+
+    std::array<int, 3> bin;
+    bin[2] = static_cast<int>(cell % m_binCount[2]);
+    bin[1] = static_cast<int>((cell / m_binCount[2]) % m_binCount[1]);
+    bin[0] = static_cast<int>(cell / m_binCount[2] / m_binCount[1]);
+    for (const std::array<int, 3>& offset : m_halfShell) {
+      Index other;
+      Vector3 shift;
+      if (!neighborCell(bin, offset, other, shift))
+        continue;
+      const Index otherBegin = m_cellOffsets[other];
+      const Index otherEnd = m_cellOffsets[other + 1];
+      for (Index a = begin; a < end; ++a) {
+        Vector3 position = m_cellPositions[a] - shift;
+        for (Index b = otherBegin; b < otherEnd; ++b) {
+          Vector3 delta = m_cellPositions[b] - position;
+          if (delta.squaredNorm() < cutoffSquared && a != b)
+            visit(m_cellPoints[a], m_cellPoints[b], delta);
+        }
+      }
+    }
+  }
+}
+
 } // namespace Core
 } // namespace Avogadro
 
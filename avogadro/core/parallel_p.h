@@ -0,0 +1,86 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_PARALLEL_P_H
+#define AVOGADRO_CORE_PARALLEL_P_H
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+/**
+ * @return The number of threads the hardware runs at once, at least one.
+ */
+inline unsigned int threadCount()
+{
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+namespace detail {
+
+// Call f(worker, index) when f takes the worker, or f(index) otherwise.
+template <typename Function>
+auto callParallel(Function& f, unsigned int worker, int index, int)
+  -> decltype(f(worker, index), void())
+{
+  f(worker, index);
+}
+
+template <typename Function>
+auto callParallel(Function& f, unsigned int, int index, long)
+  -> decltype(f(index), void())
+{
+  f(index);
+}
+
+} // namespace detail
+
+/**
+ * Call @p f for each index from 0 to @p count - 1 on at most @p threads
+ * threads, the calling one included. Indices are handed out one at a time,
+ * so an index should stand for a sizable piece of work.
+ *
+ * @p f is called as f(index), or as f(worker, index) when it takes two
+ * arguments. The worker numbers the thread making the call, from 0 to the
+ * returned number of threads, so that it can pick per-thread scratch data.
+ * @return The number of threads used.
+ */
+template <typename Function>
+unsigned int parallelFor(unsigned int threads, int count, Function f)
+{
+  threads = std::min(std::max(threads, 1u),
+                     static_cast<unsigned int>(std::max(count, 1)));
+  std::atomic<int> next(0);
+  auto worker = [&](unsigned int id) {
+    for (int i = next++; i < count; i = next++)
+      detail::callParallel(f, id, i, 0);
+  };
+  std::vector<std::thread> pool;
+  for (unsigned int i = 1; i < threads; ++i)
+    pool.emplace_back(worker, i);
+  worker(0);
+  for (auto& thread : pool)
+    thread.join();
+  return threads;
+}
+
+/**
+ * Call @p f for each index from 0 to @p count - 1 on up to threadCount()
+ * threads, as parallelFor() above.
+ */
+template <typename Function>
+unsigned int parallelFor(int count, Function f)
+{
+  return parallelFor(threadCount(), count, f);
+}
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_PARALLEL_P_H
@@ -19,10 +19,7 @@
 #include "molecule.h"
 
 #include <algorithm>
-#include <cstring>
-#include <iterator>
-#include <limits>
-#include <set>
+#include <cstdint>
 #include <vector>
 
 namespace Avogadro {
@@ -30,471 +27,260 @@ namespace Core {
 
 namespace {
 
-// === DistanceMatrix ====================================================== //
-class DistanceMatrix
-{
-public:
-  // construction and destruction
-  DistanceMatrix(size_t size);
-  ~DistanceMatrix();
-
-  // operators
-  size_t operator()(size_t i, size_t j) const;
-  size_t& operator()(size_t i, size_t j);
-
-private:
-  size_t m_size;
-  size_t* m_values;
-};
-
-DistanceMatrix::DistanceMatrix(size_t size)
-{
-  m_size = size;
-  m_values = new size_t[size * size];
-  memset(m_values, 0, size * size * sizeof(size_t));
-}
-
-DistanceMatrix::~DistanceMatrix()
-{
-  delete[] m_values;
-}
-
-size_t DistanceMatrix::operator()(size_t i, size_t j) const
-{
-  return m_values[i * m_size + j];
-}
-
-size_t& DistanceMatrix::operator()(size_t i, size_t j)
-{
-  return m_values[i * m_size + j];
-}
-
-// === PidMatrix =========================================================== //
-// The PidMatrix class implements a path-included distance matrix.
-class PidMatrix
-{
-public:
-  // construction and destruction
-  PidMatrix(size_t size);
-  ~PidMatrix();
-
-  // paths
-  std::vector<std::vector<size_t>>& paths(size_t i, size_t j);
-  void addPaths(size_t i, size_t j,
-                const std::vector<std::vector<size_t>>& paths);
-  std::vector<std::vector<size_t>> splice(size_t i, size_t j, size_t k);
-
-  // operators
-  std::vector<std::vector<size_t>>& operator()(size_t i, size_t j);
-
-private:
-  size_t m_size;
-  std::vector<std::vector<size_t>>* m_values;
-};
-
-// --- Construction and Destruction ---------------------------------------- //
-PidMatrix::PidMatrix(size_t size)
-{
-  m_size = size;
-  m_values = new std::vector<std::vector<size_t>>[ size * size ];
-}
-
-PidMatrix::~PidMatrix()
-{
-  delete[] m_values;
-}
-
-// --- Paths --------------------------------------------------------------- //
-std::vector<std::vector<size_t>>& PidMatrix::paths(size_t i, size_t j)
-{
-  return m_values[i * m_size + j];
-}
-
-void PidMatrix::addPaths(size_t i, size_t j,
-                         const std::vector<std::vector<size_t>>& p)
-{
-  std::vector<std::vector<size_t>>& current = m_values[i * m_size + j];
-  current.insert(current.end(), p.begin(), p.end());
-}
-
-std::vector<std::vector<size_t>>& PidMatrix::operator()(size_t i, size_t j)
-{
-  return paths(i, j);
-}
+typedef std::vector<std::vector<size_t>> RingList;
+
+// Split the edges of the graph into its biconnected components with an
+// iterative Hopcroft-Tarjan depth first search. Every ring lies inside one of
+// them, bridges come out as components of a single edge.
+std::vector<std::vector<size_t>> biconnectedComponents(const Graph& graph)
+{
+  struct Frame
+  {
+    size_t vertex;
+    size_t parentEdge;
+    size_t next;
+  };
+
+  const size_t n = graph.size();
+  const size_t none = static_cast<size_t>(-1);
+  std::vector<size_t> order(n, none);
+  std::vector<size_t> low(n, 0);
+  std::vector<size_t> edgeStack;
+  std::vector<Frame> frames;
+  std::vector<std::vector<size_t>> components;
+  size_t time = 0;
+
+  for (size_t root = 0; root < n; ++root) {
+    if (order[root] != none || graph.degree(root) == 0)
+      continue;
+    order[root] = low[root] = time++;
+    frames.push_back({ root, none, 0 });
+    while (!frames.empty()) {
+      Frame& frame = frames.back();
+      const size_t v = frame.vertex;
+      const std::vector<size_t>& neighbors = graph.neighbors(v);
+      const std::vector<size_t>& edges = graph.edges(v);
+      if (frame.next < neighbors.size()) {
+        const size_t w = neighbors[frame.next];
+        const size_t edge = edges[frame.next];
+        ++frame.next;
+        if (edge == frame.parentEdge)
+          continue;
+        if (order[w] == none) {
+          edgeStack.push_back(edge);
+          order[w] = low[w] = time++;
+          frames.push_back({ w, edge, 0 });
+        } else if (order[w] < order[v]) {
+          edgeStack.push_back(edge);
+          low[v] = std::min(low[v], order[w]);
+        }
+        continue;
+      }
 
-std::vector<std::vector<size_t>> PidMatrix::splice(size_t i, size_t j, size_t k)
-{
-  std::vector<std::vector<size_t>> splicedPaths;
-
-  std::vector<std::vector<size_t>> ijPaths = paths(i, j);
-  std::vector<std::vector<size_t>> jkPaths = paths(j, k);
-
-  if (ijPaths.empty() && jkPaths.empty()) {
-    std::vector<size_t> path;
-    path.push_back(j);
-    splicedPaths.push_back(path);
-  } else if (ijPaths.empty()) {
-    for (std::vector<std::vector<size_t>>::iterator iter = jkPaths.begin();
-         iter != jkPaths.end(); ++iter) {
-      std::vector<size_t> path;
-      path.push_back(j);
-      path.insert(path.end(), iter->begin(), iter->end());
-      splicedPaths.push_back(path);
-    }
-  } else if (jkPaths.empty()) {
-    for (std::vector<std::vector<size_t>>::iterator iter = ijPaths.begin();
-         iter != ijPaths.end(); ++iter) {
-      std::vector<size_t> path = *iter;
-      path.push_back(j);
-      splicedPaths.push_back(path);
-    }
-  } else {
-    for (std::vector<std::vector<size_t>>::iterator ijIter = ijPaths.begin();
-         ijIter != ijPaths.end(); ++ijIter) {
-      for (std::vector<std::vector<size_t>>::iterator jkIter = jkPaths.begin();
-           jkIter != jkPaths.end(); ++jkIter) {
-        std::vector<size_t> path = *ijIter;
-        path.push_back(j);
-        path.insert(path.end(), jkIter->begin(), jkIter->end());
-        splicedPaths.push_back(path);
+      // all of v is explored, the edges above it close a component if no
+      // back edge from below reaches past its parent
+      const size_t parentEdge = frame.parentEdge;
+      frames.pop_back();
+      if (frames.empty())
+        break;
+      const size_t u = frames.back().vertex;
+      low[u] = std::min(low[u], low[v]);
+      if (low[v] >= order[u]) {
+        std::vector<size_t> component;
+        size_t edge;
+        do {
+          edge = edgeStack.back();
+          edgeStack.pop_back();
+          component.push_back(edge);
+        } while (edge != parentEdge);
+        components.push_back(component);
       }
     }
   }
 
-  return splicedPaths;
+  return components;
 }
 
-// === RingCandidate ======================================================= //
-class RingCandidate
-{
-public:
-  // construction and destruction
-  RingCandidate(size_t n, size_t s, size_t e);
-
-  // properties
-  size_t size() const;
-  size_t start() const;
-  size_t end() const;
-
-  // static methods
-  static bool compareSize(const RingCandidate& a, const RingCandidate& b);
-
-private:
-  size_t m_size;
-  size_t m_start;
-  size_t m_end;
-};
-
-// --- Construction and Destruction ---------------------------------------- //
-RingCandidate::RingCandidate(size_t n, size_t s, size_t e)
-{
-  m_size = n;
-  m_start = s;
-  m_end = e;
-}
-
-// --- Properties ---------------------------------------------------------- //
-size_t RingCandidate::size() const
-{
-  return m_size;
-}
-
-size_t RingCandidate::start() const
-{
-  return m_start;
-}
-
-size_t RingCandidate::end() const
-{
-  return m_end;
-}
-
-// --- Static Methods ------------------------------------------------------ //
-bool RingCandidate::compareSize(const RingCandidate& a, const RingCandidate& b)
-{
-  return a.size() < b.size();
-}
-
-// === Sssr ================================================================ //
-class Sssr
-{
-public:
-  // construction and destruction
-  Sssr();
-  ~Sssr();
-
-  // properties
-  size_t size() const;
-  bool isEmpty() const;
-
-  // rings
-  const std::vector<std::vector<size_t>>& rings() const;
-  void append(const std::vector<size_t>& ring);
-  bool isValid(const std::vector<size_t>& ring) const;
-  bool isUnique(const std::vector<size_t>& ring) const;
-
-private:
-  std::vector<std::vector<size_t>> m_rings;
-};
-
-// --- Construction and Destruction ---------------------------------------- //
-Sssr::Sssr()
-{
-}
-
-Sssr::~Sssr()
-{
-}
-
-// --- Properties ---------------------------------------------------------- //
-size_t Sssr::size() const
-{
-  return m_rings.size();
-}
-
-bool Sssr::isEmpty() const
-{
-  return m_rings.empty();
-}
-
-// --- Rings --------------------------------------------------------------- //
-const std::vector<std::vector<size_t>>& Sssr::rings() const
-{
-  return m_rings;
-}
-
-void Sssr::append(const std::vector<size_t>& ring)
-{
-  m_rings.push_back(ring);
-}
-
-bool Sssr::isValid(const std::vector<size_t>& ring) const
-{
-  // Check for any duplicate atoms.
-  for (size_t i = 0; i < ring.size(); ++i)
-    for (size_t j = i + 1; j < ring.size(); ++j)
-      if (ring[i] == ring[j])
-        return false;
-
-  return true;
-}
-
-bool Sssr::isUnique(const std::vector<size_t>& path) const
-{
-  // Must be unique if sssr is empty.
-  if (isEmpty())
-    return true;
-
-  // Check if a ring with the same atoms is already in the sssr.
-  std::set<size_t> pathSet;
-  pathSet.insert(path.begin(), path.end());
-
-  for (std::vector<std::vector<size_t>>::const_iterator iter = m_rings.begin();
-       iter != m_rings.end(); ++iter) {
-    const std::vector<size_t>& ring = *iter;
-
-    std::set<size_t> ringSet;
-    ringSet.insert(ring.begin(), ring.end());
-
-    std::vector<size_t> sortedRing(ring.begin(), ring.end());
-    std::sort(sortedRing.begin(), sortedRing.end());
-
-    std::set<size_t> intersection;
-    std::set_intersection(pathSet.begin(), pathSet.end(), ringSet.begin(),
-                          ringSet.end(),
-                          std::inserter(intersection, intersection.begin()));
-
-    if (intersection.size() == ring.size())
-      return false;
-  }
-
-  // Build the set of bonds in the path.
-  std::set<std::pair<size_t, size_t>> pathBonds;
-  for (size_t i = 0; i < path.size() - 1; i++) {
-    pathBonds.insert(std::make_pair(std::min(path[i], path[i + 1]),
-                                    std::max(path[i], path[i + 1])));
-  }
-
-  pathBonds.insert(std::make_pair(std::min(path.front(), path.back()),
-                                  std::max(path.front(), path.back())));
-
-  // Remove bonds from path bonds that are already in a smaller ring.
-  for (std::vector<std::vector<size_t>>::const_iterator iter = m_rings.begin();
-       iter != m_rings.end(); ++iter) {
-    const std::vector<size_t>& ring = *iter;
-
-    if (ring.size() >= path.size())
-      continue;
-
-    for (size_t i = 0; i < ring.size(); i++) {
-      pathBonds.erase(std::make_pair(std::min(ring[i], ring[i + 1]),
-                                     std::max(ring[i], ring[i + 1])));
-    }
-
-    pathBonds.erase(std::make_pair(std::min(ring.front(), ring.back()),
-                                   std::max(ring.front(), ring.back())));
-  }
-
-  // Check if any other ring contains the same bonds.
-  for (std::vector<std::vector<size_t>>::const_iterator iter = m_rings.begin();
-       iter != m_rings.end(); ++iter) {
-    const std::vector<size_t>& ring = *iter;
-
-    std::set<std::pair<size_t, size_t>> ringBonds;
-
-    // Add ring bonds.
-    for (size_t i = 0; i < ring.size() - 1; i++) {
-      ringBonds.insert(std::make_pair(std::min(ring[i], ring[i + 1]),
-                                      std::max(ring[i], ring[i + 1])));
+// Find a minimum cycle basis of one biconnected component, given as the
+// edges of the graph in it, and append its rings to @p rings.
+void perceiveComponentRings(const Graph& graph,
+                            const std::vector<size_t>& componentEdges,
+                            std::vector<size_t>& local, RingList& rings)
+{
+  // number the vertices and edges of the component from zero
+  std::vector<size_t> vertices;
+  std::vector<std::vector<std::pair<size_t, size_t>>> adjacency;
+  for (size_t e = 0; e < componentEdges.size(); ++e) {
+    const std::pair<size_t, size_t> ends =
+      graph.endpoints(componentEdges[e]);
+    size_t ab[2] = { ends.first, ends.second };
+    for (size_t& vertex : ab) {
+      if (local[vertex] == static_cast<size_t>(-1)) {
+        local[vertex] = vertices.size();
+        vertices.push_back(vertex);
+        adjacency.emplace_back();
+      }
+      vertex = local[vertex];
     }
-
-    // Add closure bond.
-    ringBonds.insert(std::make_pair(std::min(ring.front(), ring.back()),
-                                    std::max(ring.front(), ring.back())));
-
-    // Check intersection.
-    std::set<std::pair<size_t, size_t>> intersection;
-    std::set_intersection(pathBonds.begin(), pathBonds.end(), ringBonds.begin(),
-                          ringBonds.end(),
-                          std::inserter(intersection, intersection.begin()));
-
-    if (intersection.size() == pathBonds.size())
-      return false;
+    adjacency[ab[0]].push_back(std::make_pair(ab[1], e));
+    adjacency[ab[1]].push_back(std::make_pair(ab[0], e));
   }
 
-  return true;
-}
-
-std::vector<std::vector<size_t>> perceiveRings(const Graph& graph)
-{
-  size_t n = graph.size();
-
-  size_t ringCount = graph.vertexCount() - graph.edgeCount() + 1;
+  const size_t v = vertices.size();
+  const size_t e = componentEdges.size();
+  const size_t ringCount = e + 1 > v ? e + 1 - v : 0;
+  for (size_t vertex : vertices)
+    local[vertex] = static_cast<size_t>(-1);
   if (ringCount == 0)
-    return std::vector<std::vector<size_t>>();
-
-  // Algorithm 1 - create the distance and pid matrices.
-  DistanceMatrix D(n);
-  PidMatrix P(n);
-  PidMatrix Pt(n);
-
-  for (size_t i = 0; i < n; ++i) {
-    for (size_t j = 0; j < n; ++j) {
-      if (i == j)
-        D(i, j) = 0;
-      else if (graph.containsEdge(i, j))
-        D(i, j) = 1;
-      else
-        D(i, j) = std::numeric_limits<size_t>::max() / 2; // ~ infinity
-    }
+    return;
+
+  // a single ring: every vertex has two neighbors, walk around it
+  if (ringCount == 1) {
+    std::vector<size_t> ring;
+    size_t previous = static_cast<size_t>(-1);
+    size_t current = 0;
+    do {
+      ring.push_back(vertices[current]);
+      size_t next = adjacency[current][0].first;
+      if (next == previous)
+        next = adjacency[current][1].first;
+      previous = current;
+      current = next;
+    } while (current != 0);
+    rings.push_back(ring);
+    return;
   }
 
-  for (size_t k = 0; k < n; ++k) {
-    for (size_t i = 0; i < n; ++i) {
-      for (size_t j = 0; j < n; ++j) {
-        if (i == j || i == k || k == j)
+  // Horton's candidates: the ring through a root, along shortest paths to
+  // both ends of an edge. They are tried from the shortest up, so the search
+  // only needs to reach half the length of the current rings, and the
+  // independent ones are kept until the basis is complete. Independence is
+  // tested by Gaussian elimination of the edge sets over GF(2).
+  const size_t words = (e + 63) / 64;
+  std::vector<std::vector<uint64_t>> basis;
+  std::vector<size_t> pivots;
+  std::vector<size_t> distance(v, static_cast<size_t>(-1));
+  std::vector<size_t> parent(v);
+  std::vector<size_t> parentEdge(v);
+  std::vector<size_t> visited;
+  std::vector<size_t> mark(v, static_cast<size_t>(-1));
+  std::vector<uint64_t> edgeSet(words);
+  std::vector<size_t> path;
+
+  for (size_t length = 3; length <= v && basis.size() < ringCount; ++length) {
+    const size_t depth = length / 2;
+    for (size_t root = 0; root < v && basis.size() < ringCount; ++root) {
+      // breadth first search up to the depth needed for this length
+      distance[root] = 0;
+      parentEdge[root] = static_cast<size_t>(-1);
+      visited.assign(1, root);
+      for (size_t i = 0; i < visited.size(); ++i) {
+        const size_t x = visited[i];
+        if (distance[x] == depth)
           continue;
-
-        if (D(i, j) > D(i, k) + D(k, j)) {
-          if (D(i, j) == D(i, k) + D(k, j) + 1)
-            Pt(i, j) = P(i, j);
-          else
-            Pt(i, j).clear();
-
-          D(i, j) = D(i, k) + D(k, j);
-          P(i, j) = P.splice(i, k, j);
-        } else if (D(i, j) == D(i, k) + D(k, j)) {
-          P.addPaths(i, j, P.splice(i, k, j));
-        } else if (D(i, j) == D(i, k) + D(k, j) - 1) {
-          Pt.addPaths(i, j, P.splice(i, k, j));
+        for (const auto& neighbor : adjacency[x]) {
+          if (distance[neighbor.first] == static_cast<size_t>(-1)) {
+            distance[neighbor.first] = distance[x] + 1;
+            parent[neighbor.first] = x;
+            parentEdge[neighbor.first] = neighbor.second;
+            visited.push_back(neighbor.first);
+          }
         }
       }
-    }
-  }
-
-  // Algorithm 2 - create the ring candidate set.
-  std::vector<RingCandidate> candidates;
-  for (size_t i = 0; i < n; i++) {
-    for (size_t j = i + 1; j < n; j++) {
-      if (P(i, j).size() == 1 && Pt(i, j).size() == 0) {
-        continue;
-      } else {
-        size_t size;
-
-        if (P(i, j).size() > 1)
-          size = 2 * D(i, j);
-        else
-          size = 2 * D(i, j) + 1;
-
-        if (size > 2)
-          candidates.push_back(RingCandidate(size, i, j));
-      }
-    }
-  }
 
-  // Sort the candidates.
-  std::sort(candidates.begin(), candidates.end(), RingCandidate::compareSize);
-
-  // Algorithm 3 - find sssr from the ring candidate set.
-  Sssr sssr;
-
-  for (std::vector<RingCandidate>::iterator iter = candidates.begin();
-       iter != candidates.end(); ++iter) {
-    const RingCandidate& candidate = *iter;
-
-    // odd sized ring
-    if (candidate.size() & 1) {
-      for (size_t i = 0; i < Pt(candidate.start(), candidate.end()).size();
-           ++i) {
-        std::vector<size_t> ring;
-        ring.push_back(candidate.start());
-        std::vector<size_t>& path = Pt(candidate.start(), candidate.end())[i];
-        ring.insert(ring.end(), path.begin(), path.end());
-        ring.push_back(candidate.end());
-        if (!P(candidate.end(), candidate.start()).empty()) {
-          path = P(candidate.end(), candidate.start())[0];
-          ring.insert(ring.end(), path.begin(), path.end());
+      for (size_t x : visited) {
+        for (const auto& neighbor : adjacency[x]) {
+          const size_t y = neighbor.first;
+          const size_t edge = neighbor.second;
+          if (y < x || distance[y] == static_cast<size_t>(-1) ||
+              distance[x] + distance[y] + 1 != length ||
+              parentEdge[x] == edge || parentEdge[y] == edge) {
+            continue;
+          }
+
+          // the two paths to the root may only meet at the root
+          for (size_t a = x; a != root; a = parent[a])
+            mark[a] = root;
+          bool simple = true;
+          for (size_t b = y; b != root && simple; b = parent[b])
+            simple = mark[b] != root;
+          for (size_t a = x; a != root; a = parent[a])
+            mark[a] = static_cast<size_t>(-1);
+          if (!simple)
+            continue;
+
+          std::fill(edgeSet.begin(), edgeSet.end(), 0);
+          edgeSet[edge / 64] |= uint64_t(1) << (edge % 64);
+          for (size_t a = x; a != root; a = parent[a])
+            edgeSet[parentEdge[a] / 64] |= uint64_t(1) << (parentEdge[a] % 64);
+          for (size_t b = y; b != root; b = parent[b])
+            edgeSet[parentEdge[b] / 64] |= uint64_t(1) << (parentEdge[b] % 64);
+
+          // reduce by the basis, in the order it was built
+          std::vector<uint64_t> reduced(edgeSet);
+          for (size_t i = 0; i < basis.size(); ++i) {
+            if (reduced[pivots[i] / 64] & (uint64_t(1) << (pivots[i] % 64))) {
+              for (size_t w = 0; w < words; ++w)
+                reduced[w] ^= basis[i][w];
+            }
+          }
+          size_t pivot = 0;
+          while (pivot < words && reduced[pivot] == 0)
+            ++pivot;
+          if (pivot == words)
+            continue;
+          uint64_t bits = reduced[pivot];
+          pivot *= 64;
+          while (!(bits & 1)) {
+            bits >>= 1;
+            ++pivot;
+          }
+          basis.push_back(reduced);
+          pivots.push_back(pivot);
+
+          // the ring in order: root to x, then y back towards the root
+          path.clear();
+          for (size_t a = x; a != root; a = parent[a])
+            path.push_back(vertices[a]);
+          path.push_back(vertices[root]);
+          std::reverse(path.begin(), path.end());
+          for (size_t b = y; b != root; b = parent[b])
+            path.push_back(vertices[b]);
+          rings.push_back(path);
+          if (basis.size() == ringCount)
+            break;
         }
-
-        // Check if ring is valid and unique.
-        if (sssr.isValid(ring) && sssr.isUnique(ring)) {
-          sssr.append(ring);
+        if (basis.size() == ringCount)
           break;
-        }
       }
-    }
 
-    // Even sized ring.
-    else {
-      for (size_t i = 0; i < P(candidate.start(), candidate.end()).size() - 1;
-           ++i) {
-        std::vector<size_t> ring;
-        ring.push_back(candidate.start());
-        std::vector<size_t>& path = P(candidate.start(), candidate.end())[i];
-        ring.insert(ring.end(), path.begin(), path.end());
-        ring.push_back(candidate.end());
-        path = P(candidate.end(), candidate.start())[i + 1];
-        ring.insert(ring.end(), path.begin(), path.end());
-
-        // check if ring is valid and unique
-        if (sssr.isValid(ring) && sssr.isUnique(ring)) {
-          sssr.append(ring);
-          break;
-        }
-      }
+      for (size_t x : visited)
+        distance[x] = static_cast<size_t>(-1);
     }
+  }
+}
 
-    if (sssr.size() == ringCount)
-      break;
+RingList perceiveRings(const Graph& graph)
+{
+  RingList rings;
+  std::vector<size_t> local(graph.size(), static_cast<size_t>(-1));
+  for (const auto& component : biconnectedComponents(graph)) {
+    if (component.size() > 2)
+      perceiveComponentRings(graph, component, local, rings);
   }
 
-  return sssr.rings();
+  std::stable_sort(rings.begin(), rings.end(),
+                   [](const std::vector<size_t>& a,
+                      const std::vector<size_t>& b) {
+                     return a.size() < b.size();
+                   });
+  return rings;
 }
 
 } // end anonymous namespace
 
 RingPerceiver::RingPerceiver(const Molecule* m)
-  : m_ringsPerceived(false), m_molecule(m)
+  : m_ringsPerceived(false), m_revision(0), m_molecule(m)
 {
 }
 
@@ -515,11 +301,19 @@ const Molecule* RingPerceiver::molecule() const
 
 std::vector<std::vector<size_t>>& RingPerceiver::rings()
 {
+  // perceive again if the bonds changed since the last time
+  if (m_ringsPerceived && m_molecule &&
+      m_molecule->graph().revision() != m_revision) {
+    m_ringsPerceived = false;
+  }
+
   if (!m_ringsPerceived) {
-    if (m_molecule)
+    if (m_molecule) {
       m_rings = perceiveRings(m_molecule->graph());
-    else
+      m_revision = m_molecule->graph().revision();
+    } else {
       m_rings.clear();
+    }
 
     m_ringsPerceived = true;
   }
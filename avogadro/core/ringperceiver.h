@@ -27,6 +27,15 @@ namespace Core {
 
 class Molecule;
 
+/**
+ * @class RingPerceiver ringperceiver.h <avogadro/core/ringperceiver.h>
+ * @brief Finds the smallest set of smallest rings of a molecule.
+ *
+ * The molecule is split into ring systems, the biconnected components of its
+ * bonds, and a minimum cycle basis is found for each of them separately, so
+ * chains and bridges between rings cost no more than a linear search. The
+ * rings are kept until the bonds of the molecule change.
+ */
 class AVOGADROCORE_EXPORT RingPerceiver
 {
 public:
@@ -38,11 +47,13 @@ public:
   void setMolecule(const Molecule* m);
   const Molecule* molecule() const;
 
-  // ring perception
+  // ring perception, the rings are ordered by size and each lists its atoms
+  // in order around the ring
   std::vector<std::vector<size_t>>& rings();
 
 private:
   bool m_ringsPerceived;
+  size_t m_revision;
   const Molecule* m_molecule;
   std::vector<std::vector<size_t>> m_rings;
 };
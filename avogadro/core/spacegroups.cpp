@@ -4,12 +4,15 @@
 ******************************************************************************/
 
 #include <algorithm> // for std::count()
+#include <array>
 #include <cassert>
 #include <cctype> // for isdigit()
+#include <cmath>
 #include <iostream>
 
 #include "array.h"
 #include "crystaltools.h"
+#include "matrix.h"
 #include "molecule.h"
 #include "spacegroupdata.h"
 #include "unitcell.h"
@@ -229,34 +232,142 @@ Real readTransformCoordinate(const std::string& coordinate, const Vector3& v)
   return ret;
 }
 
-Vector3 getSingleTransform(const std::string& transform, const Vector3& v)
+namespace {
+
+// A symmetry operation on fractional coordinates, rotation * v + translation.
+struct SymmetryOperation
 {
-  Vector3 ret;
-  std::vector<std::string> coordinates = split(transform, ',');
+  Matrix3 rotation;
+  Vector3 translation;
+};
 
-  // This should be 3 in size. Something very bad happened if it is not.
-  assert(coordinates.size() == 3);
+typedef std::vector<SymmetryOperation> SymmetryOperations;
 
-  ret[0] = readTransformCoordinate(coordinates[0], v);
-  ret[1] = readTransformCoordinate(coordinates[1], v);
-  ret[2] = readTransformCoordinate(coordinates[2], v);
-  return ret;
+// The operations of every Hall setting, parsed from the transform strings
+// once on first use. Each coordinate of a transform is linear in x, y and z,
+// so evaluating it at the origin and the unit vectors gives its coefficients.
+const std::vector<SymmetryOperations>& symmetryOperations()
+{
+  static const std::vector<SymmetryOperations> table = []() {
+    std::vector<SymmetryOperations> operations(531);
+    for (unsigned short hall = 1; hall <= 530; ++hall) {
+      for (const std::string& transform :
+           split(space_group_transforms[hall], ' ')) {
+        std::vector<std::string> coordinates = split(transform, ',');
+        assert(coordinates.size() == 3);
+        SymmetryOperation operation;
+        for (int row = 0; row < 3; ++row) {
+          const std::string& coordinate = coordinates[row];
+          operation.translation[row] =
+            readTransformCoordinate(coordinate, Vector3::Zero());
+          for (int col = 0; col < 3; ++col) {
+            operation.rotation(row, col) =
+              readTransformCoordinate(coordinate, Vector3::Unit(col)) -
+              operation.translation[row];
+          }
+        }
+        operations[hall].push_back(operation);
+      }
+    }
+    return operations;
+  }();
+  return table;
 }
 
-Array<Vector3> SpaceGroups::getTransforms(unsigned short hallNumber,
-                                          const Vector3& v)
+const SymmetryOperations& symmetryOperations(unsigned short hallNumber)
 {
+  static const SymmetryOperations none;
   if (hallNumber == 0 || hallNumber > 530)
-    return Array<Vector3>();
+    return none;
+  return symmetryOperations()[hallNumber];
+}
 
-  Array<Vector3> ret;
+// Atoms hashed by their fractional coordinates wrapped into the unit cell.
+// The cells of the grid are at least the tolerance wide, so atoms within the
+// tolerance of a point, through any periodic image, are in the neighboring
+// cells of the point's cell.
+class PeriodicHash
+{
+public:
+  PeriodicHash(const UnitCell& unitCell, double tolerance, size_t atoms)
+  {
+    const Matrix3& cell = unitCell.cellMatrix();
+    const Real volume = std::fabs(cell.determinant());
+    // no more cells than atoms, however small the tolerance
+    const int maxCount =
+      std::max(1, static_cast<int>(std::ceil(std::cbrt(Real(atoms)))));
+    for (int c = 0; c < 3; ++c) {
+      Vector3 normal = cell.col((c + 1) % 3).cross(cell.col((c + 2) % 3));
+      Real width = volume / normal.norm();
+      Real count = tolerance > 0.0 ? std::floor(width / tolerance) : maxCount;
+      count = std::min(count, Real(maxCount));
+      m_count[c] = std::max(1, static_cast<int>(count));
+    }
+    m_cells.resize(m_count[0] * m_count[1] * m_count[2]);
+  }
+
+  void insert(Index atom, const Vector3& frac)
+  {
+    std::array<int, 3> bin = binIndex(frac);
+    m_cells[cellIndex(bin[0], bin[1], bin[2])].push_back(atom);
+  }
+
+  // Call f(atom) for the atoms around frac, stopping if it returns true.
+  template <typename Function>
+  bool any(const Vector3& frac, Function f) const
+  {
+    std::array<int, 3> bin = binIndex(frac);
+    std::array<Index, 27> cells;
+    size_t count = 0;
+    for (int x = -1; x <= 1; ++x)
+      for (int y = -1; y <= 1; ++y)
+        for (int z = -1; z <= 1; ++z)
+          cells[count++] = cellIndex(bin[0] + x, bin[1] + y, bin[2] + z);
+    // thin cells wrap around onto the same grid cells
+    std::sort(cells.begin(), cells.end());
+    count = std::unique(cells.begin(), cells.end()) - cells.begin();
+    for (size_t i = 0; i < count; ++i)
+      for (Index atom : m_cells[cells[i]])
+        if (f(atom))
+          return true;
+    return false;
+  }
+
+private:
+  std::array<int, 3> binIndex(const Vector3& frac) const
+  {
+    std::array<int, 3> bin;
+    for (int c = 0; c < 3; ++c) {
+      Real wrapped = frac[c] - std::floor(frac[c]);
+      bin[c] = std::min(m_count[c] - 1,
+                        std::max(0, static_cast<int>(wrapped * m_count[c])));
+    }
+    return bin;
+  }
+
+  Index cellIndex(int x, int y, int z) const
+  {
+    x = ((x % m_count[0]) + m_count[0]) % m_count[0];
+    y = ((y % m_count[1]) + m_count[1]) % m_count[1];
+    z = ((z % m_count[2]) + m_count[2]) % m_count[2];
+    return (Index(x) * m_count[1] + y) * m_count[2] + z;
+  }
+
+  std::array<int, 3> m_count;
+  std::vector<std::vector<Index>> m_cells;
+};
 
-  std::string transformsStr = transformsString(hallNumber);
-  // These transforms are separated by spaces
-  std::vector<std::string> transforms = split(transformsStr, ' ');
+} // namespace
 
-  for (Index i = 0; i < transforms.size(); ++i)
-    ret.push_back(getSingleTransform(transforms[i], v));
+Array<Vector3> SpaceGroups::getTransforms(unsigned short hallNumber,
+                                          const Vector3& v)
+{
+  const SymmetryOperations& operations = symmetryOperations(hallNumber);
+
+  Array<Vector3> ret;
+  ret.reserve(operations.size());
+  for (const SymmetryOperation& operation : operations)
+    ret.push_back(operation.rotation * v + operation.translation);
 
   return ret;
 }
@@ -266,44 +377,49 @@ void SpaceGroups::fillUnitCell(Molecule& mol, unsigned short hallNumber,
 {
   if (!mol.unitCell())
     return;
-  UnitCell* uc = mol.unitCell();
+  const UnitCell& uc = *mol.unitCell();
+  const SymmetryOperations& operations = symmetryOperations(hallNumber);
 
   Array<unsigned char> atomicNumbers = mol.atomicNumbers();
   Array<Vector3> positions = mol.atomPositions3d();
   Index numAtoms = mol.atomCount();
 
+  // Every atom, original or new, is hashed so that only the atoms near a
+  // candidate are compared with it.
+  PeriodicHash hash(uc, cartTol,
+                    numAtoms * std::max(size_t(1), operations.size()));
+  std::vector<Vector3> cartesian(positions.begin(), positions.end());
+  std::vector<unsigned char> numbers(atomicNumbers.begin(),
+                                     atomicNumbers.end());
+  for (Index i = 0; i < numAtoms; ++i)
+    hash.insert(i, uc.toFractional(positions[i]));
+
   // We are going to loop through the original atoms. That is why
   // we have numAtoms cached instead of using atomCount().
   for (Index i = 0; i < numAtoms; ++i) {
     unsigned char atomicNum = atomicNumbers[i];
-    Vector3 pos = uc->toFractional(positions[i]);
-
-    Array<Vector3> newAtoms = getTransforms(hallNumber, pos);
+    Vector3 pos = uc.toFractional(positions[i]);
 
     // We skip 0 because it is the original atom.
-    for (Index j = 1; j < newAtoms.size(); ++j) {
-      // The new atoms are in fractional coordinates. Convert to cartesian.
-      Vector3 newCandidate = uc->toCartesian(newAtoms[j]);
+    for (size_t j = 1; j < operations.size(); ++j) {
+      Vector3 frac = operations[j].rotation * pos + operations[j].translation;
+      Vector3 newCandidate = uc.toCartesian(frac);
 
       // If there is already an atom in this location within a
       // certain tolerance, do not add the atom.
-      bool atomAlreadyPresent = false;
-      for (Index k = 0; k < mol.atomCount(); k++) {
-        // If it does not have the same atomic number, skip over it.
-        if (mol.atomicNumber(k) != atomicNum)
-          continue;
-        Real distance = uc->distance(mol.atomPosition3d(k), newCandidate);
-        if (distance <= cartTol)
-          atomAlreadyPresent = true;
-      }
-
-      // If there is already an atom present here, just continue
+      bool atomAlreadyPresent = hash.any(frac, [&](Index k) {
+        return numbers[k] == atomicNum &&
+               uc.distance(cartesian[k], newCandidate) <= cartTol;
+      });
       if (atomAlreadyPresent)
         continue;
 
       // If we got this far, add the atom!
       Atom newAtom = mol.addAtom(atomicNum);
       newAtom.setPosition3d(newCandidate);
+      hash.insert(cartesian.size(), frac);
+      cartesian.push_back(newCandidate);
+      numbers.push_back(atomicNum);
     }
   }
   CrystalTools::wrapAtomsToUnitCell(mol);
@@ -315,41 +431,46 @@ void SpaceGroups::reduceToAsymmetricUnit(Molecule& mol,
 {
   if (!mol.unitCell())
     return;
-  UnitCell* uc = mol.unitCell();
-
-  // The number of atoms may change as we remove atoms, so don't cache
-  // the number of atoms, atomic positions, or atomic numbers
-  // There's no point in looking at the last atom
-  for (Index i = 0; i + 1 < mol.atomCount(); ++i) {
-    unsigned char atomicNum = mol.atomicNumber(i);
-    Vector3 pos = uc->toFractional(mol.atomPosition3d(i));
-    Array<Vector3> transformAtoms = getTransforms(hallNumber, pos);
-
-    // Loop through the rest of the atoms in this crystal and see if any match
-    // up with a transform
-    for (Index j = i + 1; j < mol.atomCount(); ++j) {
-      // If the atomic number does not match, skip over it
-      if (mol.atomicNumber(j) != atomicNum)
-        continue;
+  const UnitCell& uc = *mol.unitCell();
+  const SymmetryOperations& operations = symmetryOperations(hallNumber);
 
-      Vector3 trialPos = mol.atomPosition3d(j);
-      // Loop through the transform atoms
-      // We skip 0 because it is the original atom.
-      for (Index k = 1; k < transformAtoms.size(); ++k) {
-        // The transform atoms are in fractional coordinates. Convert to
-        // cartesian.
-        Vector3 transformPos = uc->toCartesian(transformAtoms[k]);
-        Real distance = uc->distance(trialPos, transformPos);
+  Array<unsigned char> atomicNumbers = mol.atomicNumbers();
+  Array<Vector3> positions = mol.atomPositions3d();
+  Index numAtoms = mol.atomCount();
+
+  PeriodicHash hash(uc, cartTol, numAtoms);
+  for (Index i = 0; i < numAtoms; ++i)
+    hash.insert(i, uc.toFractional(positions[i]));
+
+  // Keep the first atom of each set of equivalent atoms, marking the later
+  // atoms found at one of its transforms for removal
+  std::vector<bool> removed(numAtoms, false);
+  for (Index i = 0; i < numAtoms; ++i) {
+    if (removed[i])
+      continue;
+    unsigned char atomicNum = atomicNumbers[i];
+    Vector3 pos = uc.toFractional(positions[i]);
+
+    // We skip 0 because it is the original atom.
+    for (size_t k = 1; k < operations.size(); ++k) {
+      Vector3 frac = operations[k].rotation * pos + operations[k].translation;
+      Vector3 transformPos = uc.toCartesian(frac);
+      hash.any(frac, [&](Index j) {
         // Is the atom within the cartesian tolerance distance?
-        if (distance <= cartTol) {
-          // Remove this atom and adjust the index
-          mol.removeAtom(j);
-          --j;
-          break;
-        }
-      }
+        if (j > i && !removed[j] && atomicNumbers[j] == atomicNum &&
+            uc.distance(positions[j], transformPos) <= cartTol)
+          removed[j] = true;
+        return false;
+      });
     }
   }
+
+  // Remove the atoms from the last one, so the indices still to be removed
+  // are not moved
+  for (Index i = numAtoms; i > 0; --i) {
+    if (removed[i - 1])
+      mol.removeAtom(i - 1);
+  }
 }
 
 const char* SpaceGroups::transformsString(unsigned short hallNumber)
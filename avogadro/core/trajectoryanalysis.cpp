@@ -0,0 +1,245 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "trajectoryanalysis.h"
+
+#include "molecule.h"
+#include "parallel_p.h"
+
+#include <Eigen/SVD>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace Avogadro {
+namespace Core {
+
+namespace {
+
+Vector3 centroid(const Array<Vector3>& positions)
+{
+  Vector3 sum(Vector3::Zero());
+  for (const Vector3& position : positions)
+    sum += position;
+  return positions.empty() ? sum : Vector3(sum / positions.size());
+}
+
+// The positions of the analyzed atoms of a frame.
+struct FrameBuffer
+{
+  Array<Vector3> frame;
+  Array<Vector3> atoms;
+};
+
+// The sums over the frames handled by one thread, for the RMSF.
+struct Fluctuations
+{
+  std::vector<Vector3> sum;
+  std::vector<double> squaredSum;
+  int frames;
+};
+
+} // namespace
+
+TrajectoryAnalysis::TrajectoryAnalysis(const Molecule* molecule)
+  : m_molecule(molecule), m_referenceFrame(0), m_aligned(true)
+{
+}
+
+void TrajectoryAnalysis::setMolecule(const Molecule* molecule)
+{
+  m_molecule = molecule;
+}
+
+void TrajectoryAnalysis::setAtoms(const std::vector<Index>& atoms)
+{
+  m_atoms = atoms;
+}
+
+void TrajectoryAnalysis::setReferenceFrame(int frame)
+{
+  m_referenceFrame = frame;
+}
+
+void TrajectoryAnalysis::setAligned(bool aligned)
+{
+  m_aligned = aligned;
+}
+
+void TrajectoryAnalysis::setProgressFunction(const ProgressFunction& progress)
+{
+  m_progress = progress;
+}
+
+bool TrajectoryAnalysis::compute()
+{
+  m_rmsd.clear();
+  m_radiusOfGyration.clear();
+  m_rmsf.clear();
+  if (!m_molecule)
+    return false;
+
+  const Molecule& molecule = *m_molecule;
+  const int sets = molecule.coordinate3dCount();
+  const int frames = std::max(sets, 1);
+  const Index atomCount = molecule.atomCount();
+  const Index count = m_atoms.empty() ? atomCount : m_atoms.size();
+  for (Index atom : m_atoms) {
+    if (atom >= atomCount)
+      return false;
+  }
+
+  // read a frame and pick the analyzed atoms out of it
+  auto readFrame = [&](int index, FrameBuffer& buffer) {
+    if (sets == 0) {
+      const Array<Vector3>& positions = molecule.atomPositions3d();
+      buffer.frame.assign(positions.begin(), positions.end());
+    } else if (!molecule.coordinate3d(index, buffer.frame)) {
+      return false;
+    }
+    if (buffer.frame.size() != atomCount)
+      return false;
+    if (m_atoms.empty()) {
+      buffer.atoms.swap(buffer.frame);
+    } else {
+      buffer.atoms.resize(count);
+      for (Index i = 0; i < count; ++i)
+        buffer.atoms[i] = buffer.frame[m_atoms[i]];
+    }
+    return true;
+  };
+
+  FrameBuffer referenceBuffer;
+  if (m_referenceFrame < 0 || m_referenceFrame >= frames ||
+      !readFrame(m_referenceFrame, referenceBuffer)) {
+    return false;
+  }
+  const Array<Vector3> reference = referenceBuffer.atoms;
+
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  m_rmsd.assign(frames, nan);
+  m_radiusOfGyration.assign(frames, nan);
+
+  const unsigned int maxThreads = threadCount();
+  std::vector<FrameBuffer> buffers(maxThreads);
+  std::vector<Fluctuations> fluctuations(maxThreads);
+  for (Fluctuations& sums : fluctuations) {
+    sums.sum.assign(count, Vector3::Zero());
+    sums.squaredSum.assign(count, 0.0);
+    sums.frames = 0;
+  }
+
+  std::atomic<int> done(0);
+  std::atomic<bool> canceled(false);
+  const unsigned int threads = parallelFor(frames, [&](unsigned int worker,
+                                                       int index) {
+    if (canceled)
+      return;
+    FrameBuffer& buffer = buffers[worker];
+    if (readFrame(index, buffer)) {
+      Array<Vector3>& positions = buffer.atoms;
+      m_radiusOfGyration[index] = radiusOfGyration(positions);
+
+      // the deviations from the reference, after superposition if wanted
+      Matrix3 rotation(Matrix3::Identity());
+      Vector3 translation(Vector3::Zero());
+      if (m_aligned)
+        superpose(reference, positions, rotation, translation);
+      Fluctuations& sums = fluctuations[worker];
+      double squared = 0.0;
+      for (Index i = 0; i < count; ++i) {
+        const Vector3 deviation =
+          rotation * positions[i] + translation - reference[i];
+        sums.sum[i] += deviation;
+        sums.squaredSum[i] += deviation.squaredNorm();
+        squared += deviation.squaredNorm();
+      }
+      ++sums.frames;
+      m_rmsd[index] = count > 0 ? std::sqrt(squared / count) : 0.0;
+    }
+    if (m_progress && !m_progress(++done, frames))
+      canceled = true;
+  });
+  if (canceled) {
+    m_rmsd.clear();
+    m_radiusOfGyration.clear();
+    return false;
+  }
+
+  // the fluctuations about the mean deviation, which is the fluctuation
+  // about the mean position
+  Fluctuations& total = fluctuations[0];
+  for (unsigned int t = 1; t < threads; ++t) {
+    for (Index i = 0; i < count; ++i) {
+      total.sum[i] += fluctuations[t].sum[i];
+      total.squaredSum[i] += fluctuations[t].squaredSum[i];
+    }
+    total.frames += fluctuations[t].frames;
+  }
+  m_rmsf.assign(count, 0.0);
+  if (total.frames > 0) {
+    for (Index i = 0; i < count; ++i) {
+      const Vector3 mean = total.sum[i] / total.frames;
+      const double variance =
+        total.squaredSum[i] / total.frames - mean.squaredNorm();
+      m_rmsf[i] = std::sqrt(std::max(0.0, variance));
+    }
+  }
+  return true;
+}
+
+double TrajectoryAnalysis::superpose(const Array<Vector3>& reference,
+                                     const Array<Vector3>& positions,
+                                     Matrix3& rotation, Vector3& translation)
+{
+  rotation.setIdentity();
+  translation.setZero();
+  const size_t count = std::min(reference.size(), positions.size());
+  if (count == 0 || reference.size() != positions.size())
+    return 0.0;
+
+  // the covariance of the centered points
+  const Vector3 referenceCenter = centroid(reference);
+  const Vector3 center = centroid(positions);
+  Matrix3 covariance(Matrix3::Zero());
+  for (size_t i = 0; i < count; ++i) {
+    covariance +=
+      (positions[i] - center) * (reference[i] - referenceCenter).transpose();
+  }
+
+  // the rotation from its singular vectors, flipping the smallest axis if
+  // the best fit would otherwise be a reflection
+  Eigen::JacobiSVD<Matrix3> svd(covariance,
+                                Eigen::ComputeFullU | Eigen::ComputeFullV);
+  Matrix3 u = svd.matrixU();
+  const Matrix3& v = svd.matrixV();
+  if ((v * u.transpose()).determinant() < 0.0)
+    u.col(2) = -u.col(2);
+  rotation = v * u.transpose();
+  translation = referenceCenter - rotation * center;
+
+  double squared = 0.0;
+  for (size_t i = 0; i < count; ++i)
+    squared += (rotation * positions[i] + translation - reference[i])
+                 .squaredNorm();
+  return std::sqrt(squared / count);
+}
+
+double TrajectoryAnalysis::radiusOfGyration(const Array<Vector3>& positions)
+{
+  if (positions.empty())
+    return 0.0;
+
+  const Vector3 center = centroid(positions);
+  double squared = 0.0;
+  for (const Vector3& position : positions)
+    squared += (position - center).squaredNorm();
+  return std::sqrt(squared / positions.size());
+}
+
+} // namespace Core
+} // namespace Avogadro
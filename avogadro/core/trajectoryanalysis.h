@@ -0,0 +1,131 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_TRAJECTORYANALYSIS_H
+#define AVOGADRO_CORE_TRAJECTORYANALYSIS_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "matrix.h"
+#include "vector.h"
+
+#include <functional>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+class Molecule;
+
+/**
+ * @class TrajectoryAnalysis trajectoryanalysis.h
+ * <avogadro/core/trajectoryanalysis.h>
+ * @brief Computes the RMSD, RMSF and radius of gyration over the frames of a
+ * trajectory.
+ *
+ * Every frame of the molecule's coordinate sets, or its trajectory provider,
+ * is superposed onto a reference frame with the Kabsch algorithm before the
+ * deviations are measured. The frames are read into buffers of their own and
+ * processed in parallel, so the current coordinates of the molecule are left
+ * alone; the molecule must not be modified while compute() runs. All
+ * quantities are unweighted, every atom counts the same.
+ */
+class AVOGADROCORE_EXPORT TrajectoryAnalysis
+{
+public:
+  /**
+   * Called with the number of frames processed so far and the total number
+   * of frames, from whichever thread finished the frame. Returning false
+   * cancels the analysis.
+   */
+  typedef std::function<bool(int, int)> ProgressFunction;
+
+  explicit TrajectoryAnalysis(const Molecule* molecule = nullptr);
+
+  void setMolecule(const Molecule* molecule);
+  const Molecule* molecule() const { return m_molecule; }
+
+  /**
+   * Only analyze the atoms with these indices, or all atoms if empty, the
+   * default. The RMSF is reported for these atoms, in this order.
+   */
+  void setAtoms(const std::vector<Index>& atoms);
+  const std::vector<Index>& atoms() const { return m_atoms; }
+
+  /** The frame the others are superposed onto, 0 by default. */
+  void setReferenceFrame(int frame);
+  int referenceFrame() const { return m_referenceFrame; }
+
+  /**
+   * Superpose the frames onto the reference, the default, or only compare
+   * them as they are if false.
+   */
+  void setAligned(bool aligned);
+  bool aligned() const { return m_aligned; }
+
+  /** Set the function called as the frames are processed. */
+  void setProgressFunction(const ProgressFunction& progress);
+
+  /**
+   * Analyze all frames. A molecule without coordinate sets is analyzed as a
+   * single frame of its current positions.
+   * @return False if there is no molecule, the reference frame could not be
+   * read or the progress function cancelled the analysis.
+   */
+  bool compute();
+
+  /** @return The number of frames analyzed by the last compute(). */
+  int frameCount() const { return static_cast<int>(m_rmsd.size()); }
+
+  /**
+   * @return The RMSD of each frame from the reference frame, after
+   * superposition. Frames that could not be read, or have a different number
+   * of atoms, are NaN.
+   */
+  const std::vector<double>& rmsd() const { return m_rmsd; }
+
+  /** @return The radius of gyration of each frame, NaN like the RMSD. */
+  const std::vector<double>& radiusOfGyration() const
+  {
+    return m_radiusOfGyration;
+  }
+
+  /**
+   * @return The root mean square fluctuation of each analyzed atom about its
+   * mean position in the superposed frames.
+   */
+  const std::vector<double>& rmsf() const { return m_rmsf; }
+
+  /**
+   * Find the rotation and translation that best superpose @p positions onto
+   * @p reference in the least squares sense, using the Kabsch algorithm.
+   * Both must have the same number of points. The superposed positions are
+   * rotation * p + translation.
+   * @return The RMSD after superposition.
+   */
+  static double superpose(const Array<Vector3>& reference,
+                          const Array<Vector3>& positions, Matrix3& rotation,
+                          Vector3& translation);
+
+  /** @return The radius of gyration of @p positions. */
+  static double radiusOfGyration(const Array<Vector3>& positions);
+
+private:
+  const Molecule* m_molecule;
+  std::vector<Index> m_atoms;
+  int m_referenceFrame;
+  bool m_aligned;
+  ProgressFunction m_progress;
+
+  std::vector<double> m_rmsd;
+  std::vector<double> m_radiusOfGyration;
+  std::vector<double> m_rmsf;
+};
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_TRAJECTORYANALYSIS_H
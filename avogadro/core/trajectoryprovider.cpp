@@ -0,0 +1,72 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "trajectoryprovider.h"
+
+#include <mutex>
+
+namespace Avogadro {
+namespace Core {
+
+TrajectoryProvider::TrajectoryProvider(size_t cacheSize)
+  : m_cacheSize(cacheSize)
+{
+}
+
+TrajectoryProvider::~TrajectoryProvider() {}
+
+bool TrajectoryProvider::frame(int index, Array<Vector3>& positions)
+{
+  if (index < 0 || index >= frameCount())
+    return false;
+
+  std::lock_guard<Mutex> locker(m_mutex);
+  auto cached = m_cacheIndex.find(index);
+  if (cached != m_cacheIndex.end()) {
+    m_cache.splice(m_cache.begin(), m_cache, cached->second);
+    const Array<Vector3>& cachedPositions = cached->second->second;
+    positions.assign(cachedPositions.begin(), cachedPositions.end());
+    return true;
+  }
+
+  Array<Vector3> framePositions;
+  if (!readFrame(index, framePositions))
+    return false;
+  // a copy, as the reference counts of shared arrays are not atomic and the
+  // positions may be released in another thread
+  positions.assign(framePositions.begin(), framePositions.end());
+
+  if (m_cacheSize > 0) {
+    m_cache.push_front(std::make_pair(index, framePositions));
+    m_cacheIndex[index] = m_cache.begin();
+    trimCache();
+  }
+  return true;
+}
+
+void TrajectoryProvider::setCacheSize(size_t frames)
+{
+  std::lock_guard<Mutex> locker(m_mutex);
+  m_cacheSize = frames;
+  trimCache();
+}
+
+void TrajectoryProvider::clearCache()
+{
+  std::lock_guard<Mutex> locker(m_mutex);
+  m_cache.clear();
+  m_cacheIndex.clear();
+}
+
+void TrajectoryProvider::trimCache()
+{
+  while (m_cache.size() > m_cacheSize) {
+    m_cacheIndex.erase(m_cache.back().first);
+    m_cache.pop_back();
+  }
+}
+
+} // End Core namespace
+} // End Avogadro namespace
@@ -0,0 +1,85 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_TRAJECTORYPROVIDER_H
+#define AVOGADRO_CORE_TRAJECTORYPROVIDER_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "mutex.h"
+#include "vector.h"
+
+#include <list>
+#include <map>
+#include <utility>
+
+namespace Avogadro {
+namespace Core {
+
+/**
+ * @class TrajectoryProvider trajectoryprovider.h
+ * <avogadro/core/trajectoryprovider.h>
+ * @brief Supplies the frames of a trajectory on demand.
+ *
+ * Rather than holding every frame of a long trajectory in memory, a Molecule
+ * can be given a provider that reads the frame coordinates when they are
+ * requested, typically by seeking to the frame in the file. The most recently
+ * used frames are kept in a bounded cache, so stepping back and forth over a
+ * few frames does not hit the file again. Providers are shared between copies
+ * of a molecule, and frame() may be called from several threads.
+ */
+class AVOGADROCORE_EXPORT TrajectoryProvider
+{
+public:
+  /**
+   * @brief Create a provider caching up to @p cacheSize frames.
+   */
+  explicit TrajectoryProvider(size_t cacheSize = 32);
+  virtual ~TrajectoryProvider();
+
+  /** @return The number of frames in the trajectory. */
+  virtual int frameCount() const = 0;
+
+  /**
+   * @brief Get the atom positions of a frame.
+   * @param index The index of the frame.
+   * @param positions Set to the positions of the frame.
+   * @return True on success, false if the frame could not be read.
+   */
+  bool frame(int index, Array<Vector3>& positions);
+
+  /**
+   * @brief Set the number of frames kept in the cache, 0 disables caching.
+   */
+  void setCacheSize(size_t frames);
+  size_t cacheSize() const { return m_cacheSize; }
+
+  /** @brief Drop all cached frames. */
+  void clearCache();
+
+protected:
+  /**
+   * @brief Read the positions of a frame, called for frames not in the cache.
+   * Calls are serialized, so implementations do not need to lock.
+   */
+  virtual bool readFrame(int index, Array<Vector3>& positions) = 0;
+
+private:
+  typedef std::list<std::pair<int, Array<Vector3>>> FrameList;
+
+  void trimCache();
+
+  Mutex m_mutex;
+  size_t m_cacheSize;
+  // Most recently used frames first, with their positions in the list.
+  FrameList m_cache;
+  std::map<int, FrameList::iterator> m_cacheIndex;
+};
+
+} // End Core namespace
+} // End Avogadro namespace
+
+#endif // AVOGADRO_CORE_TRAJECTORYPROVIDER_H
@@ -17,13 +17,89 @@
 #ifndef AVOGADRO_CORE_UTILITIES_H
 #define AVOGADRO_CORE_UTILITIES_H
 
+#include <cstring>
+#include <locale>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <charconv>
+#include <string_view>
+#define AVOGADRO_HAS_STD_STRING_VIEW
+#endif
+
 namespace Avogadro {
 namespace Core {
 
+#ifdef AVOGADRO_HAS_STD_STRING_VIEW
+typedef std::string_view StringView;
+#else
+/**
+ * @brief A minimal stand in for std::string_view when building as C++11.
+ */
+class StringView
+{
+public:
+  typedef const char* const_iterator;
+  static const size_t npos = static_cast<size_t>(-1);
+
+  StringView() : m_data(nullptr), m_size(0) {}
+  StringView(const char* string) : m_data(string), m_size(std::strlen(string))
+  {
+  }
+  StringView(const char* string, size_t size) : m_data(string), m_size(size)
+  {
+  }
+  StringView(const std::string& string)
+    : m_data(string.data()), m_size(string.size())
+  {
+  }
+
+  const char* data() const { return m_data; }
+  size_t size() const { return m_size; }
+  size_t length() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  const char& operator[](size_t i) const { return m_data[i]; }
+  const_iterator begin() const { return m_data; }
+  const_iterator end() const { return m_data + m_size; }
+
+  void remove_prefix(size_t n)
+  {
+    m_data += n;
+    m_size -= n;
+  }
+  void remove_suffix(size_t n) { m_size -= n; }
+
+  StringView substr(size_t pos, size_t n = npos) const
+  {
+    if (pos > m_size)
+      throw std::out_of_range("StringView::substr");
+    return StringView(m_data + pos, n < m_size - pos ? n : m_size - pos);
+  }
+
+  operator std::string() const { return std::string(m_data, m_size); }
+
+  friend bool operator==(StringView a, StringView b)
+  {
+    return a.m_size == b.m_size &&
+           (a.m_size == 0 || std::memcmp(a.m_data, b.m_data, a.m_size) == 0);
+  }
+  friend bool operator!=(StringView a, StringView b) { return !(a == b); }
+  friend std::ostream& operator<<(std::ostream& out, StringView string)
+  {
+    return out.write(string.m_data,
+                     static_cast<std::streamsize>(string.m_size));
+  }
+
+private:
+  const char* m_data;
+  size_t m_size;
+};
+#endif
+
 /**
  * @brief Split the supplied @p string by the @p delimiter.
  * @param string The string to be split up.
@@ -45,6 +121,59 @@ inline std::vector<std::string> split(const std::string& string, char delimiter,
   return elements;
 }
 
+/**
+ * @brief True for the whitespace characters that trimmed() removes.
+ */
+inline bool isSpace(char c)
+{
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/**
+ * @brief Split the supplied @p string by the @p delimiter without copying.
+ *
+ * The items are views into @p string, which must outlive them. @p tokens is
+ * cleared first, readers reuse one vector for every line so that splitting a
+ * line does not allocate.
+ * @param string The string to be split up.
+ * @param delimiter The delimiter to split the string by.
+ * @param tokens Set to the items.
+ * @param skipEmpty If true any empty items will be skipped.
+ */
+inline void split(StringView string, char delimiter,
+                  std::vector<StringView>& tokens, bool skipEmpty = true)
+{
+  tokens.clear();
+  size_t start = 0;
+  for (size_t i = 0; i < string.size(); ++i) {
+    if (string[i] != delimiter)
+      continue;
+    if (!skipEmpty || i > start)
+      tokens.push_back(string.substr(start, i - start));
+    start = i + 1;
+  }
+  // Like std::getline, a trailing delimiter does not add an empty item
+  if (start < string.size())
+    tokens.push_back(string.substr(start));
+}
+
+/**
+ * @brief Remove the next whitespace separated token from @p string.
+ * @return The token, or an empty view if there are no tokens left.
+ */
+inline StringView nextToken(StringView& string)
+{
+  size_t i = 0;
+  while (i < string.size() && isSpace(string[i]))
+    ++i;
+  size_t start = i;
+  while (i < string.size() && !isSpace(string[i]))
+    ++i;
+  StringView token = string.substr(start, i - start);
+  string.remove_prefix(i);
+  return token;
+}
+
 /**
  * @brief Search the input string for the search string.
  * @param input String to be examined.
@@ -81,15 +210,88 @@ inline std::string trimmed(const std::string& input)
   return input.substr(start, end - start + 1);
 }
 
+/**
+ * @brief Parse the number at the start of @p string.
+ *
+ * Leading whitespace is skipped and anything after the number is ignored, as
+ * with stream extraction, but the number is always read in the C locale and
+ * nothing is allocated. Numbers out of the range of T fail, as do negative
+ * numbers if T is unsigned.
+ * @return False if @p string does not start with a number of type T.
+ */
+template <typename T>
+bool parseNumber(StringView string, T& value)
+{
+  static_assert(std::is_arithmetic<T>::value, "Only numbers can be parsed");
+  const char* first = string.data();
+  const char* last = first + string.size();
+  while (first != last && isSpace(*first))
+    ++first;
+  // Streams accept an explicit plus sign, from_chars does not
+  if (first != last && *first == '+') {
+    ++first;
+    if (first != last && *first == '-')
+      return false;
+  }
+  // Streams would wrap negative numbers around for unsigned types
+  if (std::is_unsigned<T>::value && first != last && *first == '-')
+    return false;
+
+#if defined(AVOGADRO_HAS_STD_STRING_VIEW) && defined(__cpp_lib_to_chars)
+  std::from_chars_result result = std::from_chars(first, last, value);
+  return result.ec == std::errc() && result.ptr != first;
+#else
+  std::istringstream stream(std::string(first, last));
+  stream.imbue(std::locale::classic());
+  stream >> value;
+  return !stream.fail();
+#endif
+}
+
+namespace internal {
+
+template <typename T>
+struct IsParsedNumber
+  : std::integral_constant<bool, std::is_floating_point<T>::value ||
+                                   (std::is_integral<T>::value &&
+                                    sizeof(T) > 1)>
+{
+};
+
+template <typename T>
+bool castString(StringView string, T& value, std::true_type)
+{
+  return parseNumber(string, value);
+}
+
+// Like stream extraction, a string is the first whitespace separated word
+inline bool castString(StringView string, std::string& value, std::false_type)
+{
+  StringView token = nextToken(string);
+  value.assign(token.data(), token.size());
+  return !token.empty();
+}
+
+// Characters and anything else still go through a stream
+template <typename T>
+bool castString(StringView string, T& value, std::false_type)
+{
+  std::istringstream stream{ std::string(string.data(), string.size()) };
+  stream >> value;
+  return !stream.fail();
+}
+
+} // namespace internal
+
 /**
  * @brief Cast the inputString to the specified type.
  * @param inputString String to cast to the specified type.
  */
 template <typename T>
-T lexicalCast(const std::string& inputString)
+T lexicalCast(StringView inputString)
 {
-  T value;
-  std::istringstream(inputString) >> value;
+  T value = T();
+  internal::castString(inputString, value, internal::IsParsedNumber<T>());
   return value;
 }
 
@@ -98,14 +300,15 @@ T lexicalCast(const std::string& inputString)
  * @param inputString String to cast to the specified type.
  * @param ok Set to true on success, and false if the string could not be
  * converted to the specified type.
+ * @note Unlike stream extraction, numbers out of the range of the type fail,
+ * and so do negative numbers for unsigned types. Parse values that may be
+ * negative as signed.
  */
 template <typename T>
-T lexicalCast(const std::string& inputString, bool& ok)
+T lexicalCast(StringView inputString, bool& ok)
 {
-  T value;
-  std::istringstream stream(inputString);
-  stream >> value;
-  ok = !stream.fail();
+  T value = T();
+  ok = internal::castString(inputString, value, internal::IsParsedNumber<T>());
   return value;
 }
 
@@ -46,26 +46,162 @@ using Core::Variant;
 
 CjsonFormat::CjsonFormat() = default;
 
+CjsonFormat::CjsonFormat(bool binary) : m_binary(binary) {}
+
 CjsonFormat::~CjsonFormat() = default;
 
-bool setJsonKey(json& j, Molecule& m, const std::string& key)
+namespace {
+
+// The key of the objects standing in for packed arrays of numbers.
+const char* const columnKey = "@column";
+
+// Reserved for arrays of known size, larger ones grow as they are read.
+const std::size_t maxReserved = 1 << 24;
+
+// Builds the document like json::parse() from JSON text or MessagePack,
+// except that arrays holding only numbers are packed into columns of doubles
+// and replaced by an object with their index under columnKey. Large arrays of
+// coordinates, cube values or coefficients then take eight bytes a value and
+// are handed to the molecule without going through a json value each.
+class CjsonReader : public json::json_sax_t
 {
-  if (j.count(key) && j.find(key)->is_string()) {
-    m.setData(key, j.value(key, "undefined"));
+public:
+  json root;
+  std::vector<std::vector<double>> columns;
+  std::string error;
+
+  // @return The numbers of @p j if it is a non-empty packed array of numbers,
+  // otherwise null.
+  std::vector<double>* numbers(const json& j)
+  {
+    if (!j.is_object() || j.size() != 1)
+      return nullptr;
+    auto column = j.find(columnKey);
+    if (column == j.end() || !column->is_number_unsigned() ||
+        column->get<size_t>() >= columns.size()) {
+      return nullptr;
+    }
+    return &columns[column->get<size_t>()];
+  }
+
+  bool null() override { return value(json()); }
+  bool boolean(bool b) override { return value(json(b)); }
+  bool number_integer(number_integer_t n) override
+  {
+    return number(static_cast<double>(n)) || value(json(n));
+  }
+  bool number_unsigned(number_unsigned_t n) override
+  {
+    return number(static_cast<double>(n)) || value(json(n));
+  }
+  bool number_float(number_float_t n, const string_t&) override
+  {
+    return number(n) || value(json(n));
+  }
+  bool string(string_t& s) override { return value(json(std::move(s))); }
+
+  bool start_object(std::size_t) override
+  {
+    m_stack.push_back(Level{ insert(json::object()), false });
+    return true;
+  }
+  bool key(string_t& k) override
+  {
+    m_key = std::move(k);
+    return true;
+  }
+  bool end_object() override
+  {
+    m_stack.pop_back();
     return true;
   }
-  return false;
-}
 
-bool isNumericArray(json& j)
-{
-  if (j.is_array() && j.size() > 0) {
-    for (unsigned int i = 0; i < j.size(); ++i) {
-      json v = j[i];
-      if (!v.is_number()) {
-        return false;
-      }
+  bool start_array(std::size_t elements) override
+  {
+    // Packed until something other than a number turns up.
+    m_stack.push_back(Level{ insert(json::array()), true });
+    m_packed.push_back(std::vector<double>());
+    if (elements != std::size_t(-1))
+      m_packed.back().reserve(std::min(elements, maxReserved));
+    return true;
+  }
+  bool end_array() override
+  {
+    Level level = m_stack.back();
+    m_stack.pop_back();
+    if (level.packed && !m_packed.back().empty()) {
+      *level.value = json::object();
+      (*level.value)[columnKey] = columns.size();
+      columns.push_back(std::move(m_packed.back()));
     }
+    m_packed.pop_back();
+    return true;
+  }
+
+  bool parse_error(std::size_t, const std::string& message,
+                   const nlohmann::detail::exception&) override
+  {
+    error = message;
+    return false;
+  }
+
+private:
+  struct Level
+  {
+    json* value;
+    bool packed;
+  };
+
+  // Append to the array being packed, false if there is none.
+  bool number(double n)
+  {
+    if (m_stack.empty() || !m_stack.back().packed)
+      return false;
+    m_packed.back().push_back(n);
+    return true;
+  }
+
+  bool value(json&& j)
+  {
+    insert(std::move(j));
+    return true;
+  }
+
+  // Add a value to the innermost array or object, unpacking an array that
+  // turns out to hold more than numbers.
+  json* insert(json&& j)
+  {
+    if (m_stack.empty()) {
+      root = std::move(j);
+      return &root;
+    }
+    Level& level = m_stack.back();
+    if (level.value->is_object()) {
+      json& member = (*level.value)[m_key];
+      member = std::move(j);
+      return &member;
+    }
+    if (level.packed) {
+      for (double n : m_packed.back())
+        level.value->push_back(n);
+      m_packed.back().clear();
+      level.packed = false;
+    }
+    level.value->push_back(std::move(j));
+    return &level.value->back();
+  }
+
+  std::vector<Level> m_stack;
+  std::vector<std::vector<double>> m_packed;
+  std::string m_key;
+};
+
+} // namespace
+
+bool setJsonKey(json& j, Molecule& m, const std::string& key)
+{
+  if (j.count(key) && j.find(key)->is_string()) {
+    m.setData(key, j.value(key, "undefined"));
     return true;
   }
   return false;
@@ -87,11 +223,19 @@ bool isBooleanArray(json& j)
 
 bool CjsonFormat::read(std::istream& file, Molecule& molecule)
 {
-  json jsonRoot = json::parse(file, nullptr, false);
-  if (jsonRoot.is_discarded()) {
-    appendError("Error parsing JSON.");
+  // MessagePack documents start with a map, JSON text with a brace.
+  file >> std::ws;
+  const int first = file.peek();
+  const bool binary = (first & 0xf0) == 0x80 || first == 0xde || first == 0xdf;
+
+  CjsonReader reader;
+  if (!json::sax_parse(file, &reader,
+                       binary ? json::input_format_t::msgpack
+                              : json::input_format_t::json)) {
+    appendError("Error parsing JSON: " + reader.error);
     return false;
   }
+  json& jsonRoot = reader.root;
 
   if (!jsonRoot.is_object()) {
     appendError("Error: Input is not a JSON object.");
@@ -115,18 +259,18 @@ bool CjsonFormat::read(std::istream& file, Molecule& molecule)
   setJsonKey(jsonRoot, molecule, "formula");
 
   // Read in the atoms.
-  json atoms = jsonRoot["atoms"];
+  json& atoms = jsonRoot["atoms"];
   if (!atoms.is_object()) {
     appendError("The 'atoms' key does not contain an object.");
     return false;
   }
 
-  json atomicNumbers = atoms["elements"]["number"];
+  auto atomicNumbers = reader.numbers(atoms["elements"]["number"]);
   // This represents our minimal spec for a molecule - atoms that have an
   // atomic number.
-  if (isNumericArray(atomicNumbers) && atomicNumbers.size() > 0) {
-    for (unsigned int i = 0; i < atomicNumbers.size(); ++i)
-      molecule.addAtom(atomicNumbers[i]);
+  if (atomicNumbers) {
+    for (double number : *atomicNumbers)
+      molecule.addAtom(static_cast<unsigned char>(number));
   } else {
     appendError("Malformed array for in atoms.elements.number");
     return false;
@@ -134,18 +278,19 @@ bool CjsonFormat::read(std::istream& file, Molecule& molecule)
   Index atomCount = molecule.atomCount();
 
   // 3d coordinates if available for our atoms
-  json atomicCoords = atoms["coords"]["3d"];
-  if (isNumericArray(atomicCoords) && atomicCoords.size() == 3 * atomCount) {
+  auto atomicCoords = reader.numbers(atoms["coords"]["3d"]);
+  if (atomicCoords && atomicCoords->size() == 3 * atomCount) {
+    const vector<double>& coords = *atomicCoords;
     for (Index i = 0; i < atomCount; ++i) {
       auto a = molecule.atom(i);
-      a.setPosition3d(Vector3(atomicCoords[3 * i], atomicCoords[3 * i + 1],
-                              atomicCoords[3 * i + 2]));
+      a.setPosition3d(
+        Vector3(coords[3 * i], coords[3 * i + 1], coords[3 * i + 2]));
     }
   }
 
   // todo? 2d position
   // labels
-  json labels = atoms["labels"];
+  json& labels = atoms["labels"];
   if (labels.is_array() && labels.size() == atomCount) {
     for (size_t i = 0; i < atomCount; ++i) {
       molecule.atom(i).setLabel(labels[i]);
@@ -153,23 +298,25 @@ bool CjsonFormat::read(std::istream& file, Molecule& molecule)
   }
 
   // formal charges
-  json formalCharges = atoms["formalCharges"];
-  if (formalCharges.is_array() && formalCharges.size() == atomCount) {
+  auto formalCharges = reader.numbers(atoms["formalCharges"]);
+  if (formalCharges && formalCharges->size() == atomCount) {
     for (size_t i = 0; i < atomCount; ++i) {
-      molecule.atom(i).setFormalCharge(formalCharges[i]);
+      molecule.atom(i).setFormalCharge(
+        static_cast<signed char>((*formalCharges)[i]));
     }
   }
 
   // Check for coordinate sets, and read them in if found, e.g. trajectories.
-  json coordSets = atoms["coords"]["3dSets"];
+  json& coordSets = atoms["coords"]["3dSets"];
   if (coordSets.is_array() && coordSets.size()) {
     for (unsigned int i = 0; i < coordSets.size(); ++i) {
       Array<Vector3> setArray;
-      json set = coordSets[i];
-      if (isNumericArray(set)) {
-        for (unsigned int j = 0; j < set.size() / 3; ++j) {
+      auto set = reader.numbers(coordSets[i]);
+      if (set) {
+        const vector<double>& coords = *set;
+        for (unsigned int j = 0; j < coords.size() / 3; ++j) {
           setArray.push_back(
-            Vector3(set[3 * j], set[3 * j + 1], set[3 * j + 2]));
+            Vector3(coords[3 * j], coords[3 * j + 1], coords[3 * j + 2]));
         }
         molecule.setCoordinate3d(setArray, i);
       }
@@ -179,57 +326,63 @@ bool CjsonFormat::read(std::istream& file, Molecule& molecule)
   }
 
   // Read in colors if they are present.
-  json colors = atoms["colors"];
-  if (colors.is_array() && colors.size() == 3 * atomCount) {
+  auto colors = reader.numbers(atoms["colors"]);
+  if (colors && colors->size() == 3 * atomCount) {
     for (Index i = 0; i < atomCount; ++i) {
-      Vector3ub color(colors[3 * i], colors[3 * i + 1], colors[3 * i + 2]);
+      Vector3ub color(static_cast<unsigned char>((*colors)[3 * i]),
+                      static_cast<unsigned char>((*colors)[3 * i + 1]),
+                      static_cast<unsigned char>((*colors)[3 * i + 2]));
       molecule.setColor(i, color);
     }
   }
 
   // Selection is optional, but if present should be loaded.
-  json selection = atoms["selected"];
+  json& selection = atoms["selected"];
+  auto selectionNumbers = reader.numbers(selection);
   if (isBooleanArray(selection) && selection.size() == atomCount)
     for (Index i = 0; i < atomCount; ++i)
       molecule.setAtomSelected(i, selection[i]);
-  else if (isNumericArray(selection) && selection.size() == atomCount)
+  else if (selectionNumbers && selectionNumbers->size() == atomCount)
     for (Index i = 0; i < atomCount; ++i)
-      molecule.setAtomSelected(i, selection[i] != 0);
+      molecule.setAtomSelected(i, (*selectionNumbers)[i] != 0);
   if (atoms.find("layer") != atoms.end()) {
-    json layerJson = atoms["layer"];
-    if (isNumericArray(layerJson)) {
+    auto layerJson = reader.numbers(atoms["layer"]);
+    if (layerJson) {
       auto& layer = LayerManager::getMoleculeInfo(&molecule)->layer;
-      for (Index i = 0; i < atomCount; ++i) {
-        while (layerJson[i] > layer.maxLayer()) {
+      for (Index i = 0; i < atomCount && i < layerJson->size(); ++i) {
+        const size_t id = static_cast<size_t>((*layerJson)[i]);
+        while (id > layer.maxLayer()) {
           layer.addLayer();
         }
-        layer.addAtom(layerJson[i], i);
+        layer.addAtom(id, i);
       }
     }
   }
 
   // Bonds are optional, but if present should be loaded.
-  json bonds = jsonRoot["bonds"];
-  if (bonds.is_object() && isNumericArray(bonds["connections"]["index"])) {
-    json connections = bonds["connections"]["index"];
-    for (unsigned int i = 0; i < connections.size() / 2; ++i) {
-      molecule.addBond(static_cast<Index>(connections[2 * i]),
-                       static_cast<Index>(connections[2 * i + 1]), 1);
-    }
-    json order = bonds["order"];
-    if (isNumericArray(order)) {
-      for (unsigned int i = 0; i < molecule.bondCount() && i < order.size();
+  json& bonds = jsonRoot["bonds"];
+  auto connections = bonds.is_object()
+                       ? reader.numbers(bonds["connections"]["index"])
+                       : nullptr;
+  if (connections) {
+    for (unsigned int i = 0; i < connections->size() / 2; ++i) {
+      molecule.addBond(static_cast<Index>((*connections)[2 * i]),
+                       static_cast<Index>((*connections)[2 * i + 1]), 1);
+    }
+    auto order = reader.numbers(bonds["order"]);
+    if (order) {
+      for (unsigned int i = 0; i < molecule.bondCount() && i < order->size();
            ++i) {
-        molecule.bond(i).setOrder(static_cast<int>(order[i]));
+        molecule.bond(i).setOrder(static_cast<int>((*order)[i]));
       }
     }
   }
 
   // residues are optional, but should be loaded
-  json residues = jsonRoot["residues"];
+  json& residues = jsonRoot["residues"];
   if (residues.is_array()) {
     for (unsigned int i = 0; i < residues.size(); ++i) {
-      json residue = residues[i];
+      json& residue = residues[i];
       if (!residue.is_object())
         continue; // malformed
 
@@ -238,7 +391,7 @@ bool CjsonFormat::read(std::istream& file, Molecule& molecule)
       auto chainId = residue["chainId"].get<char>();
       Residue newResidue(name, id, chainId);
 
-      json hetero = residue["hetero"];
+      json& hetero = residue["hetero"];
       if (hetero == true)
         newResidue.setHeterogen(true);
 
@@ -247,7 +400,7 @@ bool CjsonFormat::read(std::istream& file, Molecule& molecule)
         newResidue.setSecondaryStructure(
           static_cast<Avogadro::Core::Residue::SecondaryStructure>(secStruct));
 
-      json atomsResidue = residue["atoms"];
+      json& atomsResidue = residue["atoms"];
       if (atomsResidue.is_object()) {
         for (auto& item : atomsResidue.items()) {
           if (item.value() < molecule.atomCount()) {
@@ -256,9 +409,11 @@ bool CjsonFormat::read(std::istream& file, Molecule& molecule)
           }
         }
       }
-      json color = residue["color"];
-      if (color.is_array() && color.size() == 3) {
-        Vector3ub col = Vector3ub(color[0], color[1], color[2]);
+      auto color = reader.numbers(residue["color"]);
+      if (color && color->size() == 3) {
+        Vector3ub col = Vector3ub(static_cast<unsigned char>((*color)[0]),
+                                  static_cast<unsigned char>((*color)[1]),
+                                  static_cast<unsigned char>((*color)[2]));
         newResidue.setColor(col);
       }
 
@@ -266,67 +421,72 @@ bool CjsonFormat::read(std::istream& file, Molecule& molecule)
     }
   }
 
-  json unitCell = jsonRoot["unitCell"];
-  if (!unitCell.is_object())
-    unitCell = jsonRoot["unit cell"];
+  json* unitCell = &jsonRoot["unitCell"];
+  if (!unitCell->is_object())
+    unitCell = &jsonRoot["unit cell"];
 
-  if (unitCell.is_object()) {
+  if (unitCell->is_object()) {
+    json& cell = *unitCell;
     Core::UnitCell* unitCellObject = nullptr;
 
     // read in cell vectors in preference to a, b, c parameters
-    json cellVectors = unitCell["cellVectors"];
-    if (cellVectors.is_array() && cellVectors.size() == 9 &&
-        isNumericArray(cellVectors)) {
-      Vector3 aVector(cellVectors[0], cellVectors[1], cellVectors[2]);
-      Vector3 bVector(cellVectors[3], cellVectors[4], cellVectors[5]);
-      Vector3 cVector(cellVectors[6], cellVectors[7], cellVectors[8]);
+    auto cellVectors = reader.numbers(cell["cellVectors"]);
+    if (cellVectors && cellVectors->size() == 9) {
+      const vector<double>& v = *cellVectors;
+      Vector3 aVector(v[0], v[1], v[2]);
+      Vector3 bVector(v[3], v[4], v[5]);
+      Vector3 cVector(v[6], v[7], v[8]);
       unitCellObject = new Core::UnitCell(aVector, bVector, cVector);
-    } else if (unitCell["a"].is_number() && unitCell["b"].is_number() &&
-               unitCell["c"].is_number() && unitCell["alpha"].is_number() &&
-               unitCell["beta"].is_number() && unitCell["gamma"].is_number()) {
-      Real a = static_cast<Real>(unitCell["a"]);
-      Real b = static_cast<Real>(unitCell["b"]);
-      Real c = static_cast<Real>(unitCell["c"]);
-      Real alpha = static_cast<Real>(unitCell["alpha"]) * DEG_TO_RAD;
-      Real beta = static_cast<Real>(unitCell["beta"]) * DEG_TO_RAD;
-      Real gamma = static_cast<Real>(unitCell["gamma"]) * DEG_TO_RAD;
+    } else if (cell["a"].is_number() && cell["b"].is_number() &&
+               cell["c"].is_number() && cell["alpha"].is_number() &&
+               cell["beta"].is_number() && cell["gamma"].is_number()) {
+      Real a = static_cast<Real>(cell["a"]);
+      Real b = static_cast<Real>(cell["b"]);
+      Real c = static_cast<Real>(cell["c"]);
+      Real alpha = static_cast<Real>(cell["alpha"]) * DEG_TO_RAD;
+      Real beta = static_cast<Real>(cell["beta"]) * DEG_TO_RAD;
+      Real gamma = static_cast<Real>(cell["gamma"]) * DEG_TO_RAD;
       unitCellObject = new Core::UnitCell(a, b, c, alpha, beta, gamma);
     }
     if (unitCellObject != nullptr)
       molecule.setUnitCell(unitCellObject);
   }
 
-  json fractional = atoms["coords"]["3dFractional"];
-  if (!fractional.is_array())
-    fractional = atoms["coords"]["3d fractional"];
-  if (fractional.is_array() && fractional.size() == 3 * atomCount &&
-      isNumericArray(fractional) && molecule.unitCell()) {
+  auto fractional = reader.numbers(atoms["coords"]["3dFractional"]);
+  if (!fractional)
+    fractional = reader.numbers(atoms["coords"]["3d fractional"]);
+  if (fractional && fractional->size() == 3 * atomCount &&
+      molecule.unitCell()) {
+    const vector<double>& f = *fractional;
     Array<Vector3> fcoords;
     fcoords.reserve(atomCount);
-    for (Index i = 0; i < atomCount; ++i) {
-      fcoords.push_back(Vector3(static_cast<Real>(fractional[i * 3 + 0]),
-                                static_cast<Real>(fractional[i * 3 + 1]),
-                                static_cast<Real>(fractional[i * 3 + 2])));
-    }
+    for (Index i = 0; i < atomCount; ++i)
+      fcoords.push_back(Vector3(f[i * 3 + 0], f[i * 3 + 1], f[i * 3 + 2]));
     CrystalTools::setFractionalCoordinates(molecule, fcoords);
   }
 
   // Basis set is optional, if present read it in.
-  json basisSet = jsonRoot["basisSet"];
+  json& basisSet = jsonRoot["basisSet"];
   if (basisSet.is_object()) {
     GaussianSet* basis = new GaussianSet;
     basis->setMolecule(&molecule);
     // Gather the relevant pieces together so that they can be read in.
-    json shellTypes = basisSet["shellTypes"];
-    json primitivesPerShell = basisSet["primitivesPerShell"];
-    json shellToAtomMap = basisSet["shellToAtomMap"];
-    json exponents = basisSet["exponents"];
-    json coefficients = basisSet["coefficients"];
-
-    int nGTO = 0;
-    for (unsigned int i = 0; i < shellTypes.size(); ++i) {
+    auto shellTypes = reader.numbers(basisSet["shellTypes"]);
+    auto primitivesPerShell = reader.numbers(basisSet["primitivesPerShell"]);
+    auto shellToAtomMap = reader.numbers(basisSet["shellToAtomMap"]);
+    auto exponents = reader.numbers(basisSet["exponents"]);
+    auto coefficients = reader.numbers(basisSet["coefficients"]);
+
+    size_t nGTO = 0;
+    const size_t shellCount =
+      shellTypes && primitivesPerShell && shellToAtomMap && exponents &&
+          coefficients
+        ? std::min({ shellTypes->size(), primitivesPerShell->size(),
+                     shellToAtomMap->size() })
+        : 0;
+    for (size_t i = 0; i < shellCount; ++i) {
       GaussianSet::orbital type;
-      switch (static_cast<int>(shellTypes[i])) {
+      switch (static_cast<int>((*shellTypes)[i])) {
         case 0:
           type = GaussianSet::S;
           break;
@@ -345,82 +505,64 @@ bool CjsonFormat::read(std::istream& file, Molecule& molecule)
           type = GaussianSet::UU;
       }
       if (type != GaussianSet::UU) {
-        int b = basis->addBasis(static_cast<int>(shellToAtomMap[i]), type);
-        for (int j = 0; j < static_cast<int>(primitivesPerShell[i]); ++j) {
-          basis->addGto(b, coefficients[nGTO], exponents[nGTO]);
+        int b = basis->addBasis(static_cast<int>((*shellToAtomMap)[i]), type);
+        const int primitives = static_cast<int>((*primitivesPerShell)[i]);
+        for (int j = 0; j < primitives && nGTO < exponents->size() &&
+                        nGTO < coefficients->size();
+             ++j) {
+          basis->addGto(b, (*coefficients)[nGTO], (*exponents)[nGTO]);
           ++nGTO;
         }
       }
     }
 
-    json orbitals = jsonRoot["orbitals"];
+    json& orbitals = jsonRoot["orbitals"];
     if (orbitals.is_object() && basis->isValid()) {
       basis->setElectronCount(orbitals["electronCount"]);
-      json occupations = orbitals["occupations"];
-      if (isNumericArray(occupations)) {
+      auto occupations = reader.numbers(orbitals["occupations"]);
+      if (occupations) {
         std::vector<unsigned char> occs;
-        for (unsigned int i = 0; i < occupations.size(); ++i)
-          occs.push_back(static_cast<unsigned char>(occupations[i]));
-        basis->setMolecularOrbitalOccupancy(occupations);
-      }
-      json energies = orbitals["energies"];
-      if (isNumericArray(energies)) {
-        std::vector<double> energyArray;
-        for (unsigned int i = 0; i < energies.size(); ++i)
-          energyArray.push_back(static_cast<double>(energies[i]));
-        basis->setMolecularOrbitalEnergy(energyArray);
+        for (double occupation : *occupations)
+          occs.push_back(static_cast<unsigned char>(occupation));
+        basis->setMolecularOrbitalOccupancy(occs);
       }
-      json numbers = orbitals["numbers"];
-      if (isNumericArray(numbers)) {
+      auto energies = reader.numbers(orbitals["energies"]);
+      if (energies)
+        basis->setMolecularOrbitalEnergy(*energies);
+      auto numbers = reader.numbers(orbitals["numbers"]);
+      if (numbers) {
         std::vector<unsigned int> numArray;
-        for (unsigned int i = 0; i < numbers.size(); ++i)
-          numArray.push_back(static_cast<unsigned int>(numbers[i]));
+        for (double number : *numbers)
+          numArray.push_back(static_cast<unsigned int>(number));
         basis->setMolecularOrbitalNumber(numArray);
       }
-      json moCoefficients = orbitals["moCoefficients"];
-      json moCoefficientsA = orbitals["alphaCoefficients"];
-      json moCoefficientsB = orbitals["betaCoefficients"];
-      if (isNumericArray(moCoefficients)) {
-        std::vector<double> coeffs;
-        for (unsigned int i = 0; i < moCoefficients.size(); ++i)
-          coeffs.push_back(static_cast<double>(moCoefficients[i]));
-        basis->setMolecularOrbitals(coeffs);
-      } else if (isNumericArray(moCoefficientsA) &&
-                 isNumericArray(moCoefficientsB)) {
-        std::vector<double> coeffsA;
-        for (unsigned int i = 0; i < moCoefficientsA.size(); ++i)
-          coeffsA.push_back(static_cast<double>(moCoefficientsA[i]));
-        std::vector<double> coeffsB;
-        for (unsigned int i = 0; i < moCoefficientsB.size(); ++i)
-          coeffsB.push_back(static_cast<double>(moCoefficientsB[i]));
-        basis->setMolecularOrbitals(coeffsA, BasisSet::Alpha);
-        basis->setMolecularOrbitals(coeffsB, BasisSet::Beta);
+      auto moCoefficients = reader.numbers(orbitals["moCoefficients"]);
+      auto moCoefficientsA = reader.numbers(orbitals["alphaCoefficients"]);
+      auto moCoefficientsB = reader.numbers(orbitals["betaCoefficients"]);
+      if (moCoefficients) {
+        basis->setMolecularOrbitals(*moCoefficients);
+      } else if (moCoefficientsA && moCoefficientsB) {
+        basis->setMolecularOrbitals(*moCoefficientsA, BasisSet::Alpha);
+        basis->setMolecularOrbitals(*moCoefficientsB, BasisSet::Beta);
       } else {
         std::cout << "No orbital cofficients found!" << std::endl;
       }
       // Check for orbital coefficient sets, these are paired with coordinates
       // when they exist, but have constant basis set, atom types, etc.
-      if (orbitals["sets"].is_array() && orbitals["sets"].size()) {
-        json orbSets = orbitals["sets"];
+      json& orbSets = orbitals["sets"];
+      if (orbSets.is_array() && orbSets.size()) {
         for (unsigned int idx = 0; idx < orbSets.size(); ++idx) {
-          moCoefficients = orbSets[idx]["moCoefficients"];
-          moCoefficientsA = orbSets[idx]["alphaCoefficients"];
-          moCoefficientsB = orbSets[idx]["betaCoefficients"];
-          if (isNumericArray(moCoefficients)) {
-            std::vector<double> coeffs;
-            for (unsigned int i = 0; i < moCoefficients.size(); ++i)
-              coeffs.push_back(static_cast<double>(moCoefficients[i]));
-            basis->setMolecularOrbitals(coeffs, BasisSet::Paired, idx);
-          } else if (isNumericArray(moCoefficientsA) &&
-                     isNumericArray(moCoefficientsB)) {
-            std::vector<double> coeffsA;
-            for (unsigned int i = 0; i < moCoefficientsA.size(); ++i)
-              coeffsA.push_back(static_cast<double>(moCoefficientsA[i]));
-            std::vector<double> coeffsB;
-            for (unsigned int i = 0; i < moCoefficientsB.size(); ++i)
-              coeffsB.push_back(static_cast<double>(moCoefficientsB[i]));
-            basis->setMolecularOrbitals(coeffsA, BasisSet::Alpha, idx);
-            basis->setMolecularOrbitals(coeffsB, BasisSet::Beta, idx);
+          moCoefficients = reader.numbers(orbSets[idx]["moCoefficients"]);
+          moCoefficientsA = reader.numbers(orbSets[idx]["alphaCoefficients"]);
+          moCoefficientsB = reader.numbers(orbSets[idx]["betaCoefficients"]);
+          if (moCoefficients) {
+            basis->setMolecularOrbitals(*moCoefficients, BasisSet::Paired,
+                                        idx);
+          } else if (moCoefficientsA && moCoefficientsB) {
+            basis->setMolecularOrbitals(*moCoefficientsA, BasisSet::Alpha,
+                                        idx);
+            basis->setMolecularOrbitals(*moCoefficientsB, BasisSet::Beta,
+                                        idx);
           }
         }
         // Set the first step as active.
@@ -430,36 +572,53 @@ bool CjsonFormat::read(std::istream& file, Molecule& molecule)
     molecule.setBasisSet(basis);
   }
 
+  // A cube is optional, its values are moved in without a copy.
+  json& cube = jsonRoot["cube"];
+  if (cube.is_object()) {
+    auto origin = reader.numbers(cube["origin"]);
+    auto spacing = reader.numbers(cube["spacing"]);
+    auto dimensions = reader.numbers(cube["dimensions"]);
+    auto scalars = reader.numbers(cube["scalars"]);
+    if (origin && origin->size() == 3 && spacing && spacing->size() == 3 &&
+        dimensions && dimensions->size() == 3 && scalars) {
+      const Vector3i dims(static_cast<int>((*dimensions)[0]),
+                          static_cast<int>((*dimensions)[1]),
+                          static_cast<int>((*dimensions)[2]));
+      if (scalars->size() == static_cast<size_t>(dims.prod())) {
+        Cube* newCube = molecule.addCube();
+        const vector<double>& o = *origin;
+        const vector<double>& s = *spacing;
+        newCube->setLimits(Vector3(o[0], o[1], o[2]), dims,
+                           Vector3(s[0], s[1], s[2]));
+        newCube->data()->swap(*scalars);
+      }
+    }
+  }
+
   // See if there is any vibration data, load it if so.
-  json vibrations = jsonRoot["vibrations"];
+  json& vibrations = jsonRoot["vibrations"];
   if (vibrations.is_object()) {
-    json frequencies = vibrations["frequencies"];
-    if (isNumericArray(frequencies)) {
-      Array<double> freqs;
-      for (unsigned int i = 0; i < frequencies.size(); ++i) {
-        freqs.push_back(static_cast<double>(frequencies[i]));
-      }
-      molecule.setVibrationFrequencies(freqs);
+    auto frequencies = reader.numbers(vibrations["frequencies"]);
+    if (frequencies) {
+      molecule.setVibrationFrequencies(
+        Array<double>(frequencies->begin(), frequencies->end()));
     }
-    json intensities = vibrations["intensities"];
-    if (isNumericArray(intensities)) {
-      Array<double> intens;
-      for (unsigned int i = 0; i < intensities.size(); ++i) {
-        intens.push_back(static_cast<double>(intensities[i]));
-      }
-      molecule.setVibrationIntensities(intens);
+    auto intensities = reader.numbers(vibrations["intensities"]);
+    if (intensities) {
+      molecule.setVibrationIntensities(
+        Array<double>(intensities->begin(), intensities->end()));
     }
-    json displacements = vibrations["eigenVectors"];
+    json& displacements = vibrations["eigenVectors"];
     if (displacements.is_array()) {
       Array<Array<Vector3>> disps;
       for (unsigned int i = 0; i < displacements.size(); ++i) {
-        json arr = displacements[i];
-        if (isNumericArray(arr)) {
+        auto arr = reader.numbers(displacements[i]);
+        if (arr) {
           Array<Vector3> mode;
-          mode.resize(arr.size() / 3);
-          double* ptr = &mode[0][0];
-          for (unsigned int j = 0; j < arr.size(); ++j) {
-            *(ptr++) = static_cast<double>(arr[j]);
+          mode.resize(arr->size() / 3);
+          for (size_t j = 0; j < mode.size(); ++j) {
+            mode[j] =
+              Vector3((*arr)[3 * j], (*arr)[3 * j + 1], (*arr)[3 * j + 2]);
           }
           disps.push_back(mode);
         }
@@ -470,20 +629,20 @@ bool CjsonFormat::read(std::istream& file, Molecule& molecule)
 
   if (jsonRoot.find("layer") != jsonRoot.end()) {
     auto names = LayerManager::getMoleculeInfo(&molecule);
-    json visible = jsonRoot["layer"]["visible"];
+    json& visible = jsonRoot["layer"]["visible"];
     if (isBooleanArray(visible)) {
       for (const auto& v : visible) {
         names->visible.push_back(v);
       }
     }
-    json locked = jsonRoot["layer"]["locked"];
+    json& locked = jsonRoot["layer"]["locked"];
     if (isBooleanArray(locked)) {
       for (const auto& l : locked) {
         names->locked.push_back(l);
       }
     }
 
-    json enables = jsonRoot["layer"]["enable"];
+    json& enables = jsonRoot["layer"]["enable"];
     for (const auto& enable : enables.items()) {
       names->enable[enable.key()] = std::vector<bool>();
       for (const auto& e : enable.value()) {
@@ -491,7 +650,7 @@ bool CjsonFormat::read(std::istream& file, Molecule& molecule)
       }
     }
 
-    json settings = jsonRoot["layer"]["settings"];
+    json& settings = jsonRoot["layer"]["settings"];
     for (const auto& setting : settings.items()) {
       names->settings[setting.key()] = Core::Array<LayerData*>();
       for (const auto& s : setting.value()) {
@@ -612,16 +771,13 @@ bool CjsonFormat::write(std::ostream& file, const Molecule& molecule)
     // when we have just one (paired), or two (alpha and beta) to write.
     auto moMatrix = gaussian->moMatrix();
     auto betaMatrix = gaussian->moMatrix(BasisSet::Beta);
-    json moCoefficients;
-    for (int j = 0; j < moMatrix.cols(); ++j)
-      for (int i = 0; i < moMatrix.rows(); ++i)
-        moCoefficients.push_back(moMatrix(i, j));
+    // The matrices are column major, the order the coefficients are written.
+    json moCoefficients = vector<double>(
+      moMatrix.data(), moMatrix.data() + moMatrix.size());
 
     if (betaMatrix.cols() > 0 && betaMatrix.rows() > 0) {
-      json moBeta;
-      for (int j = 0; j < moMatrix.cols(); ++j)
-        for (int i = 0; i < moMatrix.rows(); ++i)
-          moBeta.push_back(moMatrix(i, j));
+      json moBeta = vector<double>(betaMatrix.data(),
+                                   betaMatrix.data() + betaMatrix.size());
 
       root["orbitals"]["alphaCoefficients"] = moCoefficients;
       root["orbitals"]["betaCoefficients"] = moBeta;
@@ -660,12 +816,7 @@ bool CjsonFormat::write(std::ostream& file, const Molecule& molecule)
   // Write out any cubes that are present in the molecule.
   if (molecule.cubeCount() > 0) {
     const Cube* cube = molecule.cube(0);
-    json cubeData;
-    for (vector<double>::const_iterator it = cube->data()->begin(),
-                                        itEnd = cube->data()->end();
-         it != itEnd; ++it) {
-      cubeData.push_back(*it);
-    }
+    json cubeData = *cube->data();
     // Get the origin, max, spacing, and dimensions to place in the object.
     json cubeObj;
     json cubeMin;
@@ -878,7 +1029,10 @@ bool CjsonFormat::write(std::ostream& file, const Molecule& molecule)
   }
 
   // Write out the file, use a two space indent to "pretty print".
-  file << std::setw(2) << root;
+  if (m_binary)
+    json::to_msgpack(root, file);
+  else
+    file << std::setw(2) << root;
 
   return true;
 }
@@ -886,14 +1040,14 @@ bool CjsonFormat::write(std::ostream& file, const Molecule& molecule)
 vector<std::string> CjsonFormat::fileExtensions() const
 {
   vector<std::string> ext;
-  ext.push_back("cjson");
+  ext.push_back(m_binary ? "cjsonb" : "cjson");
   return ext;
 }
 
 vector<std::string> CjsonFormat::mimeTypes() const
 {
   vector<std::string> mime;
-  mime.push_back("chemical/x-cjson");
+  mime.push_back(m_binary ? "chemical/x-cjson-binary" : "chemical/x-cjson");
   return mime;
 }
 
@@ -49,6 +49,42 @@ public:
 
   bool read(std::istream& in, Core::Molecule& molecule) override;
   bool write(std::ostream& out, const Core::Molecule& molecule) override;
+
+protected:
+  /** Write MessagePack instead of JSON text if @p binary is true. */
+  explicit CjsonFormat(bool binary);
+
+private:
+  bool m_binary = false;
+};
+
+/**
+ * @class BinaryCjsonFormat cjsonformat.h <avogadro/io/cjsonformat.h>
+ * @brief Chemical JSON encoded as MessagePack.
+ *
+ * The document is the same as for CjsonFormat, but numbers are stored as
+ * binary rather than text, which makes large coordinate sets, cubes and
+ * orbital coefficients smaller and much faster to read and write. Either
+ * format reads both encodings.
+ */
+class AVOGADROIO_EXPORT BinaryCjsonFormat : public CjsonFormat
+{
+public:
+  BinaryCjsonFormat() : CjsonFormat(true) {}
+
+  FileFormat* newInstance() const override { return new BinaryCjsonFormat; }
+  std::string identifier() const override { return "Avogadro: CJSONB"; }
+  std::string name() const override { return "Binary Chemical JSON"; }
+  std::string description() const override
+  {
+    return "Chemical JSON stored as MessagePack, for large molecules, "
+           "trajectories, cubes and orbitals";
+  }
+
+  std::string specificationUrl() const override
+  {
+    return "https://msgpack.org";
+  }
 };
 
 } // end Io namespace
@@ -15,6 +15,7 @@
 ******************************************************************************/
 
 #include "dcdformat.h"
+#include "filetrajectory_p.h"
 #include "struct.h"
 
 #include <avogadro/core/elements.h>
@@ -23,9 +24,11 @@
 #include <avogadro/core/utilities.h>
 #include <avogadro/core/vector.h>
 
+#include <algorithm>
 #include <cmath>
 #include <iomanip>
 #include <istream>
+#include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
@@ -74,6 +77,65 @@ char swap_endian(char endian)
     return '>';
 }
 
+namespace {
+
+// Read the X, Y and Z blocks of a frame, each one is enclosed by the record
+// length markers.
+bool readDcdPositions(std::istream& in, char endian, int natoms,
+                      Array<Vector3>& positions)
+{
+  vector<float> xyz(3 * static_cast<size_t>(natoms));
+  for (int axis = 0; axis < 3; ++axis) {
+    in.ignore(sizeof(int32_t));
+    in.read(reinterpret_cast<char*>(xyz.data() + axis * natoms),
+            natoms * sizeof(float));
+    in.ignore(sizeof(int32_t));
+  }
+  if (!in)
+    return false;
+
+  if ((endian == '>') != MappedFile::hostIsBigEndian())
+    swapByteOrder(xyz.data(), xyz.size());
+  positionsFromBlocks(xyz.data(), natoms, 1.0, positions);
+  return true;
+}
+
+// Check the record length markers around the X, Y and Z blocks of a frame.
+bool validDcdFrame(const MappedFile& file, size_t offset, int natoms,
+                   bool swap)
+{
+  const int32_t blockLength = natoms * static_cast<int32_t>(sizeof(float));
+  const size_t blockSize = blockLength + 2 * sizeof(int32_t);
+  for (int axis = 0; axis < 3; ++axis) {
+    size_t block = offset + axis * blockSize;
+    int32_t leading, trailing;
+    if (!file.read(block, &leading, 1, swap) ||
+        !file.read(block + blockSize - sizeof(int32_t), &trailing, 1, swap) ||
+        leading != blockLength || trailing != blockLength) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Decode the X, Y and Z blocks of a validated frame from the mapped file.
+bool mappedDcdPositions(const MappedFile& file, size_t offset, int natoms,
+                        bool swap, Array<Vector3>& positions)
+{
+  const size_t blockSize = natoms * sizeof(float) + 2 * sizeof(int32_t);
+  vector<float> xyz(3 * static_cast<size_t>(natoms));
+  for (int axis = 0; axis < 3; ++axis) {
+    if (!file.read(offset + axis * blockSize + sizeof(int32_t),
+                   xyz.data() + axis * natoms, natoms, swap)) {
+      return false;
+    }
+  }
+  positionsFromBlocks(xyz.data(), natoms, 1.0, positions);
+  return true;
+}
+
+} // namespace
+
 DcdFormat::DcdFormat() {}
 
 DcdFormat::~DcdFormat() {}
@@ -235,11 +297,13 @@ bool DcdFormat::read(std::istream& inStream, Core::Molecule& mol)
 
   // CHARMM trajectories have an extra block to be read, that contains
   // information about the unit cell
+  std::streamoff extraBlockSize = 0;
   if ((charmm & DCD_IS_CHARMM) && (charmm & DCD_HAS_EXTRA_BLOCK)) {
     snprintf(fmt, sizeof(fmt), "%c1i", endian);
     inStream.read(buff, struct_calcsize(fmt));
     int leadingNum;
     struct_unpack(buff, fmt, &leadingNum);
+    extraBlockSize = leadingNum + 2 * sizeof(int);
 
     if (leadingNum == 48) {
       double unitcell[6];
@@ -267,57 +331,18 @@ bool DcdFormat::read(std::istream& inStream, Core::Molecule& mol)
   }
 
   // Reading the atom coordinates
-  int formatint[6];
-  Array<float> cx, cy, cz;
-  cx.reserve(NATOMS);
-  cy.reserve(NATOMS);
-  cz.reserve(NATOMS);
-
-  snprintf(fmt, sizeof(fmt), "%c1i", endian);
-  inStream.read(buff, struct_calcsize(fmt));
-  struct_unpack(buff, fmt, &formatint[0]);
-
-  for (int i = 0; i < NATOMS; ++i) {
-    // X coordinates
-    snprintf(fmt, sizeof(fmt), "%c%df", endian, 1);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &cx[i]);
-    /* code */
-  }
-
-  snprintf(fmt, sizeof(fmt), "%c2i", endian);
-  inStream.read(buff, struct_calcsize(fmt));
-  struct_unpack(buff, fmt, &formatint[1], &formatint[2]);
-
-  for (int i = 0; i < NATOMS; ++i) {
-    // Y coordinates
-    snprintf(fmt, sizeof(fmt), "%c%df", endian, 1);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &cy[i]);
-  }
-
-  snprintf(fmt, sizeof(fmt), "%c2i", endian);
-  inStream.read(buff, struct_calcsize(fmt));
-  struct_unpack(buff, fmt, &formatint[3], &formatint[4]);
-
-  for (int i = 0; i < NATOMS; ++i) {
-    // Z coordinates
-    snprintf(fmt, sizeof(fmt), "%c%df", endian, 1);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &cz[i]);
+  std::streamoff firstFrame = inStream.tellg();
+  Array<Vector3> positions;
+  if (!readDcdPositions(inStream, endian, NATOMS, positions)) {
+    appendError("Error reading the coordinates of the first frame.");
+    return false;
   }
 
-  snprintf(fmt, sizeof(fmt), "%c1i", endian);
-  inStream.read(buff, struct_calcsize(fmt));
-  struct_unpack(buff, fmt, &formatint[5]);
-
   typedef map<string, unsigned char> AtomTypeMap;
   AtomTypeMap atomTypes;
   unsigned char customElementCounter = CustomElementMin;
 
   for (int i = 0; i < NATOMS; ++i) {
-    Vector3 pos(cx[i], cy[i], cz[i]);
-
     AtomTypeMap::const_iterator it;
     atomTypes.insert(std::make_pair(to_string(i), customElementCounter++));
     it = atomTypes.find(to_string(i));
@@ -326,23 +351,11 @@ bool DcdFormat::read(std::istream& inStream, Core::Molecule& mol)
     //   return false;
     // }
     Atom newAtom = mol.addAtom(it->second);
-    newAtom.setPosition3d(pos);
+    newAtom.setPosition3d(positions[i]);
   }
 
   mol.setTimeStep(0, 0);
 
-  // Skipping fourth dimension block
-  if ((charmm & DCD_IS_CHARMM) && (charmm & DCD_HAS_EXTRA_BLOCK)) {
-    snprintf(fmt, sizeof(fmt), "%c1i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    int sizeToRead;
-    struct_unpack(buff, fmt, &sizeToRead);
-
-    inStream.read(buff, sizeToRead);
-
-    inStream.read(buff, sizeof(int));
-  }
-
   // Set the custom element map if needed
   if (!atomTypes.empty()) {
     Molecule::CustomElementMap elementMap;
@@ -354,61 +367,96 @@ bool DcdFormat::read(std::istream& inStream, Core::Molecule& mol)
     mol.setCustomElementMap(elementMap);
   }
 
-  mol.setCoordinate3d(mol.atomPositions3d(), 0);
-
-  // Do we have an animation?
-  int coordSet = 1;
-  while ((static_cast<int>(inStream.tellg()) != fileLen) &&
-         (static_cast<int>(inStream.tellg()) != DCD_EOF)) {
-    // Reading the atom coordinates
-    Array<Vector3> positions;
-    positions.reserve(NATOMS);
-
-    snprintf(fmt, sizeof(fmt), "%c1i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &formatint[0]);
-
-    for (int i = 0; i < NATOMS; ++i) {
-      // X coordinates
-      snprintf(fmt, sizeof(fmt), "%c%df", endian, 1);
-      inStream.read(buff, struct_calcsize(fmt));
-      struct_unpack(buff, fmt, &cx[i]);
+  // All frames have the same size, so they can be found without reading them.
+  // The unit cell block precedes the coordinates of all but the first.
+  std::streamoff coordinateSize =
+    3 * (2 * sizeof(int) + static_cast<std::streamoff>(NATOMS) * 4);
+  std::streamoff frameSize = coordinateSize + extraBlockSize;
+
+  // Files are mapped into memory, the frames are validated once and then
+  // decoded straight from the mapped pages.
+  std::shared_ptr<MappedFile> mapped;
+  if (isFileStream(inStream)) {
+    mapped = std::make_shared<MappedFile>();
+    if (!mapped->open(fileName()))
+      mapped.reset();
+  }
+  if (mapped) {
+    bool swap = (endian == '>') != MappedFile::hostIsBigEndian();
+    vector<size_t> offsets;
+    for (size_t offset = firstFrame;
+         validDcdFrame(*mapped, offset, NATOMS, swap); offset += frameSize) {
+      offsets.push_back(offset);
     }
-
-    snprintf(fmt, sizeof(fmt), "%c2i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &formatint[1], &formatint[2]);
-
-    for (int i = 0; i < NATOMS; ++i) {
-      // Y coordinates
-      snprintf(fmt, sizeof(fmt), "%c%df", endian, 1);
-      inStream.read(buff, struct_calcsize(fmt));
-      struct_unpack(buff, fmt, &cy[i]);
+    for (size_t i = 1; i < offsets.size(); ++i)
+      mol.setTimeStep(DELTA * i, i);
+
+    auto reader = [NATOMS, swap](const MappedFile& file, size_t offset,
+                                 Array<Vector3>& framePositions) {
+      return mappedDcdPositions(file, offset, NATOMS, swap, framePositions);
+    };
+    if (readFramesOnDemand(inStream)) {
+      mol.setTrajectoryProvider(
+        std::make_shared<MappedTrajectory>(mapped, offsets, reader));
+    } else {
+      for (size_t i = 0; i < offsets.size(); ++i) {
+        if (!reader(*mapped, offsets[i], positions))
+          break;
+        mol.setCoordinate3d(positions, i);
+      }
     }
+    return true;
+  }
 
-    snprintf(fmt, sizeof(fmt), "%c2i", endian);
-    inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &formatint[3], &formatint[4]);
+  if (readFramesOnDemand(inStream)) {
+    std::streamoff frameCount =
+      std::max(std::streamoff(1),
+               (fileLen - firstFrame - coordinateSize) / frameSize + 1);
+    vector<std::streamoff> offsets;
+    offsets.reserve(frameCount);
+    for (std::streamoff i = 0; i < frameCount; ++i) {
+      offsets.push_back(firstFrame + i * frameSize);
+      mol.setTimeStep(DELTA * i, i);
+    }
 
-    for (int i = 0; i < NATOMS; ++i) {
-      // Z coordinates
-      snprintf(fmt, sizeof(fmt), "%c%df", endian, 1);
-      inStream.read(buff, struct_calcsize(fmt));
-      struct_unpack(buff, fmt, &cz[i]);
+    auto trajectory = std::make_shared<FileTrajectory>(
+      fileName(), offsets,
+      [endian, NATOMS](std::istream& in, Array<Vector3>& framePositions) {
+        return readDcdPositions(in, endian, NATOMS, framePositions);
+      });
+    if (!trajectory->isOpen()) {
+      appendError("Error reopening file: " + fileName());
+      return false;
     }
+    mol.setTrajectoryProvider(trajectory);
+    return true;
+  }
 
+  // Skipping the unit cell block of the next frame
+  if ((charmm & DCD_IS_CHARMM) && (charmm & DCD_HAS_EXTRA_BLOCK)) {
     snprintf(fmt, sizeof(fmt), "%c1i", endian);
     inStream.read(buff, struct_calcsize(fmt));
-    struct_unpack(buff, fmt, &formatint[5]);
+    int sizeToRead;
+    struct_unpack(buff, fmt, &sizeToRead);
 
-    for (int i = 0; i < NATOMS; ++i) {
-      Vector3 pos(cx[i], cy[i], cz[i]);
-      positions.push_back(pos);
-    }
+    inStream.read(buff, sizeToRead);
+
+    inStream.read(buff, sizeof(int));
+  }
+
+  mol.setCoordinate3d(mol.atomPositions3d(), 0);
+
+  // Do we have an animation?
+  int coordSet = 1;
+  while ((static_cast<int>(inStream.tellg()) != fileLen) &&
+         (static_cast<int>(inStream.tellg()) != DCD_EOF)) {
+    // Reading the atom coordinates
+    if (!readDcdPositions(inStream, endian, NATOMS, positions))
+      break;
 
     mol.setTimeStep(DELTA * coordSet, coordSet);
 
-    // Skipping fourth dimension block
+    // Skipping the unit cell block of the next frame
     if ((charmm & DCD_IS_CHARMM) && (charmm & DCD_HAS_EXTRA_BLOCK)) {
       snprintf(fmt, sizeof(fmt), "%c1i", endian);
       inStream.read(buff, struct_calcsize(fmt));
@@ -16,6 +16,8 @@
 
 #include "fileformat.h"
 
+#include <nlohmann/json.hpp>
+
 #include <fstream>
 #include <locale>
 #include <sstream>
@@ -148,6 +150,32 @@ void FileFormat::clear()
   m_error.clear();
 }
 
+bool FileFormat::isFileStream(const std::istream& in) const
+{
+  return &in == m_in && !m_fileName.empty();
+}
+
+bool FileFormat::readFramesOnDemand(std::istream& in) const
+{
+  // Frames are read back from the file, so it has to be the stream we opened.
+  if (!isFileStream(in))
+    return false;
+
+  if (!m_options.empty()) {
+    nlohmann::json opts = nlohmann::json::parse(m_options, nullptr, false);
+    if (opts.is_object() && opts.count("lazyFrames") &&
+        opts["lazyFrames"].is_boolean()) {
+      return opts["lazyFrames"].get<bool>();
+    }
+  }
+
+  std::streampos current = in.tellg();
+  in.seekg(0, std::ios_base::end);
+  std::streamoff size = in.tellg();
+  in.seekg(current);
+  return size > (std::streamoff(64) << 20);
+}
+
 void FileFormat::appendError(const std::string& errorString, bool newLine)
 {
   m_error += errorString;
@@ -245,6 +245,23 @@ protected:
    */
   void appendError(const std::string& errorString, bool newLine = true);
 
+  /**
+   * @brief Is @p in the stream of the file opened by open()? Readers can then
+   * access the file directly, e.g. to map it into memory.
+   */
+  bool isFileStream(const std::istream& in) const;
+
+  /**
+   * @brief Should the frames of a trajectory be read on demand?
+   * Frames are read from the file when needed if @p in is the stream of the
+   * file opened by open() and the file is larger than 64 MiB. A "lazyFrames"
+   * boolean in the options overrides the size check.
+   * @param in The stream passed to read().
+   * @return True if the reader should index the frames and hand them to a
+   * trajectory provider, false to load them all into the molecule.
+   */
+  bool readFramesOnDemand(std::istream& in) const;
+
 private:
   std::string m_error;
   std::string m_fileName;
@@ -0,0 +1,61 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "filetrajectory_p.h"
+
+#include <locale>
+
+namespace Avogadro {
+namespace Io {
+
+FileTrajectory::FileTrajectory(const std::string& fileName,
+                               const std::vector<std::streamoff>& offsets,
+                               const FrameReader& reader)
+  : m_file(fileName.c_str(), std::ifstream::binary), m_offsets(offsets),
+    m_reader(reader)
+{
+  m_file.imbue(std::locale("C"));
+}
+
+FileTrajectory::~FileTrajectory() {}
+
+int FileTrajectory::frameCount() const
+{
+  return static_cast<int>(m_offsets.size());
+}
+
+bool FileTrajectory::readFrame(int index, Core::Array<Vector3>& positions)
+{
+  if (!m_file.is_open())
+    return false;
+
+  m_file.clear();
+  m_file.seekg(m_offsets[index]);
+  if (!m_file)
+    return false;
+  return m_reader(m_file, positions);
+}
+
+MappedTrajectory::MappedTrajectory(std::shared_ptr<const MappedFile> file,
+                                   const std::vector<size_t>& offsets,
+                                   const FrameReader& reader)
+  : m_file(file), m_offsets(offsets), m_reader(reader)
+{
+}
+
+MappedTrajectory::~MappedTrajectory() {}
+
+int MappedTrajectory::frameCount() const
+{
+  return static_cast<int>(m_offsets.size());
+}
+
+bool MappedTrajectory::readFrame(int index, Core::Array<Vector3>& positions)
+{
+  return m_reader(*m_file, m_offsets[index], positions);
+}
+
+} // namespace Io
+} // namespace Avogadro
@@ -0,0 +1,84 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_IO_FILETRAJECTORY_P_H
+#define AVOGADRO_IO_FILETRAJECTORY_P_H
+
+#include "mappedfile_p.h"
+
+#include <avogadro/core/trajectoryprovider.h>
+
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Avogadro {
+namespace Io {
+
+/**
+ * @brief Reads trajectory frames from a file on demand.
+ *
+ * The readers index the file in one pass, recording the byte offset of every
+ * frame. Reading a frame seeks to its offset and hands the stream to the
+ * format specific frame reader.
+ */
+class FileTrajectory : public Core::TrajectoryProvider
+{
+public:
+  typedef std::function<bool(std::istream&, Core::Array<Vector3>&)>
+    FrameReader;
+
+  FileTrajectory(const std::string& fileName,
+                 const std::vector<std::streamoff>& offsets,
+                 const FrameReader& reader);
+  ~FileTrajectory() override;
+
+  bool isOpen() const { return m_file.is_open(); }
+  int frameCount() const override;
+
+protected:
+  bool readFrame(int index, Core::Array<Vector3>& positions) override;
+
+private:
+  std::ifstream m_file;
+  std::vector<std::streamoff> m_offsets;
+  FrameReader m_reader;
+};
+
+/**
+ * @brief Decodes trajectory frames on demand from a memory mapped file.
+ *
+ * Binary readers validate the layout of the frames while indexing, the frame
+ * reader then decodes the coordinates straight from the mapped pages at the
+ * recorded offset.
+ */
+class MappedTrajectory : public Core::TrajectoryProvider
+{
+public:
+  typedef std::function<bool(const MappedFile&, size_t, Core::Array<Vector3>&)>
+    FrameReader;
+
+  MappedTrajectory(std::shared_ptr<const MappedFile> file,
+                   const std::vector<size_t>& offsets,
+                   const FrameReader& reader);
+  ~MappedTrajectory() override;
+
+  int frameCount() const override;
+
+protected:
+  bool readFrame(int index, Core::Array<Vector3>& positions) override;
+
+private:
+  std::shared_ptr<const MappedFile> m_file;
+  std::vector<size_t> m_offsets;
+  FrameReader m_reader;
+};
+
+} // namespace Io
+} // namespace Avogadro
+
+#endif // AVOGADRO_IO_FILETRAJECTORY_P_H
@@ -126,12 +126,13 @@ bool GromacsFormat::read(std::istream& in, Molecule& molecule)
     // Offset: 52 format: %8.4f value: y velocity (nm/ps, a.k.a. km/s)
     // Offset: 60 format: %8.4f value: z velocity (nm/ps, a.k.a. km/s)
 
-    size_t residueId = lexicalCast<size_t>(buffer.substr(0, 5), ok);
+    int residueNumber = lexicalCast<int>(buffer.substr(0, 5), ok);
     if (!ok) {
       appendError("Failed to parse residue sequence number: " +
                   buffer.substr(0, 5));
       return false;
     }
+    size_t residueId = static_cast<size_t>(residueNumber);
 
     if (residueId != currentResidueId) {
       currentResidueId = residueId;
@@ -124,6 +124,25 @@ public:
   void* dataPointer() { return &m_data[0]; }
 };
 
+class ResizePositions : public Avogadro::Io::Hdf5DataFormat::ResizeContainer
+{
+  Avogadro::Core::Array<Avogadro::Vector3>& m_data;
+
+public:
+  ResizePositions(Avogadro::Core::Array<Avogadro::Vector3>& data)
+    : m_data(data)
+  {
+  }
+  bool resize(const std::vector<int>& dims)
+  {
+    if (dims.empty() || dims.back() != 3)
+      return false;
+    m_data.resize(dimsToNumberOfElements(dims) / 3);
+    return true;
+  }
+  void* dataPointer() { return m_data[0].data(); }
+};
+
 } // end unnamed namespace
 
 // end doxygen exclude:
@@ -411,6 +430,14 @@ bool Hdf5DataFormat::writeDataset(const std::string& path,
 
 std::vector<int> Hdf5DataFormat::readRawDataset(
   const std::string& path, ResizeContainer& container) const
+{
+  return readRawDataset(path, container, std::vector<size_t>(),
+                        std::vector<size_t>());
+}
+
+std::vector<int> Hdf5DataFormat::readRawDataset(
+  const std::string& path, ResizeContainer& container,
+  const std::vector<size_t>& offset, const std::vector<size_t>& count) const
 {
   std::vector<int> result;
   if (!isOpen())
@@ -427,7 +454,7 @@ std::vector<int> Hdf5DataFormat::readRawDataset(
   // Lookup dimensions
   // Get dataspace for dataset
   hid_t dataspace_id = H5Dget_space(dataset_id);
-  if (dataset_id < 0) {
+  if (dataspace_id < 0) {
     H5Dclose(dataset_id);
     return result;
   }
@@ -441,36 +468,53 @@ std::vector<int> Hdf5DataFormat::readRawDataset(
   }
 
   // Get actual dimensions.
-  hsize_t* hdims = new hsize_t[ndims];
-  if (H5Sget_simple_extent_dims(dataspace_id, hdims, nullptr) != ndims) {
-    delete[] hdims;
+  std::vector<hsize_t> hdims(ndims);
+  if (H5Sget_simple_extent_dims(dataspace_id, hdims.data(), nullptr) !=
+      ndims) {
     H5Sclose(dataspace_id);
     H5Dclose(dataset_id);
     return result;
   }
 
+  // Select the block to read, which must lie within the dataset. The memory
+  // holds just the block.
+  hid_t memspace_id = dataspace_id;
+  if (!offset.empty()) {
+    bool valid = offset.size() == hdims.size() && count.size() == hdims.size();
+    for (int i = 0; valid && i < ndims; ++i)
+      valid = count[i] > 0 && offset[i] + count[i] <= hdims[i];
+    std::vector<hsize_t> hoffset(offset.begin(), offset.end());
+    std::vector<hsize_t> hcount(count.begin(), count.end());
+    if (valid) {
+      valid = H5Sselect_hyperslab(dataspace_id, H5S_SELECT_SET, hoffset.data(),
+                                  nullptr, hcount.data(), nullptr) >= 0;
+    }
+    if (valid)
+      memspace_id = H5Screate_simple(ndims, hcount.data(), nullptr);
+    if (!valid || memspace_id < 0) {
+      H5Sclose(dataspace_id);
+      H5Dclose(dataset_id);
+      return result;
+    }
+    hdims = hcount;
+  }
+
   result.reserve(ndims);
   for (int i = 0; i < ndims; ++i) {
     result.push_back(static_cast<int>(hdims[i]));
   }
 
   // Allocate and read into data.
-  if (!container.resize(result)) {
-    result.clear();
-    H5Sclose(dataspace_id);
-    H5Dclose(dataset_id);
-    return result;
-  }
-
-  if (H5Dread(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, dataspace_id, H5P_DEFAULT,
-              container.dataPointer()) < 0) {
+  if (!container.resize(result) ||
+      H5Dread(dataset_id, H5T_NATIVE_DOUBLE,
+              offset.empty() ? H5S_ALL : memspace_id, dataspace_id,
+              H5P_DEFAULT, container.dataPointer()) < 0) {
     result.clear();
-    H5Sclose(dataspace_id);
-    H5Dclose(dataset_id);
-    return result;
   }
 
   // Cleanup
+  if (memspace_id != dataspace_id)
+    H5Sclose(memspace_id);
   H5Sclose(dataspace_id);
   H5Dclose(dataset_id);
 
@@ -497,6 +541,189 @@ std::vector<int> Hdf5DataFormat::readDataset(const std::string& path,
   return readRawDataset(path, container);
 }
 
+std::vector<int> Hdf5DataFormat::readHyperslab(
+  const std::string& path, const std::vector<size_t>& offset,
+  const std::vector<size_t>& count, std::vector<double>& data) const
+{
+  if (offset.empty())
+    return std::vector<int>();
+  ResizeVector container(data);
+  return readRawDataset(path, container, offset, count);
+}
+
+bool Hdf5DataFormat::createFrameDataset(
+  const std::string& path, const std::vector<size_t>& frameDims,
+  int compression, const std::vector<size_t>& chunkDims) const
+{
+  if (!isOpen() || frameDims.empty())
+    return false;
+  if (!chunkDims.empty() && chunkDims.size() != frameDims.size())
+    return false;
+
+  // Frames are stacked along an unlimited major dimension, each chunk holds
+  // (part of) a single frame.
+  const int ndims = static_cast<int>(frameDims.size()) + 1;
+  std::vector<hsize_t> hdims(ndims, 0);
+  std::vector<hsize_t> maxdims(ndims, H5S_UNLIMITED);
+  std::vector<hsize_t> chunk(ndims, 1);
+  for (size_t i = 0; i < frameDims.size(); ++i) {
+    const size_t chunkDim = chunkDims.empty() ? frameDims[i] : chunkDims[i];
+    if (frameDims[i] == 0 || chunkDim == 0 || chunkDim > frameDims[i])
+      return false;
+    hdims[i + 1] = maxdims[i + 1] = static_cast<hsize_t>(frameDims[i]);
+    chunk[i + 1] = static_cast<hsize_t>(chunkDim);
+  }
+
+  // Remove old data set if it exists.
+  if (datasetExists(path)) {
+    if (!removeDataset(path))
+      return false;
+  }
+
+  hid_t dataspace_id = H5Screate_simple(ndims, hdims.data(), maxdims.data());
+  if (dataspace_id < 0)
+    return false;
+
+  // Create any intermediate groups if needed:
+  hid_t lcpl_id = H5Pcreate(H5P_LINK_CREATE);
+  hid_t dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+  bool ok = lcpl_id >= 0 && dcpl_id >= 0 &&
+            H5Pset_create_intermediate_group(lcpl_id, 1) >= 0 &&
+            H5Pset_chunk(dcpl_id, ndims, chunk.data()) >= 0;
+
+  // Shuffling the bytes of the doubles first makes them compress better.
+  if (ok && compression > 0 && H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0) {
+    ok = H5Pset_shuffle(dcpl_id) >= 0 &&
+         H5Pset_deflate(dcpl_id, std::min(compression, 9)) >= 0;
+  }
+
+  if (ok) {
+    hid_t dataset_id = H5Dcreate(d->fileId, path.c_str(), H5T_NATIVE_DOUBLE,
+                                 dataspace_id, lcpl_id, dcpl_id, H5P_DEFAULT);
+    ok = dataset_id >= 0;
+    if (ok)
+      H5Dclose(dataset_id);
+  }
+
+  // Cleanup.
+  if (dcpl_id >= 0)
+    H5Pclose(dcpl_id);
+  if (lcpl_id >= 0)
+    H5Pclose(lcpl_id);
+  H5Sclose(dataspace_id);
+
+  return ok;
+}
+
+bool Hdf5DataFormat::appendRawFrame(const std::string& path,
+                                    const double data[], size_t size) const
+{
+  if (!isOpen() || !datasetExists(path))
+    return false;
+
+  hid_t dataset_id = H5Dopen(d->fileId, path.c_str(), H5P_DEFAULT);
+  if (dataset_id < 0)
+    return false;
+
+  // The frame must fill the dataset's minor dimensions, and the major one
+  // must be extendible.
+  hid_t dataspace_id = H5Dget_space(dataset_id);
+  int ndims = dataspace_id < 0 ? 0 : H5Sget_simple_extent_ndims(dataspace_id);
+  std::vector<hsize_t> hdims(std::max(ndims, 0));
+  std::vector<hsize_t> maxdims(hdims.size());
+  bool ok = ndims > 1 && H5Sget_simple_extent_dims(dataspace_id, hdims.data(),
+                                                   maxdims.data()) == ndims;
+  if (ok) {
+    hsize_t frameSize = 1;
+    for (int i = 1; i < ndims; ++i)
+      frameSize *= hdims[i];
+    ok = maxdims[0] == H5S_UNLIMITED && frameSize == size;
+  }
+  if (dataspace_id >= 0)
+    H5Sclose(dataspace_id);
+  dataspace_id = H5I_INVALID_HID;
+
+  // Grow the dataset by a frame, and select the new frame to write.
+  std::vector<hsize_t> offset(hdims.size(), 0);
+  std::vector<hsize_t> count(hdims);
+  if (ok) {
+    offset[0] = hdims[0];
+    count[0] = 1;
+    hdims[0] += 1;
+    ok = H5Dset_extent(dataset_id, hdims.data()) >= 0;
+  }
+  if (ok) {
+    dataspace_id = H5Dget_space(dataset_id);
+    ok = dataspace_id >= 0 &&
+         H5Sselect_hyperslab(dataspace_id, H5S_SELECT_SET, offset.data(),
+                             nullptr, count.data(), nullptr) >= 0;
+  }
+  if (ok) {
+    hid_t memspace_id = H5Screate_simple(ndims, count.data(), nullptr);
+    ok = memspace_id >= 0 &&
+         H5Dwrite(dataset_id, H5T_NATIVE_DOUBLE, memspace_id, dataspace_id,
+                  H5P_DEFAULT, data) >= 0;
+    if (memspace_id >= 0)
+      H5Sclose(memspace_id);
+  }
+
+  // Cleanup.
+  if (dataspace_id >= 0)
+    H5Sclose(dataspace_id);
+  H5Dclose(dataset_id);
+
+  return ok;
+}
+
+bool Hdf5DataFormat::appendFrame(const std::string& path,
+                                 const std::vector<double>& data) const
+{
+  return appendRawFrame(path, data.data(), data.size());
+}
+
+bool Hdf5DataFormat::appendFrame(const std::string& path,
+                                 const Core::Array<Vector3>& data) const
+{
+  if (data.empty())
+    return false;
+  return appendRawFrame(path, data[0].data(), 3 * data.size());
+}
+
+std::vector<int> Hdf5DataFormat::readFrame(const std::string& path,
+                                           size_t frame,
+                                           std::vector<double>& data) const
+{
+  // Read a block one frame deep spanning the other dimensions.
+  std::vector<int> dims = datasetDimensions(path);
+  if (dims.size() < 2)
+    return std::vector<int>();
+  std::vector<size_t> offset(dims.size(), 0);
+  std::vector<size_t> count(dims.begin(), dims.end());
+  offset[0] = frame;
+  count[0] = 1;
+
+  ResizeVector container(data);
+  std::vector<int> result = readRawDataset(path, container, offset, count);
+  if (!result.empty())
+    result.erase(result.begin());
+  return result;
+}
+
+bool Hdf5DataFormat::readFrame(const std::string& path, size_t frame,
+                               Core::Array<Vector3>& data) const
+{
+  std::vector<int> dims = datasetDimensions(path);
+  if (dims.size() != 3 || dims[1] == 0 || dims[2] != 3)
+    return false;
+  std::vector<size_t> offset(3, 0);
+  std::vector<size_t> count(dims.begin(), dims.end());
+  offset[0] = frame;
+  count[0] = 1;
+
+  ResizePositions container(data);
+  return !readRawDataset(path, container, offset, count).empty();
+}
+
 std::vector<std::string> Hdf5DataFormat::datasets() const
 {
   if (!isOpen())
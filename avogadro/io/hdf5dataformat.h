@@ -20,6 +20,7 @@
 #include "avogadroioexport.h"
 
 #include <avogadro/core/matrix.h> // can't forward declare eigen types
+#include <avogadro/core/vector.h>
 
 #include <cstddef>
 #include <string>
@@ -63,6 +64,13 @@ namespace Io {
  * If not, it should be serialized into the text file in a suitable format. The
  * thresholding operations are optional; the threshold size does not affect the
  * behavior of the read/write methods and are only for user convenience.
+ *
+ * Data that grows over time, such as the positions of a trajectory or a
+ * series of cubes, can be stored in a frame dataset made by
+ * createFrameDataset(). Frames are appended one at a time with appendFrame()
+ * and stored in compressed chunks, so readFrame() and readHyperslab() only
+ * read the part of the file they return. The number of frames is the first
+ * entry of datasetDimensions().
  */
 class AVOGADROIO_EXPORT Hdf5DataFormat
 {
@@ -277,6 +285,86 @@ public:
   std::vector<int> readDataset(const std::string& path,
                                Core::Array<double>& data) const;
 
+  /**
+   * @brief readHyperslab Populate the data container @a data with the block of
+   * the dataset at @a path that starts at @a offset and spans @a count
+   * elements in each dimension.
+   * @param path An absolute path into the HDF5 data.
+   * @param offset The first element of the block, major dimension first.
+   * @param count The size of the block, major dimension first.
+   * @param data The data container to into which the block shall be
+   * deserialized. @a data will be resized to fit the block.
+   * @return The dimensionality of the block, which is @a count. If an error
+   * occurs, for instance if the block does not fit in the dataset, an empty
+   * vector is returned.
+   */
+  std::vector<int> readHyperslab(const std::string& path,
+                                 const std::vector<size_t>& offset,
+                                 const std::vector<size_t>& count,
+                                 std::vector<double>& data) const;
+
+  /**
+   * @brief createFrameDataset Create an empty dataset at the specified
+   * absolute HDF5 path that frames are appended to with appendFrame().
+   * @param path An absolute path into the HDF5 data.
+   * @param frameDims The dimensionality of a frame, major dimension first,
+   * for instance { atoms, 3 } for a trajectory or the dimensions of a cube.
+   * @param compression The deflate level, from 0 (uncompressed) to 9.
+   * Default: 4.
+   * @param chunkDims The dimensionality of the part of a frame stored in one
+   * chunk, which is the unit that is read and decompressed. Default: the
+   * whole frame. Smaller chunks make it cheaper to read small blocks of large
+   * frames, such as a slice of a cube.
+   * @note Any existing dataset at @a path is removed.
+   * @return true if the dataset is successfully created, false otherwise.
+   */
+  bool createFrameDataset(
+    const std::string& path, const std::vector<size_t>& frameDims,
+    int compression = 4,
+    const std::vector<size_t>& chunkDims = std::vector<size_t>()) const;
+
+  /**
+   * @brief appendFrame Append a frame to a dataset created with
+   * createFrameDataset().
+   * @param path An absolute path into the HDF5 data.
+   * @param data The frame, which must have as many elements as a frame of
+   * the dataset.
+   * @return true if the frame is successfully written, false otherwise.
+   */
+  bool appendFrame(const std::string& path,
+                   const std::vector<double>& data) const;
+
+  /**
+   * @brief appendFrame Append a frame of positions to a dataset created with
+   * createFrameDataset() with frames of { data.size(), 3 }.
+   * @param path An absolute path into the HDF5 data.
+   * @param data The positions of the frame.
+   * @return true if the frame is successfully written, false otherwise.
+   */
+  bool appendFrame(const std::string& path,
+                   const Core::Array<Vector3>& data) const;
+
+  /**
+   * @brief readFrame Populate the data container @a data with frame @a frame
+   * of the dataset at @a path. Only the chunks holding the frame are read.
+   * @param path An absolute path into the HDF5 data.
+   * @param frame The index of the frame along the major dimension.
+   * @param data The data container to into which the frame shall be
+   * deserialized. @a data will be resized to fit the frame.
+   * @return The dimensionality of the frame, major dimension first. If an
+   * error occurs, an empty vector is returned.
+   */
+  std::vector<int> readFrame(const std::string& path, size_t frame,
+                             std::vector<double>& data) const;
+
+  /**
+   * @brief readFrame Populate @a data with the positions of frame @a frame of
+   * the dataset at @a path, which must have frames of { atoms, 3 }.
+   * @return true if the frame is successfully read, false otherwise.
+   */
+  bool readFrame(const std::string& path, size_t frame,
+                 Core::Array<Vector3>& data) const;
+
   /**
    * @brief datasets Traverse the currently opened file and return a list of all
    * dataset objects in the file.
@@ -318,6 +406,25 @@ private:
   std::vector<int> readRawDataset(const std::string& path,
                                   ResizeContainer& container) const;
 
+  /**
+   * @brief readRawDataset As above, but only read the block starting at
+   * @a offset spanning @a count elements in each dimension.
+   * @return The dimensionality of the block, or an empty vector if an error
+   * occurs.
+   */
+  std::vector<int> readRawDataset(const std::string& path,
+                                  ResizeContainer& container,
+                                  const std::vector<size_t>& offset,
+                                  const std::vector<size_t>& count) const;
+
+  /**
+   * @brief appendRawFrame Extend the frame dataset at @a path by one frame
+   * and write the @a size values of @a data into it.
+   * @return true if the frame is successfully written, false otherwise.
+   */
+  bool appendRawFrame(const std::string& path, const double data[],
+                      size_t size) const;
+
   class Private;
   /** Internal storage, used to encapsulate HDF5 data. */
   Private* const d;
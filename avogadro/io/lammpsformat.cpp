@@ -15,6 +15,7 @@
 ******************************************************************************/
 
 #include "lammpsformat.h"
+#include "filetrajectory_p.h"
 
 #include <avogadro/core/crystaltools.h>
 #include <avogadro/core/elements.h>
@@ -25,6 +26,8 @@
 
 #include <iomanip>
 #include <istream>
+#include <limits>
+#include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
@@ -47,6 +50,7 @@ using Core::Elements;
 using Core::lexicalCast;
 using Core::Molecule;
 using Core::split;
+using Core::StringView;
 using Core::trimmed;
 using Core::UnitCell;
 
@@ -54,149 +58,203 @@ using Core::UnitCell;
 using std::isalpha;
 #endif
 
-LammpsTrajectoryFormat::LammpsTrajectoryFormat() {}
-
-LammpsTrajectoryFormat::~LammpsTrajectoryFormat() {}
+namespace {
 
-bool LammpsTrajectoryFormat::read(std::istream& inStream, Core::Molecule& mol)
+// The box and the columns of a frame in a dump file.
+struct LammpsFrame
 {
-  size_t numAtoms = 0, timestep = 0, x_idx = -1, y_idx = -1, z_idx = -1,
+  size_t timestep = 0, numAtoms = 0, x_idx = -1, y_idx = -1, z_idx = -1,
          type_idx = -1, id_idx = -1;
   double x_min = 0, x_max = 0, y_min = 0, y_max = 0, z_min = 0, z_max = 0,
          tilt_xy = 0, tilt_xz = 0, tilt_yz = 0, scale_x = 0., scale_y = 0.,
          scale_z = 0.;
+  vector<string> labels;
 
-  string buffer;
-  getline(inStream, buffer); // Finish the first line
-  buffer = trimmed(buffer);
-  if (buffer != "ITEM: TIMESTEP") {
-    appendError("No timestep item found.");
-    return false;
+  UnitCell* unitCell() const
+  {
+    return new UnitCell(Vector3(x_max - x_min, 0, 0),
+                        Vector3(tilt_xy, y_max - y_min, 0),
+                        Vector3(tilt_xz, tilt_yz, z_max - z_min));
   }
-  getline(inStream, buffer);
-  if (!buffer.empty()) {
-    timestep = lexicalCast<size_t>(buffer);
-    mol.setTimeStep(timestep, 0);
+
+  // If parsed coordinates are fractional, the corresponding unscaling is
+  // done. Else the positions are assigned as parsed.
+  Vector3 position(const vector<StringView>& tokens) const
+  {
+    double x = lexicalCast<double>(tokens[x_idx - 2]);
+    double y = lexicalCast<double>(tokens[y_idx - 2]);
+    double z = lexicalCast<double>(tokens[z_idx - 2]);
+    return Vector3((1 - scale_x) * x + scale_x * (x_min + (x_max - x_min) * x),
+                   (1 - scale_y) * y + scale_y * (y_min + (y_max - y_min) * y),
+                   (1 - scale_z) * z + scale_z * (z_min + (z_max - z_min) * z));
   }
+};
+
+// Parse the header of a frame, following the "ITEM: TIMESTEP" line.
+bool readLammpsHeader(std::istream& in, LammpsFrame& frame, string& error)
+{
+  frame = LammpsFrame();
 
-  getline(inStream, buffer);
+  string buffer;
+  getline(in, buffer);
+  if (!buffer.empty())
+    frame.timestep = lexicalCast<size_t>(buffer);
+
+  getline(in, buffer);
   buffer = trimmed(buffer);
   if (buffer != "ITEM: NUMBER OF ATOMS") {
-    appendError("No number of atoms item found.");
+    error = "No number of atoms item found.";
     return false;
   }
-  getline(inStream, buffer);
+  getline(in, buffer);
   if (!buffer.empty())
-    numAtoms = lexicalCast<size_t>(buffer);
+    frame.numAtoms = lexicalCast<size_t>(buffer);
 
   // If unit cell is triclinic, tilt factors are needed to define the supercell
-  getline(inStream, buffer);
+  getline(in, buffer);
   if (buffer.find("ITEM: BOX BOUNDS xy xz yz") == 0) {
     // Read x_min, x_max, tiltfactor_xy
-    getline(inStream, buffer);
+    getline(in, buffer);
     vector<string> box_bounds_x(split(buffer, ' '));
-    x_min = lexicalCast<double>(box_bounds_x.at(0));
-    x_max = lexicalCast<double>(box_bounds_x.at(1));
-    tilt_xy = lexicalCast<double>(box_bounds_x.at(2));
+    frame.x_min = lexicalCast<double>(box_bounds_x.at(0));
+    frame.x_max = lexicalCast<double>(box_bounds_x.at(1));
+    frame.tilt_xy = lexicalCast<double>(box_bounds_x.at(2));
     // Read y_min, y_max, tiltfactor_xz
-    getline(inStream, buffer);
+    getline(in, buffer);
     vector<string> box_bounds_y(split(buffer, ' '));
-    y_min = lexicalCast<double>(box_bounds_y.at(0));
-    y_max = lexicalCast<double>(box_bounds_y.at(1));
-    tilt_xz = lexicalCast<double>(box_bounds_y.at(2));
-    getline(inStream, buffer);
+    frame.y_min = lexicalCast<double>(box_bounds_y.at(0));
+    frame.y_max = lexicalCast<double>(box_bounds_y.at(1));
+    frame.tilt_xz = lexicalCast<double>(box_bounds_y.at(2));
+    getline(in, buffer);
     // Read z_min, z_max, tiltfactor_yz
     vector<string> box_bounds_z(split(buffer, ' '));
-    z_min = lexicalCast<double>(box_bounds_z.at(0));
-    z_max = lexicalCast<double>(box_bounds_z.at(1));
-    tilt_yz = lexicalCast<double>(box_bounds_z.at(2));
-
-    x_min -= std::min(std::min(std::min(tilt_xy, tilt_xz), tilt_xy + tilt_xz),
-                      (double)0);
-    x_max -= std::max(std::max(std::max(tilt_xy, tilt_xz), tilt_xy + tilt_xz),
-                      (double)0);
-    y_min -= std::min(tilt_yz, (double)0);
-    y_max -= std::max(tilt_yz, (double)0);
+    frame.z_min = lexicalCast<double>(box_bounds_z.at(0));
+    frame.z_max = lexicalCast<double>(box_bounds_z.at(1));
+    frame.tilt_yz = lexicalCast<double>(box_bounds_z.at(2));
+
+    double tilt_xy = frame.tilt_xy, tilt_xz = frame.tilt_xz,
+           tilt_yz = frame.tilt_yz;
+    frame.x_min -= std::min(
+      std::min(std::min(tilt_xy, tilt_xz), tilt_xy + tilt_xz), (double)0);
+    frame.x_max -= std::max(
+      std::max(std::max(tilt_xy, tilt_xz), tilt_xy + tilt_xz), (double)0);
+    frame.y_min -= std::min(tilt_yz, (double)0);
+    frame.y_max -= std::max(tilt_yz, (double)0);
   }
 
   // Else if unit cell is orthogonal, tilt factors are zero
   else if (buffer.find("ITEM: BOX BOUNDS") == 0) {
     // Read x_min, x_max
-    getline(inStream, buffer);
+    getline(in, buffer);
     vector<string> box_bounds_x(split(buffer, ' '));
-    x_min = lexicalCast<double>(box_bounds_x.at(0));
-    x_max = lexicalCast<double>(box_bounds_x.at(1));
+    frame.x_min = lexicalCast<double>(box_bounds_x.at(0));
+    frame.x_max = lexicalCast<double>(box_bounds_x.at(1));
     // Read y_min, y_max
-    getline(inStream, buffer);
+    getline(in, buffer);
     vector<string> box_bounds_y(split(buffer, ' '));
-    y_min = lexicalCast<double>(box_bounds_y.at(0));
-    y_max = lexicalCast<double>(box_bounds_y.at(1));
+    frame.y_min = lexicalCast<double>(box_bounds_y.at(0));
+    frame.y_max = lexicalCast<double>(box_bounds_y.at(1));
     // Read z_min, z_max
-    getline(inStream, buffer);
+    getline(in, buffer);
     vector<string> box_bounds_z(split(buffer, ' '));
-    z_min = lexicalCast<double>(box_bounds_z.at(0));
-    z_max = lexicalCast<double>(box_bounds_z.at(1));
+    frame.z_min = lexicalCast<double>(box_bounds_z.at(0));
+    frame.z_max = lexicalCast<double>(box_bounds_z.at(1));
   }
 
-  typedef map<string, unsigned char> AtomTypeMap;
-  AtomTypeMap atomTypes;
-  unsigned char customElementCounter = CustomElementMin;
-
   // x,y,z stand for the coordinate axes
   // s stands for scaled coordinates
   // u stands for unwrapped coordinates
   // scale_x = 0. if coordinates are cartesian and 1 if fractional (scaled)
-  getline(inStream, buffer);
-  vector<string> labels(split(buffer, ' '));
-  for (size_t i = 0; i < labels.size(); i++) {
+  getline(in, buffer);
+  frame.labels = split(buffer, ' ');
+  const vector<string>& labels = frame.labels;
+  for (size_t i = 0; i < labels.size(); ++i) {
     if (labels[i] == "x" || labels[i] == "xu") {
-      x_idx = i;
-      scale_x = 0.;
+      frame.x_idx = i;
+      frame.scale_x = 0.;
     } else if (labels[i] == "xs" || labels[i] == "xsu") {
-      x_idx = i;
-      scale_x = 1.;
+      frame.x_idx = i;
+      frame.scale_x = 1.;
     } else if (labels[i] == "y" || labels[i] == "yu") {
-      y_idx = i;
-      scale_y = 0.;
+      frame.y_idx = i;
+      frame.scale_y = 0.;
     } else if (labels[i] == "ys" || labels[i] == "ysu") {
-      y_idx = i;
-      scale_y = 1.;
+      frame.y_idx = i;
+      frame.scale_y = 1.;
     } else if (labels[i] == "z" || labels[i] == "zu") {
-      z_idx = i;
-      scale_z = 0.;
+      frame.z_idx = i;
+      frame.scale_z = 0.;
     } else if (labels[i] == "zs" || labels[i] == "zsu") {
-      z_idx = i;
-      scale_z = 1.;
+      frame.z_idx = i;
+      frame.scale_z = 1.;
     } else if (labels[i] == "type")
-      type_idx = i;
+      frame.type_idx = i;
     else if (labels[i] == "id")
-      id_idx = i;
+      frame.id_idx = i;
   }
+  return true;
+}
+
+// Parse the atom lines of a frame, the first two labels are "ITEM: ATOMS".
+bool readLammpsPositions(std::istream& in, const LammpsFrame& frame,
+                         size_t numAtoms, Array<Vector3>& positions,
+                         string& buffer)
+{
+  positions.clear();
+  positions.reserve(numAtoms);
+  vector<StringView> tokens;
+  for (size_t i = 0; i < numAtoms; ++i) {
+    getline(in, buffer);
+    split(buffer, ' ', tokens);
+    if (tokens.size() + 2 < frame.labels.size())
+      return false;
+    positions.push_back(frame.position(tokens));
+  }
+  return true;
+}
+
+} // namespace
+
+LammpsTrajectoryFormat::LammpsTrajectoryFormat() {}
+
+LammpsTrajectoryFormat::~LammpsTrajectoryFormat() {}
+
+bool LammpsTrajectoryFormat::read(std::istream& inStream, Core::Molecule& mol)
+{
+  string buffer, error;
+  getline(inStream, buffer); // Finish the first line
+  buffer = trimmed(buffer);
+  if (buffer != "ITEM: TIMESTEP") {
+    appendError("No timestep item found.");
+    return false;
+  }
+
+  LammpsFrame frame;
+  std::streamoff firstFrame = inStream.tellg();
+  if (!readLammpsHeader(inStream, frame, error)) {
+    appendError(error);
+    return false;
+  }
+  mol.setTimeStep(frame.timestep, 0);
+  size_t numAtoms = frame.numAtoms;
+
+  typedef map<string, unsigned char> AtomTypeMap;
+  AtomTypeMap atomTypes;
+  unsigned char customElementCounter = CustomElementMin;
 
   // Parse atoms
+  vector<StringView> tokens;
   for (size_t i = 0; i < numAtoms; ++i) {
     getline(inStream, buffer);
-    vector<string> tokens(split(buffer, ' '));
+    split(buffer, ' ', tokens);
 
-    if (tokens.size() < labels.size() - 2) {
+    if (tokens.size() + 2 < frame.labels.size()) {
       appendError("Not enough tokens in this line: " + buffer);
       return false;
     }
 
     unsigned char atomicNum(0);
-    atomicNum = lexicalCast<short int>(tokens[type_idx - 2]);
-
-    // If parsed coordinates are fractional, the corresponding unscaling is
-    // done. Else the positions are assigned as parsed.
-    Vector3 pos((1 - scale_x) * lexicalCast<double>(tokens[x_idx - 2]) +
-                  scale_x * (x_min + (x_max - x_min) *
-                                       lexicalCast<double>(tokens[x_idx - 2])),
-                (1 - scale_y) * lexicalCast<double>(tokens[y_idx - 2]) +
-                  scale_y * (y_min + (y_max - y_min) *
-                                       lexicalCast<double>(tokens[y_idx - 2])),
-                (1 - scale_z) * lexicalCast<double>(tokens[z_idx - 2]) +
-                  scale_z * (z_min + (z_max - z_min) *
-                                       lexicalCast<double>(tokens[z_idx - 2])));
+    atomicNum = lexicalCast<short int>(tokens[frame.type_idx - 2]);
 
     AtomTypeMap::const_iterator it = atomTypes.find(to_string(atomicNum));
     if (it == atomTypes.end()) {
@@ -209,7 +267,7 @@ bool LammpsTrajectoryFormat::read(std::istream& inStream, Core::Molecule& mol)
       }
     }
     Atom newAtom = mol.addAtom(it->second);
-    newAtom.setPosition3d(pos);
+    newAtom.setPosition3d(frame.position(tokens));
   }
 
   // Set the custom element map if needed:
@@ -232,163 +290,61 @@ bool LammpsTrajectoryFormat::read(std::istream& inStream, Core::Molecule& mol)
     appendError(errorStream.str());
     return false;
   }
-  mol.setCoordinate3d(mol.atomPositions3d(), 0);
-  mol.setUnitCell(new UnitCell(Vector3(x_max - x_min, 0, 0),
-                               Vector3(tilt_xy, y_max - y_min, 0),
-                               Vector3(tilt_xz, tilt_yz, z_max - z_min)));
+  mol.setUnitCell(frame.unitCell());
+
+  // With frames read on demand only the headers are parsed while indexing,
+  // for the timesteps and the unit cell of the last frame.
+  bool onDemand = readFramesOnDemand(inStream);
+  vector<std::streamoff> offsets(1, firstFrame);
+  if (!onDemand)
+    mol.setCoordinate3d(mol.atomPositions3d(), 0);
 
   // Do we have an animation?
-  size_t numAtoms2;
   int coordSet = 1;
   while (getline(inStream, buffer) && trimmed(buffer) == "ITEM: TIMESTEP") {
-    x_idx = -1;
-    y_idx = -1;
-    z_idx = -1;
-    type_idx = -1;
-    id_idx = -1;
-    x_min = 0;
-    x_max = 0;
-    y_min = 0;
-    y_max = 0;
-    z_min = 0;
-    z_max = 0;
-    tilt_xy = 0;
-    tilt_xz = 0;
-    tilt_yz = 0;
-    scale_x = 0.;
-    scale_y = 0.;
-    scale_z = 0.;
-
-    getline(inStream, buffer);
-    if (!buffer.empty()) {
-      timestep = lexicalCast<size_t>(buffer);
-      mol.setTimeStep(timestep, coordSet);
-    }
-
-    getline(inStream, buffer);
-    buffer = trimmed(buffer);
-    if (buffer != "ITEM: NUMBER OF ATOMS") {
-      appendError("No number of atoms item found.");
+    std::streamoff offset = inStream.tellg();
+    if (!readLammpsHeader(inStream, frame, error)) {
+      appendError(error);
       return false;
     }
-    getline(inStream, buffer);
-    if (!buffer.empty())
-      numAtoms2 = lexicalCast<size_t>(buffer);
+    mol.setTimeStep(frame.timestep, coordSet);
 
-    if (numAtoms2 != numAtoms) {
+    if (frame.numAtoms != numAtoms) {
       appendError("Number of atoms isn't constant in the trajectory.");
     }
 
-    // If unit cell is triclinic, tilt factors are needed to define the
-    // supercell
-    getline(inStream, buffer);
-    if (buffer.find("ITEM: BOX BOUNDS xy xz yz") == 0) {
-      // Read x_min, x_max, tiltfactor_xy
-      getline(inStream, buffer);
-      vector<string> box_bounds_x(split(buffer, ' '));
-      x_min = lexicalCast<double>(box_bounds_x.at(0));
-      x_max = lexicalCast<double>(box_bounds_x.at(1));
-      tilt_xy = lexicalCast<double>(box_bounds_x.at(2));
-      // Read y_min, y_max, tiltfactor_xz
-      getline(inStream, buffer);
-      vector<string> box_bounds_y(split(buffer, ' '));
-      y_min = lexicalCast<double>(box_bounds_y.at(0));
-      y_max = lexicalCast<double>(box_bounds_y.at(1));
-      tilt_xz = lexicalCast<double>(box_bounds_y.at(2));
-      getline(inStream, buffer);
-      // Read z_min, z_max, tiltfactor_yz
-      vector<string> box_bounds_z(split(buffer, ' '));
-      z_min = lexicalCast<double>(box_bounds_z.at(0));
-      z_max = lexicalCast<double>(box_bounds_z.at(1));
-      tilt_yz = lexicalCast<double>(box_bounds_z.at(2));
-
-      x_min -= std::min(std::min(std::min(tilt_xy, tilt_xz), tilt_xy + tilt_xz),
-                        (double)0);
-      x_max -= std::max(std::max(std::max(tilt_xy, tilt_xz), tilt_xy + tilt_xz),
-                        (double)0);
-      y_min -= std::min(tilt_yz, (double)0);
-      y_max -= std::max(tilt_yz, (double)0);
-    }
-
-    // Else if unit cell is orthogonal, tilt factors are zero
-    else if (buffer.find("ITEM: BOX BOUNDS") == 0) {
-      // Read x_min, x_max
-      getline(inStream, buffer);
-      vector<string> box_bounds_x(split(buffer, ' '));
-      x_min = lexicalCast<double>(box_bounds_x.at(0));
-      x_max = lexicalCast<double>(box_bounds_x.at(1));
-      // Read y_min, y_max
-      getline(inStream, buffer);
-      vector<string> box_bounds_y(split(buffer, ' '));
-      y_min = lexicalCast<double>(box_bounds_y.at(0));
-      y_max = lexicalCast<double>(box_bounds_y.at(1));
-      // Read z_min, z_max
-      getline(inStream, buffer);
-      vector<string> box_bounds_z(split(buffer, ' '));
-      z_min = lexicalCast<double>(box_bounds_z.at(0));
-      z_max = lexicalCast<double>(box_bounds_z.at(1));
-    }
-
-    // x,y,z stand for the coordinate axes
-    // s stands for scaled coordinates
-    // u stands for unwrapped coordinates
-    // scale_x = 0. if coordinates are cartesian and 1 if fractional (scaled)
-    getline(inStream, buffer);
-    labels = vector<string>(split(buffer, ' '));
-    for (size_t i = 0; i < labels.size(); ++i) {
-      if (labels[i] == "x" || labels[i] == "xu") {
-        x_idx = i;
-        scale_x = 0.;
-      } else if (labels[i] == "xs" || labels[i] == "xsu") {
-        x_idx = i;
-        scale_x = 1.;
-      } else if (labels[i] == "y" || labels[i] == "yu") {
-        y_idx = i;
-        scale_y = 0.;
-      } else if (labels[i] == "ys" || labels[i] == "ysu") {
-        y_idx = i;
-        scale_y = 1.;
-      } else if (labels[i] == "z" || labels[i] == "zu") {
-        z_idx = i;
-        scale_z = 0.;
-      } else if (labels[i] == "zs" || labels[i] == "zsu") {
-        z_idx = i;
-        scale_z = 1.;
-      } else if (labels[i] == "type")
-        type_idx = i;
-      else if (labels[i] == "id")
-        id_idx = i;
-    }
-
-    Array<Vector3> positions;
-    positions.reserve(numAtoms);
-
-    for (size_t i = 0; i < numAtoms; ++i) {
-      getline(inStream, buffer);
-      vector<string> tokens(split(buffer, ' '));
-      if (tokens.size() < 5) {
+    if (onDemand) {
+      for (size_t i = 0; i < numAtoms; ++i)
+        inStream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+      if (inStream.fail())
+        break;
+      offsets.push_back(offset);
+      ++coordSet;
+    } else {
+      Array<Vector3> positions;
+      if (!readLammpsPositions(inStream, frame, numAtoms, positions, buffer)) {
         appendError("Not enough tokens in this line: " + buffer);
         return false;
       }
-      // If parsed coordinates are fractional, the corresponding unscaling is
-      // done. Else the positions are assigned as parsed.
-      Vector3 pos(
-        (1 - scale_x) * lexicalCast<double>(tokens[x_idx - 2]) +
-          scale_x *
-            (x_min + (x_max - x_min) * lexicalCast<double>(tokens[x_idx - 2])),
-        (1 - scale_y) * lexicalCast<double>(tokens[y_idx - 2]) +
-          scale_y *
-            (y_min + (y_max - y_min) * lexicalCast<double>(tokens[y_idx - 2])),
-        (1 - scale_z) * lexicalCast<double>(tokens[z_idx - 2]) +
-          scale_z *
-            (z_min + (z_max - z_min) * lexicalCast<double>(tokens[z_idx - 2])));
-      positions.push_back(pos);
+      mol.setCoordinate3d(positions, coordSet++);
     }
+    mol.setUnitCell(frame.unitCell());
+  }
 
-    mol.setCoordinate3d(positions, coordSet++);
-    mol.setUnitCell(new UnitCell(Vector3(x_max - x_min, 0, 0),
-                                 Vector3(tilt_xy, y_max - y_min, 0),
-                                 Vector3(tilt_xz, tilt_yz, z_max - z_min)));
+  if (onDemand) {
+    auto trajectory = std::make_shared<FileTrajectory>(
+      fileName(), offsets,
+      [numAtoms](std::istream& in, Array<Vector3>& positions) {
+        LammpsFrame header;
+        string line;
+        return readLammpsHeader(in, header, line) &&
+               readLammpsPositions(in, header, numAtoms, positions, line);
+      });
+    if (!trajectory->isOpen()) {
+      appendError("Error reopening file: " + fileName());
+      return false;
+    }
+    mol.setTrajectoryProvider(trajectory);
   }
 
   return true;
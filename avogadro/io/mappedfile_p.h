@@ -0,0 +1,139 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_IO_MAPPEDFILE_P_H
+#define AVOGADRO_IO_MAPPEDFILE_P_H
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/vector.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace Avogadro {
+namespace Io {
+
+/**
+ * @brief Reverse the byte order of each of the @p count values.
+ */
+template <typename T>
+void swapByteOrder(T* values, size_t count)
+{
+  static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Only 32 and 64 bit values");
+  // Swap as unsigned integers, so the loop can be vectorized
+  typedef typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type
+    Word;
+  for (size_t i = 0; i < count; ++i) {
+    Word word;
+    std::memcpy(&word, values + i, sizeof(T));
+#if defined(__GNUC__) || defined(__clang__)
+    word = sizeof(T) == 4 ? __builtin_bswap32(static_cast<uint32_t>(word))
+                          : __builtin_bswap64(word);
+#else
+    Word swapped = 0;
+    for (size_t b = 0; b < sizeof(T); ++b)
+      swapped = (swapped << 8) | ((word >> (8 * b)) & 0xff);
+    word = swapped;
+#endif
+    std::memcpy(values + i, &word, sizeof(T));
+  }
+}
+
+/**
+ * @brief A read only memory map of a whole file.
+ *
+ * Binary trajectory readers map the file once and decode the frames straight
+ * from the mapped pages, the operating system takes care of reading ahead and
+ * of dropping pages that are no longer used.
+ */
+class MappedFile
+{
+public:
+  MappedFile();
+  ~MappedFile();
+
+  bool open(const std::string& fileName);
+  void close();
+
+  bool isOpen() const { return m_data != nullptr; }
+  const char* data() const { return m_data; }
+  size_t size() const { return m_size; }
+
+  /**
+   * @brief Copy @p count values of type T starting at @p offset, reversing the
+   * byte order of each one if @p swap is true.
+   * @return False if the values are not all inside the file.
+   */
+  template <typename T>
+  bool read(size_t offset, T* values, size_t count, bool swap) const;
+
+  /** @return True if the byte order of the host is big endian. */
+  static bool hostIsBigEndian();
+
+private:
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* m_data;
+  size_t m_size;
+#ifdef _WIN32
+  void* m_file;
+  void* m_mapping;
+#endif
+};
+
+template <typename T>
+bool MappedFile::read(size_t offset, T* values, size_t count, bool swap) const
+{
+  static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Only 32 and 64 bit values");
+  if (offset > m_size || count > (m_size - offset) / sizeof(T))
+    return false;
+
+  std::memcpy(values, m_data + offset, count * sizeof(T));
+  if (swap)
+    swapByteOrder(values, count);
+  return true;
+}
+
+/**
+ * @brief Set @p positions from a block of x, followed by blocks of y and z
+ * coordinates of @p count atoms each, multiplied by @p scale.
+ */
+template <typename T>
+void positionsFromBlocks(const T* xyz, size_t count, double scale,
+                         Core::Array<Vector3>& positions)
+{
+  typedef Eigen::Matrix<T, Eigen::Dynamic, 3> Blocks;
+  positions.resize(count);
+  if (count == 0)
+    return;
+  Eigen::Map<const Blocks> blocks(xyz, count, 3);
+  Eigen::Map<Eigen::Matrix3Xd>(positions.data()->data(), 3, count) =
+    blocks.transpose().template cast<double>() * scale;
+}
+
+/**
+ * @brief Set @p positions from the x, y, z triplets of @p count atoms,
+ * multiplied by @p scale.
+ */
+template <typename T>
+void positionsFromTriplets(const T* xyz, size_t count, double scale,
+                           Core::Array<Vector3>& positions)
+{
+  typedef Eigen::Matrix<T, 3, Eigen::Dynamic> Triplets;
+  positions.resize(count);
+  if (count == 0)
+    return;
+  Eigen::Map<Eigen::Matrix3Xd>(positions.data()->data(), 3, count) =
+    Eigen::Map<const Triplets>(xyz, 3, count).template cast<double>() * scale;
+}
+
+} // namespace Io
+} // namespace Avogadro
+
+#endif // AVOGADRO_IO_MAPPEDFILE_P_H
@@ -27,6 +27,7 @@ using Avogadro::Core::SecondaryStructureAssigner;
 using Avogadro::Core::UnitCell;
 using Avogadro::Core::lexicalCast;
 using Avogadro::Core::startsWith;
+using Avogadro::Core::StringView;
 using Avogadro::Core::trimmed;
 
 using std::getline;
@@ -52,6 +53,8 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
   Array<Vector3> positions;
 
   while (getline(in, buffer)) { // Read Each line one by one
+    // Fixed width fields are parsed in place, without copying them
+    StringView line(buffer);
 
     if (startsWith(buffer, "ENDMDL")) {
       if (coordSet == 0) {
@@ -68,12 +71,12 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
     else if (startsWith(buffer, "CRYST1")) {
       // PDB reports in degrees and Angstroms
       //   Avogadro uses radians internally
-      Real a = lexicalCast<Real>(buffer.substr(6, 9), ok);
-      Real b = lexicalCast<Real>(buffer.substr(15, 9), ok);
-      Real c = lexicalCast<Real>(buffer.substr(24, 9), ok);
-      Real alpha = lexicalCast<Real>(buffer.substr(33, 7), ok) * DEG_TO_RAD;
-      Real beta = lexicalCast<Real>(buffer.substr(40, 7), ok) * DEG_TO_RAD;
-      Real gamma = lexicalCast<Real>(buffer.substr(47, 8), ok) * DEG_TO_RAD;
+      Real a = lexicalCast<Real>(line.substr(6, 9), ok);
+      Real b = lexicalCast<Real>(line.substr(15, 9), ok);
+      Real c = lexicalCast<Real>(line.substr(24, 9), ok);
+      Real alpha = lexicalCast<Real>(line.substr(33, 7), ok) * DEG_TO_RAD;
+      Real beta = lexicalCast<Real>(line.substr(40, 7), ok) * DEG_TO_RAD;
+      Real gamma = lexicalCast<Real>(line.substr(47, 8), ok) * DEG_TO_RAD;
 
       Core::UnitCell* cell = new Core::UnitCell(a, b, c, alpha, beta, gamma);
       mol.setUnitCell(cell);
@@ -81,23 +84,25 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
 
     else if (startsWith(buffer, "ATOM") || startsWith(buffer, "HETATM")) {
       // First we initialize the residue instance
-      size_t residueId = lexicalCast<size_t>(buffer.substr(22, 4), ok);
+      // Sequence numbers may be negative, they are stored as an Index
+      int residueNumber = lexicalCast<int>(line.substr(22, 4), ok);
       if (!ok) {
         appendError("Failed to parse residue sequence number: " +
                     buffer.substr(22, 4));
         return false;
       }
+      size_t residueId = static_cast<size_t>(residueNumber);
 
       if (residueId != currentResidueId) {
         currentResidueId = residueId;
 
-        string residueName = lexicalCast<string>(buffer.substr(17, 3), ok);
+        string residueName = lexicalCast<string>(line.substr(17, 3), ok);
         if (!ok) {
           appendError("Failed to parse residue name: " + buffer.substr(17, 3));
           return false;
         }
 
-        char chainId = lexicalCast<char>(buffer.substr(21, 1), ok);
+        char chainId = lexicalCast<char>(line.substr(21, 1), ok);
         if (!ok) {
           chainId = 'A'; // it's a non-standard "PDB"-like file
         }
@@ -107,26 +112,26 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
           r->setHeterogen(true);
       }
 
-      string atomName = lexicalCast<string>(buffer.substr(12, 4), ok);
+      string atomName = lexicalCast<string>(line.substr(12, 4), ok);
       if (!ok) {
         appendError("Failed to parse atom name: " + buffer.substr(12, 4));
         return false;
       }
 
       Vector3 pos; // Coordinates
-      pos.x() = lexicalCast<Real>(buffer.substr(30, 8), ok);
+      pos.x() = lexicalCast<Real>(line.substr(30, 8), ok);
       if (!ok) {
         appendError("Failed to parse x coordinate: " + buffer.substr(30, 8));
         return false;
       }
 
-      pos.y() = lexicalCast<Real>(buffer.substr(38, 8), ok);
+      pos.y() = lexicalCast<Real>(line.substr(38, 8), ok);
       if (!ok) {
         appendError("Failed to parse y coordinate: " + buffer.substr(38, 8));
         return false;
       }
 
-      pos.z() = lexicalCast<Real>(buffer.substr(46, 8), ok);
+      pos.z() = lexicalCast<Real>(line.substr(46, 8), ok);
       if (!ok) {
         appendError("Failed to parse z coordinate: " + buffer.substr(46, 8));
         return false;
@@ -158,7 +163,7 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
     else if (startsWith(buffer, "TER")) { //  This is very important, each TER
                                           //  record also counts in the serial.
       // Need to account for that when comparing with CONECT
-      terList.push_back(lexicalCast<int>(buffer.substr(6, 5), ok));
+      terList.push_back(lexicalCast<int>(line.substr(6, 5), ok));
 
       if (!ok) {
         appendError("Failed to parse TER serial");
@@ -167,7 +172,7 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
     }
 
     else if (startsWith(buffer, "CONECT")) {
-      int a = lexicalCast<int>(buffer.substr(6, 5), ok);
+      int a = lexicalCast<int>(line.substr(6, 5), ok);
       if (!ok) {
         appendError("Failed to parse coordinate a " + buffer.substr(6, 5));
         return false;
@@ -185,7 +190,7 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
           break;
 
         else {
-          int b = lexicalCast<int>(buffer.substr(bCoords[i], 5), ok) - 1;
+          int b = lexicalCast<int>(line.substr(bCoords[i], 5), ok) - 1;
           if (!ok) {
             appendError("Failed to parse coordinate b" + std::to_string(i) +
                         " " + buffer.substr(bCoords[i], 5));
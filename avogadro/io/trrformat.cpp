@@ -15,6 +15,7 @@
 ******************************************************************************/
 
 #include "trrformat.h"
+#include "filetrajectory_p.h"
 #include "struct.h"
 
 #include <avogadro/core/elements.h>
@@ -23,8 +24,10 @@
 #include <avogadro/core/utilities.h>
 #include <avogadro/core/vector.h>
 
+#include <algorithm>
 #include <iomanip>
 #include <istream>
+#include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
@@ -86,7 +89,7 @@ int isDouble(map<string, int>& header)
   for (int i = 0; i < (int)(sizeof(headerKeys) / sizeof(*headerKeys)); i++) {
     if (header[headerKeys[i]] != 0) {
       if (headerKeys[i] == "box_size") {
-        size = (int)(header[headerKeys[i]] / DIM * DIM);
+        size = (int)(header[headerKeys[i]] / (DIM * DIM));
         break;
       } else {
         size = (int)(header[headerKeys[i]] / (header["natoms"] * DIM));
@@ -97,6 +100,117 @@ int isDouble(map<string, int>& header)
   return size == SIZE_DOUBLE;
 }
 
+namespace {
+
+template <typename T>
+bool readTriplets(std::istream& in, int natoms, bool swap,
+                  Array<Vector3>& positions)
+{
+  vector<T> xyz(static_cast<size_t>(natoms) * DIM);
+  in.read(reinterpret_cast<char*>(xyz.data()), xyz.size() * sizeof(T));
+  if (!in)
+    return false;
+  if (swap)
+    swapByteOrder(xyz.data(), xyz.size());
+  positionsFromTriplets(xyz.data(), natoms, NM_TO_ANGSTROM, positions);
+  return true;
+}
+
+// Read the positions, the first of the coordinate blocks of a frame.
+bool readTrrPositions(std::istream& in, char endian, bool doubleStatus,
+                      int natoms, Array<Vector3>& positions)
+{
+  bool swap = (endian == '>') != MappedFile::hostIsBigEndian();
+  return doubleStatus ? readTriplets<double>(in, natoms, swap, positions)
+                      : readTriplets<float>(in, natoms, swap, positions);
+}
+
+template <typename T>
+bool mappedTriplets(const MappedFile& file, size_t offset, int natoms,
+                    bool swap, Array<Vector3>& positions)
+{
+  vector<T> xyz(static_cast<size_t>(natoms) * DIM);
+  if (!file.read(offset, xyz.data(), xyz.size(), swap))
+    return false;
+  positionsFromTriplets(xyz.data(), natoms, NM_TO_ANGSTROM, positions);
+  return true;
+}
+
+// Decode the positions of a validated frame from the mapped file.
+bool mappedTrrPositions(const MappedFile& file, size_t offset, int natoms,
+                        bool doubleStatus, bool swap,
+                        Array<Vector3>& positions)
+{
+  return doubleStatus
+           ? mappedTriplets<double>(file, offset, natoms, swap, positions)
+           : mappedTriplets<float>(file, offset, natoms, swap, positions);
+}
+
+// Where the blocks of a frame start in a mapped file, 0 if not present.
+struct TrrFrame
+{
+  size_t box = 0;
+  size_t positions = 0;
+  size_t next = 0;
+  int natoms = 0;
+  bool doubleStatus = false;
+};
+
+// Walk over the header of the frame at offset, checking that the frame is
+// complete and that its blocks have the expected sizes.
+bool mappedTrrFrame(const MappedFile& file, size_t offset, bool swap,
+                    TrrFrame& frame)
+{
+  int32_t magic, lengths[2];
+  if (!file.read(offset, &magic, 1, swap) || magic != GROMACS_MAGIC ||
+      !file.read(offset + sizeof(magic), lengths, 2, swap) || lengths[0] < 1) {
+    return false;
+  }
+
+  size_t pos = offset + sizeof(magic) + sizeof(lengths);
+  if (pos + lengths[0] - 1 > file.size() ||
+      string(file.data() + pos, lengths[0] - 1).substr(0, 12) != TRRVERSION) {
+    return false;
+  }
+  pos += lengths[0] - 1;
+
+  // "ir_size", "e_size", "box_size", "vir_size", "pres_size",
+  // "top_size", "sym_size", "x_size", "v_size", "f_size",
+  // "natoms", "step", "nre"
+  int32_t sizes[13];
+  if (!file.read(pos, sizes, 13, swap))
+    return false;
+  pos += sizeof(sizes);
+  frame.natoms = sizes[10];
+  if (frame.natoms <= 0)
+    return false;
+
+  int realSize = sizeof(float);
+  if (sizes[2] != 0)
+    realSize = sizes[2] / (DIM * DIM);
+  else if (sizes[7] != 0 || sizes[8] != 0 || sizes[9] != 0)
+    realSize = std::max(std::max(sizes[7], sizes[8]), sizes[9]) /
+               (frame.natoms * DIM);
+  if (realSize != sizeof(float) && realSize != sizeof(double))
+    return false;
+  frame.doubleStatus = realSize == sizeof(double);
+
+  // Timestep and lambda
+  pos += 2 * realSize;
+  frame.box = sizes[2] != 0 ? pos : 0;
+  pos += sizes[2] + sizes[3] + sizes[4];
+  if (sizes[7] != 0 && sizes[7] != frame.natoms * DIM * realSize)
+    return false;
+  frame.positions = sizes[7] != 0 ? pos : 0;
+  pos += sizes[7] + sizes[8] + sizes[9];
+  if (pos > file.size())
+    return false;
+  frame.next = pos;
+  return true;
+}
+
+} // namespace
+
 TrrFormat::TrrFormat() {}
 
 TrrFormat::~TrrFormat() {}
@@ -216,6 +330,13 @@ bool TrrFormat::read(std::istream& inStream, Core::Molecule& mol)
   AtomTypeMap atomTypes;
   unsigned char customElementCounter = CustomElementMin;
 
+  // With frames read on demand only the frame headers are parsed, recording
+  // where the coordinates of each frame start.
+  bool onDemand = readFramesOnDemand(inStream) && header["x_size"] != 0;
+  vector<std::streamoff> offsets(1, inStream.tellg());
+  std::streamoff coordinatesSize =
+    header["x_size"] + header["v_size"] + header["f_size"];
+
   // Reading the coordinates of positions, velocities and forces
   for (int _kid = 0; _kid < 3; ++_kid) {
     natoms = header["natoms"];
@@ -271,7 +392,59 @@ bool TrrFormat::read(std::istream& inStream, Core::Molecule& mol)
       mol.setCustomElementMap(elementMap);
     }
   }
-  mol.setCoordinate3d(mol.atomPositions3d(), 0);
+  // Files are mapped into memory, the frame headers are validated once and the
+  // positions then decoded straight from the mapped pages.
+  std::shared_ptr<MappedFile> mapped;
+  if (isFileStream(inStream)) {
+    mapped = std::make_shared<MappedFile>();
+    if (!mapped->open(fileName()))
+      mapped.reset();
+  }
+  if (mapped) {
+    bool swap = (endian == '>') != MappedFile::hostIsBigEndian();
+    vector<size_t> positionOffsets;
+    size_t box = 0;
+    TrrFrame frame;
+    for (size_t offset = 0; offset < mapped->size() &&
+                            mappedTrrFrame(*mapped, offset, swap, frame);
+         offset = frame.next) {
+      if (frame.natoms != natoms || frame.doubleStatus != doubleStatus)
+        break;
+      if (frame.positions != 0)
+        positionOffsets.push_back(frame.positions);
+      if (frame.box != 0)
+        box = frame.box;
+    }
+
+    // The unit cell of the last frame, as read by the stream parser
+    Array<Vector3> cell;
+    if (box != 0 &&
+        mappedTrrPositions(*mapped, box, DIM, doubleStatus, swap, cell)) {
+      mol.setUnitCell(new UnitCell(cell[0], cell[1], cell[2]));
+    }
+
+    auto reader = [natoms, doubleStatus, swap](const MappedFile& file,
+                                               size_t offset,
+                                               Array<Vector3>& positions) {
+      return mappedTrrPositions(file, offset, natoms, doubleStatus, swap,
+                                positions);
+    };
+    if (onDemand) {
+      mol.setTrajectoryProvider(
+        std::make_shared<MappedTrajectory>(mapped, positionOffsets, reader));
+    } else {
+      Array<Vector3> positions;
+      for (size_t i = 0; i < positionOffsets.size(); ++i) {
+        if (!reader(*mapped, positionOffsets[i], positions))
+          break;
+        mol.setCoordinate3d(positions, i);
+      }
+    }
+    return true;
+  }
+
+  if (!onDemand)
+    mol.setCoordinate3d(mol.atomPositions3d(), 0);
 
   // Do we have an animation?
   // EOF check
@@ -377,45 +550,38 @@ bool TrrFormat::read(std::istream& inStream, Core::Molecule& mol)
     }
 
     natoms = header["natoms"];
-    Array<Vector3> positions;
-    positions.reserve(natoms);
-
-    // Reading the coordinates of positions, velocities and forces
-    for (int _kid = 0; _kid < 3; ++_kid) {
-      double coordsDouble[DIM];
-      float coordsFloat[DIM];
-      for (int i = 0; i < natoms; ++i) {
-        if (header[keyCheck2[_kid]] != 0) {
-          memset(coordsDouble, 0, sizeof(coordsDouble));
-          memset(coordsFloat, 0, sizeof(coordsFloat));
-          if (doubleStatus) {
-            snprintf(fmt, sizeof(fmt), "%c%dd", endian, DIM);
-            inStream.read(buff, struct_calcsize(fmt));
-            struct_unpack(buff, fmt, &coordsDouble[0], &coordsDouble[1],
-                          &coordsDouble[2]);
-          } else {
-            snprintf(fmt, sizeof(fmt), "%c%df", endian, DIM);
-            inStream.read(buff, struct_calcsize(fmt));
-            struct_unpack(buff, fmt, &coordsFloat[0], &coordsFloat[1],
-                          &coordsFloat[2]);
-          }
+    if (onDemand) {
+      if (std::streamoff(inStream.tellg()) + coordinatesSize > fileLen)
+        break;
+      offsets.push_back(inStream.tellg());
+      inStream.seekg(coordinatesSize, std::ios_base::cur);
+      continue;
+    }
 
-          if (keyCheck2[_kid] == "x_size") {
-            // If parsed coordinates are fractional, the corresponding unscaling
-            // is done. Else the positions are assigned as parsed.
-            Vector3 pos(coordsDouble[0] * NM_TO_ANGSTROM +
-                          coordsFloat[0] * NM_TO_ANGSTROM,
-                        coordsDouble[1] * NM_TO_ANGSTROM +
-                          coordsFloat[1] * NM_TO_ANGSTROM,
-                        coordsDouble[2] * NM_TO_ANGSTROM +
-                          coordsFloat[2] * NM_TO_ANGSTROM);
-            positions.push_back(pos);
-          }
-        }
-      }
+    // Reading the positions, and skipping the velocities and forces
+    Array<Vector3> positions;
+    if (header["x_size"] != 0 &&
+        !readTrrPositions(inStream, endian, doubleStatus, natoms, positions)) {
+      appendError("Error reading the positions of frame " +
+                  to_string(coordSet) + ".");
+      return false;
     }
+    inStream.seekg(header["v_size"] + header["f_size"], std::ios_base::cur);
     mol.setCoordinate3d(positions, coordSet++);
-    positions.clear();
+  }
+
+  if (onDemand) {
+    auto trajectory = std::make_shared<FileTrajectory>(
+      fileName(), offsets,
+      [endian, doubleStatus, natoms](std::istream& in,
+                                     Array<Vector3>& positions) {
+        return readTrrPositions(in, endian, doubleStatus, natoms, positions);
+      });
+    if (!trajectory->isOpen()) {
+      appendError("Error reopening file: " + fileName());
+      return false;
+    }
+    mol.setTrajectoryProvider(trajectory);
   }
   return true;
 }
@@ -4,6 +4,7 @@
 ******************************************************************************/
 
 #include "xyzformat.h"
+#include "filetrajectory_p.h"
 
 #include <avogadro/core/elements.h>
 #include <avogadro/core/molecule.h>
@@ -15,6 +16,8 @@
 
 #include <iomanip>
 #include <istream>
+#include <limits>
+#include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
@@ -34,6 +37,7 @@ using Core::Array;
 using Core::Atom;
 using Core::Elements;
 using Core::Molecule;
+using Core::StringView;
 using Core::lexicalCast;
 using Core::split;
 using Core::trimmed;
@@ -42,6 +46,37 @@ using Core::trimmed;
 using std::isalpha;
 #endif
 
+namespace {
+
+// Read the positions from the atom lines of a frame.
+bool readXyzPositions(std::istream& in, size_t numAtoms,
+                      Array<Vector3>& positions, string& buffer)
+{
+  positions.clear();
+  positions.reserve(numAtoms);
+  vector<StringView> tokens;
+  for (size_t i = 0; i < numAtoms; ++i) {
+    getline(in, buffer);
+    split(buffer, ' ', tokens);
+    if (tokens.size() < 4)
+      return false;
+    positions.push_back(Vector3(lexicalCast<double>(tokens[1]),
+                                lexicalCast<double>(tokens[2]),
+                                lexicalCast<double>(tokens[3])));
+  }
+  return true;
+}
+
+// Read the atom count and comment line of the next frame.
+bool nextXyzFrame(std::istream& in, size_t numAtoms, string& buffer)
+{
+  bool ok = false;
+  return getline(in, buffer) && lexicalCast<size_t>(buffer, ok) == numAtoms &&
+         ok && getline(in, buffer);
+}
+
+} // namespace
+
 XyzFormat::XyzFormat() {}
 
 XyzFormat::~XyzFormat() {}
@@ -92,9 +127,11 @@ bool XyzFormat::read(std::istream& inStream, Core::Molecule& mol)
   }
 
   // Parse atoms
+  std::streamoff firstFrame = inStream.tellg();
+  vector<StringView> tokens;
   for (size_t i = 0; i < numAtoms; ++i) {
     getline(inStream, buffer);
-    vector<string> tokens(split(buffer, ' '));
+    split(buffer, ' ', tokens);
 
     if (tokens.size() < 4) {
       appendError("Not enough tokens in this line: " + buffer);
@@ -103,7 +140,7 @@ bool XyzFormat::read(std::istream& inStream, Core::Molecule& mol)
 
     unsigned char atomicNum(0);
     if (isalpha(tokens[0][0]))
-      atomicNum = Elements::atomicNumberFromSymbol(tokens[0]);
+      atomicNum = Elements::atomicNumberFromSymbol(string(tokens[0]));
     else
       atomicNum = static_cast<unsigned char>(lexicalCast<short int>(tokens[0]));
 
@@ -125,39 +162,42 @@ bool XyzFormat::read(std::istream& inStream, Core::Molecule& mol)
   }
 
   // Do we have an animation?
-  size_t numAtoms2;
-  if (getline(inStream, buffer) && (numAtoms2 = lexicalCast<int>(buffer)) &&
-      numAtoms == numAtoms2) {
-    getline(inStream, buffer); // Skip the blank
-    mol.setCoordinate3d(mol.atomPositions3d(), 0);
-    int coordSet = 1;
-    while (numAtoms == numAtoms2) {
-      Array<Vector3> positions;
-      positions.reserve(numAtoms);
-
-      for (size_t i = 0; i < numAtoms; ++i) {
-        getline(inStream, buffer);
-        vector<string> tokens(split(buffer, ' '));
-        if (tokens.size() < 4) {
+  if (nextXyzFrame(inStream, numAtoms, buffer)) {
+    if (readFramesOnDemand(inStream)) {
+      // Index the frames, they are only parsed when requested
+      vector<std::streamoff> offsets(1, firstFrame);
+      do {
+        offsets.push_back(inStream.tellg());
+        for (size_t i = 0; i < numAtoms; ++i)
+          inStream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        if (inStream.fail()) {
+          offsets.pop_back();
+          break;
+        }
+      } while (nextXyzFrame(inStream, numAtoms, buffer));
+
+      auto trajectory = std::make_shared<FileTrajectory>(
+        fileName(), offsets,
+        [numAtoms](std::istream& in, Array<Vector3>& positions) {
+          string line;
+          return readXyzPositions(in, numAtoms, positions, line);
+        });
+      if (!trajectory->isOpen()) {
+        appendError("Error reopening file: " + fileName());
+        return false;
+      }
+      mol.setTrajectoryProvider(trajectory);
+    } else {
+      mol.setCoordinate3d(mol.atomPositions3d(), 0);
+      int coordSet = 1;
+      do {
+        Array<Vector3> positions;
+        if (!readXyzPositions(inStream, numAtoms, positions, buffer)) {
           appendError("Not enough tokens in this line: " + buffer);
           return false;
         }
-        Vector3 pos(lexicalCast<double>(tokens[1]),
-                    lexicalCast<double>(tokens[2]),
-                    lexicalCast<double>(tokens[3]));
-        positions.push_back(pos);
-      }
-
-      mol.setCoordinate3d(positions, coordSet++);
-
-      if (!getline(inStream, buffer)) {
-        numAtoms2 = lexicalCast<int>(buffer);
-        if (numAtoms == numAtoms2)
-          break;
-      }
-
-      std::getline(inStream, buffer); // Skip the blank
-      positions.clear();
+        mol.setCoordinate3d(positions, coordSet++);
+      } while (nextXyzFrame(inStream, numAtoms, buffer));
     }
   }
 
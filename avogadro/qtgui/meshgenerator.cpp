@@ -21,9 +21,15 @@
 #include <avogadro/core/mesh.h>
 #include <avogadro/core/mutex.h>
 
+#include <QtConcurrent/QtConcurrentMap>
+
 #include <QDebug>
 #include <QReadWriteLock>
 
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
 namespace Avogadro {
 namespace QtGui {
 
@@ -43,7 +49,7 @@ MeshGenerator::MeshGenerator(const Cube* cube_, Mesh* mesh_, float iso,
     m_mesh(nullptr), m_stepSize(0.0, 0.0, 0.0), m_min(0.0, 0.0, 0.0),
     m_dim(0, 0, 0), m_progmin(0), m_progmax(0)
 {
-  initialize(cube_, mesh_, iso);
+  initialize(cube_, mesh_, iso, reverse);
 }
 
 MeshGenerator::~MeshGenerator()
@@ -72,6 +78,101 @@ bool MeshGenerator::initialize(const Cube* cube_, Mesh* mesh_, float iso,
   return true;
 }
 
+namespace {
+
+// Read only view of the cube values, indexed as (x * ny + y) * nz + z.
+struct Grid
+{
+  const double* data;
+  int nx, ny, nz;
+  Vector3f spacing;
+
+  float value(int i, int j, int k) const
+  {
+    return static_cast<float>(
+      data[(static_cast<size_t>(i) * ny + j) * nz + k]);
+  }
+
+  // Difference along one axis, central in the interior, one sided at the edge.
+  float difference(int i, int j, int k, int axis) const
+  {
+    Vector3i lo(i, j, k);
+    Vector3i hi(i, j, k);
+    const int n = axis == 0 ? nx : (axis == 1 ? ny : nz);
+    if (lo[axis] > 0)
+      --lo[axis];
+    if (hi[axis] < n - 1)
+      ++hi[axis];
+    if (lo[axis] == hi[axis])
+      return 0.0f;
+    return (value(hi[0], hi[1], hi[2]) - value(lo[0], lo[1], lo[2])) /
+           (static_cast<float>(hi[axis] - lo[axis]) * spacing[axis]);
+  }
+
+  Vector3f gradient(const Vector3i& p) const
+  {
+    return Vector3f(difference(p[0], p[1], p[2], 0),
+                    difference(p[0], p[1], p[2], 1),
+                    difference(p[0], p[1], p[2], 2));
+  }
+};
+
+// A range of whole x planes, along with the vertices and triangles found in it.
+struct Slab
+{
+  Slab(int begin_, int end_) : begin(begin_), end(end_) {}
+
+  int begin;
+  int end;
+  std::vector<Vector3f> vertices;
+  std::vector<Vector3f> normals;
+  std::vector<unsigned int> triangles;
+};
+
+// A cube edge, as the grid point it starts from and the axis it runs along.
+struct EdgeOwner
+{
+  int offset[3];
+  int axis;
+};
+
+// Call f(j, k, axis, v0, v1) for every edge starting in plane i that crosses
+// the surface. The order is fixed, and defines the vertex numbering.
+template <typename Function>
+void forEachCrossing(const Grid& grid, float iso, int i, Function f)
+{
+  for (int j = 0; j < grid.ny; ++j) {
+    for (int k = 0; k < grid.nz; ++k) {
+      const float v0 = grid.value(i, j, k);
+      const bool inside = v0 <= iso;
+      if (i + 1 < grid.nx) {
+        const float v1 = grid.value(i + 1, j, k);
+        if ((v1 <= iso) != inside)
+          f(j, k, 0, v0, v1);
+      }
+      if (j + 1 < grid.ny) {
+        const float v1 = grid.value(i, j + 1, k);
+        if ((v1 <= iso) != inside)
+          f(j, k, 1, v0, v1);
+      }
+      if (k + 1 < grid.nz) {
+        const float v1 = grid.value(i, j, k + 1);
+        if ((v1 <= iso) != inside)
+          f(j, k, 2, v0, v1);
+      }
+    }
+  }
+}
+
+} // namespace
+
+inline float MeshGenerator::offset(float val1, float val2)
+{
+  if (val2 - val1 < 1.0e-9f && val1 - val2 < 1.0e-9f)
+    return 0.5;
+  return (m_iso - val1) / (val2 - val1);
+}
+
 void MeshGenerator::run()
 {
   if (!m_cube || !m_mesh) {
@@ -87,33 +188,153 @@ void MeshGenerator::run()
   m_mesh->setStable(false);
   m_mesh->clear();
 
-  m_vertices.reserve(m_dim.x() * m_dim.y() * m_dim.z() * 3);
-  m_normals.reserve(m_dim.x() * m_dim.y() * m_dim.z() * 3);
+  const std::vector<double>* data = m_cube->data();
+  const size_t points = static_cast<size_t>(m_dim.x()) * m_dim.y() * m_dim.z();
+  if (m_dim.minCoeff() < 2 || data->size() < points) {
+    m_cube->lock()->unlock();
+    m_mesh->setStable(true);
+    return;
+  }
 
-  // Now to march the cube
-  for (int i = 0; i < m_dim.x() - 1; ++i) {
-    for (int j = 0; j < m_dim.y() - 1; ++j) {
-      for (int k = 0; k < m_dim.z() - 1; ++k) {
-        marchingCube(Vector3i(i, j, k));
-      }
-    }
-    if (m_vertices.capacity() < m_vertices.size() + m_dim.y() * m_dim.x() * 3) {
-      m_vertices.reserve(m_vertices.capacity() * 2);
-      m_normals.reserve(m_normals.capacity() * 2);
+  Grid grid;
+  grid.data = data->data();
+  grid.nx = m_dim.x();
+  grid.ny = m_dim.y();
+  grid.nz = m_dim.z();
+  grid.spacing = m_stepSize;
+
+  // Each cube edge is identified by the corner it starts from and its axis
+  EdgeOwner owners[12];
+  for (int e = 0; e < 12; ++e) {
+    const int* a = a2iVertexOffset[a2iEdgeConnection[e][0]];
+    const int* b = a2iVertexOffset[a2iEdgeConnection[e][1]];
+    for (int d = 0; d < 3; ++d) {
+      owners[e].offset[d] = std::min(a[d], b[d]);
+      if (a[d] != b[d])
+        owners[e].axis = d;
     }
-    emit progressValueChanged(i);
   }
 
+  // Split the cube into slabs of whole x planes, x being the slowest index
+  const int planes = grid.nx;
+  const int slabSize =
+    std::max(2, planes / (4 * std::max(1, QThread::idealThreadCount())));
+  std::vector<Slab> slabs;
+  for (int i = 0; i < planes; i += slabSize)
+    slabs.push_back(Slab(i, std::min(i + slabSize, planes)));
+
+  // First find the vertices on the edges leaving each grid point
+  std::vector<unsigned int> planeOffsets(planes + 1, 0);
+  QtConcurrent::blockingMap(slabs, [&](Slab& slab) {
+    for (int i = slab.begin; i < slab.end; ++i) {
+      unsigned int count = 0;
+      forEachCrossing(grid, m_iso, i,
+                      [&](int j, int k, int axis, float v0, float v1) {
+                        const float t = offset(v0, v1);
+                        Vector3i p(i, j, k);
+                        Vector3f pos =
+                          m_min + p.cast<float>().cwiseProduct(m_stepSize);
+                        pos[axis] += t * m_stepSize[axis];
+                        Vector3i q(p);
+                        ++q[axis];
+                        Vector3f norm = -((1.0f - t) * grid.gradient(p) +
+                                          t * grid.gradient(q));
+                        norm.normalize();
+                        slab.vertices.push_back(pos);
+                        slab.normals.push_back(m_reverseWinding ? -norm
+                                                                : norm);
+                        ++count;
+                      });
+      planeOffsets[i + 1] = count;
+    }
+  });
+  for (int i = 0; i < planes; ++i)
+    planeOffsets[i + 1] += planeOffsets[i];
+
+  // Now march the cells, looking the shared vertices up by their edge
+  std::atomic<int> progress(0);
+  const size_t planeEdges = static_cast<size_t>(grid.ny) * grid.nz * 3;
+  auto edgeIndices = [&](int i, std::vector<unsigned int>& edges) {
+    unsigned int index = planeOffsets[i];
+    forEachCrossing(grid, m_iso, i, [&](int j, int k, int axis, float, float) {
+      edges[(static_cast<size_t>(j) * grid.nz + k) * 3 + axis] = index++;
+    });
+  };
+  QtConcurrent::blockingMap(slabs, [&](Slab& slab) {
+    std::vector<unsigned int> lower(planeEdges, 0);
+    std::vector<unsigned int> upper(planeEdges, 0);
+    if (slab.begin < planes - 1)
+      edgeIndices(slab.begin, lower);
+    for (int i = slab.begin; i < slab.end && i < planes - 1; ++i) {
+      edgeIndices(i + 1, upper);
+      for (int j = 0; j < grid.ny - 1; ++j) {
+        for (int k = 0; k < grid.nz - 1; ++k) {
+          // Find which vertices are inside of the surface
+          int flags = 0;
+          for (int c = 0; c < 8; ++c) {
+            if (grid.value(i + a2iVertexOffset[c][0],
+                           j + a2iVertexOffset[c][1],
+                           k + a2iVertexOffset[c][2]) <= m_iso) {
+              flags |= 1 << c;
+            }
+          }
+          if (aiCubeEdgeFlags[flags] == 0)
+            continue;
+
+          // Store the triangles, there can be up to five per cube
+          const int* table = a2iTriangleConnectionTable[flags];
+          for (int t = 0; t < 15 && table[t] >= 0; t += 3) {
+            unsigned int triangle[3];
+            for (int n = 0; n < 3; ++n) {
+              const EdgeOwner& owner = owners[table[t + n]];
+              const std::vector<unsigned int>& edges =
+                owner.offset[0] == 0 ? lower : upper;
+              triangle[n] =
+                edges[(static_cast<size_t>(j + owner.offset[1]) * grid.nz + k +
+                       owner.offset[2]) *
+                        3 +
+                      owner.axis];
+            }
+            // Make sure we get the triangle winding the right way around!
+            if (!m_reverseWinding) {
+              slab.triangles.insert(slab.triangles.end(), triangle,
+                                    triangle + 3);
+            } else {
+              slab.triangles.push_back(triangle[2]);
+              slab.triangles.push_back(triangle[1]);
+              slab.triangles.push_back(triangle[0]);
+            }
+          }
+        }
+      }
+      lower.swap(upper);
+      emit progressValueChanged(++progress);
+    }
+  });
+
   m_cube->lock()->unlock();
 
-  // Copy the data across
-  m_mesh->setVertices(m_vertices);
-  m_mesh->setNormals(m_normals);
-  m_mesh->setStable(true);
+  // Copy the data across, the slabs are already in order
+  Core::Array<Vector3f> vertices(planeOffsets[planes], Vector3f::Zero());
+  Core::Array<Vector3f> normals(planeOffsets[planes], Vector3f::Zero());
+  Core::Array<unsigned int> triangles;
+  size_t triangleCount = 0;
+  for (const Slab& slab : slabs)
+    triangleCount += slab.triangles.size();
+  triangles.reserve(triangleCount);
+  for (const Slab& slab : slabs) {
+    std::copy(slab.vertices.begin(), slab.vertices.end(),
+              vertices.begin() + planeOffsets[slab.begin]);
+    std::copy(slab.normals.begin(), slab.normals.end(),
+              normals.begin() + planeOffsets[slab.begin]);
+    triangles.insert(triangles.end(), slab.triangles.begin(),
+                     slab.triangles.end());
+  }
 
-  // Now we are done give all that memory back
-  m_vertices.resize(0);
-  m_normals.resize(0);
+  m_mesh->setVertices(vertices);
+  m_mesh->setNormals(normals);
+  m_mesh->setTriangles(triangles);
+  m_mesh->setStable(true);
 }
 
 void MeshGenerator::clear()
@@ -128,117 +349,6 @@ void MeshGenerator::clear()
   m_progmax = 0;
 }
 
-Vector3f MeshGenerator::normal(const Vector3f& pos)
-{
-  Vector3f norm(m_cube->valuef(pos - Vector3f(0.01f, 0.00f, 0.00f)) -
-                  m_cube->valuef(pos + Vector3f(0.01f, 0.00f, 0.00f)),
-                m_cube->valuef(pos - Vector3f(0.00f, 0.01f, 0.00f)) -
-                  m_cube->valuef(pos + Vector3f(0.00f, 0.01f, 0.00f)),
-                m_cube->valuef(pos - Vector3f(0.00f, 0.00f, 0.01f)) -
-                  m_cube->valuef(pos + Vector3f(0.00f, 0.00f, 0.01f)));
-  norm.normalize();
-  return norm;
-}
-
-inline float MeshGenerator::offset(float val1, float val2)
-{
-  if (val2 - val1 < 1.0e-9f && val1 - val2 < 1.0e-9f)
-    return 0.5;
-  return (m_iso - val1) / (val2 - val1);
-}
-
-unsigned long MeshGenerator::duplicate(const Vector3i&, const Vector3f&)
-{
-  // FIXME Not implemented yet.
-  return 0;
-}
-
-bool MeshGenerator::marchingCube(const Vector3i& pos)
-{
-  float afCubeValue[8];
-  Vector3f asEdgeVertex[12];
-  Vector3f asEdgeNorm[12];
-
-  // Calculate the position in the Cube
-  Vector3f fPos;
-  for (unsigned int i = 0; i < 3; ++i)
-    fPos[i] = static_cast<float>(pos[i]) * m_stepSize[i] + m_min[i];
-
-  // Make a local copy of the values at the cube's corners
-  for (int i = 0; i < 8; ++i) {
-    afCubeValue[i] = static_cast<float>(
-      m_cube->value(Vector3i(pos + Vector3i(a2iVertexOffset[i]))));
-  }
-
-  // Find which vertices are inside of the surface and which are outside
-  long iFlagIndex = 0;
-  for (int i = 0; i < 8; ++i) {
-    if (afCubeValue[i] <= m_iso) {
-      iFlagIndex |= 1 << i;
-    }
-  }
-
-  // Find which edges are intersected by the surface
-  long iEdgeFlags = aiCubeEdgeFlags[iFlagIndex];
-
-  // No intersections if the cube is entirely inside or outside of the surface
-  if (iEdgeFlags == 0) {
-    return false;
-  }
-
-  // Find the point of intersection of the surface with each edge
-  // Then find the normal to the surface at those points
-  for (int i = 0; i < 12; ++i) {
-    // if there is an intersection on this edge
-    if (iEdgeFlags & (1 << i)) {
-      float fOffset = offset(afCubeValue[a2iEdgeConnection[i][0]],
-                             afCubeValue[a2iEdgeConnection[i][1]]);
-
-      asEdgeVertex[i] =
-        Vector3f(fPos.x() +
-                   (a2fVertexOffset[a2iEdgeConnection[i][0]][0] +
-                    fOffset * a2fEdgeDirection[i][0]) *
-                     m_stepSize[0],
-                 fPos.y() +
-                   (a2fVertexOffset[a2iEdgeConnection[i][0]][1] +
-                    fOffset * a2fEdgeDirection[i][1]) *
-                     m_stepSize[1],
-                 fPos.z() +
-                   (a2fVertexOffset[a2iEdgeConnection[i][0]][2] +
-                    fOffset * a2fEdgeDirection[i][2]) *
-                     m_stepSize[2]);
-
-      /// FIXME Optimize this to only calculate normals when required
-      asEdgeNorm[i] = normal(asEdgeVertex[i]);
-    }
-  }
-
-  // Store the triangles that were found, there can be up to five per cube
-  for (int i = 0; i < 5; ++i) {
-    if (a2iTriangleConnectionTable[iFlagIndex][3 * i] < 0)
-      break;
-    int iVertex = 0;
-    iEdgeFlags = a2iTriangleConnectionTable[iFlagIndex][3 * i];
-    // Make sure we get the triangle winding the right way around!
-    if (!m_reverseWinding) {
-      for (int j = 0; j < 3; ++j) {
-        iVertex = a2iTriangleConnectionTable[iFlagIndex][3 * i + j];
-        m_indices.push_back(static_cast<unsigned int>(m_vertices.size()));
-        m_normals.push_back(asEdgeNorm[iVertex]);
-        m_vertices.push_back(asEdgeVertex[iVertex]);
-      }
-    } else {
-      for (int j = 2; j >= 0; --j) {
-        iVertex = a2iTriangleConnectionTable[iFlagIndex][3 * i + j];
-        m_indices.push_back(static_cast<unsigned int>(m_vertices.size()));
-        m_normals.push_back(-asEdgeNorm[iVertex]);
-        m_vertices.push_back(asEdgeVertex[iVertex]);
-      }
-    }
-  }
-  return true;
-}
-
 // Lists the positions, relative to vertex0, of the 8 vertices of a cube
 const float MeshGenerator::a2fVertexOffset[8][3] = {
   { 0.0, 0.0, 0.0 }, { 1.0, 0.0, 0.0 }, { 1.0, 1.0, 0.0 }, { 0.0, 1.0, 0.0 },
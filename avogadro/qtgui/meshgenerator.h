@@ -46,6 +46,11 @@ namespace QtGui {
  * by Cory Bloyd (marchingsource.cpp) and available at,
  * http://local.wasp.uwa.edu.au/~pbourke/geometry/polygonise/
  *
+ * Each surface vertex lies on a cube edge and is shared by all of the
+ * triangles that use that edge, so the resulting Mesh is indexed (see
+ * Mesh::triangles()). The cube is processed in parallel in slabs of whole
+ * planes, and the output does not depend on the number of threads used.
+ *
  * You must first initialize the class and then call run() to actually
  * polygonize the isosurface. Connect to the classes finished() signal to
  * do something once the polygonization is complete.
@@ -123,29 +128,15 @@ signals:
   void progressValueChanged(int);
 
 protected:
-  /**
-   * Get the normal to the supplied point. This operation is quite expensive
-   * and so should be avoided wherever possible.
-   * @param pos The position of the vertex whose normal is needed.
-   * @return The normal vector for the supplied point.
-   */
-  Vector3f normal(const Vector3f& pos);
-
   /**
    * Get the offset, i.e. the approximate point of intersection of the surface
    * between two points.
-   * @param val1 The position of the vertex whose normal is needed.
-   * @return The normal vector for the supplied point.
+   * @param val1 The value at the first end of the edge.
+   * @param val2 The value at the second end of the edge.
+   * @return The fraction of the edge from the first end to the surface.
    */
   float offset(float val1, float val2);
 
-  unsigned long duplicate(const Vector3i& c, const Vector3f& pos);
-
-  /**
-   * Perform a marching cubes step on a single cube.
-   */
-  bool marchingCube(const Vector3i& pos);
-
   float m_iso;              /** The value of the isosurface. */
   bool m_reverseWinding;    /** Whether the winding and normals are reversed */
   const Core::Cube* m_cube; /** The cube that we are generating a Mesh from. */
@@ -153,8 +144,6 @@ protected:
   Vector3f m_stepSize;      /** The step size vector for cube */
   Vector3f m_min;           /** The minimum point in the cube. */
   Vector3i m_dim;           /** The dimensions of the cube. */
-  Core::Array<Vector3f> m_vertices, m_normals;
-  Core::Array<unsigned int> m_indices;
   int m_progmin;
   int m_progmax;
 
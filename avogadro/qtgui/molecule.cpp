@@ -6,6 +6,7 @@
 #include "molecule.h"
 #include "rwmolecule.h"
 
+#include <algorithm>
 #include <iostream>
 
 namespace Avogadro {
@@ -180,9 +181,10 @@ void Molecule::addBonds(const Core::Array<std::pair<Index, Index>>& bonds,
                         const Core::Array<unsigned char>& orders)
 {
   assert(orders.size() == bonds.size());
-  for (Index i = 0; i < orders.size(); ++i) {
-    addBond(bonds[i].first, bonds[i].second, orders[i]);
-  }
+  Index firstBond = bondCount();
+  Core::Molecule::addBonds(bonds, orders);
+  for (Index i = firstBond; i < bondCount(); ++i)
+    m_bondUniqueIds.push_back(i);
 }
 void Molecule::swapBond(Index a, Index b)
 {
@@ -291,6 +293,28 @@ void Molecule::emitChanged(unsigned int change)
     emit changed(change);
 }
 
+Molecule::IndexRanges Molecule::indexRanges(std::vector<Index> indices)
+{
+  std::sort(indices.begin(), indices.end());
+  IndexRanges ranges;
+  for (Index index : indices) {
+    if (!ranges.empty() && ranges.back().second >= index)
+      ranges.back().second = std::max(ranges.back().second, index + 1);
+    else
+      ranges.push_back(std::make_pair(index, index + 1));
+  }
+  return ranges;
+}
+
+void Molecule::emitAtomsChanged(unsigned int change, const IndexRanges& atoms)
+{
+  if (change == NoChange)
+    return;
+  m_changedAtoms = atoms;
+  emit changed(change);
+  m_changedAtoms.clear();
+}
+
 Index Molecule::findAtomUniqueId(Index index) const
 {
   for (Index i = 0; i < static_cast<Index>(m_atomUniqueIds.size()); ++i)
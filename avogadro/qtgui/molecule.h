@@ -16,6 +16,8 @@
 
 #include <QtCore/QObject>
 #include <list>
+#include <utility>
+#include <vector>
 
 namespace Avogadro {
 namespace QtGui {
@@ -153,7 +155,7 @@ public:
                    unsigned char bondOrder = 1) override;
 
   void addBonds(const Core::Array<std::pair<Index, Index>>& bonds,
-                const Core::Array<unsigned char>& orders);
+                const Core::Array<unsigned char>& orders) override;
   /**
    * @brief Add a bond between the specified atoms.
    * @param a The first atom in the bond.
@@ -235,6 +237,32 @@ public:
   void swapBond(Index a, Index b);
   void swapAtom(Index a, Index b);
 
+  /**
+   * Ranges of indices, each from the first index up to, but not including,
+   * the second.
+   */
+  typedef std::vector<std::pair<Index, Index>> IndexRanges;
+
+  /**
+   * @return The ranges of consecutive indices in @p indices, which need not
+   * be sorted.
+   */
+  static IndexRanges indexRanges(std::vector<Index> indices);
+
+  /**
+   * @brief Emit the changed() signal for a change limited to @p atoms.
+   * Receivers can then update only what depends on those atoms, see
+   * changedAtoms().
+   */
+  void emitAtomsChanged(unsigned int change, const IndexRanges& atoms);
+
+  /**
+   * @return The atoms the changed() signal being emitted is limited to. This
+   * is empty if the change is not limited to known atoms, and outside of the
+   * signal.
+   */
+  const IndexRanges& changedAtoms() const { return m_changedAtoms; }
+
 public slots:
   /**
    * @brief Force the molecule to emit the changed() signal.
@@ -256,6 +284,7 @@ signals:
 private:
   Core::Array<Index> m_atomUniqueIds;
   Core::Array<Index> m_bondUniqueIds;
+  IndexRanges m_changedAtoms;
 
   friend class RWMolecule;
 
@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <set>
 
 #ifdef USE_SPGLIB
 #include <avogadro/core/avospglib.h>
@@ -269,6 +270,35 @@ RWMolecule::BondType RWMolecule::addBond(Index atom1, Index atom2,
   return BondType(this, bondId);
 }
 
+Index RWMolecule::addBonds(const Array<std::pair<Index, Index>>& bonds,
+                           const Array<unsigned char>& orders)
+{
+  assert(orders.size() == bonds.size());
+  Array<std::pair<Index, Index>> newBonds;
+  Array<unsigned char> newOrders;
+  std::set<std::pair<Index, Index>> added;
+  for (Index i = 0; i < bonds.size(); ++i) {
+    Index atom1 = bonds[i].first;
+    Index atom2 = bonds[i].second;
+    if (atom1 == atom2 || std::max(atom1, atom2) >= atomCount() ||
+        m_molecule.bond(atom1, atom2).isValid())
+      continue;
+    std::pair<Index, Index> pair = Molecule::makeBondPair(atom1, atom2);
+    if (!added.insert(pair).second)
+      continue;
+    newBonds.push_back(pair);
+    newOrders.push_back(orders[i]);
+  }
+  if (newBonds.empty())
+    return 0;
+
+  AddBondsCommand* comm =
+    new AddBondsCommand(*this, newBonds, newOrders, bondCount());
+  comm->setText(tr("Add Bonds"));
+  m_undoStack.push(comm);
+  return newBonds.size();
+}
+
 RWMolecule::BondType RWMolecule::bond(Index atom1, Index atom2) const
 {
   Molecule::BondType b = m_molecule.bond(atom1, atom2);
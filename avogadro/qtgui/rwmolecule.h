@@ -322,6 +322,16 @@ public:
                    unsigned char order = 1);
   /** @} */
 
+  /**
+   * Create several new bonds in a single undo step. Pairs of atoms that are
+   * already bonded, or repeated, are skipped.
+   * @param bonds The pairs of atoms to bond.
+   * @param orders The order of each of the bonds.
+   * @return The number of bonds added.
+   */
+  Index addBonds(const Core::Array<std::pair<Index, Index>>& bonds,
+                 const Core::Array<unsigned char>& orders);
+
   /**
    * Get a bond object.
    * @param bondId The index of the requested bond.
@@ -401,6 +401,35 @@ public:
 };
 } // namespace
 
+namespace {
+class AddBondsCommand : public RWMolecule::UndoCommand
+{
+  Array<std::pair<Index, Index>> m_bondPairs;
+  Array<unsigned char> m_bondOrders;
+  Index m_firstBondId;
+
+public:
+  AddBondsCommand(RWMolecule& m, const Array<std::pair<Index, Index>>& pairs,
+                  const Array<unsigned char>& orders, Index firstBondId)
+    : UndoCommand(m), m_bondPairs(pairs), m_bondOrders(orders),
+      m_firstBondId(firstBondId)
+  {}
+
+  void redo() override
+  {
+    assert(m_molecule.bondCount() == m_firstBondId);
+    m_molecule.addBonds(m_bondPairs, m_bondOrders);
+  }
+
+  void undo() override
+  {
+    // the new bonds are on top, remove them from the last one
+    for (Index i = m_molecule.bondCount(); i > m_firstBondId; --i)
+      m_molecule.removeBond(i - 1);
+  }
+};
+} // namespace
+
 namespace {
 class RemoveBondCommand : public RWMolecule::UndoCommand
 {
@@ -29,6 +29,11 @@ void ScenePlugin::process(const QtGui::Molecule& molecule,
 
 void ScenePlugin::processEditable(const RWMolecule&, Rendering::GroupNode&) {}
 
+bool ScenePlugin::processChanges(const QtGui::Molecule&, unsigned int)
+{
+  return false;
+}
+
 QWidget* ScenePlugin::setupWidget()
 {
   return nullptr;
@@ -62,6 +62,17 @@ public:
   virtual void processEditable(const RWMolecule& molecule,
                                Rendering::GroupNode& node);
 
+  /**
+   * Update the primitives added by the last call to process() after a change
+   * of the @p molecule, rather than processing it again. The @p changes are
+   * the flags of Molecule::changed(), and Molecule::changedAtoms() lists the
+   * atoms that changed.
+   * @return False if the primitives cannot be updated in place, in which case
+   * the scene is processed again. This is the default.
+   */
+  virtual bool processChanges(const QtGui::Molecule& molecule,
+                              unsigned int changes);
+
   /**
    * The name of the scene plugin, will be displayed in the user interface.
    */
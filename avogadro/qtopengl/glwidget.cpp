@@ -27,7 +27,7 @@ namespace QtOpenGL {
 
 GLWidget::GLWidget(QWidget* p)
   : QOpenGLWidget(p), m_activeTool(nullptr), m_defaultTool(nullptr),
-    m_renderTimer(nullptr)
+    m_toolNode(nullptr), m_renderTimer(nullptr)
 {
   setFocusPolicy(Qt::ClickFocus);
   connect(&m_scenePlugins,
@@ -47,7 +47,8 @@ void GLWidget::setMolecule(QtGui::Molecule* mol)
   m_molecule = mol;
   foreach (QtGui::ToolPlugin* tool, m_tools)
     tool->setMolecule(m_molecule);
-  connect(m_molecule, SIGNAL(changed(unsigned int)), SLOT(updateScene()));
+  connect(m_molecule, SIGNAL(changed(unsigned int)),
+          SLOT(moleculeChanged(unsigned int)));
 }
 
 QtGui::Molecule* GLWidget::molecule()
@@ -80,15 +81,8 @@ void GLWidget::updateScene()
     }
 
     // Let the tools perform any drawing they need to do.
-    if (m_activeTool) {
-      Rendering::GroupNode* toolNode = new Rendering::GroupNode(moleculeNode);
-      m_activeTool->draw(*toolNode);
-    }
-
-    if (m_defaultTool) {
-      Rendering::GroupNode* toolNode = new Rendering::GroupNode(moleculeNode);
-      m_defaultTool->draw(*toolNode);
-    }
+    m_toolNode = new Rendering::GroupNode(moleculeNode);
+    drawTools();
 
     m_renderer.resetGeometry();
     update();
@@ -97,9 +91,48 @@ void GLWidget::updateScene()
     delete mol;
 }
 
+void GLWidget::moleculeChanged(unsigned int changes)
+{
+  // Atoms that only moved can be updated in place by the scene plugins, as
+  // long as all of them support that; otherwise the scene is built again.
+  if (m_molecule && m_toolNode && !m_molecule->changedAtoms().empty() &&
+      changes == (QtGui::Molecule::Atoms | QtGui::Molecule::Modified)) {
+    bool updated = true;
+    foreach (QtGui::ScenePlugin* scenePlugin,
+             m_scenePlugins.activeScenePlugins()) {
+      if (!scenePlugin->processChanges(*m_molecule, changes)) {
+        updated = false;
+        break;
+      }
+    }
+    if (updated) {
+      drawTools();
+      m_renderer.resetGeometry();
+      update();
+      return;
+    }
+  }
+  updateScene();
+}
+
+void GLWidget::drawTools()
+{
+  m_toolNode->clear();
+  if (m_activeTool) {
+    Rendering::GroupNode* toolNode = new Rendering::GroupNode(m_toolNode);
+    m_activeTool->draw(*toolNode);
+  }
+
+  if (m_defaultTool) {
+    Rendering::GroupNode* toolNode = new Rendering::GroupNode(m_toolNode);
+    m_defaultTool->draw(*toolNode);
+  }
+}
+
 void GLWidget::clearScene()
 {
   m_renderer.scene().clear();
+  m_toolNode = nullptr;
 }
 
 void GLWidget::resetCamera()
@@ -165,6 +165,12 @@ protected slots:
    */
   void updateTimeout();
 
+  /**
+   * Update the scene for a change of the molecule, in place if the scene
+   * plugins can do that, see ScenePlugin::processChanges().
+   */
+  void moleculeChanged(unsigned int changes);
+
 protected:
   /** This is where the GL context is initialized. */
   void initializeGL() override;
@@ -186,10 +192,15 @@ protected:
   /** @} */
 
 private:
+  /** Let the tools draw into the tool node of the scene again. */
+  void drawTools();
+
   QPointer<QtGui::Molecule> m_molecule;
   QList<QtGui::ToolPlugin*> m_tools;
   QtGui::ToolPlugin* m_activeTool;
   QtGui::ToolPlugin* m_defaultTool;
+  // Holds what the tools draw, null until the scene is built.
+  Rendering::GroupNode* m_toolNode;
   Rendering::GLRenderer m_renderer;
   QtGui::ScenePluginModel m_scenePlugins;
 
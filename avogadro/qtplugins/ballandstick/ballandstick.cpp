@@ -21,6 +21,8 @@
 #include <QtWidgets/QVBoxLayout>
 #include <QtWidgets/QWidget>
 
+#include <algorithm>
+
 namespace Avogadro {
 namespace QtPlugins {
 
@@ -119,6 +121,44 @@ struct LayerBallAndStick : Core::LayerData
   }
 };
 
+namespace {
+
+// Set the ends of the cylinders drawn for a bond of @p order, one pair for
+// each line of a multiple bond, and return how many there are. The central
+// line of single and triple bonds comes last.
+int bondCylinderEnds(const Vector3f& pos1, const Vector3f& pos2, int order,
+                     float bondRadius, Vector3f ends[6])
+{
+  Vector3f bondVector = pos2 - pos1;
+  float bondLength = bondVector.norm();
+  bondVector /= bondLength;
+  int count = 0;
+  switch (order) {
+    case 3: {
+      Vector3f delta = bondVector.unitOrthogonal() * (2.0f * bondRadius);
+      ends[count++] = pos1 + delta;
+      ends[count++] = pos2 + delta;
+      ends[count++] = pos1 - delta;
+      ends[count++] = pos2 - delta;
+    }
+    default:
+    case 1:
+      ends[count++] = pos1;
+      ends[count++] = pos2;
+      break;
+    case 2: {
+      Vector3f delta = bondVector.unitOrthogonal() * bondRadius;
+      ends[count++] = pos1 + delta;
+      ends[count++] = pos2 + delta;
+      ends[count++] = pos1 - delta;
+      ends[count++] = pos2 - delta;
+    }
+  }
+  return count / 2;
+}
+
+} // namespace
+
 BallAndStick::BallAndStick(QObject* p) : ScenePlugin(p), m_group(nullptr)
 {
   m_layerManager = PluginLayerManager(m_name);
@@ -141,6 +181,11 @@ void BallAndStick::process(const QtGui::Molecule& molecule,
   spheres->identifier().type = Rendering::AtomType;
   geometry->addDrawable(spheres);
   geometry->addDrawable(selectedSpheres);
+  m_molecule = &molecule;
+  m_spheres = spheres;
+  m_selectedSpheres = selectedSpheres;
+  m_atomSpheres.assign(molecule.atomCount(), MaxIndex);
+  m_atomSelectedSpheres.assign(molecule.atomCount(), MaxIndex);
 
   for (Index i = 0; i < molecule.atomCount(); ++i) {
     Core::Atom atom = molecule.atom(i);
@@ -156,11 +201,13 @@ void BallAndStick::process(const QtGui::Molecule& molecule,
     Vector3ub color = atom.color();
     float radius = static_cast<float>(Elements::radiusVDW(atomicNumber));
     float scale = interface.atomScale;
+    m_atomSpheres[i] = spheres->size();
     spheres->addSphere(atom.position3d().cast<float>(), color, radius * scale,
                        i);
     if (atom.selected()) {
       color = Vector3ub(0, 0, 255);
       radius *= 1.2;
+      m_atomSelectedSpheres[i] = selectedSpheres->size();
       selectedSpheres->addSphere(atom.position3d().cast<float>(), color,
                                  radius * scale, i);
     }
@@ -170,6 +217,8 @@ void BallAndStick::process(const QtGui::Molecule& molecule,
   cylinders->identifier().molecule = &molecule;
   cylinders->identifier().type = Rendering::BondType;
   geometry->addDrawable(cylinders);
+  m_cylinders = cylinders;
+  m_bondCylinders.assign(molecule.bondCount(), BondCylinders{ 0, 0, 1, 0.0f });
   for (Index i = 0; i < molecule.bondCount(); ++i) {
     Core::Bond bond = molecule.bond(i);
     if (!m_layerManager.bondEnabled(bond.atom1().index(),
@@ -196,30 +245,81 @@ void BallAndStick::process(const QtGui::Molecule& molecule,
     Vector3f pos2 = bond.atom2().position3d().cast<float>();
     Vector3ub color1 = bond.atom1().color();
     Vector3ub color2 = bond.atom2().color();
-    Vector3f bondVector = pos2 - pos1;
-    float bondLength = bondVector.norm();
-    bondVector /= bondLength;
-    switch (interface1.multiBonds || interface2.multiBonds ? bond.order() : 1) {
-      case 3: {
-        Vector3f delta = bondVector.unitOrthogonal() * (2.0f * bondRadius);
-        cylinders->addCylinder(pos1 + delta, pos2 + delta, bondRadius, color1,
-                               color2, i);
-        cylinders->addCylinder(pos1 - delta, pos2 - delta, bondRadius, color1,
-                               color2, i);
-      }
-      default:
-      case 1:
-        cylinders->addCylinder(pos1, pos2, m_bondRadius, color1, color2, i);
-        break;
-      case 2: {
-        Vector3f delta = bondVector.unitOrthogonal() * bondRadius;
-        cylinders->addCylinder(pos1 + delta, pos2 + delta, bondRadius, color1,
-                               color2, i);
-        cylinders->addCylinder(pos1 - delta, pos2 - delta, bondRadius, color1,
-                               color2, i);
+    int order =
+      interface1.multiBonds || interface2.multiBonds ? bond.order() : 1;
+    Vector3f ends[6];
+    int count = bondCylinderEnds(pos1, pos2, order, bondRadius, ends);
+    m_bondCylinders[i] =
+      BondCylinders{ cylinders->size(), count, order, bondRadius };
+    for (int c = 0; c < count; ++c) {
+      // the central line uses the global bond radius
+      bool central = c == count - 1 && order != 2;
+      cylinders->addCylinder(ends[2 * c], ends[2 * c + 1],
+                             central ? m_bondRadius : bondRadius, color1,
+                             color2, i);
+    }
+  }
+}
+
+bool BallAndStick::processChanges(const QtGui::Molecule& molecule,
+                                  unsigned int changes)
+{
+  // Only atoms that moved, in the molecule drawn by the last process().
+  if (changes != (QtGui::Molecule::Atoms | QtGui::Molecule::Modified) ||
+      &molecule != m_molecule || !m_spheres ||
+      m_atomSpheres.size() != molecule.atomCount() ||
+      m_bondCylinders.size() != molecule.bondCount()) {
+    return false;
+  }
+
+  const Core::Graph& graph = molecule.graph();
+  std::vector<Index> bonds;
+  Index moved = 0;
+  for (const auto& range : molecule.changedAtoms()) {
+    if (range.second > range.first)
+      moved += range.second - range.first;
+  }
+  // every atom moved, e.g. a new trajectory frame, so do all bonds in order
+  const bool all = moved >= m_atomSpheres.size();
+  for (const auto& range : molecule.changedAtoms()) {
+    for (Index i = range.first; i < range.second && i < m_atomSpheres.size();
+         ++i) {
+      Vector3f position = molecule.atomPosition3d(i).cast<float>();
+      if (m_atomSpheres[i] != MaxIndex)
+        m_spheres->setSpherePosition(m_atomSpheres[i], position);
+      if (m_atomSelectedSpheres[i] != MaxIndex)
+        m_selectedSpheres->setSpherePosition(m_atomSelectedSpheres[i],
+                                             position);
+      if (!all) {
+        const std::vector<size_t>& edges = graph.edges(i);
+        bonds.insert(bonds.end(), edges.begin(), edges.end());
       }
     }
   }
+
+  // the bonds of the moved atoms, once each
+  if (all) {
+    bonds.resize(m_bondCylinders.size());
+    for (Index i = 0; i < bonds.size(); ++i)
+      bonds[i] = i;
+  } else {
+    std::sort(bonds.begin(), bonds.end());
+    bonds.erase(std::unique(bonds.begin(), bonds.end()), bonds.end());
+  }
+  for (Index i : bonds) {
+    const BondCylinders& bond = m_bondCylinders[i];
+    if (bond.count == 0)
+      continue;
+    const std::pair<size_t, size_t> atoms = graph.endpoints(i);
+    Vector3f ends[6];
+    bondCylinderEnds(molecule.atomPosition3d(atoms.first).cast<float>(),
+                     molecule.atomPosition3d(atoms.second).cast<float>(),
+                     bond.order, bond.radius, ends);
+    for (int c = 0; c < bond.count; ++c)
+      m_cylinders->setCylinderEnds(bond.first + c, ends[2 * c],
+                                   ends[2 * c + 1]);
+  }
+  return true;
 }
 
 QWidget* BallAndStick::setupWidget()
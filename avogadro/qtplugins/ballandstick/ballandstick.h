@@ -8,7 +8,15 @@
 
 #include <avogadro/qtgui/sceneplugin.h>
 
+#include <vector>
+
 namespace Avogadro {
+
+namespace Rendering {
+class CylinderGeometry;
+class SphereGeometry;
+} // namespace Rendering
+
 namespace QtPlugins {
 
 /**
@@ -26,6 +34,9 @@ public:
   void process(const QtGui::Molecule& molecule,
                Rendering::GroupNode& node) override;
 
+  bool processChanges(const QtGui::Molecule& molecule,
+                      unsigned int changes) override;
+
   QString name() const override { return tr("Ball and Stick"); }
 
   QString description() const override
@@ -47,7 +58,27 @@ public slots:
   void showHydrogens(bool show);
 
 private:
+  // The cylinders drawn for a bond, the first of them and how many.
+  struct BondCylinders
+  {
+    size_t first;
+    int count;
+    int order;
+    float radius;
+  };
+
   Rendering::GroupNode* m_group;
+
+  // The geometry of the last process() call, with the spheres of each atom
+  // and the cylinders of each bond, so moved atoms can be updated in place.
+  const QtGui::Molecule* m_molecule = nullptr;
+  Rendering::SphereGeometry* m_spheres = nullptr;
+  Rendering::SphereGeometry* m_selectedSpheres = nullptr;
+  Rendering::CylinderGeometry* m_cylinders = nullptr;
+  std::vector<size_t> m_atomSpheres;
+  std::vector<size_t> m_atomSelectedSpheres;
+  std::vector<BondCylinders> m_bondCylinders;
+
   std::string m_name = "Ball and Stick";
   float m_atomScale = 0.3f;
   float m_bondRadius = 0.1f;
@@ -16,12 +16,15 @@
 
 #include "bonding.h"
 
-#include <avogadro/core/elements.h>
+#include <avogadro/core/bondperceiver.h>
 #include <avogadro/qtgui/molecule.h>
+#include <avogadro/qtgui/rwmolecule.h>
 
+#include <QtConcurrent/QtConcurrentRun>
 #include <QtCore/QSettings>
 #include <QtWidgets/QAction>
 #include <QtWidgets/QDialog>
+#include <QtWidgets/QProgressDialog>
 
 #include <vector>
 
@@ -31,16 +34,17 @@ namespace Avogadro {
 namespace QtPlugins {
 
 using Core::Array;
-using Core::Elements;
+using Core::BondPerceiver;
 
 typedef Avogadro::Core::Array<Avogadro::Core::Bond> NeighborListType;
 
 Bonding::Bonding(QObject* parent_)
-  : Avogadro::QtGui::ExtensionPlugin(parent_),
+  : Avogadro::QtGui::ExtensionPlugin(parent_), m_molecule(nullptr),
     m_action(new QAction(tr("Bond Atoms"), this)),
     m_clearAction(new QAction(tr("Remove Bonds"), this)),
     m_configAction(new QAction(tr("Configure Bonding…"), this)),
-    m_dialog(nullptr), m_ui(nullptr)
+    m_dialog(nullptr), m_ui(nullptr), m_bondingAtomCount(0),
+    m_canceled(false), m_progressDialog(nullptr)
 {
   QSettings settings;
   m_tolerance = settings.value("bonding/tolerance", 0.45).toDouble();
@@ -50,9 +54,14 @@ Bonding::Bonding(QObject* parent_)
   connect(m_action, SIGNAL(triggered()), SLOT(bond()));
   connect(m_clearAction, SIGNAL(triggered()), SLOT(clearBonds()));
   connect(m_configAction, SIGNAL(triggered()), SLOT(configure()));
+  connect(&m_watcher, SIGNAL(finished()), SLOT(bondsFound()));
 }
 
-Bonding::~Bonding() {}
+Bonding::~Bonding()
+{
+  m_canceled = true;
+  m_watcher.waitForFinished();
+}
 
 QList<QAction*> Bonding::actions() const
 {
@@ -104,55 +113,77 @@ void Bonding::setValues()
 
 void Bonding::bond()
 {
-  // Yes, this is largely reproduced from Core::Molecule::perceiveBondsSimple
-  //  .. but that class doesn't know about selections
-  if (!m_molecule)
+  if (!m_molecule || m_watcher.isRunning())
     return;
 
   // Check for 3D coordinates, can't do bond perception without this.
   if (m_molecule->atomPositions3d().size() != m_molecule->atomCount())
     return;
 
-  // cache atomic radii
-  std::vector<double> radii(m_molecule->atomCount());
-  for (size_t i = 0; i < radii.size(); i++) {
-    radii[i] = Elements::radiusCovalent(m_molecule->atomicNumbers()[i]);
-    if (radii[i] <= 0.0)
-      radii[i] = 0.0;
+  // Copy what is needed so the molecule is not touched from another thread
+  Array<Vector3> positions = m_molecule->atomPositions3d();
+  Array<unsigned char> atomicNumbers = m_molecule->atomicNumbers();
+  std::vector<bool> mask;
+  if (!m_molecule->isSelectionEmpty()) {
+    mask.resize(m_molecule->atomCount());
+    for (Index i = 0; i < m_molecule->atomCount(); ++i)
+      mask[i] = m_molecule->atomSelected(i);
   }
 
-  bool emptySelection = m_molecule->isSelectionEmpty();
-  double minSq = m_minDistance * m_minDistance;
-
-  // Main bond perception loop based on a simple distance metric.
-  for (Index i = 0; i < m_molecule->atomCount(); ++i) {
-    if (!emptySelection && !m_molecule->atomSelected(i))
-      continue;
+  if (!m_progressDialog) {
+    m_progressDialog = new QProgressDialog(qobject_cast<QWidget*>(parent()));
+    m_progressDialog->setWindowModality(Qt::NonModal);
+    m_progressDialog->setWindowTitle(tr("Bond Atoms"));
+    m_progressDialog->setLabelText(tr("Perceiving bonds…"));
+    connect(m_progressDialog, SIGNAL(canceled()), SLOT(cancelBonding()));
+  }
+  m_progressDialog->setRange(0, 100);
+  m_progressDialog->setValue(0);
+  m_progressDialog->show();
+
+  // Elements without a covalent radius are not given one here, unlike in
+  // Molecule::perceiveBondsSimple()
+  BondPerceiver perceiver(m_tolerance, m_minDistance);
+  perceiver.setFallbackRadius(0.0);
+  perceiver.setAtomMask(mask);
+  QProgressDialog* dialog = m_progressDialog;
+  std::atomic<bool>* canceled = &m_canceled;
+  perceiver.setProgressFunction([dialog, canceled](int done, int total) {
+    QMetaObject::invokeMethod(dialog, "setValue", Qt::QueuedConnection,
+                              Q_ARG(int, done * 100 / total));
+    return !*canceled;
+  });
+
+  m_bondingMolecule = m_molecule;
+  m_bondingAtomCount = m_molecule->atomCount();
+  m_canceled = false;
+  m_watcher.setFuture(QtConcurrent::run([=]() {
+    BondList bonds;
+    perceiver.perceive(positions, atomicNumbers, bonds);
+    return bonds;
+  }));
+}
 
-    Vector3 ipos = m_molecule->atomPositions3d()[i];
-    for (Index j = i + 1; j < m_molecule->atomCount(); ++j) {
-      if (!emptySelection && !m_molecule->atomSelected(j))
-        continue;
+void Bonding::bondsFound()
+{
+  if (m_progressDialog)
+    m_progressDialog->reset();
 
-      double cutoff = radii[i] + radii[j] + m_tolerance;
-      Vector3 jpos = m_molecule->atomPositions3d()[j];
-      Vector3 diff = jpos - ipos;
+  // Drop the bonds if the molecule was replaced or edited in the meantime
+  if (m_canceled || !m_bondingMolecule || m_bondingMolecule != m_molecule ||
+      m_molecule->atomCount() != m_bondingAtomCount)
+    return;
 
-      if (std::fabs(diff[0]) > cutoff || std::fabs(diff[1]) > cutoff ||
-          std::fabs(diff[2]) > cutoff ||
-          (m_molecule->atomicNumbers()[i] == 1 &&
-           m_molecule->atomicNumbers()[j] == 1)) {
-        continue;
-      }
+  BondList bonds = m_watcher.result();
+  Index added = m_molecule->undoMolecule()->addBonds(
+    bonds, Array<unsigned char>(bonds.size(), 1));
+  if (added)
+    m_molecule->emitChanged(QtGui::Molecule::Bonds | QtGui::Molecule::Added);
+}
 
-      // check radius and add bond if needed
-      double cutoffSq = cutoff * cutoff;
-      double diffsq = diff.squaredNorm();
-      if (diffsq < cutoffSq && diffsq > minSq)
-        m_molecule->addBond(m_molecule->atom(i), m_molecule->atom(j), 1);
-    }
-  }
-  m_molecule->emitChanged(QtGui::Molecule::Bonds);
+void Bonding::cancelBonding()
+{
+  m_canceled = true;
 }
 
 void Bonding::clearBonds()
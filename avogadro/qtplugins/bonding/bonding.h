@@ -7,11 +7,19 @@
 #ifndef AVOGADRO_QTPLUGINS_BONDING_H
 #define AVOGADRO_QTPLUGINS_BONDING_H
 
+#include <avogadro/core/array.h>
 #include <avogadro/core/avogadrocore.h>
 #include <avogadro/qtgui/extensionplugin.h>
 
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QPointer>
 #include <QtWidgets/QDialog>
 
+#include <atomic>
+#include <utility>
+
+class QProgressDialog;
+
 namespace Ui {
 class BondingDialog;
 }
@@ -45,11 +53,15 @@ public slots:
 
 private slots:
   void bond();
+  void bondsFound();
+  void cancelBonding();
   void clearBonds();
   void configure();
   void setValues();
 
 private:
+  typedef Core::Array<std::pair<Index, Index>> BondList;
+
   QtGui::Molecule* m_molecule;
 
   double m_tolerance;
@@ -61,6 +73,14 @@ private:
 
   QDialog* m_dialog;
   Ui::BondingDialog* m_ui;
+
+  // Bonds are perceived in the background, for the molecule and the atom
+  // count at the time
+  QFutureWatcher<BondList> m_watcher;
+  QPointer<QtGui::Molecule> m_bondingMolecule;
+  Index m_bondingAtomCount;
+  std::atomic<bool> m_canceled;
+  QProgressDialog* m_progressDialog;
 };
 
 } // namespace QtPlugins
@@ -71,7 +71,9 @@ void CloseContacts::process(const Molecule &molecule, Rendering::GroupNode &node
 {
   Vector3ub color(128, 255, 64);
 
-  NeighborPerceiver perceiver(molecule.atomPositions3d(), m_maximumDistance);
+  // contacts across the boundaries of a unit cell are drawn to the image
+  NeighborPerceiver perceiver(molecule.atomPositions3d(), m_maximumDistance,
+                              molecule.unitCell());
   std::vector<bool> isAtomEnabled(molecule.atomCount());
   for (Index i = 0; i < molecule.atomCount(); ++i)
     isAtomEnabled[i] = m_layerManager.atomEnabled(i);
@@ -83,26 +85,17 @@ void CloseContacts::process(const Molecule &molecule, Rendering::GroupNode &node
   lines->identifier().type = Rendering::BondType;
   lines->setLineWidth(2.0);
   geometry->addDrawable(lines);
-  Array<Index> neighbors;
-  for (Index i = 0; i < molecule.atomCount(); ++i) {
-    if (!isAtomEnabled[i])
-      continue;
+  // each pair is visited once, already within the maximum distance
+  perceiver.forEachPair([&](Index i, Index n, const Vector3 &delta) {
+    if (!isAtomEnabled[i] || !isAtomEnabled[n])
+      return;
+    if (!checkPairNot1213(molecule, i, n))
+      return;
+
     Vector3 pos = molecule.atomPosition3d(i);
-    perceiver.getNeighborsInclusiveInPlace(neighbors, pos);
-    for (Index n : neighbors) {
-      if (n <= i) // check each pair only once
-        continue;
-      if (!isAtomEnabled[n])
-        continue;
-      if (!checkPairNot1213(molecule, i, n))
-        continue;
-
-      Vector3 npos = molecule.atomPosition3d(n);
-      double distance = (npos - pos).norm();
-      if (distance < m_maximumDistance)
-        lines->addDashedLine(pos.cast<float>(), npos.cast<float>(), color, 8);
-    }
-  }
+    Vector3 npos = pos + delta;
+    lines->addDashedLine(pos.cast<float>(), npos.cast<float>(), color, 8);
+  });
 }
 
 QWidget *CloseContacts::setupWidget()
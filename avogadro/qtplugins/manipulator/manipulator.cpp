@@ -132,6 +132,8 @@ QUndoCommand* Manipulator::mouseMoveEvent(QMouseEvent* e)
   const Core::Molecule* mol = &m_molecule->molecule();
   Vector2f windowPos(e->localPos().x(), e->localPos().y());
 
+  // the atoms moved, so the views only need to update those
+  std::vector<Index> moved;
   if (mol->isSelectionEmpty() && m_object.type == Rendering::AtomType &&
       m_object.molecule == &m_molecule->molecule()) {
     // translate single atom position
@@ -139,7 +141,13 @@ QUndoCommand* Manipulator::mouseMoveEvent(QMouseEvent* e)
     Vector3f oldPos(atom.position3d().cast<float>());
     Vector3f newPos = m_renderer->camera().unProject(windowPos, oldPos);
     atom.setPosition3d(newPos.cast<double>());
+    moved.push_back(m_object.index);
   } else if (!mol->isSelectionEmpty()) {
+    for (Index i = 0; i < mol->atomCount(); ++i) {
+      if (mol->atomSelected(i))
+        moved.push_back(i);
+    }
+
     // update all selected atoms
     Vector3f newPos = m_renderer->camera().unProject(windowPos);
     Vector3 delta = (newPos - m_lastMouse3D).cast<double>();
@@ -171,7 +179,8 @@ QUndoCommand* Manipulator::mouseMoveEvent(QMouseEvent* e)
     m_lastMouse3D = newPos;
   }
 
-  m_molecule->emitChanged(Molecule::Atoms | Molecule::Modified);
+  m_molecule->molecule().emitAtomsChanged(
+    Molecule::Atoms | Molecule::Modified, Molecule::indexRanges(moved));
   e->accept();
   return nullptr;
 }
@@ -18,8 +18,6 @@
 #include <QtWidgets/QFormLayout>
 #include <QtWidgets/QVBoxLayout>
 
-#include <algorithm>
-
 namespace Avogadro {
 namespace QtPlugins {
 
@@ -50,15 +48,17 @@ Meshes::Meshes(QObject* p) : ScenePlugin(p), m_enabled(true), m_setupWidget(null
 
 Meshes::~Meshes() {}
 
-// Generator for std::generate call below:
 namespace {
-struct Sequence
+// Indexed meshes share their vertices, others are explicit triangles.
+Core::Array<unsigned int> triangleIndices(const Mesh& mesh)
 {
-  Sequence() : i(0) {}
-  unsigned int operator()() { return i++; }
-  void reset() { i = 0; }
-  unsigned int i;
-};
+  if (!mesh.triangles().empty())
+    return mesh.triangles();
+  Core::Array<unsigned int> indices(mesh.numVertices());
+  for (size_t i = 0; i < indices.size(); ++i)
+    indices[i] = static_cast<unsigned int>(i);
+  return indices;
+}
 } // namespace
 
 void Meshes::process(const QtGui::Molecule& mol, GroupNode& node)
@@ -66,22 +66,15 @@ void Meshes::process(const QtGui::Molecule& mol, GroupNode& node)
   if (mol.meshCount()) {
     GeometryNode* geometry = new GeometryNode;
     node.addChild(geometry);
- 
-    const Mesh* mesh = mol.mesh(0);
 
-    /// @todo Allow use of MeshGeometry without an index array when all vertices
-    /// form explicit triangles.
-    // Create index array:
-    Sequence indexGenerator;
-    Core::Array<unsigned int> indices(mesh->numVertices());
-    std::generate(indices.begin(), indices.end(), indexGenerator);
+    const Mesh* mesh = mol.mesh(0);
 
     MeshGeometry* mesh1 = new MeshGeometry;
     geometry->addDrawable(mesh1);
     mesh1->setColor(m_color1);
     mesh1->setOpacity(m_opacity);
     mesh1->addVertices(mesh->vertices(), mesh->normals());
-    mesh1->addTriangles(indices);
+    mesh1->addTriangles(triangleIndices(*mesh));
     mesh1->setRenderPass(m_opacity == 255 ? Rendering::OpaquePass
                                         : Rendering::TranslucentPass);
 
@@ -89,17 +82,10 @@ void Meshes::process(const QtGui::Molecule& mol, GroupNode& node)
       MeshGeometry* mesh2 = new MeshGeometry;
       geometry->addDrawable(mesh2);
       mesh = mol.mesh(1);
-      if (mesh->numVertices() < indices.size()) {
-        indices.resize(mesh->numVertices());
-      } else if (mesh->numVertices() > indices.size()) {
-        indexGenerator.reset();
-        indices.resize(mesh->numVertices());
-        std::generate(indices.begin(), indices.end(), indexGenerator);
-      }
       mesh2->setColor(m_color2);
       mesh2->setOpacity(m_opacity);
       mesh2->addVertices(mesh->vertices(), mesh->normals());
-      mesh2->addTriangles(indices);
+      mesh2->addTriangles(triangleIndices(*mesh));
       mesh2->setRenderPass(m_opacity == 255 ? Rendering::OpaquePass
                                           : Rendering::TranslucentPass);
     }
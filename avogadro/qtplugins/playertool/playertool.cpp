@@ -217,21 +217,41 @@ void PlayerTool::animate(int advance)
     if (m_currentFrame < m_molecule->coordinate3dCount() - advance &&
         m_currentFrame + advance >= 0) {
       m_currentFrame += advance;
-      m_molecule->setCoordinate3d(m_currentFrame);
     } else {
       m_currentFrame = advance > 0 ? 0 : m_molecule->coordinate3dCount() - 1;
-      m_molecule->setCoordinate3d(m_currentFrame);
     }
-    if (m_dynamicBonding->isChecked()) {
-      m_molecule->clearBonds();
-      m_molecule->perceiveBondsSimple();
-    }
-    m_molecule->emitChanged(Molecule::Atoms | Molecule::Added);
+    showFrame(m_currentFrame, m_dynamicBonding->isChecked());
     m_slider->setValue(m_currentFrame);
     m_frameIdx->setValue(m_currentFrame + 1);
   }
 }
 
+void PlayerTool::showFrame(int frame, bool bonding)
+{
+  m_molecule->setCoordinate3d(frame);
+
+  // The bonds only change now and then, the candidate pairs are kept from
+  // frame to frame. While they stay the same only the positions are new, and
+  // the scene can update them in place. The perceiver has no progress
+  // function, so it is never cancelled, but the bonds are kept if it fails.
+  if (bonding) {
+    Core::Array<std::pair<Index, Index>> bonds;
+    if (m_bondPerceiver.perceiveFrame(m_molecule->atomPositions3d(),
+                                      m_molecule->atomicNumbers(), bonds) &&
+        bonds != m_molecule->bondPairs()) {
+      m_molecule->clearBonds();
+      m_molecule->addBonds(bonds,
+                           Core::Array<unsigned char>(bonds.size(), 1));
+      m_molecule->emitChanged(Molecule::Atoms | Molecule::Bonds |
+                              Molecule::Modified);
+      return;
+    }
+  }
+  Molecule::IndexRanges atoms;
+  atoms.push_back(std::make_pair(Index(0), m_molecule->atomCount()));
+  m_molecule->emitAtomsChanged(Molecule::Atoms | Molecule::Modified, atoms);
+}
+
 void PlayerTool::recordMovie()
 {
   // Qt 5.14 or later gives the more reliable way for multi-screen
@@ -281,12 +301,7 @@ void PlayerTool::recordMovie()
     GifBegin(&writer, (baseName + ".gif").toLatin1().data(), EXPORT_WIDTH,
              EXPORT_HEIGHT, 100 / std::min(m_animationFPS->value(), 100));
     for (int i = 0; i < m_molecule->coordinate3dCount(); ++i) {
-      m_molecule->setCoordinate3d(i);
-      if (bonding) {
-        m_molecule->clearBonds();
-        m_molecule->perceiveBondsSimple();
-      }
-      m_molecule->emitChanged(Molecule::Atoms | Molecule::Modified);
+      showFrame(i, bonding);
 
       QImage exportImage;
       m_glWidget->raise();
@@ -324,12 +339,7 @@ void PlayerTool::recordMovie()
     gwavi = gwavi_open((baseName + ".avi").toLatin1().data(), EXPORT_WIDTH,
                        EXPORT_HEIGHT, "MJPG", m_animationFPS->value(), nullptr);
     for (int i = 0; i < m_molecule->coordinate3dCount(); ++i) {
-      m_molecule->setCoordinate3d(i);
-      if (bonding) {
-        m_molecule->clearBonds();
-        m_molecule->perceiveBondsSimple();
-      }
-      m_molecule->emitChanged(Molecule::Atoms | Molecule::Modified);
+      showFrame(i, bonding);
 
       QImage exportImage;
       m_glWidget->raise();
@@ -355,12 +365,7 @@ void PlayerTool::recordMovie()
     gwavi_close(gwavi);
   } else if (selfFilter == tr("Movie (*.mp4)")) {
     for (int i = 0; i < m_molecule->coordinate3dCount(); ++i) {
-      m_molecule->setCoordinate3d(i);
-      if (bonding) {
-        m_molecule->clearBonds();
-        m_molecule->perceiveBondsSimple();
-      }
-      m_molecule->emitChanged(Molecule::Atoms | Molecule::Modified);
+      showFrame(i, bonding);
       QString fileName = QString::number(i);
       while (fileName.length() < numberLength)
         fileName.prepend('0');
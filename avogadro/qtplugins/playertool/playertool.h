@@ -20,6 +20,7 @@
 #include <avogadro/qtgui/toolplugin.h>
 
 #include <avogadro/core/avogadrocore.h>
+#include <avogadro/core/bondperceiver.h>
 
 #include <QtCore/QTimer>
 
@@ -71,12 +72,16 @@ protected slots:
   void setSliderLimit();
 
 private:
+  // Show a frame of the trajectory, bonding its atoms again if asked to.
+  void showFrame(int frame, bool bonding);
+
   QAction* m_activateAction;
   QtGui::Molecule* m_molecule;
   Rendering::GLRenderer* m_renderer;
   int m_currentFrame;
   mutable QWidget* m_toolWidget;
   QTimer m_timer;
+  Core::BondPerceiver m_bondPerceiver;
   mutable QSpinBox* m_animationFPS;
   mutable QSpinBox* m_frameIdx;
   mutable QCheckBox* m_dynamicBonding;
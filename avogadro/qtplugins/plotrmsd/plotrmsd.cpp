@@ -20,20 +20,20 @@
 #include <QProcess>
 #include <QString>
 
-#include <avogadro/core/array.h>
+#include <avogadro/core/trajectoryanalysis.h>
 #include <avogadro/io/fileformatmanager.h>
 #include <avogadro/qtgui/molecule.h>
 #include <avogadro/vtk/vtkplot.h>
 
 #include "plotrmsd.h"
 
+#include <cmath>
+
 using Avogadro::QtGui::Molecule;
 
 namespace Avogadro {
 namespace QtPlugins {
 
-using Core::Array;
-
 PlotRmsd::PlotRmsd(QObject* parent_)
   : Avogadro::QtGui::ExtensionPlugin(parent_)
   , m_actions(QList<QAction*>())
@@ -145,20 +145,17 @@ void PlotRmsd::displayDialog()
 
 void PlotRmsd::generateRmsdPattern(RmsdData& results)
 {
-  m_molecule->setCoordinate3d(0);
-  Array<Vector3> ref = m_molecule->atomPositions3d();
-
-  for (size_t i = 0; i < m_molecule->coordinate3dCount(); ++i) {
-    m_molecule->setCoordinate3d(i);
-    Array<Vector3> positions = m_molecule->atomPositions3d();
-    double sum = 0;
-    for (size_t j = 0; j < positions.size(); ++j) {
-      sum += (positions[j][0] - ref[j][0]) * (positions[j][0] - ref[j][0]) +
-             (positions[j][1] - ref[j][1]) * (positions[j][1] - ref[j][1]) +
-             (positions[j][2] - ref[j][2]) * (positions[j][2] - ref[j][2]);
-    }
-    sum = sqrt(sum / m_molecule->coordinate3dCount());
-    results.push_back(std::make_pair(static_cast<double>(i), sum));
+  // superpose every frame onto the first one, without changing the frame
+  // currently shown
+  Core::TrajectoryAnalysis analysis(m_molecule);
+  if (!analysis.compute())
+    return;
+
+  const std::vector<double>& rmsd = analysis.rmsd();
+  for (size_t i = 0; i < rmsd.size(); ++i) {
+    // skip frames that could not be read
+    if (!std::isnan(rmsd[i]))
+      results.push_back(std::make_pair(static_cast<double>(i), rmsd[i]));
   }
 }
 
@@ -26,13 +26,6 @@
 
 #include <QtConcurrent/QtConcurrentMap>
 
-#include <QDataStream>
-#include <QDir>
-#include <QFile>
-#include <QTemporaryFile>
-
-#include <QVariant>
-
 #include <QFuture>
 #include <QFutureWatcher>
 #include <QProgressDialog>
@@ -46,116 +39,132 @@ using namespace Eigen;
 namespace Avogadro {
 namespace QtPlugins {
 
-QList<QVariant> QTAIMLocateNuclearCriticalPoint(QList<QVariant> input)
+namespace {
+
+// The searches run concurrently. All tasks share the wavefunction read-only
+// and each one builds its own evaluator from it, since the evaluator keeps
+// scratch space.
+struct QTAIMCriticalPointTask
+{
+  const QTAIMWavefunction* wfn;
+  const QList<QPair<QVector3D, qreal>>* betaSpheres;
+  qint64 nucleusA;
+  qint64 nucleusB;
+  QVector3D start;
+};
+
+struct QTAIMCriticalPointResult
 {
-  const QString fileName = input.at(0).toString();
-  const qint64 nucleus = input.at(1).toInt();
-  const QVector3D x0y0z0(input.at(2).toReal(), input.at(3).toReal(),
-                         input.at(4).toReal());
+  QTAIMCriticalPointResult()
+    : found(false), nucleusA(-1), nucleusB(-1), laplacian(0.0),
+      ellipticity(0.0)
+  {
+  }
+
+  bool found;
+  qint64 nucleusA;
+  qint64 nucleusB;
+  QVector3D position;
+  qreal laplacian;
+  qreal ellipticity;
+  QList<QVector3D> path;
+};
+
+QList<QVector3D> QTAIMCriticalPointPositions(
+  const QList<QTAIMCriticalPointResult>& results)
+{
+  QList<QVector3D> positions;
+  for (qint64 n = 0; n < results.length(); ++n) {
+    if (results.at(n).found) {
+      positions.append(results.at(n).position);
+    }
+  }
+  return positions;
+}
+
+qint64 QTAIMNearestNucleus(const QTAIMWavefunction& wfn, const QVector3D& xyz)
+{
+  qreal smallestDistance = HUGE_REAL_NUMBER;
+  qint64 smallestDistanceIndex = 0;
+
+  Matrix<qreal, 3, 1> a(xyz.x(), xyz.y(), xyz.z());
+  for (qint64 n = 0; n < wfn.numberOfNuclei(); ++n) {
+    Matrix<qreal, 3, 1> b(wfn.xNuclearCoordinate(n), wfn.yNuclearCoordinate(n),
+                          wfn.zNuclearCoordinate(n));
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(fileName);
+    qreal distance = QTAIMMathUtilities::distance(a, b);
 
-  QTAIMWavefunctionEvaluator eval(wfn);
+    if (distance < smallestDistance) {
+      smallestDistance = distance;
+      smallestDistanceIndex = n;
+    }
+  }
+
+  return smallestDistanceIndex;
+}
+
+QTAIMCriticalPointResult QTAIMLocateNuclearCriticalPoint(
+  const QTAIMCriticalPointTask& task)
+{
+  QTAIMWavefunctionEvaluator eval(*task.wfn);
 
   QVector3D result;
 
-  if (wfn.nuclearCharge(nucleus) < 4) {
+  if (task.wfn->nuclearCharge(task.nucleusA) < 4) {
     //      QTAIMODEIntegrator
     //      ode(eval,QTAIMODEIntegrator::CMBPMinusThreeGradientInElectronDensity);
     QTAIMLSODAIntegrator ode(
       eval, QTAIMLSODAIntegrator::CMBPMinusThreeGradientInElectronDensity);
-    result = ode.integrate(x0y0z0);
+    result = ode.integrate(task.start);
   } else {
-    result = x0y0z0;
+    result = task.start;
   }
 
-  bool correctSignature;
   Matrix<qreal, 3, 1> xyz;
   xyz << result.x(), result.y(), result.z();
 
+  QTAIMCriticalPointResult value;
   if (QTAIMMathUtilities::signatureOfASymmetricThreeByThreeMatrix(
         eval.hessianOfElectronDensity(xyz)) == -3) {
-    correctSignature = true;
-  } else {
-    correctSignature = false;
-  }
-
-  QList<QVariant> value;
-
-  if (correctSignature) {
-    value.append(correctSignature);
-    value.append(result.x());
-    value.append(result.y());
-    value.append(result.z());
-  } else {
-    value.append(false);
+    value.found = true;
+    value.nucleusA = task.nucleusA;
+    value.position = result;
   }
 
   return value;
 }
 
-QList<QVariant> QTAIMLocateBondCriticalPoint(QList<QVariant> input)
+QTAIMCriticalPointResult QTAIMLocateBondCriticalPoint(
+  const QTAIMCriticalPointTask& task)
 {
+  QTAIMCriticalPointResult value;
 
-  QList<QVariant> value;
-  value.clear();
-
-  const QString wfnFileName = input.at(0).toString();
-  const QString nuclearCriticalPointsFileName = input.at(1).toString();
-  const qint64 nucleusA = input.at(2).toInt();
-  const qint64 nucleusB = input.at(3).toInt();
-  const QVector3D x0y0z0(input.at(4).toReal(), input.at(5).toReal(),
-                         input.at(6).toReal());
-
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
-
-  QList<QVector3D> nuclearCriticalPoints;
-  QFile nuclearCriticalPointsFile(nuclearCriticalPointsFileName);
-  nuclearCriticalPointsFile.open(QIODevice::ReadOnly);
-  QDataStream nuclearCriticalPointsFileIn(&nuclearCriticalPointsFile);
-  nuclearCriticalPointsFileIn >> nuclearCriticalPoints;
-  nuclearCriticalPointsFile.close();
-
-  QList<QPair<QVector3D, qreal>> betaSpheres;
-  for (qint64 i = 0; i < nuclearCriticalPoints.length(); ++i) {
-    QPair<QVector3D, qreal> thisBetaSphere;
-    thisBetaSphere.first = nuclearCriticalPoints.at(i);
-    thisBetaSphere.second = 0.1;
-    betaSpheres.append(thisBetaSphere);
-  }
-
-  QTAIMWavefunctionEvaluator eval(wfn);
-
-  QList<QVector3D> ncpList;
+  QTAIMWavefunctionEvaluator eval(*task.wfn);
 
   QVector3D result;
   //    QTAIMODEIntegrator
   //    ode(eval,QTAIMODEIntegrator::CMBPMinusOneGradientInElectronDensity);
   QTAIMLSODAIntegrator ode(
     eval, QTAIMLSODAIntegrator::CMBPMinusOneGradientInElectronDensity);
-  result = ode.integrate(x0y0z0);
+  result = ode.integrate(task.start);
   Matrix<qreal, 3, 1> xyz;
   xyz << result.x(), result.y(), result.z();
 
+  // for debugging
+  value.position = result;
+
   if (!(QTAIMMathUtilities::signatureOfASymmetricThreeByThreeMatrix(
           eval.hessianOfElectronDensity(xyz)) == -1) ||
       (eval.gradientOfElectronDensity(xyz)).norm() > SMALL_GRADIENT_NORM) {
-    value.append(false);
-    value.append(result.x());
-    value.append(result.y());
-    value.append(result.z());
     return value;
   }
 
-  Matrix<qreal, 3, 3> eigenvectorsOfHessian;
-  eigenvectorsOfHessian =
+  Matrix<qreal, 3, 3> eigenvectors =
     QTAIMMathUtilities::eigenvectorsOfASymmetricThreeByThreeMatrix(
       eval.hessianOfElectronDensity(xyz));
   Matrix<qreal, 3, 1> highestEigenvectorOfHessian;
-  highestEigenvectorOfHessian << eigenvectorsOfHessian(0, 2),
-    eigenvectorsOfHessian(1, 2), eigenvectorsOfHessian(2, 2);
+  highestEigenvectorOfHessian << eigenvectors(0, 2), eigenvectors(1, 2),
+    eigenvectors(2, 2);
 
   const qreal smallStep = 0.01;
 
@@ -173,7 +182,7 @@ QList<QVariant> QTAIMLocateBondCriticalPoint(QList<QVariant> input)
   //    forwardODE(eval,QTAIMODEIntegrator::SteepestAscentPathInElectronDensity);
   QTAIMLSODAIntegrator forwardODE(
     eval, QTAIMLSODAIntegrator::SteepestAscentPathInElectronDensity);
-  forwardODE.setBetaSpheres(betaSpheres);
+  forwardODE.setBetaSpheres(*task.betaSpheres);
   QVector3D forwardEndpoint = forwardODE.integrate(forwardStartingPoint);
   QList<QVector3D> forwardPath = forwardODE.path();
 
@@ -181,235 +190,126 @@ QList<QVariant> QTAIMLocateBondCriticalPoint(QList<QVariant> input)
   //    backwardODE(eval,QTAIMODEIntegrator::SteepestAscentPathInElectronDensity);
   QTAIMLSODAIntegrator backwardODE(
     eval, QTAIMLSODAIntegrator::SteepestAscentPathInElectronDensity);
-  backwardODE.setBetaSpheres(betaSpheres);
+  backwardODE.setBetaSpheres(*task.betaSpheres);
   QVector3D backwardEndpoint = backwardODE.integrate(backwardStartingPoint);
   QList<QVector3D> backwardPath = backwardODE.path();
 
-  qreal smallestDistance = HUGE_REAL_NUMBER;
-  qint64 smallestDistanceIndex = 0;
-
-  for (qint64 n = 0; n < wfn.numberOfNuclei(); ++n) {
-    Matrix<qreal, 3, 1> a(forwardEndpoint.x(), forwardEndpoint.y(),
-                          forwardEndpoint.z());
-    Matrix<qreal, 3, 1> b(wfn.xNuclearCoordinate(n), wfn.yNuclearCoordinate(n),
-                          wfn.zNuclearCoordinate(n));
-
-    qreal distance = QTAIMMathUtilities::distance(a, b);
-
-    if (distance < smallestDistance) {
-      smallestDistance = distance;
-      smallestDistanceIndex = n;
-    }
-  }
-  qint64 forwardNucleusIndex = smallestDistanceIndex;
-
-  smallestDistance = HUGE_REAL_NUMBER;
-  smallestDistanceIndex = 0;
-
-  for (qint64 n = 0; n < wfn.numberOfNuclei(); ++n) {
-    Matrix<qreal, 3, 1> a(backwardEndpoint.x(), backwardEndpoint.y(),
-                          backwardEndpoint.z());
-    Matrix<qreal, 3, 1> b(wfn.xNuclearCoordinate(n), wfn.yNuclearCoordinate(n),
-                          wfn.zNuclearCoordinate(n));
+  qint64 forwardNucleusIndex = QTAIMNearestNucleus(*task.wfn, forwardEndpoint);
+  qint64 backwardNucleusIndex =
+    QTAIMNearestNucleus(*task.wfn, backwardEndpoint);
 
-    qreal distance = QTAIMMathUtilities::distance(a, b);
-
-    if (distance < smallestDistance) {
-      smallestDistance = distance;
-      smallestDistanceIndex = n;
-    }
-  }
-  qint64 backwardNucleusIndex = smallestDistanceIndex;
-
-  bool bondPathConnectsPair;
-  if ((forwardNucleusIndex == nucleusA && backwardNucleusIndex == nucleusB) ||
-      (forwardNucleusIndex == nucleusB && backwardNucleusIndex == nucleusA)) {
-    bondPathConnectsPair = true;
-  } else {
-    bondPathConnectsPair = false;
-  }
+  bool bondPathConnectsPair = (forwardNucleusIndex == task.nucleusA &&
+                               backwardNucleusIndex == task.nucleusB) ||
+                              (forwardNucleusIndex == task.nucleusB &&
+                               backwardNucleusIndex == task.nucleusA);
 
   if (bondPathConnectsPair) {
-    value.append(true);
-    value.append(nucleusA);
-    value.append(nucleusB);
-    value.append(result.x());
-    value.append(result.y());
-    value.append(result.z());
-    Matrix<qreal, 3, 1> xyz_;
-    xyz_ << result.x(), result.y(), result.z();
-    value.append(eval.laplacianOfElectronDensity(xyz_));
-    value.append(QTAIMMathUtilities::ellipticityOfASymmetricThreeByThreeMatrix(
-      eval.hessianOfElectronDensity(xyz_)));
-    value.append(1 + forwardPath.length() + 1 + backwardPath.length() + 1);
-    value.append(forwardEndpoint.x());
-    for (qint64 i = forwardPath.length() - 1; i >= 0; --i) {
-      value.append(forwardPath.at(i).x());
-    }
-    value.append(result.x());
-    for (qint64 i = 0; i < backwardPath.length(); ++i) {
-      value.append(backwardPath.at(i).x());
-    }
-    value.append(backwardEndpoint.x());
-    value.append(forwardEndpoint.y());
-    for (qint64 i = forwardPath.length() - 1; i >= 0; --i) {
-      value.append(forwardPath.at(i).y());
-    }
-    value.append(result.y());
-    for (qint64 i = 0; i < backwardPath.length(); ++i) {
-      value.append(backwardPath.at(i).y());
-    }
-    value.append(backwardEndpoint.y());
-    value.append(forwardEndpoint.z());
+    value.found = true;
+    value.nucleusA = task.nucleusA;
+    value.nucleusB = task.nucleusB;
+    value.laplacian = eval.laplacianOfElectronDensity(xyz);
+    value.ellipticity =
+      QTAIMMathUtilities::ellipticityOfASymmetricThreeByThreeMatrix(
+        eval.hessianOfElectronDensity(xyz));
+
+    value.path.append(forwardEndpoint);
     for (qint64 i = forwardPath.length() - 1; i >= 0; --i) {
-      value.append(forwardPath.at(i).z());
+      value.path.append(forwardPath.at(i));
     }
-    value.append(result.z());
-    for (qint64 i = 0; i < backwardPath.length(); ++i) {
-      value.append(backwardPath.at(i).z());
-    }
-    value.append(backwardEndpoint.z());
-
-  } else {
-    value.append(false);
-    // for debugging
-    value.append(result.x());
-    value.append(result.y());
-    value.append(result.z());
+    value.path.append(result);
+    value.path.append(backwardPath);
+    value.path.append(backwardEndpoint);
   }
 
   return value;
 }
 
-QList<QVariant> QTAIMLocateElectronDensitySink(QList<QVariant> input)
+// Sources and sinks are critical points of the Laplacian of the electron
+// density with the given signature.
+QTAIMCriticalPointResult QTAIMLocateLaplacianCriticalPoint(
+  const QTAIMCriticalPointTask& task, qint64 mode, qint64 signature)
 {
-  qint64 counter = 0;
-  const QString fileName = input.at(counter).toString();
-  counter++;
-  //    const qint64 nucleus=input.at(counter).toInt(); counter++
-  qreal x0 = input.at(counter).toReal();
-  counter++;
-  qreal y0 = input.at(counter).toReal();
-  counter++;
-  qreal z0 = input.at(counter).toReal();
-  counter++;
-
-  const QVector3D x0y0z0(x0, y0, z0);
+  QTAIMCriticalPointResult value;
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(fileName);
-
-  QTAIMWavefunctionEvaluator eval(wfn);
-
-  bool correctSignature;
-  QVector3D result;
+  QTAIMWavefunctionEvaluator eval(*task.wfn);
 
   Matrix<qreal, 3, 1> xyz;
-  xyz << x0, y0, z0;
+  xyz << task.start.x(), task.start.y(), task.start.z();
   if (eval.electronDensity(xyz) < 1.e-1) {
-    correctSignature = false;
-  } else {
-    //      QTAIMODEIntegrator
-    //      ode(eval,QTAIMODEIntegrator::CMBPMinusThreeGradientInElectronDensityLaplacian);
-    QTAIMLSODAIntegrator ode(
-      eval,
-      QTAIMLSODAIntegrator::CMBPMinusThreeGradientInElectronDensityLaplacian);
-    result = ode.integrate(x0y0z0);
-
-    Matrix<qreal, 3, 1> xyz_;
-    xyz_ << result.x(), result.y(), result.z();
-
-    if (eval.electronDensity(xyz_) > 1.e-1 &&
-        eval.gradientOfElectronDensityLaplacian(xyz_).norm() < 1.e-3) {
-      if (QTAIMMathUtilities::signatureOfASymmetricThreeByThreeMatrix(
-            eval.hessianOfElectronDensityLaplacian(xyz_)) == -3) {
-        correctSignature = true;
-      } else {
-        correctSignature = false;
-      }
-    } else {
-      correctSignature = false;
-    }
+    return value;
   }
 
-  QList<QVariant> value;
-  if (correctSignature) {
-    value.append(correctSignature);
-    value.append(result.x());
-    value.append(result.y());
-    value.append(result.z());
-  } else {
-    value.append(false);
+  QTAIMLSODAIntegrator ode(eval, mode);
+  QVector3D result = ode.integrate(task.start);
+
+  Matrix<qreal, 3, 1> xyz_;
+  xyz_ << result.x(), result.y(), result.z();
+
+  if (eval.electronDensity(xyz_) > 1.e-1 &&
+      eval.gradientOfElectronDensityLaplacian(xyz_).norm() < 1.e-3 &&
+      QTAIMMathUtilities::signatureOfASymmetricThreeByThreeMatrix(
+        eval.hessianOfElectronDensityLaplacian(xyz_)) == signature) {
+    value.found = true;
+    value.position = result;
   }
 
   return value;
 }
 
-QList<QVariant> QTAIMLocateElectronDensitySource(QList<QVariant> input)
+QTAIMCriticalPointResult QTAIMLocateElectronDensitySink(
+  const QTAIMCriticalPointTask& task)
 {
-  qint64 counter = 0;
-  const QString fileName = input.at(counter).toString();
-  counter++;
-  //    const qint64 nucleus=input.at(counter).toInt(); counter++
-  qreal x0 = input.at(counter).toReal();
-  counter++;
-  qreal y0 = input.at(counter).toReal();
-  counter++;
-  qreal z0 = input.at(counter).toReal();
-  counter++;
-
-  const QVector3D x0y0z0(x0, y0, z0);
+  //      QTAIMODEIntegrator
+  //      ode(eval,QTAIMODEIntegrator::CMBPMinusThreeGradientInElectronDensityLaplacian);
+  return QTAIMLocateLaplacianCriticalPoint(
+    task,
+    QTAIMLSODAIntegrator::CMBPMinusThreeGradientInElectronDensityLaplacian, -3);
+}
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(fileName);
+QTAIMCriticalPointResult QTAIMLocateElectronDensitySource(
+  const QTAIMCriticalPointTask& task)
+{
+  //      QTAIMODEIntegrator
+  //      ode(eval,QTAIMODEIntegrator::CMBPPlusThreeGradientInElectronDensityLaplacian);
+  return QTAIMLocateLaplacianCriticalPoint(
+    task, QTAIMLSODAIntegrator::CMBPPlusThreeGradientInElectronDensityLaplacian,
+    3);
+}
 
-  QTAIMWavefunctionEvaluator eval(wfn);
+// Run the tasks concurrently behind a progress dialog. Nothing is returned if
+// the search was canceled.
+QList<QTAIMCriticalPointResult> QTAIMRunCriticalPointTasks(
+  const QList<QTAIMCriticalPointTask>& tasks, const QString& label,
+  QTAIMCriticalPointResult (*locate)(const QTAIMCriticalPointTask&))
+{
+  QProgressDialog dialog;
+  dialog.setWindowTitle("QTAIM");
+  dialog.setLabelText(label);
 
-  bool correctSignature;
-  QVector3D result;
+  QFutureWatcher<void> futureWatcher;
+  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
+  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
+  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)),
+                   &dialog, SLOT(setRange(int, int)));
+  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog,
+                   SLOT(setValue(int)));
 
-  Matrix<qreal, 3, 1> xyz;
-  xyz << x0, y0, z0;
-  if (eval.electronDensity(xyz) < 1.e-1) {
-    correctSignature = false;
-  } else {
-    //      QTAIMODEIntegrator
-    //      ode(eval,QTAIMODEIntegrator::CMBPPlusThreeGradientInElectronDensityLaplacian);
-    QTAIMLSODAIntegrator ode(
-      eval,
-      QTAIMLSODAIntegrator::CMBPPlusThreeGradientInElectronDensityLaplacian);
-    result = ode.integrate(x0y0z0);
-
-    Matrix<qreal, 3, 1> xyz_;
-    xyz_ << result.x(), result.y(), result.z();
-
-    if (eval.electronDensity(xyz_) > 1.e-1 &&
-        eval.gradientOfElectronDensityLaplacian(xyz_).norm() < 1.e-3) {
-      if (QTAIMMathUtilities::signatureOfASymmetricThreeByThreeMatrix(
-            eval.hessianOfElectronDensityLaplacian(xyz_)) == 3) {
-        correctSignature = true;
-      } else {
-        correctSignature = false;
-      }
-    } else {
-      correctSignature = false;
-    }
-  }
+  QFuture<QTAIMCriticalPointResult> future =
+    QtConcurrent::mapped(tasks, locate);
+  futureWatcher.setFuture(future);
+  dialog.exec();
+  futureWatcher.waitForFinished();
 
-  QList<QVariant> value;
-  if (correctSignature) {
-    value.append(correctSignature);
-    value.append(result.x());
-    value.append(result.y());
-    value.append(result.z());
-  } else {
-    value.append(false);
+  if (futureWatcher.future().isCanceled()) {
+    return QList<QTAIMCriticalPointResult>();
   }
-
-  return value;
+  return future.results();
 }
 
-QTAIMCriticalPointLocator::QTAIMCriticalPointLocator(QTAIMWavefunction& wfn)
+} // namespace
+
+QTAIMCriticalPointLocator::QTAIMCriticalPointLocator(
+  const QTAIMWavefunction& wfn)
 {
   m_wfn = &wfn;
 
@@ -430,67 +330,26 @@ QTAIMCriticalPointLocator::QTAIMCriticalPointLocator(QTAIMWavefunction& wfn)
 
 void QTAIMCriticalPointLocator::locateNuclearCriticalPoints()
 {
-
-  QString tempFileName = QTAIMCriticalPointLocator::temporaryFileName();
-
-  QList<QList<QVariant>> inputList;
+  QList<QTAIMCriticalPointTask> tasks;
 
   const qint64 numberOfNuclei = m_wfn->numberOfNuclei();
 
   for (qint64 n = 0; n < numberOfNuclei; ++n) {
-    QList<QVariant> input;
-    input.append(tempFileName);
-    input.append(n);
-    input.append(m_wfn->xNuclearCoordinate(n));
-    input.append(m_wfn->yNuclearCoordinate(n));
-    input.append(m_wfn->zNuclearCoordinate(n));
-
-    inputList.append(input);
-  }
-
-  m_wfn->saveToBinaryFile(tempFileName);
-
-  QProgressDialog dialog;
-  dialog.setWindowTitle("QTAIM");
-  dialog.setLabelText(QString("Nuclear Critical Points Search"));
-
-  QFutureWatcher<void> futureWatcher;
-  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
-  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
-  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)),
-                   &dialog, SLOT(setRange(int, int)));
-  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog,
-                   SLOT(setValue(int)));
+    QTAIMCriticalPointTask task;
+    task.wfn = m_wfn;
+    task.betaSpheres = nullptr;
+    task.nucleusA = n;
+    task.nucleusB = -1;
+    task.start =
+      QVector3D(m_wfn->xNuclearCoordinate(n), m_wfn->yNuclearCoordinate(n),
+                m_wfn->zNuclearCoordinate(n));
 
-  QFuture<QList<QVariant>> future =
-    QtConcurrent::mapped(inputList, QTAIMLocateNuclearCriticalPoint);
-  futureWatcher.setFuture(future);
-  dialog.exec();
-  futureWatcher.waitForFinished();
-
-  QList<QList<QVariant>> results;
-  if (futureWatcher.future().isCanceled()) {
-    results.clear();
-  } else {
-    results = future.results();
+    tasks.append(task);
   }
 
-  QFile file;
-  file.remove(tempFileName);
-
-  for (qint64 n = 0; n < results.length(); ++n) {
-
-    bool correctSignature = results.at(n).at(0).toBool();
-
-    if (correctSignature) {
-
-      QVector3D result(results.at(n).at(1).toReal(),
-                       results.at(n).at(2).toReal(),
-                       results.at(n).at(3).toReal());
-
-      m_nuclearCriticalPoints.append(result);
-    }
-  }
+  m_nuclearCriticalPoints.append(QTAIMCriticalPointPositions(
+    QTAIMRunCriticalPointTasks(tasks, QString("Nuclear Critical Points Search"),
+                               QTAIMLocateNuclearCriticalPoint)));
 }
 
 void QTAIMCriticalPointLocator::locateBondCriticalPoints()
@@ -506,17 +365,15 @@ void QTAIMCriticalPointLocator::locateBondCriticalPoints()
     return;
   }
 
-  QString tempFileName = QTAIMCriticalPointLocator::temporaryFileName();
-
-  QString nuclearCriticalPointsFileName =
-    QTAIMCriticalPointLocator::temporaryFileName();
-  QFile nuclearCriticalPointsFile(nuclearCriticalPointsFileName);
-  nuclearCriticalPointsFile.open(QIODevice::WriteOnly);
-  QDataStream nuclearCriticalPointsOut(&nuclearCriticalPointsFile);
-  nuclearCriticalPointsOut << m_nuclearCriticalPoints;
-  nuclearCriticalPointsFile.close();
+  QList<QPair<QVector3D, qreal>> betaSpheres;
+  for (qint64 i = 0; i < m_nuclearCriticalPoints.length(); ++i) {
+    QPair<QVector3D, qreal> thisBetaSphere;
+    thisBetaSphere.first = m_nuclearCriticalPoints.at(i);
+    thisBetaSphere.second = 0.1;
+    betaSpheres.append(thisBetaSphere);
+  }
 
-  QList<QList<QVariant>> inputList;
+  QList<QTAIMCriticalPointTask> tasks;
 
   for (qint64 M = 0; M < numberOfNuclei - 1; ++M) {
     for (qint64 N = M + 1; N < numberOfNuclei; ++N) {
@@ -532,100 +389,42 @@ void QTAIMCriticalPointLocator::locateBondCriticalPoints()
         m_wfn->zNuclearCoordinate(N);
 
       if (QTAIMMathUtilities::distance(a, b) < distanceCutoff) {
-        QVector3D x0y0z0(
+        QTAIMCriticalPointTask task;
+        task.wfn = m_wfn;
+        task.betaSpheres = &betaSpheres;
+        task.nucleusA = M;
+        task.nucleusB = N;
+        task.start = QVector3D(
           (m_wfn->xNuclearCoordinate(M) + m_wfn->xNuclearCoordinate(N)) / 2.0,
           (m_wfn->yNuclearCoordinate(M) + m_wfn->yNuclearCoordinate(N)) / 2.0,
           (m_wfn->zNuclearCoordinate(M) + m_wfn->zNuclearCoordinate(N)) / 2.0);
 
-        QList<QVariant> input;
-        input.append(tempFileName);
-        input.append(nuclearCriticalPointsFileName);
-        input.append(M);
-        input.append(N);
-        input.append(x0y0z0.x());
-        input.append(x0y0z0.y());
-        input.append(x0y0z0.z());
-
-        inputList.append(input);
+        tasks.append(task);
       }
     } // end N
   }   // end M
 
-  m_wfn->saveToBinaryFile(tempFileName);
-
-  QProgressDialog dialog;
-  dialog.setWindowTitle("QTAIM");
-  dialog.setLabelText(QString("Bond Critical Points Search"));
-
-  QFutureWatcher<void> futureWatcher;
-  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
-  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
-  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)),
-                   &dialog, SLOT(setRange(int, int)));
-  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog,
-                   SLOT(setValue(int)));
-
-  QFuture<QList<QVariant>> future =
-    QtConcurrent::mapped(inputList, QTAIMLocateBondCriticalPoint);
-  ;
-  futureWatcher.setFuture(future);
-  dialog.exec();
-  futureWatcher.waitForFinished();
-
-  QList<QList<QVariant>> results;
-  if (futureWatcher.future().isCanceled()) {
-    results.clear();
-  } else {
-    results = future.results();
-  }
-
-  QFile file;
-  file.remove(tempFileName);
-  file.remove(nuclearCriticalPointsFileName);
+  QList<QTAIMCriticalPointResult> results =
+    QTAIMRunCriticalPointTasks(tasks, QString("Bond Critical Points Search"),
+                               QTAIMLocateBondCriticalPoint);
 
   for (qint64 i = 0; i < results.length(); ++i) {
-    QList<QVariant> thisCriticalPoint = results.at(i);
-
-    bool success = thisCriticalPoint.at(0).toBool();
-
-    if (success) {
-      QPair<qint64, qint64> bondedAtoms_;
-      bondedAtoms_.first = thisCriticalPoint.at(1).toInt();
-      bondedAtoms_.second = thisCriticalPoint.at(2).toInt();
-      m_bondedAtoms.append(bondedAtoms_);
-
-      QVector3D coordinates(thisCriticalPoint.at(3).toReal(),
-                            thisCriticalPoint.at(4).toReal(),
-                            thisCriticalPoint.at(5).toReal());
-
-      m_bondCriticalPoints.append(coordinates);
-
-      m_laplacianAtBondCriticalPoints.append(thisCriticalPoint.at(6).toReal());
-      m_ellipticityAtBondCriticalPoints.append(
-        thisCriticalPoint.at(7).toReal());
-      qint64 pathLength = thisCriticalPoint.at(8).toInt();
-
-      QList<QVector3D> bondPath;
-      for (qint64 j = 0; j < pathLength; ++j) {
-        QVector3D pathPoint(
-          thisCriticalPoint.at(9 + j).toReal(),
-          thisCriticalPoint.at(9 + j + pathLength).toReal(),
-          thisCriticalPoint.at(9 + j + 2 * pathLength).toReal());
-
-        bondPath.append(pathPoint);
-      }
-
-      m_bondPaths.append(bondPath);
+    const QTAIMCriticalPointResult& thisCriticalPoint = results.at(i);
+
+    if (thisCriticalPoint.found) {
+      m_bondedAtoms.append(qMakePair(thisCriticalPoint.nucleusA,
+                                     thisCriticalPoint.nucleusB));
+      m_bondCriticalPoints.append(thisCriticalPoint.position);
+      m_laplacianAtBondCriticalPoints.append(thisCriticalPoint.laplacian);
+      m_ellipticityAtBondCriticalPoints.append(thisCriticalPoint.ellipticity);
+      m_bondPaths.append(thisCriticalPoint.path);
     }
   }
 }
 
 void QTAIMCriticalPointLocator::locateElectronDensitySources()
 {
-
-  QString tempFileName = QTAIMCriticalPointLocator::temporaryFileName();
-
-  QList<QList<QVariant>> inputList;
+  QList<QTAIMCriticalPointTask> tasks;
 
   qreal xmin, ymin, zmin;
   qreal xmax, ymax, zmax;
@@ -688,61 +487,28 @@ void QTAIMCriticalPointLocator::locateElectronDensitySources()
   for (qreal x = xmin; x < xmax + xstep; x = x + xstep) {
     for (qreal y = ymin; y < ymax + ystep; y = y + ystep) {
       for (qreal z = zmin; z < zmax + zstep; z = z + zstep) {
-        QList<QVariant> input;
-        input.append(tempFileName);
-        //          input.append( n );
-        input.append(x);
-        input.append(y);
-        input.append(z);
-
-        inputList.append(input);
+        QTAIMCriticalPointTask task;
+        task.wfn = m_wfn;
+        task.betaSpheres = nullptr;
+        task.nucleusA = -1;
+        task.nucleusB = -1;
+        task.start = QVector3D(x, y, z);
+
+        tasks.append(task);
       }
     }
   }
 
-  m_wfn->saveToBinaryFile(tempFileName);
-
-  QProgressDialog dialog;
-  dialog.setWindowTitle("QTAIM");
-  dialog.setLabelText(QString("Electron Density Sources Search"));
-
-  QFutureWatcher<void> futureWatcher;
-  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
-  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
-  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)),
-                   &dialog, SLOT(setRange(int, int)));
-  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog,
-                   SLOT(setValue(int)));
-
-  QFuture<QList<QVariant>> future =
-    QtConcurrent::mapped(inputList, QTAIMLocateElectronDensitySource);
-  futureWatcher.setFuture(future);
-  dialog.exec();
-  futureWatcher.waitForFinished();
-
-  QList<QList<QVariant>> results;
-  if (futureWatcher.future().isCanceled()) {
-    results.clear();
-  } else {
-    results = future.results();
-  }
-
-  QFile file;
-  file.remove(tempFileName);
+  QList<QTAIMCriticalPointResult> results = QTAIMRunCriticalPointTasks(
+    tasks, QString("Electron Density Sources Search"),
+    QTAIMLocateElectronDensitySource);
 
   for (qint64 n = 0; n < results.length(); ++n) {
 
-    qint64 counter = 0;
-    bool correctSignature = results.at(n).at(counter).toBool();
-    counter++;
-
-    if (correctSignature) {
-      qreal x = results.at(n).at(counter).toReal();
-      counter++;
-      qreal y = results.at(n).at(counter).toReal();
-      counter++;
-      qreal z = results.at(n).at(counter).toReal();
-      counter++;
+    if (results.at(n).found) {
+      qreal x = results.at(n).position.x();
+      qreal y = results.at(n).position.y();
+      qreal z = results.at(n).position.z();
 
       if ((xmin < x && x < xmax) && (ymin < y && y < ymax) &&
           (zmin < z && z < zmax)) {
@@ -775,10 +541,7 @@ void QTAIMCriticalPointLocator::locateElectronDensitySources()
 
 void QTAIMCriticalPointLocator::locateElectronDensitySinks()
 {
-
-  QString tempFileName = QTAIMCriticalPointLocator::temporaryFileName();
-
-  QList<QList<QVariant>> inputList;
+  QList<QTAIMCriticalPointTask> tasks;
 
   qreal xmin, ymin, zmin;
   qreal xmax, ymax, zmax;
@@ -841,61 +604,28 @@ void QTAIMCriticalPointLocator::locateElectronDensitySinks()
   for (qreal x = xmin; x < xmax + xstep; x = x + xstep) {
     for (qreal y = ymin; y < ymax + ystep; y = y + ystep) {
       for (qreal z = zmin; z < zmax + zstep; z = z + zstep) {
-        QList<QVariant> input;
-        input.append(tempFileName);
-        //          input.append( n );
-        input.append(x);
-        input.append(y);
-        input.append(z);
-
-        inputList.append(input);
+        QTAIMCriticalPointTask task;
+        task.wfn = m_wfn;
+        task.betaSpheres = nullptr;
+        task.nucleusA = -1;
+        task.nucleusB = -1;
+        task.start = QVector3D(x, y, z);
+
+        tasks.append(task);
       }
     }
   }
 
-  m_wfn->saveToBinaryFile(tempFileName);
-
-  QProgressDialog dialog;
-  dialog.setWindowTitle("QTAIM");
-  dialog.setLabelText(QString("Electron Density Sinks Search"));
-
-  QFutureWatcher<void> futureWatcher;
-  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
-  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
-  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)),
-                   &dialog, SLOT(setRange(int, int)));
-  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog,
-                   SLOT(setValue(int)));
-
-  QFuture<QList<QVariant>> future =
-    QtConcurrent::mapped(inputList, QTAIMLocateElectronDensitySink);
-  futureWatcher.setFuture(future);
-  dialog.exec();
-  futureWatcher.waitForFinished();
-
-  QList<QList<QVariant>> results;
-  if (futureWatcher.future().isCanceled()) {
-    results.clear();
-  } else {
-    results = future.results();
-  }
-
-  QFile file;
-  file.remove(tempFileName);
+  QList<QTAIMCriticalPointResult> results = QTAIMRunCriticalPointTasks(
+    tasks, QString("Electron Density Sinks Search"),
+    QTAIMLocateElectronDensitySink);
 
   for (qint64 n = 0; n < results.length(); ++n) {
 
-    qint64 counter = 0;
-    bool correctSignature = results.at(n).at(counter).toBool();
-    counter++;
-
-    if (correctSignature) {
-      qreal x = results.at(n).at(counter).toReal();
-      counter++;
-      qreal y = results.at(n).at(counter).toReal();
-      counter++;
-      qreal z = results.at(n).at(counter).toReal();
-      counter++;
+    if (results.at(n).found) {
+      qreal x = results.at(n).position.x();
+      qreal y = results.at(n).position.y();
+      qreal z = results.at(n).position.z();
 
       if ((xmin < x && x < xmax) && (ymin < y && y < ymax) &&
           (zmin < z && z < zmax)) {
@@ -926,22 +656,5 @@ void QTAIMCriticalPointLocator::locateElectronDensitySinks()
   //    qDebug() << "SINKS" << m_electronDensitySinks;
 }
 
-QString QTAIMCriticalPointLocator::temporaryFileName()
-{
-  QTemporaryFile temporaryFile;
-  temporaryFile.open();
-  QString tempFileName = temporaryFile.fileName();
-  temporaryFile.close();
-  temporaryFile.remove();
-
-  // wait for temporary file to be deleted
-  QDir dir;
-  do {
-    // Nothing
-  } while (dir.exists(tempFileName));
-
-  return tempFileName;
-}
-
 } // namespace QtPlugins
 } // namespace Avogadro
@@ -33,7 +33,7 @@ class QTAIMCriticalPointLocator
 {
 
 public:
-  explicit QTAIMCriticalPointLocator(QTAIMWavefunction& wfn);
+  explicit QTAIMCriticalPointLocator(const QTAIMWavefunction& wfn);
   void locateNuclearCriticalPoints();
   void locateBondCriticalPoints();
 
@@ -70,7 +70,7 @@ public:
   }
 
 private:
-  QTAIMWavefunction* m_wfn;
+  const QTAIMWavefunction* m_wfn;
 
   QList<QVector3D> m_nuclearCriticalPoints;
   QList<QVector3D> m_bondCriticalPoints;
@@ -84,8 +84,6 @@ private:
 
   QList<QVector3D> m_electronDensitySources;
   QList<QVector3D> m_electronDensitySinks;
-
-  QString temporaryFileName();
 };
 
 } // namespace QtPlugins
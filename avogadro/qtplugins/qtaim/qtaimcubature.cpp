@@ -49,28 +49,19 @@
  *
  */
 
-#include <QDataStream>
 #include <QDebug>
-#include <QDir>
-#include <QFile>
-#include <QTemporaryFile>
-#include <QTextStream>
 
 #include <QPair>
-#include <QVariantList>
 #include <QVector3D>
 
-#include <QDataStream>
-#include <QDir>
-#include <QFile>
 #include <QFuture>
 #include <QFutureWatcher>
 #include <QList>
 #include <QProgressDialog>
-#include <QTemporaryFile>
-#include <QVariant>
+#include <QVector>
 #include <QtConcurrent/QtConcurrentMap>
 
+#include <algorithm>
 #include <cfloat>
 #include <climits>
 #include <cmath>
@@ -1179,118 +1170,79 @@ int adapt_integrate(unsigned int fdim, integrand f, void* fdata,
   return ret;
 }
 
-// TODO: Consider QVariantList. For now, mimic what is known to work.
-QList<QVariant> QTAIMEvaluateProperty(QList<QVariant> variantList)
-{
-  /*
-     Order of variantList:
-     QString wfnFileName
-     qreal x0
-     qreal y0
-     qreal z0
-     qint64 nncp
-     qint64 xncp1
-     qint64 yncp1
-     qint64 zncp1
-     qint64 xncp2
-     qint64 yncp2
-     qint64 zncp2
-     ...
-     qint64 nmode
-     qint64 mode1
-     qint64 mode2
-     ...
-     qint64 nbasin
-     qint64 basin1
-     qint64 basin2
-     ...
-  */
-  qint64 counter = 0;
-  QString wfnFileName = variantList.at(counter).toString();
-  counter++;
-  qreal x0 = variantList.at(counter).toDouble();
-  counter++;
-  qreal y0 = variantList.at(counter).toDouble();
-  counter++;
-  qreal z0 = variantList.at(counter).toDouble();
-  counter++;
-
-  qint64 nncp = variantList.at(counter).toLongLong();
-  counter++;
-  QList<QVector3D> ncpList;
-  for (qint64 n = 0; n < nncp; ++n) {
-    qreal x = variantList.at(counter).toDouble();
-    counter++;
-    qreal y = variantList.at(counter).toDouble();
-    counter++;
-    qreal z = variantList.at(counter).toDouble();
-    counter++;
-
-    ncpList.append(QVector3D(x, y, z));
-  }
-
-  qint64 nmode = variantList.at(counter).toLongLong();
-  counter++;
-  QList<qint64> modeList;
-  for (qint64 m = 0; m < nmode; ++m) {
-    qint64 mode = variantList.at(counter).toLongLong();
-    counter++;
-    modeList.append(mode);
-  }
-
-  qint64 nbasin = variantList.at(counter).toLongLong();
-  counter++;
-  QList<qint64> basinList;
-  for (qint64 b = 0; b < nbasin; ++b) {
-    qint64 basin = variantList.at(counter).toLongLong();
-    counter++;
-    basinList.append(basin);
-  }
-  QSet<qint64> basinSet = basinList.toSet();
-
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
+#define HUGE_REAL_NUMBER 1.e20
 
-  QTAIMWavefunctionEvaluator eval(wfn);
+namespace {
 
-  QList<QVariant> valueList;
+// Everything the integrands need to know about one atomic basin. The
+// wavefunction is shared read-only by all worker threads, each batch of points
+// builds its own evaluator from it.
+struct QTAIMBasinParameters
+{
+  const QTAIMWavefunction* wfn;
+  QList<QVector3D> ncpList;
+  QList<QPair<QVector3D, qreal>> betaSpheres;
+  qint64 mode;
+  qint64 basin;
+};
 
-  double initialElectronDensity =
-    eval.electronDensity(Eigen::Vector3d(x0, y0, z0));
+// The radial integral along one ray from the nucleus, evaluated on the thread
+// that owns the evaluator.
+struct QTAIMRayParameters
+{
+  QTAIMWavefunctionEvaluator* eval;
+  Matrix<qreal, 3, 1> origin;
+  qreal t;
+  qreal p;
+  qint64 mode;
+};
+
+typedef void (*QTAIMBasinIntegrand)(QTAIMWavefunctionEvaluator& eval,
+                                    QTAIMLSODAIntegrator& ode,
+                                    const QTAIMBasinParameters& param,
+                                    unsigned int npts, const double* x,
+                                    double* fval);
+
+struct QTAIMBasinBatch
+{
+  QTAIMBasinIntegrand integrand;
+  const QTAIMBasinParameters* param;
+  unsigned int ndim;
+  unsigned int npts;
+  const double* x;
+  double* fval;
+};
+
+const unsigned int QTAIMBasinBatchSize = 16;
+
+// The electron density at each point whose steepest ascent path ends in the
+// basin, -1 at the other points.
+void QTAIMElectronDensityInBasin(QTAIMWavefunctionEvaluator& eval,
+                                 QTAIMLSODAIntegrator& ode,
+                                 const QTAIMBasinParameters& param,
+                                 const Matrix<qreal, Dynamic, 3>& xyz,
+                                 Matrix<qreal, Dynamic, 1>& rho)
+{
+  eval.electronDensity(xyz, rho);
 
-  // if less than some small value, then return zero for all integrands.
-  if (initialElectronDensity < 1.e-5) {
-    for (qint64 m = 0; m < nmode; ++m) {
-      qreal zero = 0.0;
-      valueList.append(zero);
-    }
-  } else {
-    QList<QPair<QVector3D, qreal>> betaSpheres;
-    for (qint64 i = 0; i < nncp; ++i) {
-      QPair<QVector3D, qreal> thisBetaSphere;
-      thisBetaSphere.first =
-        QVector3D(ncpList.at(i).x(), ncpList.at(i).y(), ncpList.at(i).z());
-      thisBetaSphere.second = 0.10;
-      betaSpheres.append(thisBetaSphere);
+  for (qint64 i = 0; i < xyz.rows(); ++i) {
+    // if less than some small value, then it does not belong to any basin.
+    if (rho(i) < 1.e-5) {
+      rho(i) = -1.0;
+      continue;
     }
 
-    QTAIMLSODAIntegrator ode(eval, 0);
-    //  Avogadro::QTAIMODEIntegrator ode(eval,0);
-
-    ode.setBetaSpheres(betaSpheres);
-
-    QVector3D endpoint = ode.integrate(QVector3D(x0, y0, z0));
-// QList<QVector3D> path=ode.path();
+    QVector3D endpoint =
+      ode.integrate(QVector3D(xyz(i, 0), xyz(i, 1), xyz(i, 2)));
 
-#define HUGE_REAL_NUMBER 1.e20
     qreal smallestDistance = HUGE_REAL_NUMBER;
     qint64 smallestDistanceIndex = -1;
 
-    for (qint64 n = 0; n < betaSpheres.length(); ++n) {
-      Matrix<qreal, 3, 1> a(endpoint.x(), endpoint.y(), endpoint.z());
-      Matrix<qreal, 3, 1> b(betaSpheres.at(n).first.x(),
-                            betaSpheres.at(n).first.y(),
-                            betaSpheres.at(n).first.z());
+    Matrix<qreal, 3, 1> a(endpoint.x(), endpoint.y(), endpoint.z());
+    for (qint64 n = 0; n < param.betaSpheres.length(); ++n) {
+      Matrix<qreal, 3, 1> b(param.betaSpheres.at(n).first.x(),
+                            param.betaSpheres.at(n).first.y(),
+                            param.betaSpheres.at(n).first.z());
 
       qreal distance = QTAIMMathUtilities::distance(a, b);
 
@@ -1299,871 +1251,227 @@ QList<QVariant> QTAIMEvaluateProperty(QList<QVariant> variantList)
         smallestDistanceIndex = n;
       }
     }
-    qint64 nucleusIndex = smallestDistanceIndex;
-
-    if (basinSet.contains(nucleusIndex)) {
-      //      if(nucleusIndex==0)
-      //      {
-      //        QFile file("/scratch/brown/0.txt");
-      //        file.open(QIODevice::WriteOnly | QIODevice::Append);
-      //        QTextStream out(&file);
-      //        out << x0 << " " << y0 << " " << z0 << "\n";
-      //        file.close();
-      //      }
-      for (qint64 m = 0; m < nmode; ++m) {
-        if (modeList.at(m) == 0) {
-          valueList.append(eval.electronDensity(Eigen::Vector3d(x0, y0, z0)));
-        } else {
-          qDebug() << "mode not defined";
-          qreal zero = 0.0;
-          valueList.append(zero);
-        }
-      }
-    } else {
-      for (qint64 m = 0; m < nmode; ++m) {
-        qreal zero = 0.0;
-        valueList.append(zero);
-      }
+
+    if (smallestDistanceIndex != param.basin) {
+      rho(i) = -1.0;
     }
   }
-
-  return valueList;
 }
 
-void property_v(unsigned int /* ndim */, unsigned int npts, const double* xyz,
-                void* param, unsigned int /* dim */, double* fval)
+Matrix<qreal, 3, 1> QTAIMBasinOrigin(const QTAIMBasinParameters& param)
 {
+  Matrix<qreal, 3, 1> origin;
+  origin << param.ncpList.at(param.basin).x(),
+    param.ncpList.at(param.basin).y(), param.ncpList.at(param.basin).z();
+  return origin;
+}
 
-  QVariantList* paramVariantListPtr = (QVariantList*)param;
-  QVariantList paramVariantList = *paramVariantListPtr;
-
-  qint64 counter = 0;
-  QString wfnFileName = paramVariantList.at(counter).toString();
-  counter++;
-
-  qint64 nncp = paramVariantList.at(counter).toLongLong();
-  counter++;
-  QList<QVector3D> ncpList;
-  for (qint64 i = 0; i < nncp; ++i) {
-    qreal x = paramVariantList.at(counter).toDouble();
-    counter++;
-    qreal y = paramVariantList.at(counter).toDouble();
-    counter++;
-    qreal z = paramVariantList.at(counter).toDouble();
-    counter++;
-
-    ncpList.append(QVector3D(x, y, z));
-  }
-  qint64 nmode = 1;
-  qint64 mode = paramVariantList.at(counter).toLongLong();
-  counter++;
-  QList<qint64> basinList;
-  for (qint64 i = counter; i < paramVariantList.length(); ++i) {
-    basinList.append(paramVariantList.at(i).toLongLong());
-    counter++;
+// Integrand in Cartesian coordinates.
+void QTAIMEvaluateProperty(QTAIMWavefunctionEvaluator& eval,
+                           QTAIMLSODAIntegrator& ode,
+                           const QTAIMBasinParameters& param,
+                           unsigned int npts, const double* x, double* fval)
+{
+  if (param.mode != 0) {
+    qDebug() << "mode not defined";
+    return;
   }
 
-  // prepare input
-
-  QList<QList<QVariant>> inputList;
-
+  Matrix<qreal, Dynamic, 3> xyz(npts, 3);
   for (unsigned int i = 0; i < npts; ++i) {
-
-    double x0 = xyz[i * 3 + 0];
-    double y0 = xyz[i * 3 + 1];
-    double z0 = xyz[i * 3 + 2];
-
-    QList<QVariant> variantList;
-
-    variantList.append(wfnFileName);
-
-    variantList.append(x0);
-    variantList.append(y0);
-    variantList.append(z0);
-
-    variantList.append(nncp);
-    for (qint64 n = 0; n < nncp; ++n) {
-      variantList.append(ncpList.at(n).x());
-      variantList.append(ncpList.at(n).y());
-      variantList.append(ncpList.at(n).z());
-    }
-
-    variantList.append(nmode); // for now, one mode
-    for (qint64 m = 0; m < nmode; ++m) {
-      variantList.append(mode);
-    }
-
-    qint64 nbasin = basinList.length();
-    variantList.append(nbasin);
-    for (qint64 b = 0; b < basinList.length(); ++b) {
-      variantList.append(basinList.at(b));
-    }
-
-    inputList.append(variantList);
+    xyz.row(i) << x[i * 3 + 0], x[i * 3 + 1], x[i * 3 + 2];
   }
 
-  // calculate
-
-  QProgressDialog dialog;
-  dialog.setWindowTitle("QTAIM");
-  dialog.setLabelText(QString("Atomic Basin Integration"));
-
-  QFutureWatcher<void> futureWatcher;
-  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
-  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
-  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)),
-                   &dialog, SLOT(setRange(int, int)));
-  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog,
-                   SLOT(setValue(int)));
-
-  QFuture<QList<QVariant>> future =
-    QtConcurrent::mapped(inputList, QTAIMEvaluateProperty);
-  futureWatcher.setFuture(future);
-  dialog.exec();
-  futureWatcher.waitForFinished();
-
-  QList<QList<QVariant>> results;
-  if (futureWatcher.future().isCanceled()) {
-    results.clear();
-  } else {
-    results = future.results();
-  }
+  Matrix<qreal, Dynamic, 1> rho;
+  QTAIMElectronDensityInBasin(eval, ode, param, xyz, rho);
 
-  // harvest results
-  for (qint64 i = 0; i < npts; ++i) {
-    for (qint64 m = 0; m < nmode; ++m) {
-      fval[m * nmode + i] = results.at(i).at(m).toDouble();
-    }
+  for (unsigned int i = 0; i < npts; ++i) {
+    fval[i] = qMax(rho(i), 0.0);
   }
 }
 
-// TODO: Consider QVariantList. For now, mimic what is known to work.
 // This version performs integration in Spherical Polar Coordinates.
 // Note that the basin limits are not explicitly determined.
-QList<QVariant> QTAIMEvaluatePropertyRTP(QList<QVariant> variantList)
+void QTAIMEvaluatePropertyRTP(QTAIMWavefunctionEvaluator& eval,
+                              QTAIMLSODAIntegrator& ode,
+                              const QTAIMBasinParameters& param,
+                              unsigned int npts, const double* x, double* fval)
 {
-  /*
-     Order of variantList:
-     QString wfnFileName
-     qreal r0
-     qreal t0
-     qreal p0
-     qint64 nncp
-     qint64 xncp1
-     qint64 yncp1
-     qint64 zncp1
-     qint64 xncp2
-     qint64 yncp2
-     qint64 zncp2
-     ...
-     qint64 nmode
-     qint64 mode1
-     qint64 mode2
-     ...
-     qint64 nbasin
-     qint64 basin1
-     qint64 basin2
-     ...
-  */
-  qint64 counter = 0;
-  QString wfnFileName = variantList.at(counter).toString();
-  counter++;
-  qreal r0 = variantList.at(counter).toDouble();
-  counter++;
-  qreal t0 = variantList.at(counter).toDouble();
-  counter++;
-  qreal p0 = variantList.at(counter).toDouble();
-  counter++;
-
-  qint64 nncp = variantList.at(counter).toLongLong();
-  counter++;
-  QList<QVector3D> ncpList;
-  for (qint64 n = 0; n < nncp; ++n) {
-    qreal x = variantList.at(counter).toDouble();
-    counter++;
-    qreal y = variantList.at(counter).toDouble();
-    counter++;
-    qreal z = variantList.at(counter).toDouble();
-    counter++;
-
-    ncpList.append(QVector3D(x, y, z));
+  if (param.mode != 0) {
+    qDebug() << "mode not defined";
+    return;
   }
 
-  qint64 nmode = variantList.at(counter).toLongLong();
-  counter++;
-  QList<qint64> modeList;
-  for (qint64 m = 0; m < nmode; ++m) {
-    qint64 mode = variantList.at(counter).toLongLong();
-    counter++;
-    modeList.append(mode);
-  }
+  const Matrix<qreal, 3, 1> origin = QTAIMBasinOrigin(param);
 
-  qint64 nbasin = variantList.at(counter).toLongLong();
-  counter++;
-  QList<qint64> basinList;
-  for (qint64 b = 0; b < nbasin; ++b) {
-    qint64 basin = variantList.at(counter).toLongLong();
-    counter++;
-    basinList.append(basin);
+  Matrix<qreal, Dynamic, 3> xyz(npts, 3);
+  for (unsigned int i = 0; i < npts; ++i) {
+    Matrix<qreal, 3, 1> r0t0p0;
+    r0t0p0 << x[i * 3 + 0], x[i * 3 + 1], x[i * 3 + 2];
+    xyz.row(i) =
+      QTAIMMathUtilities::sphericalToCartesian(r0t0p0, origin).transpose();
   }
-  QSet<qint64> basinSet = basinList.toSet();
-
-  Matrix<qreal, 3, 1> r0t0p0;
-  r0t0p0 << r0, t0, p0;
-  Matrix<qreal, 3, 1> origin;
-  origin << ncpList.at(basinList.at(0)).x(), ncpList.at(basinList.at(0)).y(),
-    ncpList.at(basinList.at(0)).z();
-
-  Matrix<qreal, 3, 1> x0y0z0 =
-    QTAIMMathUtilities::sphericalToCartesian(r0t0p0, origin);
 
-  qreal x0 = x0y0z0(0);
-  qreal y0 = x0y0z0(1);
-  qreal z0 = x0y0z0(2);
+  Matrix<qreal, Dynamic, 1> rho;
+  QTAIMElectronDensityInBasin(eval, ode, param, xyz, rho);
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
-
-  QTAIMWavefunctionEvaluator eval(wfn);
-
-  QList<QVariant> valueList;
-
-  double initialElectronDensity =
-    eval.electronDensity(Eigen::Vector3d(x0, y0, z0));
-
-  // if less than some small value, then return zero for all integrands.
-  if (initialElectronDensity < 1.e-5) {
-    for (qint64 m = 0; m < nmode; ++m) {
-      qreal zero = 0.0;
-      valueList.append(zero);
-    }
-  } else {
-    QList<QPair<QVector3D, qreal>> betaSpheres;
-    for (qint64 i = 0; i < nncp; ++i) {
-      QPair<QVector3D, qreal> thisBetaSphere;
-      thisBetaSphere.first =
-        QVector3D(ncpList.at(i).x(), ncpList.at(i).y(), ncpList.at(i).z());
-      thisBetaSphere.second = 0.10;
-      betaSpheres.append(thisBetaSphere);
-    }
-
-    QTAIMLSODAIntegrator ode(eval, 0);
-    //  Avogadro::QTAIMODEIntegrator ode(eval,0);
-
-    ode.setBetaSpheres(betaSpheres);
-
-    QVector3D endpoint = ode.integrate(QVector3D(x0, y0, z0));
-// QList<QVector3D> path=ode.path();
-
-#define HUGE_REAL_NUMBER 1.e20
-    qreal smallestDistance = HUGE_REAL_NUMBER;
-    qint64 smallestDistanceIndex = -1;
-
-    for (qint64 n = 0; n < betaSpheres.length(); ++n) {
-      Matrix<qreal, 3, 1> a(endpoint.x(), endpoint.y(), endpoint.z());
-      Matrix<qreal, 3, 1> b(betaSpheres.at(n).first.x(),
-                            betaSpheres.at(n).first.y(),
-                            betaSpheres.at(n).first.z());
-
-      qreal distance = QTAIMMathUtilities::distance(a, b);
-
-      if (distance < smallestDistance) {
-        smallestDistance = distance;
-        smallestDistanceIndex = n;
-      }
-    }
-    qint64 nucleusIndex = smallestDistanceIndex;
-
-    if (basinSet.contains(nucleusIndex)) {
-      //      if(nucleusIndex==0)
-      //      {
-      //        QFile file("/scratch/brown/0.txt");
-      //        file.open(QIODevice::WriteOnly | QIODevice::Append);
-      //        QTextStream out(&file);
-      //        out << x0 << " " << y0 << " " << z0 << "\n";
-      ////        out << r0 << " " << t0 << " " << p0 << "\n";
-      //        file.close();
-      //      }
-      for (qint64 m = 0; m < nmode; ++m) {
-        if (modeList.at(m) == 0) {
-          valueList.append(
-
-            r0 * r0 * sin(t0) *
-            eval.electronDensity(Eigen::Vector3d(x0, y0, z0))
-
-              );
-        } else {
-          qDebug() << "mode not defined";
-          qreal zero = 0.0;
-          valueList.append(zero);
-        }
-      }
-    } else {
-      for (qint64 m = 0; m < nmode; ++m) {
-        qreal zero = 0.0;
-        valueList.append(zero);
-      }
-    }
+  for (unsigned int i = 0; i < npts; ++i) {
+    const qreal r0 = x[i * 3 + 0];
+    const qreal t0 = x[i * 3 + 1];
+    fval[i] = rho(i) < 0.0 ? 0.0 : r0 * r0 * sin(t0) * rho(i);
   }
-
-  return valueList;
 }
 
-void property_v_rtp(unsigned int /* ndim */, unsigned int npts,
-                    const double* xyz, void* param, unsigned int /* fdim */,
-                    double* fval)
+void property_r_v(unsigned int /* ndim */, unsigned int npts, const double* xyz,
+                  void* param, unsigned int /* fdim */, double* fval)
 {
+  const QTAIMRayParameters* ray = static_cast<const QTAIMRayParameters*>(param);
 
-  QVariantList* paramVariantListPtr = (QVariantList*)param;
-  QVariantList paramVariantList = *paramVariantListPtr;
-
-  qint64 counter = 0;
-  QString wfnFileName = paramVariantList.at(counter).toString();
-  counter++;
-
-  qint64 nncp = paramVariantList.at(counter).toLongLong();
-  counter++;
-  QList<QVector3D> ncpList;
-  for (qint64 i = 0; i < nncp; ++i) {
-    qreal x = paramVariantList.at(counter).toDouble();
-    counter++;
-    qreal y = paramVariantList.at(counter).toDouble();
-    counter++;
-    qreal z = paramVariantList.at(counter).toDouble();
-    counter++;
-
-    ncpList.append(QVector3D(x, y, z));
+  if (ray->mode != 0) {
+    std::fill(fval, fval + npts, 0.0);
+    return;
   }
-  qint64 nmode = 1;
-  qint64 mode = paramVariantList.at(counter).toLongLong();
-  counter++;
-  QList<qint64> basinList;
-  for (qint64 i = counter; i < paramVariantList.length(); ++i) {
-    basinList.append(paramVariantList.at(i).toLongLong());
-    counter++;
-  }
-
-  // prepare input
-
-  QList<QList<QVariant>> inputList;
 
+  Matrix<qreal, Dynamic, 3> XYZ(npts, 3);
   for (unsigned int i = 0; i < npts; ++i) {
-
-    double x0 = xyz[i * 3 + 0];
-    double y0 = xyz[i * 3 + 1];
-    double z0 = xyz[i * 3 + 2];
-
-    QList<QVariant> variantList;
-
-    variantList.append(wfnFileName);
-
-    variantList.append(x0);
-    variantList.append(y0);
-    variantList.append(z0);
-
-    variantList.append(nncp);
-    for (qint64 n = 0; n < nncp; ++n) {
-      variantList.append(ncpList.at(n).x());
-      variantList.append(ncpList.at(n).y());
-      variantList.append(ncpList.at(n).z());
-    }
-
-    variantList.append(nmode); // for now, one mode
-    for (qint64 m = 0; m < nmode; ++m) {
-      variantList.append(mode);
-    }
-
-    qint64 nbasin = basinList.length();
-    variantList.append(nbasin);
-    for (qint64 b = 0; b < basinList.length(); ++b) {
-      variantList.append(basinList.at(b));
-    }
-
-    inputList.append(variantList);
+    Matrix<qreal, 3, 1> rtp;
+    rtp << xyz[i], ray->t, ray->p;
+    XYZ.row(i) =
+      QTAIMMathUtilities::sphericalToCartesian(rtp, ray->origin).transpose();
   }
 
-  // calculate
-
-  QProgressDialog dialog;
-  dialog.setWindowTitle("QTAIM");
-  dialog.setLabelText(QString("Atomic Basin Integration"));
-
-  QFutureWatcher<void> futureWatcher;
-  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
-  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
-  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)),
-                   &dialog, SLOT(setRange(int, int)));
-  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog,
-                   SLOT(setValue(int)));
-
-  QFuture<QList<QVariant>> future =
-    QtConcurrent::mapped(inputList, QTAIMEvaluatePropertyRTP);
-  futureWatcher.setFuture(future);
-  dialog.exec();
-  futureWatcher.waitForFinished();
-
-  QList<QList<QVariant>> results;
-  if (futureWatcher.future().isCanceled()) {
-    results.clear();
-  } else {
-    results = future.results();
-  }
+  Matrix<qreal, Dynamic, 1> rho;
+  ray->eval->electronDensity(XYZ, rho);
 
-  // harvest results
-  for (qint64 i = 0; i < npts; ++i) {
-    for (qint64 m = 0; m < nmode; ++m) {
-      fval[m * nmode + i] = results.at(i).at(m).toDouble();
-    }
+  for (unsigned int i = 0; i < npts; ++i) {
+    fval[i] = xyz[i] * xyz[i] * rho(i);
   }
 }
 
-void property_r(unsigned int ndim, const double* xyz, void* param,
-                unsigned int fdim, double* fval)
+// The electron density at radius r along a ray if it lies in the basin, -1
+// otherwise.
+qreal QTAIMElectronDensityInBasinOnRay(QTAIMWavefunctionEvaluator& eval,
+                                       QTAIMLSODAIntegrator& ode,
+                                       const QTAIMBasinParameters& param,
+                                       const Matrix<qreal, 3, 1>& origin,
+                                       qreal r, qreal t, qreal p)
 {
-
-  ndim = ndim;
-  fdim = fdim;
-
-  QVariantList* paramVariantListPtr = (QVariantList*)param;
-  QVariantList paramVariantList = *paramVariantListPtr;
-
-  qint64 counter = 0;
-  QString wfnFileName = paramVariantList.at(counter).toString();
-  counter++;
-
-  qreal r = xyz[0];
-  qreal t = paramVariantList.at(counter).toDouble();
-  counter++;
-  qreal p = paramVariantList.at(counter).toDouble();
-  counter++;
-
-  qint64 nncp = paramVariantList.at(counter).toLongLong();
-  counter++;
-  QList<QVector3D> ncpList;
-  for (qint64 i = 0; i < nncp; ++i) {
-    qreal x = paramVariantList.at(counter).toDouble();
-    counter++;
-    qreal y = paramVariantList.at(counter).toDouble();
-    counter++;
-    qreal z = paramVariantList.at(counter).toDouble();
-    counter++;
-
-    ncpList.append(QVector3D(x, y, z));
-  }
-  qint64 nmode = 1;
-  qint64 mode = paramVariantList.at(counter).toLongLong();
-  counter++;
-  QList<qint64> basinList;
-  for (qint64 i = counter; i < paramVariantList.length(); ++i) {
-    basinList.append(paramVariantList.at(i).toLongLong());
-    counter++;
-  }
-
   Matrix<qreal, 3, 1> rtp;
   rtp << r, t, p;
-  Matrix<qreal, 3, 1> origin;
-  origin << ncpList.at(basinList.at(0)).x(), ncpList.at(basinList.at(0)).y(),
-    ncpList.at(basinList.at(0)).z();
-
-  Matrix<qreal, 3, 1> XYZ =
-    QTAIMMathUtilities::sphericalToCartesian(rtp, origin);
-
-  qreal x = XYZ(0);
-  qreal y = XYZ(1);
-  qreal z = XYZ(2);
-
-  // This routine reads the wavefunction file repeatedly.
-  // Let's hope that this time is dwarfed by the time
-  // taken to delineate the atomic basins in the calling routine.
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
-  QTAIMWavefunctionEvaluator eval(wfn);
-
-  for (qint64 m = 0; m < nmode; ++m) {
-    if (mode == 0) {
-      fval[m] = r * r * eval.electronDensity(Eigen::Vector3d(x, y, z));
-    }
-  }
+  Matrix<qreal, Dynamic, 3> xyz =
+    QTAIMMathUtilities::sphericalToCartesian(rtp, origin).transpose();
+
+  Matrix<qreal, Dynamic, 1> rho;
+  QTAIMElectronDensityInBasin(eval, ode, param, xyz, rho);
+  return rho(0);
 }
 
-QList<QVariant> QTAIMEvaluatePropertyTP(QList<QVariant> variantList)
+// This version integrates over the angles, the radial basin limit along each
+// ray is determined by bisection and the radial integral is done in place.
+void QTAIMEvaluatePropertyTP(QTAIMWavefunctionEvaluator& eval,
+                             QTAIMLSODAIntegrator& ode,
+                             const QTAIMBasinParameters& param,
+                             unsigned int npts, const double* x, double* fval)
 {
+  Matrix<qreal, 3, 1> origin = QTAIMBasinOrigin(param);
 
-  /*
-     Order of variantList:
-     QString wfnFileName
-     qreal t
-     qreal p
-     qint64 nncp
-     qint64 xncp1
-     qint64 yncp1
-     qint64 zncp1
-     qint64 xncp2
-     qint64 yncp2
-     qint64 zncp2
-     ...
-     qint64 nmode
-     qint64 mode1
-     qint64 mode2
-     ...
-     qint64 nbasin
-     qint64 basin1
-     qint64 basin2
-     ...
-  */
-  qint64 counter = 0;
-  QString wfnFileName = variantList.at(counter).toString();
-  counter++;
-  qreal t = variantList.at(counter).toDouble();
-  counter++;
-  qreal p = variantList.at(counter).toDouble();
-  counter++;
-
-  qint64 nncp = variantList.at(counter).toLongLong();
-  counter++;
-  QList<QVector3D> ncpList;
-  for (qint64 n = 0; n < nncp; ++n) {
-    qreal x = variantList.at(counter).toDouble();
-    counter++;
-    qreal y = variantList.at(counter).toDouble();
-    counter++;
-    qreal z = variantList.at(counter).toDouble();
-    counter++;
-
-    ncpList.append(QVector3D(x, y, z));
-  }
-
-  qint64 nmode = variantList.at(counter).toLongLong();
-  counter++;
-  QList<qint64> modeList;
-  for (qint64 m = 0; m < nmode; ++m) {
-    qint64 mode = variantList.at(counter).toLongLong();
-    counter++;
-    modeList.append(mode);
-  }
-
-  qint64 nbasin = variantList.at(counter).toLongLong();
-  counter++;
-  QList<qint64> basinList;
-  for (qint64 b = 0; b < nbasin; ++b) {
-    qint64 basin = variantList.at(counter).toLongLong();
-    counter++;
-    basinList.append(basin);
-  }
-  QSet<qint64> basinSet = basinList.toSet();
-
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
-  QTAIMWavefunctionEvaluator eval(wfn);
-
-  // Set up steepest ascent integrator and beta spheres
-  QList<QPair<QVector3D, qreal>> betaSpheres;
-  for (qint64 i = 0; i < nncp; ++i) {
-    QPair<QVector3D, qreal> thisBetaSphere;
-    thisBetaSphere.first =
-      QVector3D(ncpList.at(i).x(), ncpList.at(i).y(), ncpList.at(i).z());
-    thisBetaSphere.second = 0.10;
-    betaSpheres.append(thisBetaSphere);
-  }
-
-  QTAIMLSODAIntegrator ode(eval, 0);
-  //  Avogadro::QTAIMODEIntegrator ode(eval,0);
-
-  ode.setBetaSpheres(betaSpheres);
-
-  // Determine radial basin limit via bisection
-  // Bisection Algorithm courtesey of Wikipedia
-
-  qint64 thisBasin = basinList.at(0);
-  Matrix<qreal, 3, 1> origin;
-  origin << ncpList.at(thisBasin).x(), ncpList.at(thisBasin).y(),
-    ncpList.at(thisBasin).z();
-
-  const qreal rmin = betaSpheres.at(thisBasin).second;
-  const qreal rmax = 8.0;
-  const qreal epsilon = 1.e-3;
-
-  qreal left = rmin;
-  qreal right = rmax;
-
-  Matrix<qreal, 3, 1> rtpl;
-  rtpl << left, t, p;
-  Matrix<qreal, 3, 1> xyzl =
-    QTAIMMathUtilities::sphericalToCartesian(rtpl, origin);
-
-  qreal fleft;
-  qreal x = xyzl(0);
-  qreal y = xyzl(1);
-  qreal z = xyzl(2);
-  qreal leftElectronDensity = eval.electronDensity(Eigen::Vector3d(x, y, z));
-
-  if (leftElectronDensity < 1.e-5) {
-    fleft = -1.0;
-  } else {
-    QVector3D endpoint = ode.integrate(QVector3D(x, y, z));
-
-#define HUGE_REAL_NUMBER 1.e20
-    qreal smallestDistance = HUGE_REAL_NUMBER;
-    qint64 smallestDistanceIndex = -1;
-
-    for (qint64 n = 0; n < betaSpheres.length(); ++n) {
-      Matrix<qreal, 3, 1> a(endpoint.x(), endpoint.y(), endpoint.z());
-      Matrix<qreal, 3, 1> b(betaSpheres.at(n).first.x(),
-                            betaSpheres.at(n).first.y(),
-                            betaSpheres.at(n).first.z());
-
-      qreal distance = QTAIMMathUtilities::distance(a, b);
-
-      if (distance < smallestDistance) {
-        smallestDistance = distance;
-        smallestDistanceIndex = n;
-      }
-    }
-    qint64 nucleusIndex = smallestDistanceIndex;
-
-    if (thisBasin == nucleusIndex) {
-      fleft = leftElectronDensity;
-    } else {
-      fleft = -1.0;
-    }
-  }
-
-  Matrix<qreal, 3, 1> rtpr;
-  rtpr << right, t, p;
-  Matrix<qreal, 3, 1> xyzr =
-    QTAIMMathUtilities::sphericalToCartesian(rtpr, origin);
+  for (unsigned int i = 0; i < npts; ++i) {
+    const qreal t = x[i * 2 + 0];
+    const qreal p = x[i * 2 + 1];
 
-  qreal fright;
-  x = xyzr(0);
-  y = xyzr(1);
-  z = xyzr(2);
-  qreal rightElectronDensity = eval.electronDensity(Eigen::Vector3d(x, y, z));
+    // Determine radial basin limit via bisection
+    // Bisection Algorithm courtesey of Wikipedia
 
-  if (rightElectronDensity < 1.e-5) {
-    fright = -1.0;
-  } else {
-    QVector3D endpoint = ode.integrate(QVector3D(x, y, z));
+    const qreal rmin = param.betaSpheres.at(param.basin).second;
+    const qreal rmax = 8.0;
+    const qreal epsilon = 1.e-3;
 
-#define HUGE_REAL_NUMBER 1.e20
-    qreal smallestDistance = HUGE_REAL_NUMBER;
-    qint64 smallestDistanceIndex = -1;
+    qreal left = rmin;
+    qreal right = rmax;
 
-    for (qint64 n = 0; n < betaSpheres.length(); ++n) {
-      Matrix<qreal, 3, 1> a(endpoint.x(), endpoint.y(), endpoint.z());
-      Matrix<qreal, 3, 1> b(betaSpheres.at(n).first.x(),
-                            betaSpheres.at(n).first.y(),
-                            betaSpheres.at(n).first.z());
-
-      qreal distance = QTAIMMathUtilities::distance(a, b);
-
-      if (distance < smallestDistance) {
-        smallestDistance = distance;
-        smallestDistanceIndex = n;
-      }
-    }
-    qint64 nucleusIndex = smallestDistanceIndex;
+    qreal fleft =
+      QTAIMElectronDensityInBasinOnRay(eval, ode, param, origin, left, t, p);
+    qreal fright =
+      QTAIMElectronDensityInBasinOnRay(eval, ode, param, origin, right, t, p);
 
-    if (thisBasin == nucleusIndex) {
-      fright = rightElectronDensity;
-    } else {
-      fright = -1.0;
+    if (fleft > 0.0 && fright > 0.0) {
+      qDebug() << "error in bisection: both values positive.";
     }
-  }
-
-  if (fleft > 0.0 && fright > 0.0) {
-    qDebug() << "error in bisection: both values positive.";
-  }
-
-  qreal rf(0.0);
-  while (fabs(right - left) > 2.0 * epsilon) {
 
-    qreal midpoint = (right + left) / 2.0;
-    rf = midpoint;
+    qreal rf(0.0);
+    while (fabs(right - left) > 2.0 * epsilon) {
 
-    //    qDebug() << left << midpoint << right ;
+      qreal midpoint = (right + left) / 2.0;
+      rf = midpoint;
 
-    Matrix<qreal, 3, 1> rtpm;
-    rtpm << midpoint, t, p;
-    Matrix<qreal, 3, 1> xyzm =
-      QTAIMMathUtilities::sphericalToCartesian(rtpm, origin);
+      qreal fmidpoint = QTAIMElectronDensityInBasinOnRay(
+        eval, ode, param, origin, midpoint, t, p);
 
-    qreal fmidpoint;
-    x = xyzm(0);
-    y = xyzm(1);
-    z = xyzm(2);
-    qreal midpointElectronDensity =
-      eval.electronDensity(Eigen::Vector3d(x, y, z));
-
-    if (midpointElectronDensity < 1.e-5) {
-      fmidpoint = -1.0;
-    } else {
-      QVector3D endpoint = ode.integrate(QVector3D(x, y, z));
-
-#define HUGE_REAL_NUMBER 1.e20
-      qreal smallestDistance = HUGE_REAL_NUMBER;
-      qint64 smallestDistanceIndex = -1;
-
-      for (qint64 n = 0; n < betaSpheres.length(); ++n) {
-        Matrix<qreal, 3, 1> a(endpoint.x(), endpoint.y(), endpoint.z());
-        Matrix<qreal, 3, 1> b(betaSpheres.at(n).first.x(),
-                              betaSpheres.at(n).first.y(),
-                              betaSpheres.at(n).first.z());
-
-        qreal distance = QTAIMMathUtilities::distance(a, b);
-
-        if (distance < smallestDistance) {
-          smallestDistance = distance;
-          smallestDistanceIndex = n;
-        }
-      }
-      qint64 nucleusIndex = smallestDistanceIndex;
-
-      if (thisBasin == nucleusIndex) {
-        fmidpoint = midpointElectronDensity;
+      if ((fleft * fmidpoint) < 0) {
+        right = midpoint;
+        fright = fmidpoint;
+      } else if ((fright * fmidpoint) < 0) {
+        left = midpoint;
+        fleft = fmidpoint;
       } else {
-        fmidpoint = -1.0;
+        break;
       }
     }
 
-    if ((fleft * fmidpoint) < 0) {
-      right = midpoint;
-      fright = fmidpoint;
-    } else if ((fright * fmidpoint) < 0) {
-      left = midpoint;
-      fleft = fmidpoint;
-    } else {
-      goto endOfBisection;
-    }
-  }
-endOfBisection:
+    // Integration over r
+    QTAIMRayParameters ray;
+    ray.eval = &eval;
+    ray.origin = origin;
+    ray.t = t;
+    ray.p = p;
+    ray.mode = param.mode;
 
-  // Integration over r
-  unsigned int fdim = 1;
-  double* val;
-  double* err;
-  val = (double*)malloc(sizeof(double) * fdim);
-  err = (double*)malloc(sizeof(double) * fdim);
+    double val = 0.0;
+    double err = 0.0;
+    double tol = 1.e-6;
+    unsigned int maxEval = 0;
+    double xmin = 0.0;
+    double xmax = rf;
 
-  double tol = 1.e-6;
-  unsigned int maxEval = 0;
+    adapt_integrate_v(1, property_r_v, &ray, 1, &xmin, &xmax, maxEval, tol, 0,
+                      &val, &err);
 
-  unsigned int dim = 1;
-
-  double* xmin;
-  double* xmax;
-  xmin = (double*)malloc(dim * sizeof(double));
-  xmax = (double*)malloc(dim * sizeof(double));
-
-  xmin[0] = 0.0;
-  xmax[0] = rf;
-
-  QVariantList paramVariantList;
-  paramVariantList.append(wfnFileName);
-  paramVariantList.append(t);
-  paramVariantList.append(p);
-  paramVariantList.append(
-    ncpList.length()); // number of nuclear critical points
-  for (qint64 j = 0; j < ncpList.length(); ++j) {
-    paramVariantList.append(ncpList.at(j).x());
-    paramVariantList.append(ncpList.at(j).y());
-    paramVariantList.append(ncpList.at(j).z());
+    fval[i] = sin(t) * val;
   }
-  paramVariantList.append(0);               // mode
-  paramVariantList.append(basinList.at(0)); // basin
-
-  //  qDebug() << "Into R with rf=" << rf;
-  adapt_integrate(fdim, property_r, &paramVariantList, dim, xmin, xmax, maxEval,
-                  tol, 0, val, err);
-  //  qDebug() << "Out of R with val=" << val[0] << "err=" << err[0];
-  qreal Rval = val[0];
-
-  free(xmin);
-  free(xmax);
-  free(val);
-  free(err);
-
-  //  QList<QVariant> variantList;
-
-  variantList.append(sin(t) * Rval);
-
-  //  qDebug() << rf << t << p << sin(t) * Rval;
-
-  return variantList;
 }
 
-void property_v_tp(unsigned int /* ndim */, unsigned int npts,
-                   const double* xyz, void* param, unsigned int /* fdim */,
-                   double* fval)
+void QTAIMEvaluateBasinBatch(const QTAIMBasinBatch& batch)
 {
+  QTAIMWavefunctionEvaluator eval(*batch.param->wfn);
 
-  QVariantList* paramVariantListPtr = (QVariantList*)param;
-  QVariantList paramVariantList = *paramVariantListPtr;
-
-  qint64 counter = 0;
-  QString wfnFileName = paramVariantList.at(counter).toString();
-  counter++;
-
-  qint64 nncp = paramVariantList.at(counter).toLongLong();
-  counter++;
-  QList<QVector3D> ncpList;
-  for (qint64 i = 0; i < nncp; ++i) {
-    qreal x = paramVariantList.at(counter).toDouble();
-    counter++;
-    qreal y = paramVariantList.at(counter).toDouble();
-    counter++;
-    qreal z = paramVariantList.at(counter).toDouble();
-    counter++;
-
-    ncpList.append(QVector3D(x, y, z));
-  }
-  qint64 nmode = 1;
-  qint64 mode = paramVariantList.at(counter).toLongLong();
-  counter++;
-  QList<qint64> basinList;
-  for (qint64 i = counter; i < paramVariantList.length(); ++i) {
-    basinList.append(paramVariantList.at(i).toLongLong());
-    counter++;
-  }
-
-  // prepare input
-
-  QList<QList<QVariant>> inputList;
-
-  for (unsigned int i = 0; i < npts; ++i) {
-
-    double t = xyz[i * 2 + 0];
-    double p = xyz[i * 2 + 1];
-
-    QList<QVariant> variantList;
-
-    variantList.append(wfnFileName);
-
-    variantList.append(t);
-    variantList.append(p);
-
-    variantList.append(nncp);
-    for (qint64 n = 0; n < nncp; ++n) {
-      variantList.append(ncpList.at(n).x());
-      variantList.append(ncpList.at(n).y());
-      variantList.append(ncpList.at(n).z());
-    }
+  QTAIMLSODAIntegrator ode(
+    eval, QTAIMLSODAIntegrator::SteepestAscentPathInElectronDensity);
+  //  Avogadro::QTAIMODEIntegrator ode(eval,0);
+  ode.setBetaSpheres(batch.param->betaSpheres);
 
-    variantList.append(nmode); // for now, one mode
-    for (qint64 m = 0; m < nmode; ++m) {
-      variantList.append(mode);
-    }
+  batch.integrand(eval, ode, *batch.param, batch.npts, batch.x, batch.fval);
+}
 
-    qint64 nbasin = basinList.length();
-    variantList.append(nbasin);
-    for (qint64 b = 0; b < basinList.length(); ++b) {
-      variantList.append(basinList.at(b));
-    }
+// Evaluate the integrand at all of the points the cubature rule asks for, in
+// batches that share an evaluator.
+void QTAIMEvaluateBasinPoints(QTAIMBasinIntegrand integrand, unsigned int ndim,
+                              unsigned int npts, const double* xyz,
+                              void* param, double* fval)
+{
+  std::fill(fval, fval + npts, 0.0);
 
-    inputList.append(variantList);
+  QVector<QTAIMBasinBatch> batches;
+  for (unsigned int i = 0; i < npts; i += QTAIMBasinBatchSize) {
+    QTAIMBasinBatch batch;
+    batch.integrand = integrand;
+    batch.param = static_cast<const QTAIMBasinParameters*>(param);
+    batch.ndim = ndim;
+    batch.npts = qMin(QTAIMBasinBatchSize, npts - i);
+    batch.x = xyz + i * ndim;
+    batch.fval = fval + i;
+    batches.append(batch);
   }
 
-  // calculate
-
   QProgressDialog dialog;
   dialog.setWindowTitle("QTAIM");
   dialog.setLabelText(QString("Atomic Basin Integration"));
@@ -2176,39 +1484,47 @@ void property_v_tp(unsigned int /* ndim */, unsigned int npts,
   QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog,
                    SLOT(setValue(int)));
 
-  QFuture<QList<QVariant>> future =
-    QtConcurrent::mapped(inputList, QTAIMEvaluatePropertyTP);
+  QFuture<void> future = QtConcurrent::map(batches, QTAIMEvaluateBasinBatch);
   futureWatcher.setFuture(future);
   dialog.exec();
   futureWatcher.waitForFinished();
 
-  QList<QList<QVariant>> results;
   if (futureWatcher.future().isCanceled()) {
-    results.clear();
-  } else {
-    results = future.results();
+    std::fill(fval, fval + npts, 0.0);
   }
+}
 
-  // harvest results
-  //  qDebug() << "results=" << results;
-  for (qint64 i = 0; i < npts; ++i) {
-    for (qint64 m = 0; m < nmode; ++m) {
-      fval[m * nmode + i] = results.at(i).at(m).toDouble();
-    }
-  }
+void property_v(unsigned int ndim, unsigned int npts, const double* xyz,
+                void* param, unsigned int /* fdim */, double* fval)
+{
+  QTAIMEvaluateBasinPoints(QTAIMEvaluateProperty, ndim, npts, xyz, param,
+                           fval);
+}
+
+void property_v_rtp(unsigned int ndim, unsigned int npts, const double* xyz,
+                    void* param, unsigned int /* fdim */, double* fval)
+{
+  QTAIMEvaluateBasinPoints(QTAIMEvaluatePropertyRTP, ndim, npts, xyz, param,
+                           fval);
 }
 
+void property_v_tp(unsigned int ndim, unsigned int npts, const double* xyz,
+                   void* param, unsigned int /* fdim */, double* fval)
+{
+  QTAIMEvaluateBasinPoints(QTAIMEvaluatePropertyTP, ndim, npts, xyz, param,
+                           fval);
+}
+
+} // namespace
+
 namespace Avogadro {
 namespace QtPlugins {
 
-QTAIMCubature::QTAIMCubature(QTAIMWavefunction& wfn)
+QTAIMCubature::QTAIMCubature(const QTAIMWavefunction& wfn)
 {
 
   m_wfn = &wfn;
 
-  m_temporaryFileName = QTAIMCubature::temporaryFileName();
-  m_wfn->saveToBinaryFile(m_temporaryFileName);
-
   // Instantiate a Critical Point Locator
   QTAIMCriticalPointLocator cpl(wfn);
 
@@ -2240,7 +1556,17 @@ QList<QPair<qreal, qreal>> QTAIMCubature::integrate(qint64 mode,
   val = (double*)malloc(sizeof(double) * fdim);
   err = (double*)malloc(sizeof(double) * fdim);
 
+  QTAIMBasinParameters param;
+  param.wfn = m_wfn;
+  param.ncpList = m_ncpList;
+  for (qint64 j = 0; j < m_ncpList.length(); ++j) {
+    param.betaSpheres.append(qMakePair(m_ncpList.at(j), qreal(0.10)));
+  }
+  param.mode = 0;
+
   for (qint64 i = 0; i < m_basins.length(); ++i) {
+    param.basin = basins.at(i);
+
     if (threeDimensionalIntegration) {
 
       unsigned int dim = 3;
@@ -2262,21 +1588,8 @@ QList<QPair<qreal, qreal>> QTAIMCubature::integrate(qint64 mode,
         xmin[2] = -8. + m_ncpList.at(i).z();
         xmax[2] = 8. + m_ncpList.at(i).z();
 
-        QVariantList paramVariantList;
-        paramVariantList.append(m_temporaryFileName);
-
-        paramVariantList.append(
-          m_ncpList.length()); // number of nuclear critical points
-        for (qint64 j = 0; j < m_ncpList.length(); ++j) {
-          paramVariantList.append(m_ncpList.at(j).x());
-          paramVariantList.append(m_ncpList.at(j).y());
-          paramVariantList.append(m_ncpList.at(j).z());
-        }
-        paramVariantList.append(0);            // mode
-        paramVariantList.append(basins.at(i)); // basin
-
-        adapt_integrate_v(fdim, property_v, &paramVariantList, dim, xmin, xmax,
-                          maxEval, tol, 0, val, err);
+        adapt_integrate_v(fdim, property_v, &param, dim, xmin, xmax, maxEval,
+                          tol, 0, val, err);
 
       } else {
         const qreal pi = 4.0 * atan(1.0);
@@ -2288,21 +1601,8 @@ QList<QPair<qreal, qreal>> QTAIMCubature::integrate(qint64 mode,
         xmin[2] = 0.;
         xmax[2] = 2.0 * pi;
 
-        QVariantList paramVariantList;
-        paramVariantList.append(m_temporaryFileName);
-
-        paramVariantList.append(
-          m_ncpList.length()); // number of nuclear critical points
-        for (qint64 j = 0; j < m_ncpList.length(); ++j) {
-          paramVariantList.append(m_ncpList.at(j).x());
-          paramVariantList.append(m_ncpList.at(j).y());
-          paramVariantList.append(m_ncpList.at(j).z());
-        }
-        paramVariantList.append(0);            // mode
-        paramVariantList.append(basins.at(i)); // basin
-
-        adapt_integrate_v(fdim, property_v_rtp, &paramVariantList, dim, xmin,
-                          xmax, maxEval, tol, 0, val, err);
+        adapt_integrate_v(fdim, property_v_rtp, &param, dim, xmin, xmax,
+                          maxEval, tol, 0, val, err);
       }
 
       free(xmin);
@@ -2323,21 +1623,8 @@ QList<QPair<qreal, qreal>> QTAIMCubature::integrate(qint64 mode,
       xmin[1] = 0.;
       xmax[1] = 2.0 * pi;
 
-      QVariantList paramVariantList;
-      paramVariantList.append(m_temporaryFileName);
-
-      paramVariantList.append(
-        m_ncpList.length()); // number of nuclear critical points
-      for (qint64 j = 0; j < m_ncpList.length(); ++j) {
-        paramVariantList.append(m_ncpList.at(j).x());
-        paramVariantList.append(m_ncpList.at(j).y());
-        paramVariantList.append(m_ncpList.at(j).z());
-      }
-      paramVariantList.append(0);            // mode
-      paramVariantList.append(basins.at(i)); // basin
-
-      adapt_integrate_v(fdim, property_v_tp, &paramVariantList, dim, xmin, xmax,
-                        maxEval, tol, 0, val, err);
+      adapt_integrate_v(fdim, property_v_tp, &param, dim, xmin, xmax, maxEval,
+                        tol, 0, val, err);
 
       free(xmin);
       free(xmax);
@@ -2359,34 +1646,10 @@ QList<QPair<qreal, qreal>> QTAIMCubature::integrate(qint64 mode,
   return value;
 }
 
-QTAIMCubature::~QTAIMCubature()
-{
-  if (QFile::exists(m_temporaryFileName)) {
-    QFile::remove(m_temporaryFileName);
-  }
-}
-
 void QTAIMCubature::setMode(qint64 mode)
 {
   m_mode = mode;
 }
 
-QString QTAIMCubature::temporaryFileName()
-{
-  QTemporaryFile temporaryFile;
-  temporaryFile.open();
-  QString tempFileName = temporaryFile.fileName();
-  temporaryFile.close();
-  temporaryFile.remove();
-
-  // wait for temporary file to be deleted
-  QDir dir;
-  do {
-    // Nothing
-  } while (dir.exists(tempFileName));
-
-  return tempFileName;
-}
-
 } // end namespace QtPlugins
 } // end namespace Avogadro
@@ -119,21 +119,17 @@ public:
     ElectronDensityLaplacian = 1
   };
 
-  explicit QTAIMCubature(QTAIMWavefunction& wfn);
-  ~QTAIMCubature();
+  explicit QTAIMCubature(const QTAIMWavefunction& wfn);
 
   QList<QPair<qreal, qreal>> integrate(qint64 mode, QList<qint64> basins);
 
   void setMode(qint64 mode);
 
 private:
-  QTAIMWavefunction* m_wfn;
+  const QTAIMWavefunction* m_wfn;
   qint64 m_mode;
   QList<qint64> m_basins;
 
-  QString m_temporaryFileName;
-  QString temporaryFileName();
-
   QList<QVector3D> m_ncpList;
 };
 
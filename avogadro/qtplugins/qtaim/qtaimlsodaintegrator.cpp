@@ -50,6 +50,8 @@ QTAIMLSODAIntegrator::QTAIMLSODAIntegrator(QTAIMWavefunctionEvaluator& eval,
 
   m_betaSpheres.empty();
   m_associatedSphere = 0;
+
+  m_point.resize(1, 3);
 }
 
 QVector3D QTAIMLSODAIntegrator::integrate(QVector3D x0y0z0)
@@ -178,14 +180,21 @@ void QTAIMLSODAIntegrator::f(int neq, double t, double* y, double* ydot)
   Matrix<qreal, 3, 1> xyz;
   xyz << y[1], y[2], y[3];
 
-  if (m_mode == SteepestAscentPathInElectronDensity) {
-    g = m_eval->gradientOfElectronDensity(xyz);
-  } else {
-    if (m_mode == 1 || m_mode == 2 || m_mode == 3 || m_mode == 4) {
-      gH = m_eval->gradientAndHessianOfElectronDensity(xyz);
-    } else {
-      gH = m_eval->gradientAndHessianOfElectronDensityLaplacian(xyz);
+  if (m_mode <= CMBPPlusThreeGradientInElectronDensity) {
+    // The gradient and Hessian share one pass over the primitives
+    m_point << y[1], y[2], y[3];
+    m_eval->electronDensityDerivatives(
+      m_point, m_mode == SteepestAscentPathInElectronDensity ? 1 : 2, m_rho,
+      m_gradient, m_hessian);
+
+    g = m_gradient.row(0).transpose();
+    if (m_mode != SteepestAscentPathInElectronDensity) {
+      H << m_hessian(0, 0), m_hessian(0, 3), m_hessian(0, 4), m_hessian(0, 3),
+        m_hessian(0, 1), m_hessian(0, 5), m_hessian(0, 4), m_hessian(0, 5),
+        m_hessian(0, 2);
     }
+  } else {
+    gH = m_eval->gradientAndHessianOfElectronDensityLaplacian(xyz);
 
     g(0) = gH(0, 0);
     g(1) = gH(1, 0);
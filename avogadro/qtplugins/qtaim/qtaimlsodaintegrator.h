@@ -75,6 +75,12 @@ private:
   QList<QPair<QVector3D, qreal>> m_betaSpheres;
   qint64 m_associatedSphere;
 
+  // Storage for batch evaluations of the electron density
+  Matrix<qreal, Dynamic, 3> m_point;
+  Matrix<qreal, Dynamic, 1> m_rho;
+  Matrix<qreal, Dynamic, 3> m_gradient;
+  Matrix<qreal, Dynamic, 6> m_hessian;
+
   // LSODA integrator
 
   void f(int neq, double t, double* y, double* ydot);
@@ -18,10 +18,39 @@
 
 #include "qtaimwavefunctionevaluator.h"
 
+#include <algorithm>
+
 namespace Avogadro {
 namespace QtPlugins {
 
-QTAIMWavefunctionEvaluator::QTAIMWavefunctionEvaluator(QTAIMWavefunction& wfn)
+namespace {
+
+// x^l and its first two derivatives, without going through pow().
+inline void angularFactors(qreal x, qint64 l, qreal& a0, qreal& a1, qreal& a2)
+{
+  if (l < 1) {
+    a0 = 1.0;
+    a1 = 0.0;
+    a2 = 0.0;
+  } else if (l == 1) {
+    a0 = x;
+    a1 = 1.0;
+    a2 = 0.0;
+  } else {
+    qreal xl2 = 1.0;
+    for (qint64 i = 2; i < l; ++i) {
+      xl2 *= x;
+    }
+    a2 = l * (l - 1) * xl2;
+    a1 = l * xl2 * x;
+    a0 = xl2 * x * x;
+  }
+}
+
+} // namespace
+
+QTAIMWavefunctionEvaluator::QTAIMWavefunctionEvaluator(
+  const QTAIMWavefunction& wfn)
 {
 
   m_nmo = wfn.numberOfMolecularOrbitals();
@@ -244,9 +273,9 @@ const Matrix<qreal, 3, 1> QTAIMWavefunctionEvaluator::gradientOfElectronDensity(
 
   value.setZero();
   for (qint64 m = 0; m < m_nmo; ++m) {
-    value(0) += m_occno(m) * m_cdg100(m) * m_cdg000(m);
-    value(1) += m_occno(m) * m_cdg010(m) * m_cdg000(m);
-    value(2) += m_occno(m) * m_cdg001(m) * m_cdg000(m);
+    value(0) += 2 * m_occno(m) * m_cdg100(m) * m_cdg000(m);
+    value(1) += 2 * m_occno(m) * m_cdg010(m) * m_cdg000(m);
+    value(2) += 2 * m_occno(m) * m_cdg001(m) * m_cdg000(m);
   }
 
   return value;
@@ -326,7 +355,7 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::hessianOfElectronDensity(
       if (m_xamom(p) < 2) {
         ax2 = zero;
       } else if (m_xamom(p) == 2) {
-        ax2 = one;
+        ax2 = aax2;
       } else {
         ax2 = aax2 * ipow(xx0, m_xamom(p) - 2);
       }
@@ -334,7 +363,7 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::hessianOfElectronDensity(
       if (m_yamom(p) < 2) {
         ay2 = zero;
       } else if (m_yamom(p) == 2) {
-        ay2 = one;
+        ay2 = aay2;
       } else {
         ay2 = aay2 * ipow(yy0, m_yamom(p) - 2);
       }
@@ -342,7 +371,7 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::hessianOfElectronDensity(
       if (m_zamom(p) < 2) {
         az2 = zero;
       } else if (m_zamom(p) == 2) {
-        az2 = one;
+        az2 = aaz2;
       } else {
         az2 = aaz2 * ipow(zz0, m_zamom(p) - 2);
       }
@@ -481,7 +510,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensity(
       if (m_xamom(p) < 2) {
         ax2 = zero;
       } else if (m_xamom(p) == 2) {
-        ax2 = one;
+        ax2 = aax2;
       } else {
         ax2 = aax2 * ipow(xx0, m_xamom(p) - 2);
       }
@@ -489,7 +518,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensity(
       if (m_yamom(p) < 2) {
         ay2 = zero;
       } else if (m_yamom(p) == 2) {
-        ay2 = one;
+        ay2 = aay2;
       } else {
         ay2 = aay2 * ipow(yy0, m_yamom(p) - 2);
       }
@@ -497,7 +526,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensity(
       if (m_zamom(p) < 2) {
         az2 = zero;
       } else if (m_zamom(p) == 2) {
-        az2 = one;
+        az2 = aaz2;
       } else {
         az2 = aaz2 * ipow(zz0, m_zamom(p) - 2);
       }
@@ -539,9 +568,9 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensity(
 
   gValue.setZero();
   for (qint64 m = 0; m < m_nmo; ++m) {
-    gValue(0) += m_occno(m) * m_cdg100(m) * m_cdg000(m);
-    gValue(1) += m_occno(m) * m_cdg010(m) * m_cdg000(m);
-    gValue(2) += m_occno(m) * m_cdg001(m) * m_cdg000(m);
+    gValue(0) += 2 * m_occno(m) * m_cdg100(m) * m_cdg000(m);
+    gValue(1) += 2 * m_occno(m) * m_cdg010(m) * m_cdg000(m);
+    gValue(2) += 2 * m_occno(m) * m_cdg001(m) * m_cdg000(m);
   }
 
   hValue.setZero();
@@ -579,6 +608,149 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensity(
   return value;
 }
 
+void QTAIMWavefunctionEvaluator::electronDensityDerivatives(
+  const Matrix<qreal, Dynamic, 3>& xyz, qint64 order,
+  Matrix<qreal, Dynamic, 1>& rho, Matrix<qreal, Dynamic, 3>& gradient,
+  Matrix<qreal, Dynamic, 6>& hessian)
+{
+  const qint64 npts = xyz.rows();
+
+  rho.setZero(npts);
+  if (order > 0) {
+    gradient.setZero(npts, 3);
+  }
+  if (order > 1) {
+    hessian.setZero(npts, 6);
+  }
+  if (npts < 1) {
+    return;
+  }
+
+  // Screen the primitives against the bounding box of the batch.
+  const Matrix<qreal, 1, 3> lower = xyz.colwise().minCoeff();
+  const Matrix<qreal, 1, 3> upper = xyz.colwise().maxCoeff();
+  m_batchPrimitives.clear();
+  for (qint64 p = 0; p < m_nprim; ++p) {
+    qreal dx = std::max(std::max(lower(0) - m_X0(p), m_X0(p) - upper(0)), 0.0);
+    qreal dy = std::max(std::max(lower(1) - m_Y0(p), m_Y0(p) - upper(1)), 0.0);
+    qreal dz = std::max(std::max(lower(2) - m_Z0(p), m_Z0(p) - upper(2)), 0.0);
+    if (-m_alpha(p) * (dx * dx + dy * dy + dz * dz) > m_cutoff) {
+      m_batchPrimitives.push_back(p);
+    }
+  }
+  const qint64 nkept = static_cast<qint64>(m_batchPrimitives.size());
+  if (nkept == 0) {
+    return;
+  }
+
+  // Primitive values and derivatives, one block of rows per component in the
+  // order 000, 100, 010, 001, 200, 020, 002, 110, 101, 011.
+  const qint64 ncomp = order < 1 ? 1 : (order < 2 ? 4 : 10);
+  m_batchPrimitiveValues.setZero(ncomp * npts, nkept);
+  for (qint64 k = 0; k < nkept; ++k) {
+    const qint64 p = m_batchPrimitives[k];
+    const qreal alpha = m_alpha(p);
+    qreal* dg = m_batchPrimitiveValues.col(k).data();
+
+    for (qint64 i = 0; i < npts; ++i) {
+      const qreal xx0 = xyz(i, 0) - m_X0(p);
+      const qreal yy0 = xyz(i, 1) - m_Y0(p);
+      const qreal zz0 = xyz(i, 2) - m_Z0(p);
+
+      const qreal b0arg = -alpha * (xx0 * xx0 + yy0 * yy0 + zz0 * zz0);
+      if (b0arg <= m_cutoff) {
+        continue;
+      }
+      const qreal b0 = exp(b0arg);
+
+      qreal ax0, ax1, ax2;
+      qreal ay0, ay1, ay2;
+      qreal az0, az1, az2;
+      angularFactors(xx0, m_xamom(p), ax0, ax1, ax2);
+      angularFactors(yy0, m_yamom(p), ay0, ay1, ay2);
+      angularFactors(zz0, m_zamom(p), az0, az1, az2);
+
+      dg[i] = ax0 * ay0 * az0 * b0;
+      if (order < 1) {
+        continue;
+      }
+
+      const qreal bx1 = -2 * alpha * xx0;
+      const qreal by1 = -2 * alpha * yy0;
+      const qreal bz1 = -2 * alpha * zz0;
+      const qreal fx = ax1 + ax0 * bx1;
+      const qreal fy = ay1 + ay0 * by1;
+      const qreal fz = az1 + az0 * bz1;
+
+      dg[npts + i] = ay0 * az0 * b0 * fx;
+      dg[2 * npts + i] = ax0 * az0 * b0 * fy;
+      dg[3 * npts + i] = ax0 * ay0 * b0 * fz;
+      if (order < 2) {
+        continue;
+      }
+
+      const qreal bx2 = -2 * alpha + 4 * alpha * alpha * xx0 * xx0;
+      const qreal by2 = -2 * alpha + 4 * alpha * alpha * yy0 * yy0;
+      const qreal bz2 = -2 * alpha + 4 * alpha * alpha * zz0 * zz0;
+
+      dg[4 * npts + i] = ay0 * az0 * b0 * (ax2 + 2 * ax1 * bx1 + ax0 * bx2);
+      dg[5 * npts + i] = ax0 * az0 * b0 * (ay2 + 2 * ay1 * by1 + ay0 * by2);
+      dg[6 * npts + i] = ax0 * ay0 * b0 * (az2 + 2 * az1 * bz1 + az0 * bz2);
+      dg[7 * npts + i] = az0 * b0 * fx * fy;
+      dg[8 * npts + i] = ay0 * b0 * fx * fz;
+      dg[9 * npts + i] = ax0 * b0 * fy * fz;
+    }
+  }
+
+  // Contract with the molecular orbital coefficients for all components and
+  // points at once.
+  if (nkept == m_nprim) {
+    m_batchOrbitals.noalias() = m_batchPrimitiveValues * m_coef.transpose();
+  } else {
+    m_batchCoefficients.resize(nkept, m_nmo);
+    for (qint64 k = 0; k < nkept; ++k) {
+      m_batchCoefficients.row(k) = m_coef.col(m_batchPrimitives[k]).transpose();
+    }
+    m_batchOrbitals.noalias() = m_batchPrimitiveValues * m_batchCoefficients;
+  }
+
+  const auto phi = m_batchOrbitals.topRows(npts);
+  rho.noalias() = phi.cwiseAbs2() * m_occno;
+  if (order < 1) {
+    return;
+  }
+
+  for (qint64 c = 0; c < 3; ++c) {
+    const auto dphi = m_batchOrbitals.middleRows((1 + c) * npts, npts);
+    gradient.col(c).noalias() = 2 * phi.cwiseProduct(dphi) * m_occno;
+  }
+  if (order < 2) {
+    return;
+  }
+
+  const qint64 pairs[3][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+  for (qint64 c = 0; c < 3; ++c) {
+    const auto dphi = m_batchOrbitals.middleRows((1 + c) * npts, npts);
+    const auto d2phi = m_batchOrbitals.middleRows((4 + c) * npts, npts);
+    hessian.col(c).noalias() =
+      2 * (dphi.cwiseAbs2() + phi.cwiseProduct(d2phi)) * m_occno;
+
+    const auto dphia =
+      m_batchOrbitals.middleRows((1 + pairs[c][0]) * npts, npts);
+    const auto dphib =
+      m_batchOrbitals.middleRows((1 + pairs[c][1]) * npts, npts);
+    const auto d2phiab = m_batchOrbitals.middleRows((7 + c) * npts, npts);
+    hessian.col(3 + c).noalias() =
+      2 * (dphia.cwiseProduct(dphib) + phi.cwiseProduct(d2phiab)) * m_occno;
+  }
+}
+
+void QTAIMWavefunctionEvaluator::electronDensity(
+  const Matrix<qreal, Dynamic, 3>& xyz, Matrix<qreal, Dynamic, 1>& rho)
+{
+  electronDensityDerivatives(xyz, 0, rho, m_batchGradient, m_batchHessian);
+}
+
 qreal QTAIMWavefunctionEvaluator::laplacianOfElectronDensity(
   const Matrix<qreal, 3, 1> xyz)
 {
@@ -650,7 +822,7 @@ qreal QTAIMWavefunctionEvaluator::laplacianOfElectronDensity(
       if (m_xamom(p) < 2) {
         ax2 = zero;
       } else if (m_xamom(p) == 2) {
-        ax2 = one;
+        ax2 = aax2;
       } else {
         ax2 = aax2 * ipow(xx0, m_xamom(p) - 2);
       }
@@ -658,7 +830,7 @@ qreal QTAIMWavefunctionEvaluator::laplacianOfElectronDensity(
       if (m_yamom(p) < 2) {
         ay2 = zero;
       } else if (m_yamom(p) == 2) {
-        ay2 = one;
+        ay2 = aay2;
       } else {
         ay2 = aay2 * ipow(yy0, m_yamom(p) - 2);
       }
@@ -666,7 +838,7 @@ qreal QTAIMWavefunctionEvaluator::laplacianOfElectronDensity(
       if (m_zamom(p) < 2) {
         az2 = zero;
       } else if (m_zamom(p) == 2) {
-        az2 = one;
+        az2 = aaz2;
       } else {
         az2 = aaz2 * ipow(zz0, m_zamom(p) - 2);
       }
@@ -799,7 +971,7 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
       if (m_xamom(p) < 2) {
         ax2 = zero;
       } else if (m_xamom(p) == 2) {
-        ax2 = one;
+        ax2 = aax2;
       } else {
         ax2 = aax2 * ipow(xx0, m_xamom(p) - 2);
       }
@@ -807,7 +979,7 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
       if (m_yamom(p) < 2) {
         ay2 = zero;
       } else if (m_yamom(p) == 2) {
-        ay2 = one;
+        ay2 = aay2;
       } else {
         ay2 = aay2 * ipow(yy0, m_yamom(p) - 2);
       }
@@ -815,7 +987,7 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
       if (m_zamom(p) < 2) {
         az2 = zero;
       } else if (m_zamom(p) == 2) {
-        az2 = one;
+        az2 = aaz2;
       } else {
         az2 = aaz2 * ipow(zz0, m_zamom(p) - 2);
       }
@@ -826,7 +998,7 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
       if (m_xamom(p) < 3) {
         ax3 = zero;
       } else if (m_xamom(p) == 3) {
-        ax3 = one;
+        ax3 = aax3;
       } else {
         ax3 = aax3 * ipow(xx0, m_xamom(p) - 3);
       }
@@ -834,7 +1006,7 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
       if (m_yamom(p) < 3) {
         ay3 = zero;
       } else if (m_yamom(p) == 3) {
-        ay3 = one;
+        ay3 = aay3;
       } else {
         ay3 = aay3 * ipow(yy0, m_yamom(p) - 3);
       }
@@ -842,7 +1014,7 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
       if (m_zamom(p) < 3) {
         az3 = zero;
       } else if (m_zamom(p) == 3) {
-        az3 = one;
+        az3 = aaz3;
       } else {
         az3 = aaz3 * ipow(zz0, m_zamom(p) - 3);
       }
@@ -1074,7 +1246,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_xamom(p) < 2) {
         ax2 = zero;
       } else if (m_xamom(p) == 2) {
-        ax2 = one;
+        ax2 = aax2;
       } else {
         ax2 = aax2 * ipow(xx0, m_xamom(p) - 2);
       }
@@ -1082,7 +1254,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_yamom(p) < 2) {
         ay2 = zero;
       } else if (m_yamom(p) == 2) {
-        ay2 = one;
+        ay2 = aay2;
       } else {
         ay2 = aay2 * ipow(yy0, m_yamom(p) - 2);
       }
@@ -1090,7 +1262,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_zamom(p) < 2) {
         az2 = zero;
       } else if (m_zamom(p) == 2) {
-        az2 = one;
+        az2 = aaz2;
       } else {
         az2 = aaz2 * ipow(zz0, m_zamom(p) - 2);
       }
@@ -1101,7 +1273,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_xamom(p) < 3) {
         ax3 = zero;
       } else if (m_xamom(p) == 3) {
-        ax3 = one;
+        ax3 = aax3;
       } else {
         ax3 = aax3 * ipow(xx0, m_xamom(p) - 3);
       }
@@ -1109,7 +1281,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_yamom(p) < 3) {
         ay3 = zero;
       } else if (m_yamom(p) == 3) {
-        ay3 = one;
+        ay3 = aay3;
       } else {
         ay3 = aay3 * ipow(yy0, m_yamom(p) - 3);
       }
@@ -1117,7 +1289,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_zamom(p) < 3) {
         az3 = zero;
       } else if (m_zamom(p) == 3) {
-        az3 = one;
+        az3 = aaz3;
       } else {
         az3 = aaz3 * ipow(zz0, m_zamom(p) - 3);
       }
@@ -1128,7 +1300,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_xamom(p) < 4) {
         ax4 = zero;
       } else if (m_xamom(p) == 4) {
-        ax4 = one;
+        ax4 = aax4;
       } else {
         ax4 = aax4 * ipow(xx0, m_xamom(p) - 4);
       }
@@ -1136,7 +1308,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_yamom(p) < 4) {
         ay4 = zero;
       } else if (m_yamom(p) == 4) {
-        ay4 = one;
+        ay4 = aay4;
       } else {
         ay4 = aay4 * ipow(yy0, m_yamom(p) - 4);
       }
@@ -1144,7 +1316,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_zamom(p) < 4) {
         az4 = zero;
       } else if (m_zamom(p) == 4) {
-        az4 = one;
+        az4 = aaz4;
       } else {
         az4 = aaz4 * ipow(zz0, m_zamom(p) - 4);
       }
@@ -1483,7 +1655,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_xamom(p) < 2) {
         ax2 = zero;
       } else if (m_xamom(p) == 2) {
-        ax2 = one;
+        ax2 = aax2;
       } else {
         ax2 = aax2 * ipow(xx0, m_xamom(p) - 2);
       }
@@ -1491,7 +1663,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_yamom(p) < 2) {
         ay2 = zero;
       } else if (m_yamom(p) == 2) {
-        ay2 = one;
+        ay2 = aay2;
       } else {
         ay2 = aay2 * ipow(yy0, m_yamom(p) - 2);
       }
@@ -1499,7 +1671,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_zamom(p) < 2) {
         az2 = zero;
       } else if (m_zamom(p) == 2) {
-        az2 = one;
+        az2 = aaz2;
       } else {
         az2 = aaz2 * ipow(zz0, m_zamom(p) - 2);
       }
@@ -1510,7 +1682,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_xamom(p) < 3) {
         ax3 = zero;
       } else if (m_xamom(p) == 3) {
-        ax3 = one;
+        ax3 = aax3;
       } else {
         ax3 = aax3 * ipow(xx0, m_xamom(p) - 3);
       }
@@ -1518,7 +1690,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_yamom(p) < 3) {
         ay3 = zero;
       } else if (m_yamom(p) == 3) {
-        ay3 = one;
+        ay3 = aay3;
       } else {
         ay3 = aay3 * ipow(yy0, m_yamom(p) - 3);
       }
@@ -1526,7 +1698,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_zamom(p) < 3) {
         az3 = zero;
       } else if (m_zamom(p) == 3) {
-        az3 = one;
+        az3 = aaz3;
       } else {
         az3 = aaz3 * ipow(zz0, m_zamom(p) - 3);
       }
@@ -1537,7 +1709,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_xamom(p) < 4) {
         ax4 = zero;
       } else if (m_xamom(p) == 4) {
-        ax4 = one;
+        ax4 = aax4;
       } else {
         ax4 = aax4 * ipow(xx0, m_xamom(p) - 4);
       }
@@ -1545,7 +1717,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_yamom(p) < 4) {
         ay4 = zero;
       } else if (m_yamom(p) == 4) {
-        ay4 = one;
+        ay4 = aay4;
       } else {
         ay4 = aay4 * ipow(yy0, m_yamom(p) - 4);
       }
@@ -1553,7 +1725,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_zamom(p) < 4) {
         az4 = zero;
       } else if (m_zamom(p) == 4) {
-        az4 = one;
+        az4 = aaz4;
       } else {
         az4 = aaz4 * ipow(zz0, m_zamom(p) - 4);
       }
@@ -1989,7 +2161,7 @@ qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityK(
       if (m_xamom(p) < 2) {
         ax2 = zero;
       } else if (m_xamom(p) == 2) {
-        ax2 = one;
+        ax2 = aax2;
       } else {
         ax2 = aax2 * ipow(xx0, m_xamom(p) - 2);
       }
@@ -1997,7 +2169,7 @@ qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityK(
       if (m_yamom(p) < 2) {
         ay2 = zero;
       } else if (m_yamom(p) == 2) {
-        ay2 = one;
+        ay2 = aay2;
       } else {
         ay2 = aay2 * ipow(yy0, m_yamom(p) - 2);
       }
@@ -2005,7 +2177,7 @@ qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityK(
       if (m_zamom(p) < 2) {
         az2 = zero;
       } else if (m_zamom(p) == 2) {
-        az2 = one;
+        az2 = aaz2;
       } else {
         az2 = aaz2 * ipow(zz0, m_zamom(p) - 2);
       }
@@ -2117,7 +2289,7 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::quantumStressTensor(
       if (m_xamom(p) < 2) {
         ax2 = zero;
       } else if (m_xamom(p) == 2) {
-        ax2 = one;
+        ax2 = aax2;
       } else {
         ax2 = aax2 * ipow(xx0, m_xamom(p) - 2);
       }
@@ -2125,7 +2297,7 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::quantumStressTensor(
       if (m_yamom(p) < 2) {
         ay2 = zero;
       } else if (m_yamom(p) == 2) {
-        ay2 = one;
+        ay2 = aay2;
       } else {
         ay2 = aay2 * ipow(yy0, m_yamom(p) - 2);
       }
@@ -2133,7 +2305,7 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::quantumStressTensor(
       if (m_zamom(p) < 2) {
         az2 = zero;
       } else if (m_zamom(p) == 2) {
-        az2 = one;
+        az2 = aaz2;
       } else {
         az2 = aaz2 * ipow(zz0, m_zamom(p) - 2);
       }
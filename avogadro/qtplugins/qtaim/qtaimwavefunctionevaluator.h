@@ -21,6 +21,8 @@
 
 #include <Eigen/Core>
 
+#include <vector>
+
 using namespace Eigen;
 
 namespace Avogadro {
@@ -33,7 +35,7 @@ class QTAIMWavefunctionEvaluator
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
-  explicit QTAIMWavefunctionEvaluator(QTAIMWavefunction& wfn);
+  explicit QTAIMWavefunctionEvaluator(const QTAIMWavefunction& wfn);
 
   qreal molecularOrbital(const qint64 mo, const Matrix<qreal, 3, 1> xyz);
   qreal electronDensity(const Matrix<qreal, 3, 1> xyz);
@@ -43,6 +45,18 @@ public:
     const Matrix<qreal, 3, 1> xyz);
   const Matrix<qreal, 3, 4> gradientAndHessianOfElectronDensity(
     const Matrix<qreal, 3, 1> xyz);
+
+  // Batch evaluation, one row of xyz per point. Derivatives up to order (0, 1
+  // or 2) are returned as structure of arrays, with the Hessian columns in the
+  // order xx, yy, zz, xy, xz, yz. Primitive functions are evaluated once per
+  // point for all quantities, and primitives that are negligible over the
+  // whole batch are skipped. The values match the single point functions.
+  void electronDensityDerivatives(const Matrix<qreal, Dynamic, 3>& xyz,
+                                  qint64 order, Matrix<qreal, Dynamic, 1>& rho,
+                                  Matrix<qreal, Dynamic, 3>& gradient,
+                                  Matrix<qreal, Dynamic, 6>& hessian);
+  void electronDensity(const Matrix<qreal, Dynamic, 3>& xyz,
+                       Matrix<qreal, Dynamic, 1>& rho);
   qreal laplacianOfElectronDensity(const Matrix<qreal, 3, 1> xyz);
   qreal electronDensityLaplacian(const Matrix<qreal, 3, 1> xyz)
   {
@@ -119,6 +133,13 @@ private:
   Matrix<qreal, Dynamic, 1> m_cdg013;
   Matrix<qreal, Dynamic, 1> m_cdg004;
 
+  std::vector<qint64> m_batchPrimitives;
+  Matrix<qreal, Dynamic, Dynamic> m_batchPrimitiveValues;
+  Matrix<qreal, Dynamic, Dynamic> m_batchCoefficients;
+  Matrix<qreal, Dynamic, Dynamic> m_batchOrbitals;
+  Matrix<qreal, Dynamic, 3> m_batchGradient;
+  Matrix<qreal, Dynamic, 6> m_batchHessian;
+
   static inline qreal ipow(qreal a, qint64 n) { return (qreal)pow(a, (int)n); }
 };
 
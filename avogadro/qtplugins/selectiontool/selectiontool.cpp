@@ -280,7 +280,7 @@ void SelectionTool::applyLayer(int layer)
 
 void SelectionTool::selectLinkedMolecule(QMouseEvent* e, Index atom)
 {
-  auto connectedAtoms = m_molecule->graph().connectedComponent(atom);
+  auto connectedAtoms = m_molecule->graph().connectedComponentView(atom);
   for (auto a : connectedAtoms) {
     selectAtom(e, a);
   }
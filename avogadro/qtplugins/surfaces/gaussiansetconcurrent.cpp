@@ -25,6 +25,8 @@
 
 #include <QtConcurrent/QtConcurrentMap>
 
+#include <algorithm>
+
 namespace Avogadro {
 namespace QtPlugins {
 
@@ -43,16 +45,37 @@ class BasisSetConcurrent
   }
 };
 
-struct GaussianShell
+struct GaussianTile
 {
   GaussianSetTools* tools; // A pointer to the tools, can't write to member vars
-  Cube* tCube;             // The target cube, used to initialise temp cubes too
-  unsigned int pos;        // The index of the point to calculate the MO for
+  Cube* tCube;             // The target cube, written to directly
+  size_t first;            // The index of the first point in the tile
+  size_t last;             // One past the index of the last point in the tile
   unsigned int state;      // The MO number to calculate
+  double minValue;         // The minimum value in the tile, once calculated
+  double maxValue;         // The maximum value in the tile, once calculated
 };
 
+namespace {
+// The approximate number of points in each tile, tiles are made up of whole
+// slabs of the cube (constant x) so they are contiguous in memory.
+const size_t TILE_POINTS = 8192;
+
+void updateTileMinMax(GaussianTile& tile, bool success)
+{
+  std::vector<double>& data = *tile.tCube->data();
+  if (!success)
+    std::fill(data.begin() + tile.first, data.begin() + tile.last, 0.0);
+  auto range = std::minmax_element(data.begin() + tile.first,
+                                   data.begin() + tile.last);
+  tile.minValue = *range.first;
+  tile.maxValue = *range.second;
+}
+} // namespace
+
 GaussianSetConcurrent::GaussianSetConcurrent(QObject* p)
-  : QObject(p), m_gaussianShells(nullptr), m_set(nullptr), m_tools(nullptr)
+  : QObject(p), m_cube(nullptr), m_tiles(nullptr), m_set(nullptr),
+    m_tools(nullptr)
 {
   // Watch for the future
   connect(&m_watcher, SIGNAL(finished()), this, SLOT(calculationComplete()));
@@ -60,7 +83,8 @@ GaussianSetConcurrent::GaussianSetConcurrent(QObject* p)
 
 GaussianSetConcurrent::~GaussianSetConcurrent()
 {
-  delete m_gaussianShells;
+  delete m_tiles;
+  delete m_tools;
 }
 
 void GaussianSetConcurrent::setMolecule(Core::Molecule* mol)
@@ -98,60 +122,79 @@ bool GaussianSetConcurrent::calculateSpinDensity(Core::Cube* cube)
 
 void GaussianSetConcurrent::calculationComplete()
 {
-  (*m_gaussianShells)[0].tCube->lock()->unlock();
-  delete m_gaussianShells;
-  m_gaussianShells = nullptr;
-  emit finished();
+  bool canceled = m_future.isCanceled();
+  if (!canceled) {
+    // Reduce the minimum and maximum values found in each of the tiles.
+    double minValue = m_tiles->front().minValue;
+    double maxValue = m_tiles->front().maxValue;
+    for (const GaussianTile& tile : *m_tiles) {
+      minValue = std::min(minValue, tile.minValue);
+      maxValue = std::max(maxValue, tile.maxValue);
+    }
+    m_cube->setMinMax(minValue, maxValue);
+  }
+  m_cube->lock()->unlock();
+  delete m_tiles;
+  m_tiles = nullptr;
+  if (!canceled)
+    emit finished();
 }
 
 bool GaussianSetConcurrent::setUpCalculation(Core::Cube* cube,
                                              unsigned int state,
-                                             void (*func)(GaussianShell&))
+                                             void (*func)(GaussianTile&))
 {
-  if (!m_set || !m_tools)
+  if (!m_set || !m_tools || !cube || cube->data()->empty())
     return false;
 
   m_set->initCalculation();
 
-  // Set up the points we want to calculate the density at.
-  m_gaussianShells =
-    new QVector<GaussianShell>(static_cast<int>(cube->data()->size()));
-
-  for (int i = 0; i < m_gaussianShells->size(); ++i) {
-    (*m_gaussianShells)[i].tools = m_tools;
-    (*m_gaussianShells)[i].tCube = cube;
-    (*m_gaussianShells)[i].pos = i;
-    (*m_gaussianShells)[i].state = state;
+  // Split the cube into tiles of whole slabs.
+  m_cube = cube;
+  size_t size = cube->data()->size();
+  size_t slab = static_cast<size_t>(cube->dimensions().y()) *
+                static_cast<size_t>(cube->dimensions().z());
+  size_t tileSize = std::max(TILE_POINTS / slab, size_t(1)) * slab;
+  m_tiles = new QVector<GaussianTile>;
+  m_tiles->reserve(static_cast<int>((size + tileSize - 1) / tileSize));
+  for (size_t first = 0; first < size; first += tileSize) {
+    GaussianTile tile;
+    tile.tools = m_tools;
+    tile.tCube = cube;
+    tile.first = first;
+    tile.last = std::min(first + tileSize, size);
+    tile.state = state;
+    tile.minValue = tile.maxValue = 0.0;
+    m_tiles->push_back(tile);
   }
 
   // Lock the cube until we are done.
   cube->lock()->lock();
 
   // The main part of the mapped reduced function...
-  m_future = QtConcurrent::map(*m_gaussianShells, func);
+  m_future = QtConcurrent::map(*m_tiles, func);
   // Connect our watcher to our future
   m_watcher.setFuture(m_future);
 
   return true;
 }
 
-void GaussianSetConcurrent::processOrbital(GaussianShell& shell)
+void GaussianSetConcurrent::processOrbital(GaussianTile& tile)
 {
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(
-    shell.pos, shell.tools->calculateMolecularOrbital(pos, shell.state));
+  updateTileMinMax(tile, tile.tools->calculateMolecularOrbital(
+                           *tile.tCube, tile.state, tile.first, tile.last));
 }
 
-void GaussianSetConcurrent::processDensity(GaussianShell& shell)
+void GaussianSetConcurrent::processDensity(GaussianTile& tile)
 {
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(shell.pos, shell.tools->calculateElectronDensity(pos));
+  updateTileMinMax(tile, tile.tools->calculateElectronDensity(
+                           *tile.tCube, tile.first, tile.last));
 }
 
-void GaussianSetConcurrent::processSpinDensity(GaussianShell& shell)
+void GaussianSetConcurrent::processSpinDensity(GaussianTile& tile)
 {
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(shell.pos, shell.tools->calculateSpinDensity(pos));
+  updateTileMinMax(tile, tile.tools->calculateSpinDensity(
+                           *tile.tCube, tile.first, tile.last));
 }
 }
 }
@@ -32,11 +32,15 @@ class GaussianSetTools;
 
 namespace QtPlugins {
 
-struct GaussianShell;
+struct GaussianTile;
 
 /**
  * @brief The GaussianSetConcurrent class uses GaussianSetTools to calculate
  * values of electronic structure properties from quantum output read in.
+ *
+ * The cube is split into tiles of whole slabs of the grid, which are
+ * calculated in parallel on the global thread pool. Progress is reported and
+ * cancellation takes effect per tile.
  * @author Marcus D. Hanwell
  */
 
@@ -73,17 +77,17 @@ private:
   QFuture<void> m_future;
   QFutureWatcher<void> m_watcher;
   Core::Cube* m_cube;
-  QVector<GaussianShell>* m_gaussianShells;
+  QVector<GaussianTile>* m_tiles;
 
   Core::GaussianSet* m_set;
   Core::GaussianSetTools* m_tools;
 
   bool setUpCalculation(Core::Cube* cube, unsigned int state,
-                        void (*func)(GaussianShell&));
+                        void (*func)(GaussianTile&));
 
-  static void processOrbital(GaussianShell& shell);
-  static void processDensity(GaussianShell& shell);
-  static void processSpinDensity(GaussianShell& shell);
+  static void processOrbital(GaussianTile& tile);
+  static void processDensity(GaussianTile& tile);
+  static void processSpinDensity(GaussianTile& tile);
 };
 }
 }
@@ -25,6 +25,8 @@
 
 #include <QtConcurrent/QtConcurrentMap>
 
+#include <algorithm>
+
 namespace Avogadro {
 namespace QtPlugins {
 
@@ -32,16 +34,38 @@ using Core::SlaterSet;
 using Core::SlaterSetTools;
 using Core::Cube;
 
-struct SlaterShell
+struct SlaterTile
 {
   SlaterSetTools* tools; // A pointer to the tools, cannot write to member vars
-  Cube* tCube;           // The target cube, used to initialise temp cubes too
-  unsigned int pos;      // The index of the point to calculate the MO for
+  Cube* tCube;           // The target cube, written to directly
+  size_t first;          // The index of the first point in the tile
+  size_t last;           // One past the index of the last point in the tile
   unsigned int state;    // The MO number to calculate
+  double minValue;       // The minimum value in the tile, once calculated
+  double maxValue;       // The maximum value in the tile, once calculated
 };
 
+namespace {
+// The approximate number of points in each tile, tiles are made up of whole
+// slabs of the cube (constant x) so they are contiguous in memory.
+const size_t TILE_POINTS = 8192;
+
+template <typename Function>
+void processTile(SlaterTile& tile, Function function)
+{
+  std::vector<double>& data = *tile.tCube->data();
+  for (size_t i = tile.first; i < tile.last; ++i)
+    data[i] = function(tile.tCube->position(static_cast<unsigned int>(i)));
+  auto range = std::minmax_element(data.begin() + tile.first,
+                                   data.begin() + tile.last);
+  tile.minValue = *range.first;
+  tile.maxValue = *range.second;
+}
+} // namespace
+
 SlaterSetConcurrent::SlaterSetConcurrent(QObject* p)
-  : QObject(p), m_shells(nullptr), m_set(nullptr), m_tools(nullptr)
+  : QObject(p), m_cube(nullptr), m_tiles(nullptr), m_set(nullptr),
+    m_tools(nullptr)
 {
   // Watch for the future
   connect(&m_watcher, SIGNAL(finished()), this, SLOT(calculationComplete()));
@@ -49,7 +73,8 @@ SlaterSetConcurrent::SlaterSetConcurrent(QObject* p)
 
 SlaterSetConcurrent::~SlaterSetConcurrent()
 {
-  delete m_shells;
+  delete m_tiles;
+  delete m_tools;
 }
 
 void SlaterSetConcurrent::setMolecule(Core::Molecule* mol)
@@ -80,58 +105,81 @@ bool SlaterSetConcurrent::calculateSpinDensity(Core::Cube* cube)
 
 void SlaterSetConcurrent::calculationComplete()
 {
-  (*m_shells)[0].tCube->lock()->unlock();
-  delete m_shells;
-  m_shells = nullptr;
-  emit finished();
+  bool canceled = m_future.isCanceled();
+  if (!canceled) {
+    // Reduce the minimum and maximum values found in each of the tiles.
+    double minValue = m_tiles->front().minValue;
+    double maxValue = m_tiles->front().maxValue;
+    for (const SlaterTile& tile : *m_tiles) {
+      minValue = std::min(minValue, tile.minValue);
+      maxValue = std::max(maxValue, tile.maxValue);
+    }
+    m_cube->setMinMax(minValue, maxValue);
+  }
+  m_cube->lock()->unlock();
+  delete m_tiles;
+  m_tiles = nullptr;
+  if (!canceled)
+    emit finished();
 }
 
 bool SlaterSetConcurrent::setUpCalculation(Core::Cube* cube, unsigned int state,
-                                           void (*func)(SlaterShell&))
+                                           void (*func)(SlaterTile&))
 {
-  if (!m_set || !m_tools)
+  if (!m_set || !m_tools || !cube || cube->data()->empty())
     return false;
 
   m_set->initCalculation();
 
-  // Set up the points we want to calculate the density at.
-  m_shells = new QVector<SlaterShell>(static_cast<int>(cube->data()->size()));
-
-  for (int i = 0; i < m_shells->size(); ++i) {
-    (*m_shells)[i].tools = m_tools;
-    (*m_shells)[i].tCube = cube;
-    (*m_shells)[i].pos = i;
-    (*m_shells)[i].state = state;
+  // Split the cube into tiles of whole slabs.
+  m_cube = cube;
+  size_t size = cube->data()->size();
+  size_t slab = static_cast<size_t>(cube->dimensions().y()) *
+                static_cast<size_t>(cube->dimensions().z());
+  size_t tileSize = std::max(TILE_POINTS / slab, size_t(1)) * slab;
+  m_tiles = new QVector<SlaterTile>;
+  m_tiles->reserve(static_cast<int>((size + tileSize - 1) / tileSize));
+  for (size_t first = 0; first < size; first += tileSize) {
+    SlaterTile tile;
+    tile.tools = m_tools;
+    tile.tCube = cube;
+    tile.first = first;
+    tile.last = std::min(first + tileSize, size);
+    tile.state = state;
+    tile.minValue = tile.maxValue = 0.0;
+    m_tiles->push_back(tile);
   }
 
   // Lock the cube until we are done.
   cube->lock()->lock();
 
   // The main part of the mapped reduced function...
-  m_future = QtConcurrent::map(*m_shells, func);
+  m_future = QtConcurrent::map(*m_tiles, func);
   // Connect our watcher to our future
   m_watcher.setFuture(m_future);
 
   return true;
 }
 
-void SlaterSetConcurrent::processOrbital(SlaterShell& shell)
+void SlaterSetConcurrent::processOrbital(SlaterTile& tile)
 {
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(
-    shell.pos, shell.tools->calculateMolecularOrbital(pos, shell.state));
+  processTile(tile, [&tile](const Vector3& pos) {
+    return tile.tools->calculateMolecularOrbital(pos, tile.state);
+  });
 }
 
-void SlaterSetConcurrent::processDensity(SlaterShell& shell)
+void SlaterSetConcurrent::processDensity(SlaterTile& tile)
 {
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(shell.pos, shell.tools->calculateElectronDensity(pos));
+  processTile(tile, [&tile](const Vector3& pos) {
+    return tile.tools->calculateElectronDensity(pos);
+  });
 }
 
-void SlaterSetConcurrent::processSpinDensity(SlaterShell& shell)
+void SlaterSetConcurrent::processSpinDensity(SlaterTile& tile)
 {
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(shell.pos, shell.tools->calculateSpinDensity(pos));
+  processTile(tile, [&tile](const Vector3& pos) {
+    return tile.tools->calculateSpinDensity(pos);
+  });
 }
 }
 }
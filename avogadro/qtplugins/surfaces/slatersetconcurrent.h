@@ -32,11 +32,14 @@ class SlaterSetTools;
 
 namespace QtPlugins {
 
-struct SlaterShell;
+struct SlaterTile;
 
 /**
  * @brief The SlaterSetConcurrent class uses SlaterSetTools to calculate values
  * of electronic structure properties from quantum output read in.
+ *
+ * As in GaussianSetConcurrent the cube is calculated in parallel tiles of
+ * whole slabs of the grid.
  * @author Marcus D. Hanwell
  */
 
@@ -72,17 +75,17 @@ private:
   QFuture<void> m_future;
   QFutureWatcher<void> m_watcher;
   Core::Cube* m_cube;
-  QVector<SlaterShell>* m_shells;
+  QVector<SlaterTile>* m_tiles;
 
   Core::SlaterSet* m_set;
   Core::SlaterSetTools* m_tools;
 
   bool setUpCalculation(Core::Cube* cube, unsigned int state,
-                        void (*func)(SlaterShell&));
+                        void (*func)(SlaterTile&));
 
-  static void processOrbital(SlaterShell& shell);
-  static void processDensity(SlaterShell& shell);
-  static void processSpinDensity(SlaterShell& shell);
+  static void processOrbital(SlaterTile& tile);
+  static void processDensity(SlaterTile& tile);
+  static void processSpinDensity(SlaterTile& tile);
 };
 }
 }
@@ -30,6 +30,8 @@ namespace {
 #include <avogadro/core/variant.h>
 
 #include <avogadro/core/cube.h>
+#include <avogadro/core/edtsurface.h>
+#include <avogadro/core/elements.h>
 #include <avogadro/core/mesh.h>
 #include <avogadro/qtgui/meshgenerator.h>
 #include <avogadro/qtgui/molecule.h>
@@ -48,9 +50,12 @@ namespace {
 #include <avogadro/quantumio/nwchemjson.h>
 #include <avogadro/quantumio/nwchemlog.h>
 
+#include <QtConcurrent/QtConcurrentRun>
+
 #include <QtCore/QBuffer>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDebug>
+#include <QtCore/QFutureWatcher>
 #include <QtCore/QProcess>
 #include <QtGui/QOpenGLFramebufferObject>
 #include <QtWidgets/QAction>
@@ -70,6 +75,15 @@ class Surfaces::PIMPL
 public:
   GifWriter* gifWriter = nullptr;
   gwavi_t* gwaviWriter = nullptr;
+
+  // Distance field surfaces are calculated in the background into a cube
+  // owned here, and are shown as a single mesh at the zero isosurface. The
+  // cube is handed to the molecule it was calculated for once it is done,
+  // unless the surfaces were reset in the meantime.
+  QFutureWatcher<void> edtWatcher;
+  Core::Cube edtCube;
+  QtGui::Molecule* edtMolecule = nullptr;
+  bool singleMesh = false;
 };
 
 Surfaces::Surfaces(QObject* p) : ExtensionPlugin(p), d(new PIMPL())
@@ -79,6 +93,8 @@ Surfaces::Surfaces(QObject* p) : ExtensionPlugin(p), d(new PIMPL())
   connect(action, SIGNAL(triggered()), SLOT(surfacesActivated()));
   m_actions.push_back(action);
 
+  connect(&d->edtWatcher, SIGNAL(finished()), SLOT(edtFinished()));
+
   // Register quantum file formats
   Io::FileFormatManager::registerFormat(new QuantumIO::GAMESSUSOutput);
   Io::FileFormatManager::registerFormat(new QuantumIO::GaussianFchk);
@@ -91,6 +107,7 @@ Surfaces::Surfaces(QObject* p) : ExtensionPlugin(p), d(new PIMPL())
 
 Surfaces::~Surfaces()
 {
+  d->edtWatcher.waitForFinished();
   delete d;
   delete m_cube;
 }
@@ -107,6 +124,7 @@ void Surfaces::setMolecule(QtGui::Molecule* mol)
   m_mesh1 = nullptr;
   m_mesh2 = nullptr;
   m_molecule = mol;
+  d->edtMolecule = nullptr;
 }
 
 QList<QAction*> Surfaces::actions() const
@@ -170,8 +188,6 @@ void Surfaces::calculateSurface()
     case SolventAccessible:
     case SolventExcluded:
       calculateEDT();
-      // pass a molecule and return a Cube for m_cube
-      //   displayMesh();
       break;
 
     case ElectronDensity:
@@ -190,8 +206,65 @@ void Surfaces::calculateSurface()
 
 void Surfaces::calculateEDT()
 {
-  // pass the molecule to the EDT, plus the surface type
-  // get back a Cube object in m_cube
+  if (!m_dialog || !m_molecule || d->edtWatcher.isRunning())
+    return;
+
+  // Reset state a little more frequently, minimal cost, avoid bugs.
+  m_molecule->clearCubes();
+  m_molecule->clearMeshes();
+  m_cube = nullptr;
+  m_mesh1 = nullptr;
+  m_mesh2 = nullptr;
+  m_molecule->emitChanged(Molecule::Atoms | Molecule::Added);
+
+  Core::EDTSurface::Type edtType = Core::EDTSurface::VanDerWaals;
+  switch (m_dialog->surfaceType()) {
+    case SolventAccessible:
+      edtType = Core::EDTSurface::SolventAccessible;
+      d->edtCube.setName("Solvent Accessible");
+      break;
+    case SolventExcluded:
+      edtType = Core::EDTSurface::SolventExcluded;
+      d->edtCube.setName("Solvent Excluded");
+      break;
+    default:
+      d->edtCube.setName("Van der Waals");
+      break;
+  }
+
+  // Copy what is needed so the molecule is not touched from another thread
+  Core::Array<Vector3> positions = m_molecule->atomPositions3d();
+  std::vector<double> radii(m_molecule->atomCount());
+  for (Index i = 0; i < m_molecule->atomCount(); ++i)
+    radii[i] = Core::Elements::radiusVDW(m_molecule->atomicNumber(i));
+
+  Cube* cube = &d->edtCube;
+  double spacing = m_dialog->resolution();
+  m_isoValue = 0.0f;
+  d->singleMesh = true;
+  d->edtMolecule = m_molecule;
+  d->edtWatcher.setFuture(QtConcurrent::run([=]() {
+    Core::EDTSurface edt;
+    edt.calculateCube(positions, radii, *cube, edtType, spacing);
+  }));
+}
+
+void Surfaces::edtFinished()
+{
+  // Dropped if the molecule changed or its cubes were cleared meanwhile
+  if (!m_molecule || m_molecule != d->edtMolecule) {
+    if (m_dialog)
+      m_dialog->reenableCalculateButton();
+    return;
+  }
+  d->edtMolecule = nullptr;
+
+  m_cube = m_molecule->addCube();
+  m_cube->setLimits(d->edtCube);
+  m_cube->setName(d->edtCube.name());
+  m_cube->data()->swap(*d->edtCube.data());
+  m_cube->setMinMax(d->edtCube.minValue(), d->edtCube.maxValue());
+  displayMesh();
 }
 
 void Surfaces::calculateQM()
@@ -199,6 +272,8 @@ void Surfaces::calculateQM()
   if (!m_basis || !m_dialog)
     return; // nothing to do
 
+  d->singleMesh = false;
+  d->edtMolecule = nullptr;
   // Reset state a little more frequently, minimal cost, avoid bugs.
   m_molecule->clearCubes();
   m_molecule->clearMeshes();
@@ -226,8 +301,8 @@ void Surfaces::calculateQM()
   // TODO: Check to see if this cube or surface has already been computed
   if (!m_progressDialog) {
     m_progressDialog = new QProgressDialog(qobject_cast<QWidget*>(parent()));
-    m_progressDialog->setCancelButtonText(nullptr);
     m_progressDialog->setWindowModality(Qt::NonModal);
+    connect(m_progressDialog, SIGNAL(canceled()), SLOT(cancelCalculation()));
     connectSlots = true;
   }
 
@@ -304,9 +379,21 @@ void Surfaces::calculateCube()
   // check bounds
   m_cube = m_cubes[m_dialog->surfaceIndex()];
   m_isoValue = m_dialog->isosurfaceValue();
+  d->singleMesh = false;
   displayMesh();
 }
 
+void Surfaces::cancelCalculation()
+{
+  // The calculations stop once the tiles already running have finished.
+  if (m_gaussianConcurrent)
+    m_gaussianConcurrent->watcher().cancel();
+  if (m_slaterConcurrent)
+    m_slaterConcurrent->watcher().cancel();
+  if (m_dialog)
+    m_dialog->reenableCalculateButton();
+}
+
 void Surfaces::stepChanged(int n)
 {
   if (!m_molecule || !m_basis)
@@ -316,6 +403,7 @@ void Surfaces::stepChanged(int n)
   auto g = dynamic_cast<GaussianSet*>(m_basis);
   if (g) {
     g->setActiveSetStep(n - 1);
+    d->edtMolecule = nullptr;
     m_molecule->clearCubes();
     m_molecule->clearMeshes();
     m_cube = nullptr;
@@ -340,6 +428,13 @@ void Surfaces::displayMesh()
   }
   m_meshGenerator1->initialize(m_cube, m_mesh1, -m_isoValue);
 
+  // Molecular surfaces are a single mesh at the zero isosurface
+  if (d->singleMesh) {
+    m_meshGenerator1->start();
+    m_meshesLeft = 1;
+    return;
+  }
+
   // TODO - only do this if we're generating an orbital
   //    and we need two meshes
   //   How do we know? - likely ask the cube if it's an MO?
@@ -80,8 +80,10 @@ private slots:
   void surfacesActivated();
   void calculateSurface();
   void calculateEDT();
+  void edtFinished();
   void calculateQM();
   void calculateCube();
+  void cancelCalculation();
 
   void stepChanged(int);
 
@@ -7,14 +7,169 @@
 
 #include <avogadro/core/cube.h>
 #include <avogadro/core/molecule.h>
+#include <avogadro/core/parallel_p.h>
 #include <avogadro/core/utilities.h>
 
-#include <iostream>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <iomanip>
+#include <iostream>
+
+using json = nlohmann::json;
 
 namespace Avogadro {
 namespace QuantumIO {
 
+using Core::parallelFor;
+using Core::StringView;
+using Core::threadCount;
+
+namespace {
+
+// Bytes of text parsed, and values formatted, by a thread at a time.
+const size_t CHUNK_BYTES = 1 << 22;
+const size_t BLOCK_VALUES = 1 << 16;
+
+size_t countTokens(StringView text)
+{
+  size_t count = 0;
+  bool inToken = false;
+  for (char c : text) {
+    bool space = Core::isSpace(c);
+    if (!space && !inToken)
+      ++count;
+    inToken = !space;
+  }
+  return count;
+}
+
+// Parse the data block straight into the cubes. With several cubes the file
+// holds all of their values for a point before moving on to the next point.
+// The text is read in batches, each chunk of a batch is counted and then
+// parsed by its own thread, so only one batch is ever held in memory.
+void readCubeData(std::istream& in, const std::vector<Core::Cube*>& cubes)
+{
+  std::vector<double*> data;
+  for (Core::Cube* cube : cubes)
+    data.push_back(cube->data()->data());
+  const size_t cubeCount = cubes.size();
+  const size_t total = cubes[0]->data()->size() * cubeCount;
+
+  const size_t batchBytes = threadCount() * CHUNK_BYTES;
+  std::string buffer;
+  std::vector<StringView> chunks;
+  std::vector<size_t> first;
+  size_t carry = 0;
+  size_t parsed = 0;
+  while (parsed < total && in) {
+    buffer.resize(carry + batchBytes);
+    in.read(&buffer[carry], batchBytes);
+    size_t size = carry + static_cast<size_t>(in.gcount());
+
+    // Keep a token cut off by the end of the batch for the next one
+    size_t end = size;
+    if (in) {
+      while (end > 0 && !Core::isSpace(buffer[end - 1]))
+        --end;
+      if (end == 0)
+        end = size;
+    }
+
+    chunks.clear();
+    for (size_t start = 0; start < end;) {
+      size_t stop = std::min(start + CHUNK_BYTES, end);
+      while (stop < end && !Core::isSpace(buffer[stop]))
+        ++stop;
+      chunks.push_back(StringView(buffer.data() + start, stop - start));
+      start = stop;
+    }
+
+    // Count the values in every chunk to find where each one starts
+    int chunkCount = static_cast<int>(chunks.size());
+    first.assign(chunkCount + 1, 0);
+    parallelFor(chunkCount,
+                [&](int i) { first[i + 1] = countTokens(chunks[i]); });
+    first[0] = parsed;
+    for (int i = 0; i < chunkCount; ++i)
+      first[i + 1] += first[i];
+
+    parallelFor(chunkCount, [&](int i) {
+      StringView rest = chunks[i];
+      for (size_t index = first[i]; index < total; ++index) {
+        StringView token = Core::nextToken(rest);
+        if (token.empty())
+          break;
+        double value = 0.0;
+        Core::parseNumber(token, value);
+        data[index % cubeCount][index / cubeCount] = value;
+      }
+    });
+    parsed = std::min(total, first[chunkCount]);
+
+    carry = size - end;
+    std::memmove(&buffer[0], buffer.data() + end, carry);
+  }
+
+  for (Core::Cube* cube : cubes)
+    cube->computeMinMax();
+}
+
+// Append the value formatted as %13.5e, independent of the locale.
+void appendValue(std::string& out, double value)
+{
+  char text[32];
+#if defined(AVOGADRO_HAS_STD_STRING_VIEW) && defined(__cpp_lib_to_chars)
+  int length = static_cast<int>(
+    std::to_chars(text, text + sizeof(text), value,
+                  std::chars_format::scientific, 5)
+      .ptr -
+    text);
+#else
+  int length = snprintf(text, sizeof(text), "%.5e", value);
+#endif
+  if (length < 13)
+    out.append(13 - length, ' ');
+  out.append(text, length);
+}
+
+// Write the values six to a line, starting a new line for every row along z
+// as Gaussian does. Blocks of rows are formatted concurrently and written in
+// order, a batch of blocks at a time.
+void writeCubeData(std::ostream& out, const Core::Cube& cube)
+{
+  const std::vector<double>& values = *cube.data();
+  const size_t rowLength = std::max(cube.dimensions().z(), 1);
+  const size_t rowCount = values.size() / rowLength;
+  const size_t blockRows = std::max<size_t>(1, BLOCK_VALUES / rowLength);
+  const size_t blockCount = (rowCount + blockRows - 1) / blockRows;
+
+  std::vector<std::string> blocks(4 * threadCount());
+  for (size_t batch = 0; batch < blockCount; batch += blocks.size()) {
+    int count =
+      static_cast<int>(std::min(blocks.size(), blockCount - batch));
+    parallelFor(count, [&](int b) {
+      std::string& text = blocks[b];
+      text.clear();
+      size_t row = (batch + b) * blockRows;
+      size_t lastRow = std::min(rowCount, row + blockRows);
+      for (; row < lastRow; ++row) {
+        for (size_t k = 0; k < rowLength; ++k) {
+          appendValue(text, values[row * rowLength + k]);
+          if (k % 6 == 5 || k + 1 == rowLength)
+            text += '\n';
+        }
+      }
+    });
+    for (int b = 0; b < count; ++b)
+      out.write(blocks[b].data(), blocks[b].size());
+  }
+}
+
+} // namespace
+
 GaussianCube::GaussianCube() {}
 
 GaussianCube::~GaussianCube() {}
@@ -33,9 +188,15 @@ std::vector<std::string> GaussianCube::mimeTypes() const
 
 bool GaussianCube::read(std::istream& in, Core::Molecule& molecule)
 {
+  json opts;
+  if (!options().empty())
+    opts = json::parse(options(), nullptr, false);
+  if (!opts.is_object())
+    opts = json::object();
+
   // Variables we will need
   std::string line;
-  std::vector<std::string> list;
+  std::vector<Core::StringView> list;
 
   int nAtoms;
   Vector3 min;
@@ -61,8 +222,7 @@ bool GaussianCube::read(std::istream& in, Core::Molecule& molecule)
   // Next 3 lines contains spacing and dim
   for (unsigned int i = 0; i < 3; ++i) {
     getline(in, line);
-    line = Core::trimmed(line);
-    list = Core::split(line, ' ');
+    Core::split(line, ' ', list);
     dim(i) = Core::lexicalCast<int>(list[0]);
     spacing(i) = Core::lexicalCast<double>(list[i + 1]);
   }
@@ -71,8 +231,7 @@ bool GaussianCube::read(std::istream& in, Core::Molecule& molecule)
   Vector3 pos;
   for (int i = 0; i < abs(nAtoms); ++i) {
     getline(in, line);
-    line = Core::trimmed(line);
-    list = Core::split(line, ' ');
+    Core::split(line, ' ', list);
     short int atomNum = Core::lexicalCast<short int>(list[0]);
     Core::Atom a = molecule.addAtom(static_cast<unsigned char>(atomNum));
     for (unsigned int j = 2; j < 5; ++j)
@@ -94,27 +253,23 @@ bool GaussianCube::read(std::istream& in, Core::Molecule& molecule)
   }
 
   // Render molecule
-  molecule.perceiveBondsSimple();
+  if (opts.value("perceiveBonds", true))
+    molecule.perceiveBondsSimple();
 
   // Cube block, set limits and populate data
   // min and spacing are in bohr units, convert to ANGSTROM
   min *= BOHR_TO_ANGSTROM;
   spacing *= BOHR_TO_ANGSTROM;
 
+  std::vector<Core::Cube*> cubes;
   for (unsigned int i = 0; i < nCubes; ++i) {
     // Get a cube object from molecule
     Core::Cube* cube = molecule.addCube();
-
     cube->setLimits(min, dim, spacing);
-    std::vector<double> values;
-    // push_back is slow for this, resize vector first
-    values.resize(dim(0) * dim(1) * dim(2));
-    for (unsigned int j = 0; j < values.size(); ++j)
-      in >> values[j];
-    // clear buffer, if more than one cube
-    getline(in, line);
-    cube->setData(values);
+    cubes.push_back(cube);
   }
+  if (!cubes.empty() && !cubes[0]->data()->empty())
+    readCubeData(in, cubes);
 
   return true;
 }
@@ -193,13 +348,7 @@ bool GaussianCube::write(std::ostream& outStream, const Core::Molecule& mol)
   }
 
   // write the raw cube values
-  const std::vector<double>* values = cube->data();
-  for (unsigned int i = 0; i < values->size(); ++i) {
-    outStream << std::setw(13) << std::right << std::scientific 
-              << std::setprecision(5) << (*values)[i];
-    if (i % 6 == 5)
-      outStream << "\n";
-  }
+  writeCubeData(outStream, *cube);
 
   return true;
 }
@@ -14,6 +14,13 @@
 namespace Avogadro {
 namespace QuantumIO {
 
+/**
+ * @class GaussianCube gaussiancube.h <avogadro/quantumio/gaussiancube.h>
+ * @brief Implementation of the Gaussian cube format.
+ *
+ * The volumetric data is parsed and written in parallel. Bonds are perceived
+ * after reading unless the options contain "perceiveBonds": false.
+ */
 class AVOGADROQUANTUMIO_EXPORT GaussianCube : public Io::FileFormat
 {
 public:
@@ -20,6 +20,7 @@
 #include "camera.h"
 #include "scene.h"
 
+#include "boundingvolumehierarchy.h"
 #include "bufferobject.h"
 
 #include "shader.h"
@@ -529,6 +530,7 @@ const float ao_points[] = {
 #include "avogadrogl.h"
 
 #include <iostream>
+#include <limits>
 
 using std::cout;
 using std::endl;
@@ -1072,6 +1074,31 @@ private:
   int m_numIndices;
 };
 
+namespace {
+// Whether the ray hits the sphere between its origin and end, and where.
+bool sphereHit(const SphereColor& sphere, const Vector3f& rayOrigin,
+               const Vector3f& rayEnd, const Vector3f& rayDirection,
+               float& depth)
+{
+  Vector3f distance = sphere.center - rayOrigin;
+  float B = distance.dot(rayDirection);
+  float C = distance.dot(distance) - (sphere.radius * sphere.radius);
+  float D = B * B - C;
+
+  // Test for intersection
+  if (D < 0)
+    return false;
+
+  // Test for clipping
+  if (B < 0 || (sphere.center - rayEnd).dot(rayDirection) > 0)
+    return false;
+
+  float rootD = static_cast<float>(sqrt(D));
+  depth = std::min(std::abs(B + rootD), std::abs(B - rootD));
+  return true;
+}
+} // namespace
+
 class AmbientOcclusionSphereGeometry::Private
 {
 public:
@@ -1090,16 +1117,19 @@ public:
   Eigen::Matrix4f translate;
   int aoTextureSize;
   int aoTexture;
+
+  // Picking is done through boxes around the spheres, built when needed.
+  BoundingVolumeHierarchy hitTree;
 };
 
 AmbientOcclusionSphereGeometry::AmbientOcclusionSphereGeometry()
-  : m_dirty(false), d(new Private)
+  : m_dirty(false), m_hitTreeDirty(true), d(new Private)
 {}
 
 AmbientOcclusionSphereGeometry::AmbientOcclusionSphereGeometry(
   const AmbientOcclusionSphereGeometry& other)
   : Drawable(other), m_spheres(other.m_spheres), m_indices(other.m_indices),
-    m_dirty(true), d(new Private)
+    m_dirty(true), m_hitTreeDirty(true), d(new Private)
 {}
 
 AmbientOcclusionSphereGeometry::~AmbientOcclusionSphereGeometry()
@@ -1326,38 +1356,73 @@ void AmbientOcclusionSphereGeometry::render(const Camera& camera)
   d->program.release();
 }
 
+const BoundingVolumeHierarchy& AmbientOcclusionSphereGeometry::hitTree() const
+{
+  if (m_hitTreeDirty) {
+    std::vector<BoundingVolumeHierarchy::Box> boxes;
+    boxes.reserve(m_spheres.size());
+    for (const SphereColor& sphere : m_spheres) {
+      const Vector3f extent(sphere.radius, sphere.radius, sphere.radius);
+      boxes.push_back(BoundingVolumeHierarchy::Box(sphere.center - extent,
+                                                   sphere.center + extent));
+    }
+    d->hitTree.build(boxes);
+    m_hitTreeDirty = false;
+  }
+  return d->hitTree;
+}
+
 std::multimap<float, Identifier> AmbientOcclusionSphereGeometry::hits(
   const Vector3f& rayOrigin, const Vector3f& rayEnd,
   const Vector3f& rayDirection) const
 {
   std::multimap<float, Identifier> result;
+  if (m_identifier.type == InvalidType)
+    return result;
+
+  // Check for intersection with the spheres whose boxes are on the ray.
+  float maxDepth = std::numeric_limits<float>::infinity();
+  hitTree().intersect(rayOrigin, rayDirection, maxDepth,
+                      [&](size_t i, float&) {
+                        float depth;
+                        if (!sphereHit(m_spheres[i], rayOrigin, rayEnd,
+                                       rayDirection, depth)) {
+                          return;
+                        }
+                        Identifier id;
+                        id.molecule = m_identifier.molecule;
+                        id.type = m_identifier.type;
+                        id.index = i;
+                        result.insert(std::make_pair(depth, id));
+                      });
+  return result;
+}
 
-  // Check for intersection.
-  for (size_t i = 0; i < m_spheres.size(); ++i) {
-    const SphereColor& sphere = m_spheres[i];
-
-    Vector3f distance = sphere.center - rayOrigin;
-    float B = distance.dot(rayDirection);
-    float C = distance.dot(distance) - (sphere.radius * sphere.radius);
-    float D = B * B - C;
-
-    // Test for intersection
-    if (D < 0)
-      continue;
-
-    // Test for clipping
-    if (B < 0 || (sphere.center - rayEnd).dot(rayDirection) > 0)
-      continue;
-
-    Identifier id;
-    id.molecule = m_identifier.molecule;
-    id.type = m_identifier.type;
-    id.index = i;
-    if (id.type != InvalidType) {
-      float rootD = static_cast<float>(sqrt(D));
-      float depth = std::min(std::abs(B + rootD), std::abs(B - rootD));
-      result.insert(std::pair<float, Identifier>(depth, id));
-    }
+Identifier AmbientOcclusionSphereGeometry::hit(const Vector3f& rayOrigin,
+                                               const Vector3f& rayEnd,
+                                               const Vector3f& rayDirection,
+                                               float& depth) const
+{
+  Identifier result;
+  if (m_identifier.type == InvalidType)
+    return result;
+
+  size_t closest = MaxIndex;
+  hitTree().intersect(rayOrigin, rayDirection, depth,
+                      [&](size_t i, float& maxDepth) {
+                        float sphereDepth;
+                        if (sphereHit(m_spheres[i], rayOrigin, rayEnd,
+                                      rayDirection, sphereDepth) &&
+                            (sphereDepth < maxDepth ||
+                             (sphereDepth == maxDepth && i < closest))) {
+                          maxDepth = sphereDepth;
+                          closest = i;
+                        }
+                      });
+  if (closest != MaxIndex) {
+    result.molecule = m_identifier.molecule;
+    result.type = m_identifier.type;
+    result.index = closest;
   }
   return result;
 }
@@ -1367,6 +1432,7 @@ void AmbientOcclusionSphereGeometry::addSphere(const Vector3f& position,
                                                float radius, size_t index)
 {
   m_dirty = true;
+  m_hitTreeDirty = true;
   m_spheres.push_back(SphereColor(position, radius, color));
   m_indices.push_back(index == MaxIndex ? m_indices.size() : index);
 }
@@ -1375,6 +1441,7 @@ void AmbientOcclusionSphereGeometry::clear()
 {
   m_spheres.clear();
   m_indices.clear();
+  m_hitTreeDirty = true;
 }
 
 } // End namespace Rendering
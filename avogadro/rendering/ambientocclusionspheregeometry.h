@@ -80,6 +80,13 @@ public:
     const Vector3f& rayOrigin, const Vector3f& rayEnd,
     const Vector3f& rayDirection) const override;
 
+  /**
+   * Return the closest primitive hit by the ray, if it is closer than
+   * @p depth.
+   */
+  Identifier hit(const Vector3f& rayOrigin, const Vector3f& rayEnd,
+                 const Vector3f& rayDirection, float& depth) const override;
+
   /**
    * Add a sphere to the geometry object.
    */
@@ -89,7 +96,11 @@ public:
   /**
    * Get a reference to the spheres.
    */
-  Core::Array<SphereColor>& spheres() { return m_spheres; }
+  Core::Array<SphereColor>& spheres()
+  {
+    m_hitTreeDirty = true;
+    return m_spheres;
+  }
   const Core::Array<SphereColor>& spheres() const { return m_spheres; }
 
   /**
@@ -103,10 +114,14 @@ public:
   size_t size() const { return m_spheres.size(); }
 
 private:
+  // The tree of boxes around the spheres, built again if they changed.
+  const BoundingVolumeHierarchy& hitTree() const;
+
   Core::Array<SphereColor> m_spheres;
   Core::Array<size_t> m_indices;
 
   bool m_dirty;
+  mutable bool m_hitTreeDirty;
 
   class Private;
   Private* d;
@@ -128,6 +143,7 @@ inline void swap(AmbientOcclusionSphereGeometry& lhs,
   swap(lhs.m_spheres, rhs.m_spheres);
   swap(lhs.m_indices, rhs.m_indices);
   lhs.m_dirty = rhs.m_dirty = true;
+  lhs.m_hitTreeDirty = rhs.m_hitTreeDirty = true;
 }
 
 } // End namespace Rendering
@@ -0,0 +1,90 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "boundingvolumehierarchy.h"
+
+namespace Avogadro {
+namespace Rendering {
+
+namespace {
+
+// Primitives per leaf, at most.
+const unsigned int LEAF_SIZE = 4;
+
+} // namespace
+
+void BoundingVolumeHierarchy::build(const std::vector<Box>& boxes)
+{
+  clear();
+  if (boxes.empty())
+    return;
+
+  std::vector<Vector3f> centers(boxes.size());
+  m_primitives.resize(boxes.size());
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    centers[i] = boxes[i].center();
+    m_primitives[i] = static_cast<unsigned int>(i);
+  }
+  m_nodes.reserve(2 * (boxes.size() / LEAF_SIZE + 1));
+
+  // Split the primitives at the median of their centers along the longest
+  // side of the box around the centers, depth first so that the left child
+  // always follows its parent.
+  struct Range
+  {
+    unsigned int parent;
+    bool right;
+    unsigned int first;
+    unsigned int count;
+  };
+  std::vector<Range> stack;
+  stack.push_back(
+    Range{ 0, false, 0, static_cast<unsigned int>(boxes.size()) });
+  while (!stack.empty()) {
+    const Range range = stack.back();
+    stack.pop_back();
+    const unsigned int index = static_cast<unsigned int>(m_nodes.size());
+    m_nodes.push_back(Node());
+    if (range.right)
+      m_nodes[range.parent].second = index;
+
+    Node& node = m_nodes[index];
+    for (unsigned int i = range.first; i < range.first + range.count; ++i)
+      node.box.extend(boxes[m_primitives[i]]);
+    node.first = range.first;
+    node.second = 0;
+    node.count = range.count;
+    if (range.count <= LEAF_SIZE)
+      continue;
+
+    Box centerBox;
+    for (unsigned int i = range.first; i < range.first + range.count; ++i)
+      centerBox.extend(centers[m_primitives[i]]);
+    int axis = 0;
+    centerBox.sizes().maxCoeff(&axis);
+    const unsigned int half = range.count / 2;
+    auto begin = m_primitives.begin() + range.first;
+    std::nth_element(begin, begin + half, begin + range.count,
+                     [&centers, axis](unsigned int a, unsigned int b) {
+                       return centers[a][axis] < centers[b][axis];
+                     });
+
+    // the left child is popped next, the right one once the whole left
+    // subtree was added
+    node.count = 0;
+    stack.push_back(
+      Range{ index, true, range.first + half, range.count - half });
+    stack.push_back(Range{ index, false, range.first, half });
+  }
+}
+
+void BoundingVolumeHierarchy::clear()
+{
+  m_nodes.clear();
+  m_primitives.clear();
+}
+
+} // End namespace Rendering
+} // End namespace Avogadro
@@ -0,0 +1,182 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_RENDERING_BOUNDINGVOLUMEHIERARCHY_H
+#define AVOGADRO_RENDERING_BOUNDINGVOLUMEHIERARCHY_H
+
+#include "avogadrorenderingexport.h"
+
+#include <avogadro/core/vector.h>
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace Avogadro {
+namespace Rendering {
+
+/**
+ * @class BoundingVolumeHierarchy boundingvolumehierarchy.h
+ * <avogadro/rendering/boundingvolumehierarchy.h>
+ * @brief A tree of axis aligned boxes around the primitives of a Drawable,
+ * used to find the primitives under a ray or inside a frustrum without
+ * testing every one of them.
+ *
+ * The tree is built from a box per primitive. The queries only narrow the
+ * primitives down to those whose boxes are crossed, the caller tests each of
+ * them exactly.
+ */
+class AVOGADRORENDERING_EXPORT BoundingVolumeHierarchy
+{
+public:
+  typedef Eigen::AlignedBox3f Box;
+
+  /** Build the tree, primitive i having @p boxes[i]. */
+  void build(const std::vector<Box>& boxes);
+
+  /** Remove all primitives. */
+  void clear();
+
+  /** @return The number of primitives in the tree. */
+  size_t size() const { return m_primitives.size(); }
+
+  /**
+   * Call @p test(primitive, depth) for the primitives whose boxes are
+   * crossed by the ray from @p origin along @p direction, nearest box first.
+   * The test may lower @p depth to the depth of a hit, after which boxes
+   * entered further along the ray are skipped. Leave it at infinity to visit
+   * every crossed box.
+   */
+  template <typename Test>
+  void intersect(const Vector3f& origin, const Vector3f& direction,
+                 float& depth, Test test) const;
+
+  /**
+   * Call @p test(primitive) for the primitives whose boxes are not entirely
+   * outside one of the planes of @p frustrum.
+   */
+  template <typename Test>
+  void intersect(const Frustrum& frustrum, Test test) const;
+
+private:
+  // A node is a leaf with m_primitives[first] ... [first + count - 1] if
+  // count is nonzero, otherwise its children are the next node and second.
+  struct Node
+  {
+    Box box;
+    unsigned int first;
+    unsigned int second;
+    unsigned int count;
+  };
+
+  // @return The distance along the ray where it enters the node, or infinity
+  // if it misses it or the box is entirely behind the origin.
+  static float entry(const Node& node, const Vector3f& origin,
+                     const Vector3f& inverse);
+
+  std::vector<Node> m_nodes;
+  std::vector<unsigned int> m_primitives;
+};
+
+inline float BoundingVolumeHierarchy::entry(const Node& node,
+                                            const Vector3f& origin,
+                                            const Vector3f& inverse)
+{
+  const Vector3f t1 = (node.box.min() - origin).cwiseProduct(inverse);
+  const Vector3f t2 = (node.box.max() - origin).cwiseProduct(inverse);
+  const float enter = t1.cwiseMin(t2).maxCoeff();
+  const float leave = t1.cwiseMax(t2).minCoeff();
+  if (leave < enter || leave < 0.0f)
+    return std::numeric_limits<float>::infinity();
+  return enter;
+}
+
+template <typename Test>
+void BoundingVolumeHierarchy::intersect(const Vector3f& origin,
+                                        const Vector3f& direction,
+                                        float& depth, Test test) const
+{
+  if (m_nodes.empty())
+    return;
+
+  // zero components would give 0 * infinity in the slab test
+  Vector3f inverse;
+  for (int c = 0; c < 3; ++c) {
+    const float d = direction[c] != 0.0f ? direction[c] : 1.0e-30f;
+    inverse[c] = 1.0f / d;
+  }
+
+  std::vector<std::pair<float, unsigned int>> stack;
+  const float rootEntry = entry(m_nodes[0], origin, inverse);
+  if (rootEntry <= depth)
+    stack.push_back(std::make_pair(rootEntry, 0u));
+  while (!stack.empty()) {
+    const std::pair<float, unsigned int> top = stack.back();
+    stack.pop_back();
+    if (top.first > depth)
+      continue;
+    const Node& node = m_nodes[top.second];
+    if (node.count) {
+      for (unsigned int i = node.first; i < node.first + node.count; ++i)
+        test(static_cast<size_t>(m_primitives[i]), depth);
+      continue;
+    }
+
+    // the nearer child is pushed last, so it is visited first
+    const unsigned int left = top.second + 1;
+    const float leftEntry = entry(m_nodes[left], origin, inverse);
+    const float rightEntry = entry(m_nodes[node.second], origin, inverse);
+    const std::pair<float, unsigned int> children[2] = {
+      std::make_pair(leftEntry, left), std::make_pair(rightEntry, node.second)
+    };
+    const int nearer = rightEntry < leftEntry ? 1 : 0;
+    if (children[1 - nearer].first <= depth)
+      stack.push_back(children[1 - nearer]);
+    if (children[nearer].first <= depth)
+      stack.push_back(children[nearer]);
+  }
+}
+
+template <typename Test>
+void BoundingVolumeHierarchy::intersect(const Frustrum& frustrum,
+                                        Test test) const
+{
+  if (m_nodes.empty())
+    return;
+
+  std::vector<unsigned int> stack(1, 0u);
+  while (!stack.empty()) {
+    const unsigned int index = stack.back();
+    stack.pop_back();
+    const Node& node = m_nodes[index];
+
+    // outside if the corner furthest into a plane is still outside it
+    bool outside = false;
+    for (int p = 0; p < 4 && !outside; ++p) {
+      const Vector3f& normal = frustrum.planes[p];
+      Vector3f corner;
+      for (int c = 0; c < 3; ++c)
+        corner[c] = normal[c] > 0.0f ? node.box.min()[c] : node.box.max()[c];
+      outside = (corner - frustrum.points[2 * p]).dot(normal) > 0.0f;
+    }
+    if (outside)
+      continue;
+
+    if (node.count) {
+      for (unsigned int i = node.first; i < node.first + node.count; ++i)
+        test(static_cast<size_t>(m_primitives[i]));
+    } else {
+      stack.push_back(node.second);
+      stack.push_back(index + 1);
+    }
+  }
+}
+
+} // End namespace Rendering
+} // End namespace Avogadro
+
+#endif // AVOGADRO_RENDERING_BOUNDINGVOLUMEHIERARCHY_H
@@ -70,6 +70,14 @@ public:
   template <class ContainerT>
   bool upload(const ContainerT& array, ObjectType type);
 
+  /**
+   * Replace part of the data already uploaded, starting at the element
+   * @a offset, without reallocating the buffer. The elements must be of the
+   * same type as those uploaded, and fit in the buffer.
+   */
+  template <class ContainerT>
+  bool uploadRange(const ContainerT& array, size_t offset);
+
   /** Bind the buffer object ready for rendering.
    * @note Only one ARRAY_BUFFER and one ELEMENT_ARRAY_BUFFER may be bound at
    * any time. */
@@ -83,6 +91,7 @@ public:
 
 private:
   bool uploadInternal(const void* buffer, size_t size, ObjectType objectType);
+  bool uploadRangeInternal(const void* buffer, size_t offset, size_t size);
 
   struct Private;
   Private* d;
@@ -104,6 +113,16 @@ inline bool BufferObject::upload(const ContainerT& array,
                         objectType);
 }
 
+template <class ContainerT>
+inline bool BufferObject::uploadRange(const ContainerT& array, size_t offset)
+{
+  if (array.empty())
+    return true;
+  const size_t elementSize = sizeof(typename ContainerT::value_type);
+  return uploadRangeInternal(&array[0], offset * elementSize,
+                             array.size() * elementSize);
+}
+
 } // End Rendering namespace
 } // End Avogadro namespace
 
@@ -19,6 +19,7 @@
 #include <Eigen/LU>
 
 #include <cmath>
+#include <limits>
 
 namespace Avogadro {
 namespace Rendering {
@@ -143,6 +144,39 @@ Vector3f Camera::unProject(const Vector2f& point,
   return unProject(Vector3f(point.x(), point.y(), project(reference).z()));
 }
 
+bool Camera::isInView(const Eigen::AlignedBox3f& box) const
+{
+  // The clipping planes are the sums and differences of the last row of the
+  // projection and model view with the others, positive inside.
+  Eigen::Matrix4f mvp =
+    m_data->projection.matrix() * m_data->modelView.matrix();
+  for (int row = 0; row < 3; ++row) {
+    for (int sign = -1; sign <= 1; sign += 2) {
+      Vector4f plane = mvp.row(3) + static_cast<float>(sign) * mvp.row(row);
+      // The corner of the box furthest inside the plane.
+      Vector3f corner;
+      for (int c = 0; c < 3; ++c)
+        corner[c] = plane[c] > 0.0f ? box.max()[c] : box.min()[c];
+      if (plane.head<3>().dot(corner) + plane[3] < 0.0f)
+        return false;
+    }
+  }
+  return true;
+}
+
+float Camera::pixelScale(const Vector3f& point) const
+{
+  Eigen::Matrix4f mvp =
+    m_data->projection.matrix() * m_data->modelView.matrix();
+  float w = mvp.row(3).dot(Vector4f(point.x(), point.y(), point.z(), 1.0f));
+  if (w <= 0.0f)
+    return std::numeric_limits<float>::infinity();
+  // The model view may scale the scene as well.
+  return 0.5f * static_cast<float>(m_height) *
+         std::abs(m_data->projection(1, 1)) *
+         m_data->modelView.linear().col(0).norm() / w;
+}
+
 void Camera::calculatePerspective(float fieldOfView, float aspectRatio,
                                   float zNear, float zFar)
 {
@@ -113,6 +113,18 @@ public:
   Vector3f unProject(const Vector2f& point,
                      const Vector3f& reference = Vector3f::Zero()) const;
 
+  /**
+   * Whether some of @p box may be in view, false if it is entirely outside
+   * one of the clipping planes.
+   */
+  bool isInView(const Eigen::AlignedBox3f& box) const;
+
+  /**
+   * The number of pixels a unit length at @p point covers on screen, facing
+   * the camera. Infinite for points at or behind the eye.
+   */
+  float pixelScale(const Vector3f& point) const;
+
   /**
    * Calculate the perspective projection matrix.
    * @param fieldOfView angle in degrees in the y direction.
@@ -15,6 +15,7 @@ namespace {
 } // namespace
 #include "avogadrogl.h"
 
+#include <algorithm>
 #include <iostream>
 #include <queue>
 #include <vector>
@@ -29,8 +30,12 @@ using Core::Array;
 
 const size_t CurveGeometry::SKIPPED = 1;
 
-CurveGeometry::CurveGeometry() : m_dirty(true), m_canBeFlat(true) {}
-CurveGeometry::CurveGeometry(bool flat) : m_dirty(true), m_canBeFlat(flat) {}
+CurveGeometry::CurveGeometry()
+  : m_dirty(true), m_canBeFlat(true), m_hitTreeDirty(true)
+{}
+CurveGeometry::CurveGeometry(bool flat)
+  : m_dirty(true), m_canBeFlat(flat), m_hitTreeDirty(true)
+{}
 
 CurveGeometry::~CurveGeometry()
 {
@@ -270,38 +275,57 @@ void CurveGeometry::addPoint(const Vector3f& pos, const Vector3ub& color,
   m_lines[m_indexMap[group]]->radius = radius;
   m_lines[m_indexMap[group]]->flat = radius < 0.0f;
   m_lines[m_indexMap[group]]->add(new Point(pos, color, id));
+  m_hitTreeDirty = true;
 }
 
 Array<Identifier> CurveGeometry::areaHits(const Frustrum& f) const
 {
-  Array<Identifier> result;
-  // Check for intersection.
-  for (const auto& line : m_lines) {
-    size_t skip = 0;
-    std::queue<size_t> previous;
-    for (const auto& point : line->points) {
-      previous.push(point->id);
-      if (skip < 2) {
-        ++skip;
-        continue;
-      }
-      int in = 0;
-      for (; in < 4; ++in) {
-        float dist = (point->pos - f.points[2 * in]).dot(f.planes[in]);
-        if (dist > 0.0f) {
-          // Outside of our frustrum, break.
-          break;
+  // Every point but the first two of a line selects the id of the point two
+  // before it.
+  if (m_hitTreeDirty) {
+    m_hitPoints.clear();
+    for (const auto& line : m_lines) {
+      size_t skip = 0;
+      std::queue<size_t> previous;
+      for (const auto& point : line->points) {
+        previous.push(point->id);
+        if (skip < 2) {
+          ++skip;
+          continue;
         }
+        m_hitPoints.push_back(std::make_pair(point->pos, previous.front()));
+        previous.pop();
       }
-      if (in == 4) {
-        // The center is within the four planes that make our frustrum - hit.
-        Identifier id;
-        id.molecule = m_identifier.molecule;
-        id.type = m_identifier.type;
-        id.index = previous.front();
-        result.push_back(id);
+    }
+    std::vector<BoundingVolumeHierarchy::Box> boxes;
+    boxes.reserve(m_hitPoints.size());
+    for (const auto& point : m_hitPoints)
+      boxes.push_back(BoundingVolumeHierarchy::Box(point.first, point.first));
+    m_hitTree.build(boxes);
+    m_hitTreeDirty = false;
+  }
+
+  std::vector<size_t> candidates;
+  m_hitTree.intersect(f, [&](size_t i) { candidates.push_back(i); });
+  std::sort(candidates.begin(), candidates.end());
+
+  Array<Identifier> result;
+  for (size_t i : candidates) {
+    int in = 0;
+    for (; in < 4; ++in) {
+      float dist = (m_hitPoints[i].first - f.points[2 * in]).dot(f.planes[in]);
+      if (dist > 0.0f) {
+        // Outside of our frustrum, break.
+        break;
       }
-      previous.pop();
+    }
+    if (in == 4) {
+      // The center is within the four planes that make our frustrum - hit.
+      Identifier id;
+      id.molecule = m_identifier.molecule;
+      id.type = m_identifier.type;
+      id.index = m_hitPoints[i].second;
+      result.push_back(id);
     }
   }
   return result;
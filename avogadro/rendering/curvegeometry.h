@@ -6,6 +6,7 @@
 #ifndef AVOGADRO_RENDERING_CURVEGEOMETRY_H
 #define AVOGADRO_RENDERING_CURVEGEOMETRY_H
 
+#include "boundingvolumehierarchy.h"
 #include "bufferobject.h"
 #include "drawable.h"
 #include "shader.h"
@@ -91,6 +92,12 @@ protected:
   bool m_dirty;
   bool m_canBeFlat;
 
+  // The points picked by areaHits() and the ids they select, in a tree built
+  // again once points were added.
+  mutable BoundingVolumeHierarchy m_hitTree;
+  mutable std::vector<std::pair<Vector3f, size_t>> m_hitPoints;
+  mutable bool m_hitTreeDirty;
+
   virtual void update(int index);
   virtual Vector3f computeCurvePoint(float t,
                                      const std::list<Point*>& points) const = 0;
@@ -20,6 +20,7 @@
 #include "scene.h"
 #include "visitor.h"
 
+#include "boundingvolumehierarchy.h"
 #include "bufferobject.h"
 
 #include "shader.h"
@@ -27,6 +28,7 @@
 
 namespace {
 #include "cylinders_fs.h"
+#include "cylinders_instanced_vs.h"
 #include "cylinders_vs.h"
 }
 
@@ -34,7 +36,9 @@ namespace {
 
 #include <avogadro/core/matrix.h>
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 using std::cout;
 using std::endl;
@@ -42,13 +46,127 @@ using std::endl;
 namespace Avogadro {
 namespace Rendering {
 
+namespace {
+// Points per circle, each cylinder is a tube of twice as many vertices.
+const unsigned int cylinderResolution = 12;
+// Far away cylinders only use every few points of the circle.
+const unsigned int coarseStep = 3;
+// Cylinders thinner than this many pixels are far away.
+const float coarsePixels = 4.0f;
+
+void addCylinderVertices(const CylinderColor& cylinder,
+                         std::vector<ColorNormalVertex>& vertices)
+{
+  const float resolutionRadians =
+    2.0f * static_cast<float>(M_PI) / static_cast<float>(cylinderResolution);
+  const Vector3f& position1 = cylinder.end1;
+  const Vector3f& position2 = cylinder.end2;
+  const Vector3f direction = (position2 - position1).normalized();
+
+  // Generate the radial vectors
+  Vector3f radial = direction.unitOrthogonal() * cylinder.radius;
+  Eigen::AngleAxisf transform(resolutionRadians, direction);
+
+  // Cylinder
+  ColorNormalVertex vert(cylinder.color, -direction, position1);
+  ColorNormalVertex vert2(cylinder.color2, -direction, position1);
+  for (unsigned int j = 0; j < cylinderResolution; ++j) {
+    vert.normal = radial;
+    vert.vertex = position1 + radial;
+    vertices.push_back(vert);
+    vert2.normal = vert.normal;
+    vert2.vertex = position2 + radial;
+    vertices.push_back(vert2);
+    radial = transform * radial;
+  }
+}
+
+// The indices of the triangles stitching a tube whose vertices start at
+// tubeStart, using every step-th pair of them.
+void addCylinderIndices(unsigned int tubeStart,
+                        std::vector<unsigned int>& indices,
+                        unsigned int step = 1)
+{
+  const unsigned int resolution = cylinderResolution;
+  for (unsigned int j = 0; j < resolution; j += step) {
+    unsigned int r1 = j + j;
+    unsigned int r2 = (j != 0 ? r1 : resolution + resolution) - 2 * step;
+    indices.push_back(tubeStart + r1);
+    indices.push_back(tubeStart + r1 + 1);
+    indices.push_back(tubeStart + r2);
+
+    indices.push_back(tubeStart + r2);
+    indices.push_back(tubeStart + r1 + 1);
+    indices.push_back(tubeStart + r2 + 1);
+  }
+}
+
+// The box around the cylinder, with its caps in any direction.
+Eigen::AlignedBox3f cylinderBox(const CylinderColor& cylinder)
+{
+  const Vector3f extent(cylinder.radius, cylinder.radius, cylinder.radius);
+  return Eigen::AlignedBox3f(cylinder.end1.cwiseMin(cylinder.end2) - extent,
+                             cylinder.end1.cwiseMax(cylinder.end2) + extent);
+}
+
+// Whether the ray hits the side of the cylinder between its origin and end,
+// and where.
+bool cylinderHit(const CylinderColor& cylinder, const Vector3f& rayOrigin,
+                 const Vector3f& rayEnd, const Vector3f& rayDirection,
+                 float& depth)
+{
+  // Check for cylinder intersection with the ray.
+  Vector3f ao = rayOrigin - cylinder.end1;
+  Vector3f ab = cylinder.end2 - cylinder.end1;
+  Vector3f aoxab = ao.cross(ab);
+  Vector3f vxab = rayDirection.cross(ab);
+
+  float A = vxab.dot(vxab);
+  float B = 2.0f * vxab.dot(aoxab);
+  float C =
+    aoxab.dot(aoxab) - ab.dot(ab) * (cylinder.radius * cylinder.radius);
+  float D = B * B - 4.0f * A * C;
+
+  // no intersection
+  if (D < 0.0f)
+    return false;
+
+  float t = std::min((-B + std::sqrt(D)) / (2.0f * A),
+                     (-B - std::sqrt(D)) / (2.0f * A));
+
+  Vector3f ip = rayOrigin + (rayDirection * t);
+  Vector3f ip1 = ip - cylinder.end1;
+  Vector3f ip2 = ip - (cylinder.end1 + ab);
+
+  // intersection below base or above top of the cylinder
+  if (ip1.dot(ab) < 0.0f || ip2.dot(ab) > 0.0f)
+    return false;
+
+  // Test for clipping
+  Vector3f distance = ip - rayOrigin;
+  if (distance.dot(rayDirection) < 0.0f ||
+      (ip - rayEnd).dot(rayDirection) > 0.0f)
+    return false;
+
+  depth = distance.norm();
+  return true;
+}
+} // namespace
+
 class CylinderGeometry::Private
 {
 public:
-  Private() {}
+  Private()
+    : instanced(false), numberOfInstances(0), numberOfCoarseIndices(0)
+  {}
 
+  // Either the vertices of every tube, or those of the tube drawn for each
+  // instance in the instances buffer.
   BufferObject vbo;
   BufferObject ibo;
+  BufferObject instances;
+  bool instanced;
+  size_t numberOfInstances;
 
   Shader vertexShader;
   Shader fragmentShader;
@@ -56,15 +174,26 @@ public:
 
   size_t numberOfVertices;
   size_t numberOfIndices;
+  // The coarse tube follows the detailed one in the instanced ibo.
+  size_t numberOfCoarseIndices;
+
+  // Picking is done through boxes around the cylinders, built when needed.
+  BoundingVolumeHierarchy hitTree;
+
+  // Consecutive cylinders are culled and given a level of detail together.
+  GeometryChunks chunks;
 };
 
-CylinderGeometry::CylinderGeometry() : m_dirty(false), d(new Private)
+CylinderGeometry::CylinderGeometry()
+  : m_dirty(false), m_dirtyBegin(0), m_dirtyEnd(0), m_hitTreeDirty(true),
+    m_chunksDirty(true), d(new Private)
 {
 }
 
 CylinderGeometry::CylinderGeometry(const CylinderGeometry& other)
   : Drawable(other), m_cylinders(other.m_cylinders), m_indices(other.m_indices),
-    m_indexMap(other.m_indexMap), m_dirty(true), d(new Private)
+    m_indexMap(other.m_indexMap), m_dirty(true), m_dirtyBegin(0), m_dirtyEnd(0),
+    m_hitTreeDirty(true), m_chunksDirty(true), d(new Private)
 {
 }
 
@@ -83,19 +212,64 @@ void CylinderGeometry::update()
   if (m_indices.empty() || m_cylinders.empty())
     return;
 
-  // Check if the VBOs are ready, if not get them ready.
-  if (!d->vbo.ready() || m_dirty) {
-    // Set some defaults for our cylinders.
-    const unsigned int resolution = 12; // points per circle
-    const float resolutionRadians =
-      2.0f * static_cast<float>(M_PI) / static_cast<float>(resolution);
-    std::vector<Vector3f> radials;
-    radials.reserve(resolution);
+  // Where the GL can draw instances, each cylinder is one record and the
+  // tube is placed in the vertex shader.
+  if (d->vertexShader.type() == Shader::Unknown)
+    d->instanced = GLEW_VERSION_3_3 != 0;
+
+  if (d->instanced) {
+    if (!d->instances.ready() || m_dirty) {
+      std::vector<CylinderInstance> instances;
+      instances.reserve(m_cylinders.size());
+      for (const CylinderColor& cylinder : m_cylinders) {
+        instances.push_back(CylinderInstance(cylinder.end1, cylinder.end2,
+                                             cylinder.radius, cylinder.color,
+                                             cylinder.color2));
+      }
+      if (!d->instances.upload(instances, BufferObject::ArrayBuffer))
+        cout << d->instances.error() << endl;
+      d->numberOfInstances = instances.size();
+
+      // The angle around the axis, and which end of the tube.
+      if (!d->vbo.ready()) {
+        const float resolutionRadians = 2.0f * static_cast<float>(M_PI) /
+                                        static_cast<float>(cylinderResolution);
+        std::vector<Vector2f> tube;
+        for (unsigned int j = 0; j < cylinderResolution; ++j) {
+          tube.push_back(Vector2f(j * resolutionRadians, 0.0f));
+          tube.push_back(Vector2f(j * resolutionRadians, 1.0f));
+        }
+        std::vector<unsigned int> tubeIndices;
+        addCylinderIndices(0, tubeIndices);
+        d->numberOfIndices = tubeIndices.size();
+        addCylinderIndices(0, tubeIndices, coarseStep);
+        d->numberOfCoarseIndices = tubeIndices.size() - d->numberOfIndices;
+        if (!d->vbo.upload(tube, BufferObject::ArrayBuffer))
+          cout << d->vbo.error() << endl;
+        if (!d->ibo.upload(tubeIndices, BufferObject::ElementArrayBuffer))
+          cout << d->ibo.error() << endl;
+        d->numberOfVertices = tube.size();
+      }
 
+      m_dirty = false;
+    } else if (m_dirtyBegin < m_dirtyEnd) {
+      // Only the records of the moved cylinders.
+      std::vector<CylinderInstance> instances;
+      instances.reserve(m_dirtyEnd - m_dirtyBegin);
+      for (size_t i = m_dirtyBegin; i < m_dirtyEnd; ++i) {
+        const CylinderColor& cylinder = m_cylinders[i];
+        instances.push_back(CylinderInstance(cylinder.end1, cylinder.end2,
+                                             cylinder.radius, cylinder.color,
+                                             cylinder.color2));
+      }
+      if (!d->instances.uploadRange(instances, m_dirtyBegin))
+        cout << d->instances.error() << endl;
+    }
+  } else if (!d->vbo.ready() || m_dirty) {
     std::vector<unsigned int> cylinderIndices;
     std::vector<ColorNormalVertex> cylinderVertices;
-    // cylinderIndices.reserve(m_indices.size() * 4);
-    // cylinderVertices.reserve(m_cylinders.size() * 4);
+    cylinderIndices.reserve(m_cylinders.size() * 6 * cylinderResolution);
+    cylinderVertices.reserve(m_cylinders.size() * 2 * cylinderResolution);
 
     std::vector<size_t>::const_iterator itIndex = m_indices.begin();
     std::vector<CylinderColor>::const_iterator itCylinder = m_cylinders.begin();
@@ -103,48 +277,12 @@ void CylinderGeometry::update()
     for (unsigned int i = 0;
          itIndex != m_indices.end() && itCylinder != m_cylinders.end();
          ++i, ++itIndex, ++itCylinder) {
-
-      const Vector3f& position1 = itCylinder->end1;
-      const Vector3f& position2 = itCylinder->end2;
-      const Vector3f direction = (position2 - position1).normalized();
-      float radius = itCylinder->radius;
-
-      // Generate the radial vectors
-      Vector3f radial = direction.unitOrthogonal() * radius;
-      Eigen::AngleAxisf transform(resolutionRadians, direction);
-      radials.clear();
-      for (unsigned int j = 0; j < resolution; ++j) {
-        radials.push_back(radial);
-        radial = transform * radial;
-      }
-
-      // Cylinder
-      ColorNormalVertex vert(itCylinder->color, -direction, position1);
-      ColorNormalVertex vert2(itCylinder->color2, -direction, position1);
       const unsigned int tubeStart =
         static_cast<unsigned int>(cylinderVertices.size());
-      for (std::vector<Vector3f>::const_iterator it = radials.begin(),
-                                                 itEnd = radials.end();
-           it != itEnd; ++it) {
-        vert.normal = *it;
-        vert.vertex = position1 + *it;
-        cylinderVertices.push_back(vert);
-        vert2.normal = vert.normal;
-        vert2.vertex = position2 + *it;
-        cylinderVertices.push_back(vert2);
-      }
+      addCylinderVertices(*itCylinder, cylinderVertices);
+
       // Now to stitch it together.
-      for (unsigned int j = 0; j < resolution; ++j) {
-        unsigned int r1 = j + j;
-        unsigned int r2 = (j != 0 ? r1 : resolution + resolution) - 2;
-        cylinderIndices.push_back(tubeStart + r1);
-        cylinderIndices.push_back(tubeStart + r1 + 1);
-        cylinderIndices.push_back(tubeStart + r2);
-
-        cylinderIndices.push_back(tubeStart + r2);
-        cylinderIndices.push_back(tubeStart + r1 + 1);
-        cylinderIndices.push_back(tubeStart + r2 + 1);
-      }
+      addCylinderIndices(tubeStart, cylinderIndices);
     }
 
     d->vbo.upload(cylinderVertices, BufferObject::ArrayBuffer);
@@ -153,12 +291,25 @@ void CylinderGeometry::update()
     d->numberOfIndices = cylinderIndices.size();
 
     m_dirty = false;
+  } else if (m_dirtyBegin < m_dirtyEnd) {
+    // Only the moved cylinders, the indices stay the same.
+    std::vector<ColorNormalVertex> cylinderVertices;
+    cylinderVertices.reserve((m_dirtyEnd - m_dirtyBegin) * 2 *
+                             cylinderResolution);
+    for (size_t i = m_dirtyBegin; i < m_dirtyEnd; ++i)
+      addCylinderVertices(m_cylinders[i], cylinderVertices);
+    if (!d->vbo.uploadRange(cylinderVertices,
+                            2 * cylinderResolution * m_dirtyBegin)) {
+      cout << d->vbo.error() << endl;
+    }
   }
+  m_dirtyBegin = m_dirtyEnd = 0;
 
   // Build and link the shader if it has not been used yet.
   if (d->vertexShader.type() == Shader::Unknown) {
     d->vertexShader.setType(Shader::Vertex);
-    d->vertexShader.setSource(cylinders_vs);
+    d->vertexShader.setSource(d->instanced ? cylinders_instanced_vs
+                                           : cylinders_vs);
     d->fragmentShader.setType(Shader::Fragment);
     d->fragmentShader.setSource(cylinders_fs);
     if (!d->vertexShader.compile())
@@ -185,9 +336,21 @@ void CylinderGeometry::render(const Camera& camera)
   // Prepare the VBOs, IBOs and shader program if necessary.
   update();
 
+  // Only the chunks of cylinders in view are drawn, with fewer facets for
+  // those far away when drawing instances.
+  std::vector<GeometryChunks::Run> runs;
+  chunks().visibleRuns(camera, d->instanced ? coarsePixels : 0.0f, runs);
+  if (runs.empty())
+    return;
+
   if (!d->program.bind())
     cout << d->program.error() << endl;
 
+  if (d->instanced) {
+    renderInstances(camera, runs);
+    return;
+  }
+
   d->vbo.bind();
   d->ibo.bind();
 
@@ -225,10 +388,22 @@ void CylinderGeometry::render(const Camera& camera)
   if (!d->program.setUniformValue("normalMatrix", normalMatrix))
     std::cout << d->program.error() << std::endl;
 
-  // Render the loaded spheres using the shader and bound VBO.
-  glDrawRangeElements(GL_TRIANGLES, 0, static_cast<GLuint>(d->numberOfVertices),
-                      static_cast<GLsizei>(d->numberOfIndices), GL_UNSIGNED_INT,
-                      reinterpret_cast<const GLvoid*>(0));
+  // Render the loaded cylinders using the shader and bound VBO, each a tube
+  // of its own vertices and indices.
+  const size_t vertices = 2 * cylinderResolution;
+  const size_t indices = 6 * cylinderResolution;
+  const size_t count = d->numberOfIndices / indices;
+  for (const GeometryChunks::Run& run : runs) {
+    const size_t end = std::min(run.end, count);
+    if (run.begin >= end)
+      continue;
+    glDrawRangeElements(
+      GL_TRIANGLES, static_cast<GLuint>(vertices * run.begin),
+      static_cast<GLuint>(vertices * end - 1),
+      static_cast<GLsizei>(indices * (end - run.begin)), GL_UNSIGNED_INT,
+      reinterpret_cast<const GLvoid*>(indices * run.begin *
+                                      sizeof(unsigned int)));
+  }
 
   d->vbo.release();
   d->ibo.release();
@@ -240,63 +415,171 @@ void CylinderGeometry::render(const Camera& camera)
   d->program.release();
 }
 
-std::multimap<float, Identifier> CylinderGeometry::hits(
-  const Vector3f& rayOrigin, const Vector3f& rayEnd,
-  const Vector3f& rayDirection) const
+void CylinderGeometry::renderInstances(
+  const Camera& camera, const std::vector<GeometryChunks::Run>& runs)
 {
-  std::multimap<float, Identifier> result;
-
-  for (size_t i = 0; i < m_cylinders.size(); ++i) {
-    const CylinderColor& cylinder = m_cylinders[i];
+  // The tube advances per vertex, the records per instance.
+  d->vbo.bind();
+  if (!d->program.enableAttributeArray("tube"))
+    cout << d->program.error() << endl;
+  if (!d->program.useAttributeArray("tube", 0, sizeof(Vector2f), FloatType, 2,
+                                    ShaderProgram::NoNormalize)) {
+    cout << d->program.error() << endl;
+  }
+  d->vbo.release();
 
-    // Check for cylinder intersection with the ray.
-    Vector3f ao = rayOrigin - cylinder.end1;
-    Vector3f ab = cylinder.end2 - cylinder.end1;
-    Vector3f aoxab = ao.cross(ab);
-    Vector3f vxab = rayDirection.cross(ab);
+  const char* attributes[] = { "end1", "end2", "cylinderRadius", "color",
+                               "color2" };
+  const int offsets[] = { CylinderInstance::end1Offset(),
+                          CylinderInstance::end2Offset(),
+                          CylinderInstance::radiusOffset(),
+                          CylinderInstance::colorOffset(),
+                          CylinderInstance::color2Offset() };
+  const Avogadro::Type types[] = { FloatType, FloatType, FloatType, UCharType,
+                                   UCharType };
+  const int sizes[] = { 3, 3, 1, 3, 3 };
+  for (int i = 0; i < 5; ++i) {
+    if (!d->program.enableAttributeArray(attributes[i]))
+      cout << d->program.error() << endl;
+    d->program.setAttributeArrayDivisor(attributes[i], 1);
+  }
 
-    float A = vxab.dot(vxab);
-    float B = 2.0f * vxab.dot(aoxab);
-    float C =
-      aoxab.dot(aoxab) - ab.dot(ab) * (cylinder.radius * cylinder.radius);
-    float D = B * B - 4.0f * A * C;
+  // Set up our uniforms (model-view and projection matrices right now).
+  if (!d->program.setUniformValue("modelView", camera.modelView().matrix())) {
+    cout << d->program.error() << endl;
+  }
+  if (!d->program.setUniformValue("projection", camera.projection().matrix())) {
+    cout << d->program.error() << endl;
+  }
+  Matrix3f normalMatrix = camera.modelView().linear().inverse().transpose();
+  if (!d->program.setUniformValue("normalMatrix", normalMatrix))
+    std::cout << d->program.error() << std::endl;
 
-    // no intersection
-    if (D < 0.0f)
+  // Each run starts the records at its first cylinder, and draws the
+  // detailed or the coarse tube.
+  d->ibo.bind();
+  d->instances.bind();
+  for (const GeometryChunks::Run& run : runs) {
+    const size_t end = std::min(run.end, d->numberOfInstances);
+    if (run.begin >= end)
       continue;
+    const int base = static_cast<int>(run.begin * sizeof(CylinderInstance));
+    for (int i = 0; i < 5; ++i) {
+      if (!d->program.useAttributeArray(
+            attributes[i], base + offsets[i], sizeof(CylinderInstance),
+            types[i], sizes[i],
+            types[i] == UCharType ? ShaderProgram::Normalize
+                                  : ShaderProgram::NoNormalize)) {
+        cout << d->program.error() << endl;
+      }
+    }
+    const size_t first = run.coarse ? d->numberOfIndices : 0;
+    const size_t indices =
+      run.coarse ? d->numberOfCoarseIndices : d->numberOfIndices;
+    glDrawElementsInstanced(
+      GL_TRIANGLES, static_cast<GLsizei>(indices), GL_UNSIGNED_INT,
+      reinterpret_cast<const GLvoid*>(first * sizeof(unsigned int)),
+      static_cast<GLsizei>(end - run.begin));
+  }
+  d->instances.release();
+  d->ibo.release();
 
-    float t = std::min((-B + std::sqrt(D)) / (2.0f * A),
-                       (-B - std::sqrt(D)) / (2.0f * A));
-
-    Vector3f ip = rayOrigin + (rayDirection * t);
-    Vector3f ip1 = ip - cylinder.end1;
-    Vector3f ip2 = ip - (cylinder.end1 + ab);
+  for (int i = 0; i < 5; ++i) {
+    d->program.setAttributeArrayDivisor(attributes[i], 0);
+    d->program.disableAttributeArray(attributes[i]);
+  }
+  d->program.disableAttributeArray("tube");
 
-    // intersection below base or above top of the cylinder
-    if (ip1.dot(ab) < 0.0f || ip2.dot(ab) > 0.0f)
-      continue;
+  d->program.release();
+}
 
-    // Test for clipping
-    Vector3f distance = ip - rayOrigin;
-    if (distance.dot(rayDirection) < 0.0f ||
-        (ip - rayEnd).dot(rayDirection) > 0.0f)
-      continue;
+const BoundingVolumeHierarchy& CylinderGeometry::hitTree() const
+{
+  if (m_hitTreeDirty) {
+    std::vector<BoundingVolumeHierarchy::Box> boxes;
+    boxes.reserve(m_cylinders.size());
+    for (const CylinderColor& cylinder : m_cylinders)
+      boxes.push_back(cylinderBox(cylinder));
+    d->hitTree.build(boxes);
+    m_hitTreeDirty = false;
+  }
+  return d->hitTree;
+}
 
-    Identifier id;
-    id.molecule = m_identifier.molecule;
-    id.type = m_identifier.type;
-    id.index = i;
-    if (m_indexMap.size())
-      id.index = m_indexMap.find(i)->second;
-    if (id.type != InvalidType) {
-      float depth = distance.norm();
-      result.insert(std::pair<float, Identifier>(depth, id));
-    }
+const GeometryChunks& CylinderGeometry::chunks() const
+{
+  if (m_chunksDirty) {
+    d->chunks.build(m_cylinders.size(),
+                    [this](size_t i) { return cylinderBox(m_cylinders[i]); });
+    m_chunksDirty = false;
   }
+  return d->chunks;
+}
+
+bool CylinderGeometry::boundingBox(Eigen::AlignedBox3f& box) const
+{
+  box = chunks().box();
+  return true;
+}
+
+Identifier CylinderGeometry::cylinderIdentifier(size_t cylinder) const
+{
+  Identifier id;
+  id.molecule = m_identifier.molecule;
+  id.type = m_identifier.type;
+  id.index = cylinder;
+  if (m_indexMap.size())
+    id.index = m_indexMap.find(cylinder)->second;
+  return id;
+}
 
+std::multimap<float, Identifier> CylinderGeometry::hits(
+  const Vector3f& rayOrigin, const Vector3f& rayEnd,
+  const Vector3f& rayDirection) const
+{
+  std::multimap<float, Identifier> result;
+  if (m_identifier.type == InvalidType)
+    return result;
+
+  // Check for intersection with the cylinders whose boxes are on the ray.
+  float maxDepth = std::numeric_limits<float>::infinity();
+  hitTree().intersect(rayOrigin, rayDirection, maxDepth,
+                      [&](size_t i, float&) {
+                        float depth;
+                        if (cylinderHit(m_cylinders[i], rayOrigin, rayEnd,
+                                        rayDirection, depth)) {
+                          result.insert(
+                            std::make_pair(depth, cylinderIdentifier(i)));
+                        }
+                      });
   return result;
 }
 
+Identifier CylinderGeometry::hit(const Vector3f& rayOrigin,
+                                 const Vector3f& rayEnd,
+                                 const Vector3f& rayDirection,
+                                 float& depth) const
+{
+  if (m_identifier.type == InvalidType)
+    return Identifier();
+
+  // The cylinders nearest along the ray are tested first, the boxes behind
+  // the closest hit so far are skipped.
+  size_t closest = MaxIndex;
+  hitTree().intersect(rayOrigin, rayDirection, depth,
+                      [&](size_t i, float& maxDepth) {
+                        float cylinderDepth;
+                        if (cylinderHit(m_cylinders[i], rayOrigin, rayEnd,
+                                        rayDirection, cylinderDepth) &&
+                            (cylinderDepth < maxDepth ||
+                             (cylinderDepth == maxDepth && i < closest))) {
+                          maxDepth = cylinderDepth;
+                          closest = i;
+                        }
+                      });
+  return closest != MaxIndex ? cylinderIdentifier(closest) : Identifier();
+}
+
 void CylinderGeometry::addCylinder(const Vector3f& pos1, const Vector3f& pos2,
                                    float radius, const Vector3ub& color)
 {
@@ -308,6 +591,7 @@ void CylinderGeometry::addCylinder(const Vector3f& pos1, const Vector3f& pos2,
                                    const Vector3ub& colorEnd)
 {
   m_dirty = true;
+  m_hitTreeDirty = m_chunksDirty = true;
   m_cylinders.push_back(
     CylinderColor(pos1, pos2, radius, colorStart, colorEnd));
   m_indices.push_back(m_indices.size());
@@ -329,11 +613,29 @@ void CylinderGeometry::addCylinder(const Vector3f& pos1, const Vector3f& pos2,
   addCylinder(pos1, pos2, radius, colorStart, colorEnd);
 }
 
+void CylinderGeometry::setCylinderEnds(size_t cylinder, const Vector3f& pos1,
+                                       const Vector3f& pos2)
+{
+  if (cylinder >= m_cylinders.size())
+    return;
+  m_cylinders[cylinder].end1 = pos1;
+  m_cylinders[cylinder].end2 = pos2;
+  m_hitTreeDirty = m_chunksDirty = true;
+  if (m_dirtyBegin == m_dirtyEnd) {
+    m_dirtyBegin = cylinder;
+    m_dirtyEnd = cylinder + 1;
+  } else {
+    m_dirtyBegin = std::min(m_dirtyBegin, cylinder);
+    m_dirtyEnd = std::max(m_dirtyEnd, cylinder + 1);
+  }
+}
+
 void CylinderGeometry::clear()
 {
   m_cylinders.clear();
   m_indices.clear();
   m_indexMap.clear();
+  m_hitTreeDirty = m_chunksDirty = true;
 }
 
 } // End namespace Rendering
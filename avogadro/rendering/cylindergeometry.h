@@ -18,12 +18,15 @@
 #define AVOGADRO_RENDERING_CYLINDERGEOMETRY_H
 
 #include "drawable.h"
+#include "geometrychunks.h"
 
 #include <vector>
 
 namespace Avogadro {
 namespace Rendering {
 
+class BoundingVolumeHierarchy;
+
 struct CylinderColor
 {
   CylinderColor(const Vector3f& pos1, const Vector3f& pos2, float r,
@@ -86,6 +89,18 @@ public:
     const Vector3f& rayOrigin, const Vector3f& rayEnd,
     const Vector3f& rayDirection) const override;
 
+  /**
+   * Return the closest primitive hit by the ray, if it is closer than
+   * @p depth.
+   */
+  Identifier hit(const Vector3f& rayOrigin, const Vector3f& rayEnd,
+                 const Vector3f& rayDirection, float& depth) const override;
+
+  /**
+   * Set @p box to the box around the cylinders.
+   */
+  bool boundingBox(Eigen::AlignedBox3f& box) const override;
+
   /**
    * @brief Add a cylinder to the geometry object.
    * @param pos1 Base of the cylinder axis.
@@ -131,10 +146,22 @@ public:
                    const Vector3ub& color, const Vector3ub& color2,
                    size_t index);
 
+  /**
+   * Move the ends of the cylinder at @p cylinder, counted in the order they
+   * were added, to @p pos1 and @p pos2. Only the cylinders moved since the
+   * last render are uploaded again.
+   */
+  void setCylinderEnds(size_t cylinder, const Vector3f& pos1,
+                       const Vector3f& pos2);
+
   /**
    * Get a reference to the cylinders.
    */
-  std::vector<CylinderColor>& cylinders() { return m_cylinders; }
+  std::vector<CylinderColor>& cylinders()
+  {
+    m_hitTreeDirty = m_chunksDirty = true;
+    return m_cylinders;
+  }
   const std::vector<CylinderColor>& cylinders() const { return m_cylinders; }
 
   /**
@@ -148,11 +175,33 @@ public:
   size_t size() const { return m_cylinders.size(); }
 
 private:
+  // Draw the runs of cylinders as instances of a shared tube, with the
+  // program bound.
+  void renderInstances(const Camera& camera,
+                       const std::vector<GeometryChunks::Run>& runs);
+
+  // The tree of boxes around the cylinders, built again if they changed.
+  const BoundingVolumeHierarchy& hitTree() const;
+
+  // The chunks of cylinders culled when rendering, built again if they changed.
+  const GeometryChunks& chunks() const;
+
+  // @return The identifier used for picking the cylinder at @p cylinder.
+  Identifier cylinderIdentifier(size_t cylinder) const;
+
   std::vector<CylinderColor> m_cylinders;
   std::vector<size_t> m_indices;
   std::map<size_t, size_t> m_indexMap;
 
   bool m_dirty;
+  // The cylinders moved since the last upload, from m_dirtyBegin to
+  // m_dirtyEnd.
+  size_t m_dirtyBegin;
+  size_t m_dirtyEnd;
+  // The cylinders changed since the tree used for picking was built.
+  mutable bool m_hitTreeDirty;
+  // The cylinders changed since the chunks culled when rendering were built.
+  mutable bool m_chunksDirty;
 
   class Private;
   Private* d;
@@ -173,6 +222,9 @@ inline void swap(CylinderGeometry& lhs, CylinderGeometry& rhs)
   swap(lhs.m_indices, rhs.m_indices);
   swap(lhs.m_indexMap, rhs.m_indexMap);
   lhs.m_dirty = rhs.m_dirty = true;
+  lhs.m_hitTreeDirty = rhs.m_hitTreeDirty = true;
+  lhs.m_chunksDirty = rhs.m_chunksDirty = true;
+  lhs.m_dirtyBegin = rhs.m_dirtyBegin = lhs.m_dirtyEnd = rhs.m_dirtyEnd = 0;
 }
 
 } // End namespace Rendering
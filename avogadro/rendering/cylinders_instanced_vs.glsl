@@ -0,0 +1,38 @@
+attribute vec2 tube;
+attribute vec3 end1;
+attribute vec3 end2;
+attribute float cylinderRadius;
+attribute vec3 color;
+attribute vec3 color2;
+
+uniform mat4 modelView;
+uniform mat4 projection;
+uniform mat3 normalMatrix;
+
+varying vec3 fnormal;
+
+// A unit vector orthogonal to v, picked like Eigen's unitOrthogonal() so the
+// tube has the same facets as the one built on the CPU.
+vec3 unitOrthogonal(vec3 v)
+{
+  float tolerance = 1.0e-5 * abs(v.z);
+  if (abs(v.x) > tolerance || abs(v.y) > tolerance)
+    return normalize(vec3(-v.y, v.x, 0.0));
+  return normalize(vec3(0.0, -v.z, v.y));
+}
+
+// The same tube as cylinders_vs, shared by all cylinders. The tube attribute
+// is the angle around the axis and 0 at the first end or 1 at the second.
+void main()
+{
+  vec3 axis = end2 - end1;
+  vec3 direction = normalize(axis);
+  vec3 u = unitOrthogonal(direction);
+  vec3 v = cross(direction, u);
+  vec3 radial = cylinderRadius * (cos(tube.x) * u + sin(tube.x) * v);
+  vec4 vertex = vec4(end1 + tube.y * axis + radial, 1.0);
+
+  gl_FrontColor = vec4(mix(color, color2, tube.y), 1.0);
+  gl_Position = projection * modelView * vertex;
+  fnormal = normalize(normalMatrix * radial);
+}
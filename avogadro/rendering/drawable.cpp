@@ -54,11 +54,27 @@ std::multimap<float, Identifier> Drawable::hits(const Vector3f&,
   return std::multimap<float, Identifier>();
 }
 
+Identifier Drawable::hit(const Vector3f& rayOrigin, const Vector3f& rayEnd,
+                         const Vector3f& rayDirection, float& depth) const
+{
+  std::multimap<float, Identifier> results =
+    hits(rayOrigin, rayEnd, rayDirection);
+  if (results.empty() || results.begin()->first >= depth)
+    return Identifier();
+  depth = results.begin()->first;
+  return results.begin()->second;
+}
+
 Array<Identifier> Drawable::areaHits(const Frustrum&) const
 {
   return Array<Identifier>();
 }
 
+bool Drawable::boundingBox(Eigen::AlignedBox3f&) const
+{
+  return false;
+}
+
 void Drawable::clear()
 {
 }
@@ -25,6 +25,8 @@
 #include <avogadro/core/array.h>
 #include <avogadro/core/vector.h>
 
+#include <Eigen/Geometry>
+
 #include <map>
 
 namespace Avogadro {
@@ -111,6 +113,16 @@ public:
     const Vector3f& rayOrigin, const Vector3f& rayEnd,
     const Vector3f& rayDirection) const;
 
+  /**
+   * Return the closest primitive hit by the ray, if it is closer than
+   * @p depth, which is then lowered to its depth. The default finds it among
+   * hits(), geometries with many primitives find it without testing them all.
+   * @return The primitive hit, or an invalid identifier if there was none
+   * closer than @p depth.
+   */
+  virtual Identifier hit(const Vector3f& rayOrigin, const Vector3f& rayEnd,
+                         const Vector3f& rayDirection, float& depth) const;
+
   /**
    * Return the primitives within the supplied area.
    * @param f The frustrum defining the area highlighted.
@@ -118,6 +130,13 @@ public:
    */
   virtual Core::Array<Identifier> areaHits(const Frustrum& f) const;
 
+  /**
+   * Set @p box to the box around the primitives, empty if there are none.
+   * @return False if the bounds are unknown, the drawable is then always
+   * rendered.
+   */
+  virtual bool boundingBox(Eigen::AlignedBox3f& box) const;
+
   /**
    * Clear the contents of the node.
    */
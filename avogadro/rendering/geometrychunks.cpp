@@ -0,0 +1,55 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "geometrychunks.h"
+
+#include "camera.h"
+
+namespace Avogadro {
+namespace Rendering {
+
+const size_t GeometryChunks::chunkSize;
+
+void GeometryChunks::clear()
+{
+  m_chunks.clear();
+  m_box.setEmpty();
+}
+
+void GeometryChunks::visibleRuns(const Camera& camera, float coarsePixels,
+                                 std::vector<Run>& runs) const
+{
+  runs.clear();
+  if (m_box.isEmpty() || !camera.isInView(m_box))
+    return;
+
+  // Without a viewport there is nothing to measure the detail against.
+  const bool lod = coarsePixels > 0.0f && camera.height() > 0;
+  const Vector3f eye = camera.modelView().inverse() * Vector3f::Zero();
+
+  size_t begin = 0;
+  for (const Chunk& chunk : m_chunks) {
+    if (!chunk.box.isEmpty() && camera.isInView(chunk.box)) {
+      // The point of the chunk nearest the eye shows it largest.
+      bool coarse = false;
+      if (lod) {
+        const Vector3f nearest =
+          eye.cwiseMax(chunk.box.min()).cwiseMin(chunk.box.max());
+        coarse = chunk.size * camera.pixelScale(nearest) < coarsePixels;
+      }
+      if (!runs.empty() && runs.back().end == begin &&
+          runs.back().coarse == coarse) {
+        runs.back().end = chunk.end;
+      } else {
+        Run run = { begin, chunk.end, coarse };
+        runs.push_back(run);
+      }
+    }
+    begin = chunk.end;
+  }
+}
+
+} // End namespace Rendering
+} // End namespace Avogadro
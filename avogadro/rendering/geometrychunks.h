@@ -0,0 +1,111 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#ifndef AVOGADRO_RENDERING_GEOMETRYCHUNKS_H
+#define AVOGADRO_RENDERING_GEOMETRYCHUNKS_H
+
+#include "avogadrorenderingexport.h"
+
+#include <avogadro/core/vector.h>
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <vector>
+
+namespace Avogadro {
+namespace Rendering {
+
+class Camera;
+
+/**
+ * @class GeometryChunks geometrychunks.h
+ * <avogadro/rendering/geometrychunks.h>
+ * @brief Splits the primitives of a Drawable into chunks of consecutive
+ * primitives with a bounding box each, so the chunks out of view can be
+ * skipped and those far away drawn with less detail.
+ *
+ * Primitives are added in the order of the atoms, bonds or triangles they
+ * come from, which keeps most chunks compact in space for molecules and
+ * surfaces read from files.
+ */
+class AVOGADRORENDERING_EXPORT GeometryChunks
+{
+public:
+  typedef Eigen::AlignedBox3f Box;
+
+  /** The primitives begin ... end - 1, to be drawn coarse or in detail. */
+  struct Run
+  {
+    size_t begin;
+    size_t end;
+    bool coarse;
+  };
+
+  /** The number of primitives in each chunk but the last. */
+  static const size_t chunkSize = 4096;
+
+  GeometryChunks() { m_box.setEmpty(); }
+
+  /**
+   * Build the chunks of @p count primitives, where @p bounds(i) returns the
+   * box around primitive i.
+   */
+  template <typename Bounds>
+  void build(size_t count, Bounds bounds);
+
+  /** Remove all chunks. */
+  void clear();
+
+  /** @return The number of chunks. */
+  size_t size() const { return m_chunks.size(); }
+
+  /** @return The box around all primitives, empty if there are none. */
+  const Box& box() const { return m_box; }
+
+  /**
+   * Set @p runs to the chunks in view of @p camera, merging neighbors. A
+   * chunk is coarse if its largest primitive, measured by the shortest side
+   * of its box, covers fewer than @p coarsePixels on screen, so zero keeps
+   * every chunk in detail.
+   */
+  void visibleRuns(const Camera& camera, float coarsePixels,
+                   std::vector<Run>& runs) const;
+
+private:
+  struct Chunk
+  {
+    Box box;
+    size_t end;
+    float size;
+  };
+
+  std::vector<Chunk> m_chunks;
+  Box m_box;
+};
+
+template <typename Bounds>
+void GeometryChunks::build(size_t count, Bounds bounds)
+{
+  clear();
+  for (size_t begin = 0; begin < count; begin += chunkSize) {
+    Chunk chunk;
+    chunk.box.setEmpty();
+    chunk.end = std::min(count, begin + chunkSize);
+    chunk.size = 0.0f;
+    for (size_t i = begin; i < chunk.end; ++i) {
+      const Box box = bounds(i);
+      chunk.box.extend(box);
+      chunk.size = std::max(chunk.size, box.sizes().minCoeff());
+    }
+    m_box.extend(chunk.box);
+    m_chunks.push_back(chunk);
+  }
+}
+
+} // End namespace Rendering
+} // End namespace Avogadro
+
+#endif // AVOGADRO_RENDERING_GEOMETRYCHUNKS_H
@@ -113,6 +113,20 @@ std::multimap<float, Identifier> GeometryNode::hits(
   return result;
 }
 
+Identifier GeometryNode::hit(const Vector3f& rayOrigin, const Vector3f& rayEnd,
+                             const Vector3f& rayDirection, float& depth) const
+{
+  Identifier result;
+  for (auto it = m_drawables.begin(); it != m_drawables.end(); ++it) {
+    if (!(*it)->isVisible())
+      continue;
+    Identifier closer = (*it)->hit(rayOrigin, rayEnd, rayDirection, depth);
+    if (closer.type != InvalidType)
+      result = closer;
+  }
+  return result;
+}
+
 Array<Identifier> GeometryNode::areaHits(const Frustrum& f) const
 {
   Array<Identifier> result;
@@ -101,6 +101,13 @@ public:
                                         const Vector3f& rayEnd,
                                         const Vector3f& rayDirection) const;
 
+  /**
+   * Return the closest primitive hit by the ray, if it is closer than
+   * @p depth, which is then lowered to its depth.
+   */
+  Identifier hit(const Vector3f& rayOrigin, const Vector3f& rayEnd,
+                 const Vector3f& rayDirection, float& depth) const;
+
   /**
    * Return the primitives within the supplied frustrum.
    */
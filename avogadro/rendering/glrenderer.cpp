@@ -30,6 +30,7 @@
 #include <avogadro/core/matrix.h>
 
 #include <iostream>
+#include <limits>
 
 namespace Avogadro {
 namespace Rendering {
@@ -232,6 +233,42 @@ std::multimap<float, Identifier> GLRenderer::hits(int x, int y) const
   return hits(&m_scene.rootNode(), origin, end, direction);
 }
 
+Identifier GLRenderer::hit(const GroupNode* group, const Vector3f& rayOrigin,
+                           const Vector3f& rayEnd, const Vector3f& rayDirection,
+                           float& depth) const
+{
+  Identifier result;
+  if (!group)
+    return result;
+
+  for (auto it = group->children().begin(); it != group->children().end();
+       ++it) {
+    Identifier closer;
+    const Node* itNode = it->node;
+    const GroupNode* childGroup = dynamic_cast<const GroupNode*>(itNode);
+    if (childGroup)
+      closer = hit(childGroup, rayOrigin, rayEnd, rayDirection, depth);
+    const GeometryNode* childGeometry = itNode->cast<GeometryNode>();
+    if (childGeometry)
+      closer = childGeometry->hit(rayOrigin, rayEnd, rayDirection, depth);
+    if (closer.type != InvalidType)
+      result = closer;
+  }
+  return result;
+}
+
+Identifier GLRenderer::hit(int x, int y) const
+{
+  const Vector3f origin(m_camera.unProject(
+    Vector3f(static_cast<float>(x), static_cast<float>(y), 0.f)));
+  const Vector3f end(m_camera.unProject(
+    Vector3f(static_cast<float>(x), static_cast<float>(y), 1.f)));
+  const Vector3f direction((end - origin).normalized());
+
+  float depth = std::numeric_limits<float>::infinity();
+  return hit(&m_scene.rootNode(), origin, end, direction, depth);
+}
+
 Array<Identifier> GLRenderer::hits(const GroupNode* group,
                                    const Frustrum& f) const
 {
@@ -129,6 +129,13 @@ private:
                                         const Vector3f& rayEnd,
                                         const Vector3f& rayDirection) const;
 
+  /**
+   * @brief Find the closest hit in a group node, closer than @p depth.
+   */
+  Identifier hit(const GroupNode* group, const Vector3f& rayOrigin,
+                 const Vector3f& rayEnd, const Vector3f& rayDirection,
+                 float& depth) const;
+
   Core::Array<Identifier> hits(const GroupNode* group,
                                const Frustrum& frustrum) const;
 
@@ -173,14 +180,6 @@ inline TextRenderStrategy* GLRenderer::textRenderStrategy()
   return m_textRenderStrategy;
 }
 
-inline Identifier GLRenderer::hit(int x, int y) const
-{
-  std::multimap<float, Identifier> results = hits(x, y);
-  if (results.size())
-    return results.begin()->second;
-  return Identifier();
-}
-
 } // End Rendering namespace
 } // End Avogadro namespace
 
@@ -28,6 +28,17 @@
 namespace Avogadro {
 namespace Rendering {
 
+namespace {
+// Whether some of the drawable may be in view, those that do not know their
+// bounds always are.
+bool inView(const Drawable& drawable, const Camera& camera)
+{
+  Eigen::AlignedBox3f box;
+  return !drawable.boundingBox(box) ||
+         (!box.isEmpty() && camera.isInView(box));
+}
+} // namespace
+
 GLRenderVisitor::GLRenderVisitor(const Camera& camera_,
                                  const TextRenderStrategy* trs)
   : m_camera(camera_), m_textRenderStrategy(trs), m_renderPass(NotRendering)
@@ -40,37 +51,37 @@ GLRenderVisitor::~GLRenderVisitor()
 
 void GLRenderVisitor::visit(Drawable& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (geometry.renderPass() == m_renderPass && inView(geometry, m_camera))
     geometry.render(m_camera);
 }
 
 void GLRenderVisitor::visit(SphereGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (geometry.renderPass() == m_renderPass && inView(geometry, m_camera))
     geometry.render(m_camera);
 }
 
 void GLRenderVisitor::visit(AmbientOcclusionSphereGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (geometry.renderPass() == m_renderPass && inView(geometry, m_camera))
     geometry.render(m_camera);
 }
 
 void GLRenderVisitor::visit(CurveGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (geometry.renderPass() == m_renderPass && inView(geometry, m_camera))
     geometry.render(m_camera);
 }
 
 void GLRenderVisitor::visit(CylinderGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (geometry.renderPass() == m_renderPass && inView(geometry, m_camera))
     geometry.render(m_camera);
 }
 
 void GLRenderVisitor::visit(MeshGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (geometry.renderPass() == m_renderPass && inView(geometry, m_camera))
     geometry.render(m_camera);
 }
 
@@ -94,7 +105,7 @@ void GLRenderVisitor::visit(TextLabel3D& geometry)
 
 void GLRenderVisitor::visit(LineStripGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (geometry.renderPass() == m_renderPass && inView(geometry, m_camera))
     geometry.render(m_camera);
 }
 
@@ -16,6 +16,7 @@
 #include <avogadro/core/matrix.h>
 #include <avogadro/core/vector.h>
 
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 #include <limits>
@@ -55,17 +56,21 @@ public:
 
   size_t numberOfVertices;
   size_t numberOfIndices;
+
+  // Consecutive triangles are culled together.
+  GeometryChunks chunks;
 };
 
 MeshGeometry::MeshGeometry()
-  : m_color(255, 0, 0), m_opacity(255), m_dirty(false), d(new Private)
+  : m_color(255, 0, 0), m_opacity(255), m_dirty(false),
+    m_chunksDirty(true), d(new Private)
 {}
 
 MeshGeometry::MeshGeometry(const MeshGeometry& other)
   : Drawable(other), m_vertices(other.m_vertices), m_indices(other.m_indices),
     m_color(other.m_color), m_opacity(other.m_opacity),
     m_dirty(true), // Force rendering internals to be rebuilt
-    d(new Private)
+    m_chunksDirty(true), d(new Private)
 {}
 
 MeshGeometry::~MeshGeometry()
@@ -128,6 +133,12 @@ void MeshGeometry::render(const Camera& camera)
   // Prepare the VBOs, IBOs and shader program if necessary.
   update();
 
+  // Only the chunks of triangles in view are drawn.
+  std::vector<GeometryChunks::Run> runs;
+  chunks().visibleRuns(camera, 0.0f, runs);
+  if (runs.empty())
+    return;
+
   ShaderProgram* program;
   // If the mesh is opaque, use the opaque shader
   if (m_opacity != 255)
@@ -175,11 +186,17 @@ void MeshGeometry::render(const Camera& camera)
   if (!program->setUniformValue("normalMatrix", normalMatrix))
     std::cout << program->error() << std::endl;
 
-  // Render the loaded spheres using the shader and bound VBO.
-  glDrawRangeElements(GL_TRIANGLES, 0,
-                      static_cast<GLuint>(d->numberOfVertices - 1),
-                      static_cast<GLsizei>(d->numberOfIndices), GL_UNSIGNED_INT,
-                      reinterpret_cast<const GLvoid*>(0));
+  // Render the loaded triangles using the shader and bound VBO.
+  const size_t count = d->numberOfIndices / 3;
+  for (const GeometryChunks::Run& run : runs) {
+    const size_t end = std::min(run.end, count);
+    if (run.begin >= end)
+      continue;
+    glDrawRangeElements(
+      GL_TRIANGLES, 0, static_cast<GLuint>(d->numberOfVertices - 1),
+      static_cast<GLsizei>(3 * (end - run.begin)), GL_UNSIGNED_INT,
+      reinterpret_cast<const GLvoid*>(3 * run.begin * sizeof(unsigned int)));
+  }
 
   d->vbo.release();
   d->ibo.release();
@@ -191,6 +208,29 @@ void MeshGeometry::render(const Camera& camera)
   program->release();
 }
 
+bool MeshGeometry::boundingBox(Eigen::AlignedBox3f& box) const
+{
+  box = chunks().box();
+  return true;
+}
+
+const GeometryChunks& MeshGeometry::chunks() const
+{
+  if (m_chunksDirty) {
+    d->chunks.build(m_indices.size() / 3, [this](size_t i) {
+      Eigen::AlignedBox3f box;
+      box.setEmpty();
+      for (size_t j = 3 * i; j < 3 * i + 3; ++j) {
+        if (m_indices[j] < m_vertices.size())
+          box.extend(m_vertices[m_indices[j]].vertex);
+      }
+      return box;
+    });
+    m_chunksDirty = false;
+  }
+  return d->chunks;
+}
+
 unsigned int MeshGeometry::addVertices(const Core::Array<Vector3f>& v,
                                        const Core::Array<Vector3f>& n,
                                        const Core::Array<Vector4ub>& c)
@@ -208,7 +248,7 @@ unsigned int MeshGeometry::addVertices(const Core::Array<Vector3f>& v,
   while (vIter != vEnd)
     m_vertices.push_back(PackedVertex(*(cIter++), *(nIter++), *(vIter++)));
 
-  m_dirty = true;
+  m_dirty = m_chunksDirty = true;
 
   return static_cast<unsigned int>(result);
 }
@@ -233,7 +273,7 @@ unsigned int MeshGeometry::addVertices(const Core::Array<Vector3f>& v,
     m_vertices.push_back(PackedVertex(tmpColor, *(nIter++), *(vIter++)));
   }
 
-  m_dirty = true;
+  m_dirty = m_chunksDirty = true;
 
   return static_cast<unsigned int>(result);
 }
@@ -254,7 +294,7 @@ unsigned int MeshGeometry::addVertices(const Core::Array<Vector3f>& v,
   while (vIter != vEnd)
     m_vertices.push_back(PackedVertex(tmpColor, *(nIter++), *(vIter++)));
 
-  m_dirty = true;
+  m_dirty = m_chunksDirty = true;
 
   return static_cast<unsigned int>(result);
 }
@@ -265,7 +305,7 @@ void MeshGeometry::addTriangle(unsigned int index1, unsigned int index2,
   m_indices.push_back(index1);
   m_indices.push_back(index2);
   m_indices.push_back(index3);
-  m_dirty = true;
+  m_dirty = m_chunksDirty = true;
 }
 
 void MeshGeometry::addTriangles(const Core::Array<unsigned int>& indiceArray)
@@ -273,14 +313,14 @@ void MeshGeometry::addTriangles(const Core::Array<unsigned int>& indiceArray)
   m_indices.reserve(m_indices.size() + indiceArray.size());
   std::copy(indiceArray.begin(), indiceArray.end(),
             std::back_inserter(m_indices));
-  m_dirty = true;
+  m_dirty = m_chunksDirty = true;
 }
 
 void MeshGeometry::clear()
 {
   m_vertices.clear();
   m_indices.clear();
-  m_dirty = true;
+  m_dirty = m_chunksDirty = true;
 }
 
 } // End namespace Rendering
@@ -7,6 +7,7 @@
 #define AVOGADRO_RENDERING_MESHGEOMETRY_H
 
 #include "drawable.h"
+#include "geometrychunks.h"
 
 #include <avogadro/core/array.h>
 
@@ -63,6 +64,11 @@ public:
    */
   void render(const Camera& camera) override;
 
+  /**
+   * Set @p box to the box around the triangles.
+   */
+  bool boundingBox(Eigen::AlignedBox3f& box) const override;
+
   /**
    * Add vertices to the object. Note that this just adds vertices to the
    * object. Use addTriangles with size_t indices to actually draw them.
@@ -144,12 +150,17 @@ private:
    */
   void update();
 
+  // The chunks of triangles culled when rendering, built again if they
+  // changed.
+  const GeometryChunks& chunks() const;
+
   Core::Array<PackedVertex> m_vertices;
   Core::Array<unsigned int> m_indices;
   Vector3ub m_color;
   unsigned char m_opacity;
 
   bool m_dirty;
+  mutable bool m_chunksDirty;
 
   class Private;
   Private* d;
@@ -171,6 +182,7 @@ inline void swap(MeshGeometry& lhs, MeshGeometry& rhs)
   swap(lhs.m_color, rhs.m_color);
   swap(lhs.m_opacity, rhs.m_opacity);
   lhs.m_dirty = rhs.m_dirty = true;
+  lhs.m_chunksDirty = rhs.m_chunksDirty = true;
 }
 
 } // End namespace Rendering
@@ -98,6 +98,57 @@ struct ColorNormalVertex
   }
 }; // 32 bytes total size - 16/32/64 are ideal for alignment.
 
+/// Pack the data of a sphere drawn as an instance of a shared quad.
+struct SphereInstance
+{
+  Vector3f center;           // 12 bytes
+  float radius;              //  4 bytes
+  Vector3ub color;           //  3 bytes
+  unsigned char unusedAlign; //  1 byte
+  SphereInstance(const Vector3f& p, float r, const Vector3ub& c)
+    : center(p), radius(r), color(c)
+  {}
+
+  static int centerOffset() { return 0; }
+  static int radiusOffset() { return static_cast<int>(sizeof(Vector3f)); }
+  static int colorOffset()
+  {
+    return radiusOffset() + static_cast<int>(sizeof(float));
+  }
+}; // 20 bytes total size.
+
+/// Pack the data of a cylinder drawn as an instance of a shared tube.
+struct CylinderInstance
+{
+  Vector3f end1;              // 12 bytes
+  Vector3f end2;              // 12 bytes
+  float radius;               //  4 bytes
+  Vector3ub color;            //  3 bytes
+  unsigned char unusedAlign;  //  1 byte
+  Vector3ub color2;           //  3 bytes
+  unsigned char unusedAlign2; //  1 byte
+  CylinderInstance(const Vector3f& p1, const Vector3f& p2, float r,
+                   const Vector3ub& c1, const Vector3ub& c2)
+    : end1(p1), end2(p2), radius(r), color(c1), color2(c2)
+  {}
+
+  static int end1Offset() { return 0; }
+  static int end2Offset() { return static_cast<int>(sizeof(Vector3f)); }
+  static int radiusOffset()
+  {
+    return end2Offset() + static_cast<int>(sizeof(Vector3f));
+  }
+  static int colorOffset()
+  {
+    return radiusOffset() + static_cast<int>(sizeof(float));
+  }
+  static int color2Offset()
+  {
+    return colorOffset() +
+           static_cast<int>(sizeof(Vector3ub) + sizeof(unsigned char));
+  }
+}; // 36 bytes total size.
+
 class AVOGADRORENDERING_EXPORT Scene
 {
 public:
@@ -277,6 +277,19 @@ bool ShaderProgram::useAttributeArray(const std::string& name, int offset,
   return true;
 }
 
+bool ShaderProgram::setAttributeArrayDivisor(const std::string& name,
+                                             unsigned int divisor)
+{
+  GLint location = static_cast<GLint>(findAttributeArray(name));
+  if (location == -1) {
+    m_error = "Could not set divisor of attribute " + name +
+              ". No such attribute.";
+    return false;
+  }
+  glVertexAttribDivisor(static_cast<GLuint>(location), divisor);
+  return true;
+}
+
 bool ShaderProgram::setTextureSampler(const std::string& name,
                                       const Texture2D& texture)
 {
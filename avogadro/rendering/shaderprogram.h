@@ -122,6 +122,14 @@ public:
                          Avogadro::Type elementType, int elementTupleSize,
                          NormalizeOption normalize);
 
+  /** Advance the named attribute array once every @p divisor instances of an
+   * instanced draw call instead of once per vertex, 0 restores the default.
+   * Needs OpenGL 3.3, and since the divisor outlives the program it must be
+   * reset once the instances are drawn.
+   * @return false if the attribute array does not exist.
+   */
+  bool setAttributeArrayDivisor(const std::string& name, unsigned int divisor);
+
   /** Upload the supplied array of tightly packed values to the named attribute.
    * BufferObject attributes should be preferred and this may be removed in
    * future.
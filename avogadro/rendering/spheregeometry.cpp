@@ -19,6 +19,7 @@
 #include "camera.h"
 #include "scene.h"
 
+#include "boundingvolumehierarchy.h"
 #include "bufferobject.h"
 
 #include "shader.h"
@@ -28,12 +29,15 @@
 
 namespace {
 #include "spheres_fs.h"
+#include "spheres_instanced_vs.h"
 #include "spheres_vs.h"
 } // namespace
 
 #include "avogadrogl.h"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 using std::cout;
 using std::endl;
@@ -43,13 +47,65 @@ namespace Rendering {
 
 using Core::Array;
 
+namespace {
+// Each sphere is drawn as a quad of four vertices.
+void addSphereVertices(const SphereColor& sphere,
+                       std::vector<ColorTextureVertex>& vertices)
+{
+  float r = sphere.radius;
+  ColorTextureVertex vert(sphere.center, sphere.color, Vector2f(-r, -r));
+  vertices.push_back(vert);
+  vert.textureCoord = Vector2f(-r, r);
+  vertices.push_back(vert);
+  vert.textureCoord = Vector2f(r, -r);
+  vertices.push_back(vert);
+  vert.textureCoord = Vector2f(r, r);
+  vertices.push_back(vert);
+}
+
+// The box around the sphere.
+Eigen::AlignedBox3f sphereBox(const SphereColor& sphere)
+{
+  const Vector3f extent(sphere.radius, sphere.radius, sphere.radius);
+  return Eigen::AlignedBox3f(sphere.center - extent, sphere.center + extent);
+}
+
+// Whether the ray hits the sphere between its origin and end, and where.
+bool sphereHit(const SphereColor& sphere, const Vector3f& rayOrigin,
+               const Vector3f& rayEnd, const Vector3f& rayDirection,
+               float& depth)
+{
+  Vector3f distance = sphere.center - rayOrigin;
+  float B = distance.dot(rayDirection);
+  float C = distance.dot(distance) - (sphere.radius * sphere.radius);
+  float D = B * B - C;
+
+  // Test for intersection
+  if (D < 0.0f)
+    return false;
+
+  // Test for clipping
+  if (B < 0.0f || (sphere.center - rayEnd).dot(rayDirection) > 0.0f)
+    return false;
+
+  float rootD = static_cast<float>(sqrt(D));
+  depth = std::min(std::abs(B + rootD), std::abs(B - rootD));
+  return true;
+}
+} // namespace
+
 class SphereGeometry::Private
 {
 public:
-  Private() {}
+  Private() : instanced(false), numberOfInstances(0) {}
 
+  // Either the four vertices of every sphere, or the corners of the quad
+  // drawn for each instance in the instances buffer.
   BufferObject vbo;
   BufferObject ibo;
+  BufferObject instances;
+  bool instanced;
+  size_t numberOfInstances;
 
   Shader vertexShader;
   Shader fragmentShader;
@@ -57,13 +113,23 @@ public:
 
   size_t numberOfVertices;
   size_t numberOfIndices;
+
+  // Picking is done through boxes around the spheres, built when needed.
+  BoundingVolumeHierarchy hitTree;
+
+  // Consecutive spheres are culled and given a level of detail together.
+  GeometryChunks chunks;
 };
 
-SphereGeometry::SphereGeometry() : m_dirty(false), d(new Private) {}
+SphereGeometry::SphereGeometry()
+  : m_dirty(false), m_dirtyBegin(0), m_dirtyEnd(0), m_hitTreeDirty(true),
+    m_chunksDirty(true), d(new Private)
+{}
 
 SphereGeometry::SphereGeometry(const SphereGeometry& other)
   : Drawable(other), m_spheres(other.m_spheres), m_indices(other.m_indices),
-    m_dirty(true), d(new Private)
+    m_dirty(true), m_dirtyBegin(0), m_dirtyEnd(0), m_hitTreeDirty(true),
+    m_chunksDirty(true), d(new Private)
 {}
 
 SphereGeometry::~SphereGeometry()
@@ -81,8 +147,52 @@ void SphereGeometry::update()
   if (m_indices.empty() || m_spheres.empty())
     return;
 
-  // Check if the VBOs are ready, if not get them ready.
-  if (!d->vbo.ready() || m_dirty) {
+  // Where the GL can draw instances, each sphere is one record and the quad
+  // is expanded in the vertex shader.
+  if (d->vertexShader.type() == Shader::Unknown)
+    d->instanced = GLEW_VERSION_3_3 != 0;
+
+  if (d->instanced) {
+    if (!d->instances.ready() || m_dirty) {
+      std::vector<SphereInstance> instances;
+      instances.reserve(m_spheres.size());
+      for (const SphereColor& sphere : m_spheres) {
+        instances.push_back(
+          SphereInstance(sphere.center, sphere.radius, sphere.color));
+      }
+      if (!d->instances.upload(instances, BufferObject::ArrayBuffer))
+        cout << d->instances.error() << endl;
+      d->numberOfInstances = instances.size();
+
+      if (!d->vbo.ready()) {
+        std::vector<Vector2f> corners;
+        corners.push_back(Vector2f(-1.0f, -1.0f));
+        corners.push_back(Vector2f(-1.0f, 1.0f));
+        corners.push_back(Vector2f(1.0f, -1.0f));
+        corners.push_back(Vector2f(1.0f, 1.0f));
+        std::vector<unsigned int> quadIndices = { 0, 1, 2, 3, 2, 1 };
+        if (!d->vbo.upload(corners, BufferObject::ArrayBuffer))
+          cout << d->vbo.error() << endl;
+        if (!d->ibo.upload(quadIndices, BufferObject::ElementArrayBuffer))
+          cout << d->ibo.error() << endl;
+        d->numberOfVertices = corners.size();
+        d->numberOfIndices = quadIndices.size();
+      }
+
+      m_dirty = false;
+    } else if (m_dirtyBegin < m_dirtyEnd) {
+      // Only the records of the moved spheres.
+      std::vector<SphereInstance> instances;
+      instances.reserve(m_dirtyEnd - m_dirtyBegin);
+      for (size_t i = m_dirtyBegin; i < m_dirtyEnd; ++i) {
+        const SphereColor& sphere = m_spheres[i];
+        instances.push_back(
+          SphereInstance(sphere.center, sphere.radius, sphere.color));
+      }
+      if (!d->instances.uploadRange(instances, m_dirtyBegin))
+        cout << d->instances.error() << endl;
+    }
+  } else if (!d->vbo.ready() || m_dirty) {
     std::vector<unsigned int> sphereIndices;
     std::vector<ColorTextureVertex> sphereVertices;
     sphereIndices.reserve(m_indices.size() * 4);
@@ -95,17 +205,8 @@ void SphereGeometry::update()
          itIndex != m_indices.end() && itSphere != m_spheres.end();
          ++i, ++itIndex, ++itSphere) {
       // Use our packed data structure...
-      float r = itSphere->radius;
       unsigned int index = 4 * static_cast<unsigned int>(i);
-      ColorTextureVertex vert(itSphere->center, itSphere->color,
-                              Vector2f(-r, -r));
-      sphereVertices.push_back(vert);
-      vert.textureCoord = Vector2f(-r, r);
-      sphereVertices.push_back(vert);
-      vert.textureCoord = Vector2f(r, -r);
-      sphereVertices.push_back(vert);
-      vert.textureCoord = Vector2f(r, r);
-      sphereVertices.push_back(vert);
+      addSphereVertices(*itSphere, sphereVertices);
 
       // 6 indexed vertices to draw a quad...
       sphereIndices.push_back(index + 0);
@@ -114,8 +215,6 @@ void SphereGeometry::update()
       sphereIndices.push_back(index + 3);
       sphereIndices.push_back(index + 2);
       sphereIndices.push_back(index + 1);
-
-      // m_spheres.push_back(Sphere(position, r, id, color));
     }
 
     if (!d->vbo.upload(sphereVertices, BufferObject::ArrayBuffer))
@@ -128,12 +227,22 @@ void SphereGeometry::update()
     d->numberOfIndices = sphereIndices.size();
 
     m_dirty = false;
+  } else if (m_dirtyBegin < m_dirtyEnd) {
+    // Only the moved spheres, the indices stay the same.
+    std::vector<ColorTextureVertex> sphereVertices;
+    sphereVertices.reserve((m_dirtyEnd - m_dirtyBegin) * 4);
+    for (size_t i = m_dirtyBegin; i < m_dirtyEnd; ++i)
+      addSphereVertices(m_spheres[i], sphereVertices);
+    if (!d->vbo.uploadRange(sphereVertices, 4 * m_dirtyBegin))
+      cout << d->vbo.error() << endl;
   }
+  m_dirtyBegin = m_dirtyEnd = 0;
 
   // Build and link the shader if it has not been used yet.
   if (d->vertexShader.type() == Shader::Unknown) {
     d->vertexShader.setType(Shader::Vertex);
-    d->vertexShader.setSource(spheres_vs);
+    d->vertexShader.setSource(d->instanced ? spheres_instanced_vs
+                                           : spheres_vs);
     d->fragmentShader.setType(Shader::Fragment);
     d->fragmentShader.setSource(spheres_fs);
     if (!d->vertexShader.compile())
@@ -160,9 +269,20 @@ void SphereGeometry::render(const Camera& camera)
   // Prepare the VBOs, IBOs and shader program if necessary.
   update();
 
+  // Only the chunks of spheres in view are drawn.
+  std::vector<GeometryChunks::Run> runs;
+  chunks().visibleRuns(camera, 0.0f, runs);
+  if (runs.empty())
+    return;
+
   if (!d->program.bind())
     cout << d->program.error() << endl;
 
+  if (d->instanced) {
+    renderInstances(camera, runs);
+    return;
+  }
+
   d->vbo.bind();
   d->ibo.bind();
 
@@ -200,10 +320,19 @@ void SphereGeometry::render(const Camera& camera)
     cout << d->program.error() << endl;
   }
 
-  // Render the loaded spheres using the shader and bound VBO.
-  glDrawRangeElements(GL_TRIANGLES, 0, static_cast<GLuint>(d->numberOfVertices),
-                      static_cast<GLsizei>(d->numberOfIndices), GL_UNSIGNED_INT,
-                      reinterpret_cast<const GLvoid*>(NULL));
+  // Render the loaded spheres using the shader and bound VBO, four vertices
+  // and six indices for each.
+  const size_t count = d->numberOfIndices / 6;
+  for (const GeometryChunks::Run& run : runs) {
+    const size_t end = std::min(run.end, count);
+    if (run.begin >= end)
+      continue;
+    glDrawRangeElements(
+      GL_TRIANGLES, static_cast<GLuint>(4 * run.begin),
+      static_cast<GLuint>(4 * end - 1),
+      static_cast<GLsizei>(6 * (end - run.begin)), GL_UNSIGNED_INT,
+      reinterpret_cast<const GLvoid*>(6 * run.begin * sizeof(unsigned int)));
+  }
 
   d->vbo.release();
   d->ibo.release();
@@ -215,47 +344,172 @@ void SphereGeometry::render(const Camera& camera)
   d->program.release();
 }
 
-std::multimap<float, Identifier> SphereGeometry::hits(
-  const Vector3f& rayOrigin, const Vector3f& rayEnd,
-  const Vector3f& rayDirection) const
+void SphereGeometry::renderInstances(
+  const Camera& camera, const std::vector<GeometryChunks::Run>& runs)
 {
-  std::multimap<float, Identifier> result;
+  // The corners of the quad advance per vertex, the records per instance.
+  d->vbo.bind();
+  if (!d->program.enableAttributeArray("corner"))
+    cout << d->program.error() << endl;
+  if (!d->program.useAttributeArray("corner", 0, sizeof(Vector2f), FloatType,
+                                    2, ShaderProgram::NoNormalize)) {
+    cout << d->program.error() << endl;
+  }
+  d->vbo.release();
 
-  // Check for intersection.
-  for (size_t i = 0; i < m_spheres.size(); ++i) {
-    const SphereColor& sphere = m_spheres[i];
+  const char* attributes[] = { "center", "sphereRadius", "color" };
+  const int offsets[] = { SphereInstance::centerOffset(),
+                          SphereInstance::radiusOffset(),
+                          SphereInstance::colorOffset() };
+  const Avogadro::Type types[] = { FloatType, FloatType, UCharType };
+  const int sizes[] = { 3, 1, 3 };
+  for (int i = 0; i < 3; ++i) {
+    if (!d->program.enableAttributeArray(attributes[i]))
+      cout << d->program.error() << endl;
+    d->program.setAttributeArrayDivisor(attributes[i], 1);
+  }
 
-    Vector3f distance = sphere.center - rayOrigin;
-    float B = distance.dot(rayDirection);
-    float C = distance.dot(distance) - (sphere.radius * sphere.radius);
-    float D = B * B - C;
+  // Set up our uniforms (model-view and projection matrices right now).
+  if (!d->program.setUniformValue("modelView", camera.modelView().matrix())) {
+    cout << d->program.error() << endl;
+  }
+  if (!d->program.setUniformValue("projection", camera.projection().matrix())) {
+    cout << d->program.error() << endl;
+  }
+  if (!d->program.setUniformValue("opacity", m_opacity)) {
+    cout << d->program.error() << endl;
+  }
 
-    // Test for intersection
-    if (D < 0.0f)
+  // Each run starts the records at its first sphere.
+  d->ibo.bind();
+  d->instances.bind();
+  for (const GeometryChunks::Run& run : runs) {
+    const size_t end = std::min(run.end, d->numberOfInstances);
+    if (run.begin >= end)
       continue;
+    const int base = static_cast<int>(run.begin * sizeof(SphereInstance));
+    for (int i = 0; i < 3; ++i) {
+      if (!d->program.useAttributeArray(
+            attributes[i], base + offsets[i], sizeof(SphereInstance),
+            types[i], sizes[i],
+            types[i] == UCharType ? ShaderProgram::Normalize
+                                  : ShaderProgram::NoNormalize)) {
+        cout << d->program.error() << endl;
+      }
+    }
+    glDrawElementsInstanced(GL_TRIANGLES,
+                            static_cast<GLsizei>(d->numberOfIndices),
+                            GL_UNSIGNED_INT, reinterpret_cast<const GLvoid*>(0),
+                            static_cast<GLsizei>(end - run.begin));
+  }
+  d->instances.release();
+  d->ibo.release();
 
-    // Test for clipping
-    if (B < 0.0f || (sphere.center - rayEnd).dot(rayDirection) > 0.0f)
-      continue;
+  for (int i = 0; i < 3; ++i) {
+    d->program.setAttributeArrayDivisor(attributes[i], 0);
+    d->program.disableAttributeArray(attributes[i]);
+  }
+  d->program.disableAttributeArray("corner");
 
-    Identifier id;
-    id.molecule = m_identifier.molecule;
-    id.type = m_identifier.type;
-    id.index = m_indices[i];
-    if (id.type != InvalidType) {
-      float rootD = static_cast<float>(sqrt(D));
-      float depth = std::min(std::abs(B + rootD), std::abs(B - rootD));
-      result.insert(std::pair<float, Identifier>(depth, id));
-    }
+  d->program.release();
+}
+
+const BoundingVolumeHierarchy& SphereGeometry::hitTree() const
+{
+  if (m_hitTreeDirty) {
+    std::vector<BoundingVolumeHierarchy::Box> boxes;
+    boxes.reserve(m_spheres.size());
+    for (const SphereColor& sphere : m_spheres)
+      boxes.push_back(sphereBox(sphere));
+    d->hitTree.build(boxes);
+    m_hitTreeDirty = false;
+  }
+  return d->hitTree;
+}
+
+const GeometryChunks& SphereGeometry::chunks() const
+{
+  if (m_chunksDirty) {
+    d->chunks.build(m_spheres.size(),
+                    [this](size_t i) { return sphereBox(m_spheres[i]); });
+    m_chunksDirty = false;
+  }
+  return d->chunks;
+}
+
+bool SphereGeometry::boundingBox(Eigen::AlignedBox3f& box) const
+{
+  box = chunks().box();
+  return true;
+}
+
+std::multimap<float, Identifier> SphereGeometry::hits(
+  const Vector3f& rayOrigin, const Vector3f& rayEnd,
+  const Vector3f& rayDirection) const
+{
+  std::multimap<float, Identifier> result;
+  if (m_identifier.type == InvalidType)
+    return result;
+
+  // Check for intersection with the spheres whose boxes are on the ray.
+  float maxDepth = std::numeric_limits<float>::infinity();
+  hitTree().intersect(rayOrigin, rayDirection, maxDepth,
+                      [&](size_t i, float&) {
+                        float depth;
+                        if (!sphereHit(m_spheres[i], rayOrigin, rayEnd,
+                                       rayDirection, depth)) {
+                          return;
+                        }
+                        Identifier id;
+                        id.molecule = m_identifier.molecule;
+                        id.type = m_identifier.type;
+                        id.index = m_indices[i];
+                        result.insert(std::make_pair(depth, id));
+                      });
+  return result;
+}
+
+Identifier SphereGeometry::hit(const Vector3f& rayOrigin,
+                               const Vector3f& rayEnd,
+                               const Vector3f& rayDirection,
+                               float& depth) const
+{
+  Identifier result;
+  if (m_identifier.type == InvalidType)
+    return result;
+
+  // The spheres nearest along the ray are tested first, the boxes behind
+  // the closest hit so far are skipped.
+  size_t closest = MaxIndex;
+  hitTree().intersect(rayOrigin, rayDirection, depth,
+                      [&](size_t i, float& maxDepth) {
+                        float sphereDepth;
+                        if (sphereHit(m_spheres[i], rayOrigin, rayEnd,
+                                      rayDirection, sphereDepth) &&
+                            (sphereDepth < maxDepth ||
+                             (sphereDepth == maxDepth && i < closest))) {
+                          maxDepth = sphereDepth;
+                          closest = i;
+                        }
+                      });
+  if (closest != MaxIndex) {
+    result.molecule = m_identifier.molecule;
+    result.type = m_identifier.type;
+    result.index = m_indices[closest];
   }
   return result;
 }
 
 Array<Identifier> SphereGeometry::areaHits(const Frustrum& f) const
 {
+  // The spheres whose boxes are at least partly inside the frustrum, in the
+  // order they were added.
+  std::vector<size_t> candidates;
+  hitTree().intersect(f, [&](size_t i) { candidates.push_back(i); });
+  std::sort(candidates.begin(), candidates.end());
+
   Array<Identifier> result;
-  // Check for intersection.
-  for (size_t i = 0; i < m_spheres.size(); ++i) {
+  for (size_t i : candidates) {
     const SphereColor& sphere = m_spheres[i];
 
     int in = 0;
@@ -282,14 +536,32 @@ void SphereGeometry::addSphere(const Vector3f& position, const Vector3ub& color,
                                float radius, size_t index)
 {
   m_dirty = true;
+  m_hitTreeDirty = m_chunksDirty = true;
   m_spheres.push_back(SphereColor(position, radius, color));
   m_indices.push_back(index == MaxIndex ? m_indices.size() : index);
 }
 
+void SphereGeometry::setSpherePosition(size_t sphere,
+                                       const Vector3f& position)
+{
+  if (sphere >= m_spheres.size())
+    return;
+  m_spheres[sphere].center = position;
+  m_hitTreeDirty = m_chunksDirty = true;
+  if (m_dirtyBegin == m_dirtyEnd) {
+    m_dirtyBegin = sphere;
+    m_dirtyEnd = sphere + 1;
+  } else {
+    m_dirtyBegin = std::min(m_dirtyBegin, sphere);
+    m_dirtyEnd = std::max(m_dirtyEnd, sphere + 1);
+  }
+}
+
 void SphereGeometry::clear()
 {
   m_spheres.clear();
   m_indices.clear();
+  m_hitTreeDirty = m_chunksDirty = true;
 }
 
 } // End namespace Rendering
@@ -18,6 +18,7 @@
 #define AVOGADRO_RENDERING_SPHEREGEOMETRY_H
 
 #include "drawable.h"
+#include "geometrychunks.h"
 
 #include <avogadro/core/array.h>
 #include <avogadro/core/vector.h>
@@ -25,6 +26,8 @@
 namespace Avogadro {
 namespace Rendering {
 
+class BoundingVolumeHierarchy;
+
 struct SphereColor
 {
   SphereColor(Vector3f centre, float r, Vector3ub c)
@@ -84,11 +87,23 @@ public:
     const Vector3f& rayOrigin, const Vector3f& rayEnd,
     const Vector3f& rayDirection) const override;
 
+  /**
+   * Return the closest primitive hit by the ray, if it is closer than
+   * @p depth.
+   */
+  Identifier hit(const Vector3f& rayOrigin, const Vector3f& rayEnd,
+                 const Vector3f& rayDirection, float& depth) const override;
+
   /**
    * Return the primitives within the supplied frustrum.
    */
   Core::Array<Identifier> areaHits(const Frustrum& f) const override;
 
+  /**
+   * Set @p box to the box around the spheres.
+   */
+  bool boundingBox(Eigen::AlignedBox3f& box) const override;
+
   /**
    * Set the opacity of the spheres in this group.
    */
@@ -105,10 +120,21 @@ public:
   void addSphere(const Vector3f& position, const Vector3ub& color, float radius,
                  size_t index = MaxIndex);
 
+  /**
+   * Move the sphere at @p sphere, counted in the order they were added, to
+   * @p position. Only the spheres moved since the last render are uploaded
+   * again.
+   */
+  void setSpherePosition(size_t sphere, const Vector3f& position);
+
   /**
    * Get a reference to the spheres.
    */
-  Core::Array<SphereColor>& spheres() { return m_spheres; }
+  Core::Array<SphereColor>& spheres()
+  {
+    m_hitTreeDirty = m_chunksDirty = true;
+    return m_spheres;
+  }
   const Core::Array<SphereColor>& spheres() const { return m_spheres; }
 
   /**
@@ -122,10 +148,28 @@ public:
   size_t size() const { return m_spheres.size(); }
 
 private:
+  // Draw the runs of spheres as instances of a shared quad, with the program
+  // bound.
+  void renderInstances(const Camera& camera,
+                       const std::vector<GeometryChunks::Run>& runs);
+
+  // The tree of boxes around the spheres, built again if they changed.
+  const BoundingVolumeHierarchy& hitTree() const;
+
+  // The chunks of spheres culled when rendering, built again if they changed.
+  const GeometryChunks& chunks() const;
+
   Core::Array<SphereColor> m_spheres;
   Core::Array<size_t> m_indices;
 
   bool m_dirty;
+  // The spheres moved since the last upload, from m_dirtyBegin to m_dirtyEnd.
+  size_t m_dirtyBegin;
+  size_t m_dirtyEnd;
+  // The spheres changed since the tree used for picking was built.
+  mutable bool m_hitTreeDirty;
+  // The spheres changed since the chunks culled when rendering were built.
+  mutable bool m_chunksDirty;
 
   float m_opacity = 1.0f;
 
@@ -147,6 +191,9 @@ inline void swap(SphereGeometry& lhs, SphereGeometry& rhs)
   swap(lhs.m_spheres, rhs.m_spheres);
   swap(lhs.m_indices, rhs.m_indices);
   lhs.m_dirty = rhs.m_dirty = true;
+  lhs.m_hitTreeDirty = rhs.m_hitTreeDirty = true;
+  lhs.m_chunksDirty = rhs.m_chunksDirty = true;
+  lhs.m_dirtyBegin = rhs.m_dirtyBegin = lhs.m_dirtyEnd = rhs.m_dirtyEnd = 0;
 }
 
 } // End namespace Rendering
@@ -0,0 +1,36 @@
+attribute vec2 corner;
+attribute vec3 center;
+attribute float sphereRadius;
+attribute vec3 color;
+varying vec2 v_texCoord;
+varying vec3 fColor;
+varying vec4 eyePosition;
+varying float radius;
+
+uniform mat4 modelView;
+uniform mat4 projection;
+
+// The same impostor as spheres_vs, but the quad is shared by all spheres and
+// each instance only provides its center, radius and color.
+void main()
+{
+  radius = sphereRadius;
+  fColor = color;
+  v_texCoord = corner;
+  gl_Position = modelView * vec4(center, 1.0);
+  eyePosition = gl_Position;
+
+  // Test if the closest point on the sphere would be clipped.
+  vec4 clipTestNear = eyePosition;
+  clipTestNear.z += radius;
+  clipTestNear = projection * clipTestNear;
+  if (clipTestNear.z > -clipTestNear.w) {
+    // If not, calculate clip coordinate
+    gl_Position.xy += corner * radius;
+    gl_Position = projection * gl_Position;
+  }
+  else {
+    // If so, invalidate the clip coordinate to ensure that it will be clipped.
+    gl_Position.w = 0.0;
+  }
+}
@@ -0,0 +1,124 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/bondperceiver.h>
+#include <avogadro/core/vector.h>
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::BondPerceiver;
+
+namespace {
+
+// Two water molecules, one above the other.
+void water(Array<Vector3>& positions, Array<unsigned char>& numbers)
+{
+  for (int i = 0; i < 2; ++i) {
+    double z = 3.0 * i;
+    positions.push_back(Vector3(0.0, 0.0, z));
+    positions.push_back(Vector3(0.6, -0.5, z));
+    positions.push_back(Vector3(-0.6, -0.5, z));
+    numbers.push_back(8);
+    numbers.push_back(1);
+    numbers.push_back(1);
+  }
+}
+
+} // namespace
+
+TEST(BondPerceiverTest, perceive)
+{
+  Array<Vector3> positions;
+  Array<unsigned char> numbers;
+  water(positions, numbers);
+
+  BondPerceiver perceiver;
+  Array<std::pair<Index, Index>> bonds;
+  ASSERT_TRUE(perceiver.perceive(positions, numbers, bonds));
+  ASSERT_EQ(bonds.size(), static_cast<size_t>(4));
+  EXPECT_EQ(bonds[0], std::make_pair(Index(0), Index(1)));
+  EXPECT_EQ(bonds[1], std::make_pair(Index(0), Index(2)));
+  EXPECT_EQ(bonds[2], std::make_pair(Index(3), Index(4)));
+  EXPECT_EQ(bonds[3], std::make_pair(Index(3), Index(5)));
+
+  // Only the masked atoms are bonded, keeping their indices
+  std::vector<bool> mask = { false, false, true, true, false, true };
+  perceiver.setAtomMask(mask);
+  ASSERT_TRUE(perceiver.perceive(positions, numbers, bonds));
+  ASSERT_EQ(bonds.size(), static_cast<size_t>(1));
+  EXPECT_EQ(bonds[0], std::make_pair(Index(3), Index(5)));
+}
+
+TEST(BondPerceiverTest, progress)
+{
+  Array<Vector3> positions;
+  Array<unsigned char> numbers;
+  water(positions, numbers);
+
+  BondPerceiver perceiver;
+  std::atomic<int> calls(0);
+  std::atomic<int> blocks(0);
+  perceiver.setProgressFunction([&](int done, int total) {
+    ++calls;
+    blocks = total;
+    EXPECT_LE(done, total);
+    return true;
+  });
+  Array<std::pair<Index, Index>> bonds;
+  ASSERT_TRUE(perceiver.perceive(positions, numbers, bonds));
+  EXPECT_EQ(calls.load(), blocks.load());
+  EXPECT_EQ(bonds.size(), static_cast<size_t>(4));
+
+  perceiver.setProgressFunction([](int, int) { return false; });
+  EXPECT_FALSE(perceiver.perceive(positions, numbers, bonds));
+  EXPECT_TRUE(bonds.empty());
+}
+
+TEST(BondPerceiverTest, perceiveFrame)
+{
+  Array<Vector3> positions;
+  Array<unsigned char> numbers;
+  water(positions, numbers);
+
+  BondPerceiver perceiver;
+  int searches = 0;
+  perceiver.setProgressFunction([&searches](int done, int total) {
+    if (done == total)
+      ++searches;
+    return true;
+  });
+
+  // Each frame gives the bonds of perceive(), but the candidates are only
+  // searched again once an atom moved more than half the skin
+  Array<std::pair<Index, Index>> bonds;
+  Array<std::pair<Index, Index>> expected;
+  ASSERT_TRUE(perceiver.perceiveFrame(positions, numbers, bonds));
+  ASSERT_TRUE(perceiver.perceive(positions, numbers, expected));
+  EXPECT_EQ(searches, 2);
+  EXPECT_EQ(bonds, expected);
+
+  positions[1] += Vector3(0.2, 0.0, 0.0);
+  ASSERT_TRUE(perceiver.perceiveFrame(positions, numbers, bonds));
+  EXPECT_EQ(searches, 2);
+  EXPECT_EQ(bonds, expected);
+
+  // the second molecule comes close enough for the oxygens to bond
+  for (Index i = 3; i < 6; ++i)
+    positions[i] -= Vector3(0.0, 0.0, 1.8);
+  ASSERT_TRUE(perceiver.perceiveFrame(positions, numbers, bonds));
+  ASSERT_TRUE(perceiver.perceive(positions, numbers, expected));
+  EXPECT_EQ(searches, 4);
+  EXPECT_EQ(bonds, expected);
+  EXPECT_EQ(bonds.size(), static_cast<size_t>(5));
+  EXPECT_EQ(bonds[2], std::make_pair(Index(0), Index(3)));
+}
@@ -0,0 +1,126 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/cube.h>
+#include <avogadro/core/edtsurface.h>
+#include <avogadro/core/elements.h>
+#include <avogadro/core/molecule.h>
+
+#include <cmath>
+
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::Cube;
+using Avogadro::Core::EDTSurface;
+using Avogadro::Core::Elements;
+using Avogadro::Core::Molecule;
+
+namespace {
+
+double sphereVolume(double r)
+{
+  return 4.0 / 3.0 * M_PI * r * r * r;
+}
+
+double sphereArea(double r)
+{
+  return 4.0 * M_PI * r * r;
+}
+
+} // namespace
+
+TEST(EDTSurfaceTest, singleAtom)
+{
+  Molecule mol;
+  mol.addAtom(6).setPosition3d(Vector3(0.5, -0.2, 0.1));
+  const double r = Elements::radiusVDW(6);
+
+  EDTSurface edt;
+  Cube cube;
+  ASSERT_TRUE(edt.calculateCube(mol, cube, EDTSurface::VanDerWaals, 0.1));
+  EXPECT_NEAR(cube.value(Vector3(0.5, -0.2, 0.1)), -r, 0.1);
+  EXPECT_NEAR(cube.value(Vector3(0.5, -0.2 + r + 0.1, 0.1)), 0.1, 0.01);
+  EXPECT_NEAR(EDTSurface::volume(cube), sphereVolume(r),
+              0.01 * sphereVolume(r));
+  EXPECT_NEAR(EDTSurface::surfaceArea(cube), sphereArea(r),
+              0.01 * sphereArea(r));
+
+  // The accessible surface is inflated by the probe
+  const double probe = edt.probeRadius();
+  ASSERT_TRUE(edt.calculateCube(mol, cube, EDTSurface::SolventAccessible, 0.1));
+  EXPECT_NEAR(EDTSurface::volume(cube), sphereVolume(r + probe),
+              0.01 * sphereVolume(r + probe));
+  EXPECT_NEAR(EDTSurface::surfaceArea(cube), sphereArea(r + probe),
+              0.01 * sphereArea(r + probe));
+
+  // The probe touches all of a single sphere, so the excluded surface matches
+  // the van der Waals surface
+  ASSERT_TRUE(edt.calculateCube(mol, cube, EDTSurface::SolventExcluded, 0.1));
+  EXPECT_NEAR(EDTSurface::volume(cube), sphereVolume(r),
+              0.02 * sphereVolume(r));
+  EXPECT_NEAR(EDTSurface::surfaceArea(cube), sphereArea(r),
+              0.02 * sphereArea(r));
+}
+
+TEST(EDTSurfaceTest, excludedSurface)
+{
+  Array<Vector3> positions;
+  positions.push_back(Vector3(-1.0, 0.0, 0.0));
+  positions.push_back(Vector3(1.0, 0.0, 0.0));
+  positions.push_back(Vector3(0.0, 1.8, 0.0));
+  std::vector<double> radii(3, 1.5);
+
+  EDTSurface edt;
+  Cube vdw;
+  Cube sas;
+  Cube ses;
+  ASSERT_TRUE(
+    edt.calculateCube(positions, radii, vdw, EDTSurface::VanDerWaals, 0.15));
+  ASSERT_TRUE(edt.calculateCube(positions, radii, sas,
+                                EDTSurface::SolventAccessible, 0.15));
+  ASSERT_TRUE(
+    edt.calculateCube(positions, radii, ses, EDTSurface::SolventExcluded, 0.15));
+
+  // The probe cannot reach into the crevices between the atoms
+  double vdwVolume = EDTSurface::volume(vdw);
+  double sesVolume = EDTSurface::volume(ses);
+  EXPECT_GT(sesVolume, vdwVolume + 0.5);
+  EXPECT_LT(sesVolume, EDTSurface::volume(sas));
+  EXPECT_LT(EDTSurface::surfaceArea(ses), EDTSurface::surfaceArea(vdw));
+
+  // The center of the triangle is buried
+  EXPECT_GT(vdw.value(Vector3(0.0, 0.6, 0.0)), -1.0);
+  EXPECT_LT(ses.value(Vector3(0.0, 0.6, 1.1)), 0.0);
+  EXPECT_GT(vdw.value(Vector3(0.0, 0.6, 1.1)), 0.0);
+}
+
+TEST(EDTSurfaceTest, threads)
+{
+  Array<Vector3> positions;
+  std::vector<double> radii;
+  for (int i = 0; i < 40; ++i) {
+    positions.push_back(Vector3(std::sin(1.3 * i) * 4.0,
+                                std::cos(0.7 * i) * 3.0, 0.25 * i - 5.0));
+    radii.push_back(1.2 + 0.1 * (i % 5));
+  }
+
+  EDTSurface edt;
+  Cube single;
+  Cube multiple;
+  edt.setThreadCount(1);
+  ASSERT_TRUE(edt.calculateCube(positions, radii, single,
+                                EDTSurface::SolventExcluded, 0.3));
+  edt.setThreadCount(4);
+  ASSERT_TRUE(edt.calculateCube(positions, radii, multiple,
+                                EDTSurface::SolventExcluded, 0.3));
+  EXPECT_TRUE(*single.data() == *multiple.data());
+
+  // Invalid input is rejected
+  radii.pop_back();
+  EXPECT_FALSE(edt.calculateCube(positions, radii, single,
+                                 EDTSurface::VanDerWaals, 0.3));
+}
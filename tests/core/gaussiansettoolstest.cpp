@@ -0,0 +1,141 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/cube.h>
+#include <avogadro/core/gaussianset.h>
+#include <avogadro/core/gaussiansettools.h>
+#include <avogadro/core/molecule.h>
+
+#include <algorithm>
+#include <cmath>
+
+using Avogadro::MatrixX;
+using Avogadro::Vector3;
+using Avogadro::Vector3i;
+using Avogadro::Core::Cube;
+using Avogadro::Core::GaussianSet;
+using Avogadro::Core::GaussianSetTools;
+using Avogadro::Core::Molecule;
+
+namespace {
+
+// Set up a small molecule with one shell of each supported type, and
+// arbitrary (but fixed) MO coefficients and density matrix.
+void setUpMolecule(Molecule& mol)
+{
+  mol.addAtom(8).setPosition3d(Vector3(0.0, 0.0, 0.0));
+  mol.addAtom(1).setPosition3d(Vector3(0.76, 0.59, 0.0));
+  mol.addAtom(1).setPosition3d(Vector3(-0.76, 0.59, 0.3));
+
+  GaussianSet* basis = new GaussianSet;
+  const GaussianSet::orbital types[] = { GaussianSet::S,  GaussianSet::P,
+                                         GaussianSet::D,  GaussianSet::D5,
+                                         GaussianSet::F,  GaussianSet::F7 };
+  for (unsigned int atom = 0; atom < 3; ++atom) {
+    for (int i = 0; i < 6; ++i) {
+      unsigned int shell = basis->addBasis(atom, types[i]);
+      basis->addGto(shell, 0.4, 5.0 + atom + i);
+      basis->addGto(shell, 0.6, 0.8 + 0.1 * i);
+      basis->addGto(shell, 0.3, 0.15 + 0.05 * atom);
+    }
+  }
+
+  // 3 atoms * (1 + 3 + 6 + 5 + 10 + 7) functions
+  const unsigned int functions = 96;
+  const unsigned int orbitals = 4;
+  std::vector<double> mos(functions * orbitals);
+  for (size_t i = 0; i < mos.size(); ++i)
+    mos[i] = std::sin(0.37 * i + 0.1);
+  basis->setMolecularOrbitals(mos);
+
+  MatrixX density(functions, functions);
+  for (unsigned int i = 0; i < functions; ++i)
+    for (unsigned int j = 0; j <= i; ++j)
+      density(i, j) = density(j, i) = std::cos(0.11 * i + 0.23 * j) / (i + 1);
+  basis->setDensityMatrix(density);
+
+  mol.setBasisSet(basis);
+}
+
+} // namespace
+
+TEST(GaussianSetToolsTest, molecularOrbitalCube)
+{
+  Molecule mol;
+  setUpMolecule(mol);
+  GaussianSetTools tools(&mol);
+  ASSERT_TRUE(tools.isValid());
+
+  Cube cube;
+  cube.setLimits(Vector3(-3.0, -3.0, -3.0), Vector3(3.0, 3.5, 3.0),
+                 Vector3i(13, 17, 11));
+
+  // With no cutoff the blocked values match the point by point ones
+  tools.setCutoff(0.0);
+  ASSERT_TRUE(tools.calculateMolecularOrbital(cube, 2));
+  double minValue = cube.data()->at(0);
+  double maxValue = minValue;
+  for (unsigned int i = 0; i < cube.data()->size(); ++i) {
+    double value = tools.calculateMolecularOrbital(cube.position(i), 2);
+    EXPECT_NEAR(cube.data()->at(i), value, 1e-12);
+    minValue = std::min(minValue, value);
+    maxValue = std::max(maxValue, value);
+  }
+  EXPECT_NEAR(cube.minValue(), minValue, 1e-12);
+  EXPECT_NEAR(cube.maxValue(), maxValue, 1e-12);
+
+  // Screening primitives should only make negligible differences
+  tools.setCutoff(1e-10);
+  ASSERT_TRUE(tools.calculateMolecularOrbital(cube, 2));
+  for (unsigned int i = 0; i < cube.data()->size(); ++i) {
+    double value = tools.calculateMolecularOrbital(cube.position(i), 2);
+    EXPECT_NEAR(cube.data()->at(i), value, 1e-8);
+  }
+
+  // Out of range orbitals are rejected
+  EXPECT_FALSE(tools.calculateMolecularOrbital(cube, 4));
+  EXPECT_FALSE(tools.calculateMolecularOrbital(cube, -1));
+}
+
+TEST(GaussianSetToolsTest, electronDensityCube)
+{
+  Molecule mol;
+  setUpMolecule(mol);
+  GaussianSetTools tools(&mol);
+
+  Cube cube;
+  cube.setLimits(Vector3(-3.0, -3.0, -3.0), Vector3(3.0, 3.5, 3.0),
+                 Vector3i(11, 9, 15));
+  ASSERT_TRUE(tools.calculateElectronDensity(cube));
+  for (unsigned int i = 0; i < cube.data()->size(); ++i) {
+    double value = tools.calculateElectronDensity(cube.position(i));
+    EXPECT_NEAR(cube.data()->at(i), value, 1e-8);
+  }
+}
+
+TEST(GaussianSetToolsTest, cubeRange)
+{
+  Molecule mol;
+  setUpMolecule(mol);
+  GaussianSetTools tools(&mol);
+
+  Cube cube;
+  cube.setLimits(Vector3(-2.0, -2.0, -2.0), Vector3(2.0, 2.0, 2.0),
+                 Vector3i(10, 10, 10));
+  Cube ranges;
+  ranges.setLimits(cube);
+
+  // Calculating the cube in uneven ranges gives the same values
+  ASSERT_TRUE(tools.calculateMolecularOrbital(cube, 1));
+  size_t size = ranges.data()->size();
+  for (size_t first = 0; first < size; first += 333) {
+    ASSERT_TRUE(tools.calculateMolecularOrbital(ranges, 1, first,
+                                                std::min(first + 333, size)));
+  }
+  for (size_t i = 0; i < size; ++i)
+    EXPECT_NEAR(cube.data()->at(i), ranges.data()->at(i), 1e-9);
+}
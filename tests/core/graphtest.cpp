@@ -115,6 +115,24 @@ TEST(GraphTest, addEdge)
   EXPECT_EQ(graph.containsEdge(1, 4), true);
 }
 
+TEST(GraphTest, addEdges)
+{
+  Graph graph(5);
+  graph.addEdge(0, 1);
+
+  Avogadro::Core::Array<std::pair<size_t, size_t>> edges;
+  edges.push_back(std::make_pair(size_t(3), size_t(1)));
+  edges.push_back(std::make_pair(size_t(3), size_t(4)));
+  EXPECT_EQ(graph.addEdges(edges), static_cast<size_t>(1));
+  EXPECT_EQ(graph.edgeCount(), static_cast<size_t>(3));
+  EXPECT_TRUE(graph.containsEdge(1, 3));
+  EXPECT_TRUE(graph.containsEdge(4, 3));
+  EXPECT_EQ(graph.endpoints(1), std::make_pair(size_t(1), size_t(3)));
+  EXPECT_EQ(graph.degree(3), static_cast<size_t>(2));
+  EXPECT_EQ(graph.subgraphCount(0), static_cast<size_t>(4));
+  EXPECT_EQ(graph.subgraphCount(2), static_cast<size_t>(1));
+}
+
 TEST(GraphTest, removeEdge)
 {
   Graph graph(5);
@@ -168,3 +186,53 @@ TEST(GraphTest, connectedComponents)
   graph.removeEdges(4);
   EXPECT_EQ(graph.connectedComponents().size(), static_cast<size_t>(4));
 }
+
+TEST(GraphTest, subgraphView)
+{
+  // Two chains 0-1-2-3 and 4-5, and a lone vertex 6
+  Graph graph(7);
+  graph.addEdge(0, 1);
+  graph.addEdge(1, 2);
+  graph.addEdge(2, 3);
+  graph.addEdge(4, 5);
+  ASSERT_EQ(graph.subgraphsCount(), static_cast<size_t>(3));
+  EXPECT_EQ(graph.subgraph(3), static_cast<size_t>(0));
+  EXPECT_EQ(graph.subgraph(5), static_cast<size_t>(1));
+  EXPECT_EQ(graph.subgraph(6), static_cast<size_t>(2));
+
+  Graph::IndexView chain = graph.connectedComponentView(2);
+  ASSERT_EQ(chain.size(), static_cast<size_t>(4));
+  for (size_t i = 0; i < chain.size(); ++i)
+    EXPECT_EQ(chain[i], i);
+  EXPECT_EQ(graph.subgraphCount(4), static_cast<size_t>(2));
+
+  // Breaking the chain only splits its own component
+  graph.removeEdge(1, 2);
+  ASSERT_EQ(graph.subgraphsCount(), static_cast<size_t>(4));
+  EXPECT_EQ(graph.subgraphCount(0), static_cast<size_t>(2));
+  EXPECT_EQ(graph.subgraphCount(3), static_cast<size_t>(2));
+  EXPECT_NE(graph.subgraph(1), graph.subgraph(2));
+  EXPECT_EQ(graph.subgraph(4), graph.subgraph(5));
+
+  // Joining after a split
+  graph.addEdge(3, 4);
+  graph.addEdge(6, 0);
+  ASSERT_EQ(graph.subgraphsCount(), static_cast<size_t>(2));
+  Graph::IndexView first = graph.subgraphView(0);
+  std::vector<size_t> members(first.begin(), first.end());
+  EXPECT_EQ(members, std::vector<size_t>({ 0, 1, 6 }));
+  EXPECT_EQ(graph.connectedComponent(5), std::set<size_t>({ 2, 3, 4, 5 }));
+
+  // Removing a vertex moves the last one, 6, into its place
+  graph.removeVertex(1);
+  ASSERT_EQ(graph.size(), static_cast<size_t>(6));
+  EXPECT_EQ(graph.subgraphsCount(), static_cast<size_t>(2));
+  EXPECT_EQ(graph.subgraph(1), graph.subgraph(0));
+  EXPECT_EQ(graph.subgraphCount(0), static_cast<size_t>(2));
+  EXPECT_EQ(graph.subgraphCount(4), static_cast<size_t>(4));
+
+  graph.setSize(8);
+  EXPECT_EQ(graph.subgraphsCount(), static_cast<size_t>(4));
+  graph.removeEdges();
+  EXPECT_EQ(graph.subgraphsCount(), static_cast<size_t>(8));
+}
@@ -56,6 +56,7 @@ MeshTest::MeshTest()
   m_testMesh.setIsoValue(1.2f);
   m_testMesh.setName("testmesh");
   m_testMesh.setOtherMesh(1);
+  m_testMesh.setTriangles(Array<unsigned int>(3, 0u));
 }
 
 void MeshTest::assertEquals(const Mesh& m1, const Mesh& m2)
@@ -80,6 +81,7 @@ void MeshTest::assertEquals(const Mesh& m1, const Mesh& m2)
     ++i;
   }
   EXPECT_TRUE(m1.normals() == m2.normals());
+  EXPECT_TRUE(m1.triangles() == m2.triangles());
 }
 
 TEST_F(MeshTest, copy)
@@ -97,3 +99,36 @@ TEST_F(MeshTest, assigment)
   assertEquals(m_testMesh, assign);
   EXPECT_NE(m_testMesh.lock(), assign.lock());
 }
+
+TEST_F(MeshTest, triangles)
+{
+  Mesh mesh;
+  Array<Vector3f> vertices;
+  vertices.push_back(Vector3f(0.0f, 0.0f, 0.0f));
+  vertices.push_back(Vector3f(1.0f, 0.0f, 0.0f));
+  vertices.push_back(Vector3f(0.0f, 1.0f, 0.0f));
+  vertices.push_back(Vector3f(1.0f, 1.0f, 0.0f));
+  mesh.setVertices(vertices);
+  mesh.setNormals(Array<Vector3f>(4, Vector3f(0.0f, 0.0f, 1.0f)));
+  mesh.setColors(Array<Color3f>(1, Color3f(255, 0, 0)));
+
+  Array<unsigned int> triangles;
+  triangles.push_back(0);
+  triangles.push_back(1);
+  triangles.push_back(2);
+  triangles.push_back(2);
+  triangles.push_back(1);
+  triangles.push_back(3);
+  EXPECT_TRUE(mesh.setTriangles(triangles));
+  EXPECT_EQ(mesh.numTriangles(), 2u);
+  EXPECT_TRUE(mesh.valid());
+
+  // Partial triangles are rejected
+  triangles.push_back(0);
+  EXPECT_FALSE(mesh.setTriangles(triangles));
+  EXPECT_EQ(mesh.triangles().size(), 6u);
+
+  mesh.clear();
+  EXPECT_TRUE(mesh.triangles().empty());
+  EXPECT_EQ(mesh.numTriangles(), 0u);
+}
@@ -22,6 +22,7 @@
 #include <avogadro/core/color3f.h>
 #include <avogadro/core/mesh.h>
 #include <avogadro/core/molecule.h>
+#include <avogadro/core/unitcell.h>
 #include <avogadro/core/vector.h>
 
 using Avogadro::Index;
@@ -34,6 +35,7 @@ using Avogadro::Core::Bond;
 using Avogadro::Core::Color3f;
 using Avogadro::Core::Mesh;
 using Avogadro::Core::Molecule;
+using Avogadro::Core::UnitCell;
 using Avogadro::Core::Variant;
 using Avogadro::Core::VariantMap;
 
@@ -177,6 +179,54 @@ TEST_F(MoleculeTest, addBond)
   EXPECT_EQ(bond.atom2().index(), c.index());
 }
 
+TEST_F(MoleculeTest, addBonds)
+{
+  Molecule molecule;
+  for (int i = 0; i < 4; ++i)
+    molecule.addAtom(6);
+
+  Array<std::pair<Index, Index>> bonds;
+  bonds.push_back(std::make_pair(Index(1), Index(0)));
+  bonds.push_back(std::make_pair(Index(1), Index(2)));
+  molecule.addBonds(bonds, Array<unsigned char>(2, 1));
+  EXPECT_EQ(molecule.bondCount(), static_cast<Index>(2));
+  EXPECT_EQ(molecule.bond(0, 1).index(), static_cast<Index>(0));
+  EXPECT_EQ(molecule.bond(2, 1).index(), static_cast<Index>(1));
+  EXPECT_EQ(molecule.bond(0).atom1().index(), static_cast<Index>(0));
+
+  // An existing bond only gets the new order, new ones are appended
+  bonds.clear();
+  bonds.push_back(std::make_pair(Index(2), Index(1)));
+  bonds.push_back(std::make_pair(Index(2), Index(3)));
+  Array<unsigned char> orders;
+  orders.push_back(2);
+  orders.push_back(3);
+  molecule.addBonds(bonds, orders);
+  EXPECT_EQ(molecule.bondCount(), static_cast<Index>(3));
+  EXPECT_EQ(molecule.bond(1, 2).order(), static_cast<unsigned char>(2));
+  EXPECT_EQ(molecule.bond(2, 3).index(), static_cast<Index>(2));
+  EXPECT_EQ(molecule.bond(2, 3).order(), static_cast<unsigned char>(3));
+  EXPECT_EQ(molecule.bonds(2).size(), static_cast<size_t>(2));
+
+  // Repeated pairs keep the last order, invalid pairs are skipped
+  Molecule empty;
+  for (int i = 0; i < 3; ++i)
+    empty.addAtom(6);
+  bonds.clear();
+  bonds.push_back(std::make_pair(Index(0), Index(1)));
+  bonds.push_back(std::make_pair(Index(1), Index(1)));
+  bonds.push_back(std::make_pair(Index(1), Index(0)));
+  bonds.push_back(std::make_pair(Index(2), Index(3)));
+  orders.clear();
+  orders.push_back(1);
+  orders.push_back(1);
+  orders.push_back(2);
+  orders.push_back(1);
+  empty.addBonds(bonds, orders);
+  EXPECT_EQ(empty.bondCount(), static_cast<Index>(1));
+  EXPECT_EQ(empty.bond(0, 1).order(), static_cast<unsigned char>(2));
+}
+
 TEST_F(MoleculeTest, removeBond)
 {
   Molecule molecule;
@@ -268,6 +318,34 @@ TEST_F(MoleculeTest, perceiveBondsSimple)
   EXPECT_FALSE(molecule.bond(h2, h3).isValid());
 }
 
+TEST_F(MoleculeTest, perceiveBondsPeriodic)
+{
+  // A chain of carbons along x, the last one bonded to the first through the
+  // boundary of the unit cell
+  Molecule molecule;
+  for (int i = 0; i < 4; ++i)
+    molecule.addAtom(6).setPosition3d(Vector3(0.25 + 1.5 * i, 1.0, 1.0));
+  molecule.setUnitCell(new UnitCell(Vector3(6.0, 0.0, 0.0),
+                                    Vector3(0.0, 6.0, 0.0),
+                                    Vector3(0.0, 0.0, 6.0)));
+
+  molecule.perceiveBondsSimple();
+  EXPECT_EQ(molecule.bondCount(), 3);
+  EXPECT_FALSE(molecule.bond(0, 3).isValid());
+
+  molecule.clearBonds();
+  molecule.perceiveBondsSimple(0.45, 0.32, true);
+  EXPECT_EQ(molecule.bondCount(), 4);
+  EXPECT_TRUE(molecule.bond(0, 3).isValid());
+
+  // The bonds are sorted, whatever order the pairs were found in
+  for (Index i = 1; i < molecule.bondCount(); ++i) {
+    std::pair<Index, Index> previous = molecule.bondPair(i - 1);
+    std::pair<Index, Index> current = molecule.bondPair(i);
+    EXPECT_LT(previous, current);
+  }
+}
+
 TEST_F(MoleculeTest, copy)
 {
   Molecule copy(m_testMolecule);
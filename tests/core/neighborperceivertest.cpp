@@ -7,10 +7,19 @@
 
 #include <avogadro/core/array.h>
 #include <avogadro/core/neighborperceiver.h>
+#include <avogadro/core/unitcell.h>
 #include <avogadro/core/vector.h>
 
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <utility>
+#include <vector>
+
+using Avogadro::Index;
 using Avogadro::Core::Array;
 using Avogadro::Core::NeighborPerceiver;
+using Avogadro::Core::UnitCell;
 using Avogadro::Vector3;
 
 TEST(NeighborPerceiverTest, positive)
@@ -59,3 +68,112 @@ TEST(NeighborPerceiverTest, bounds)
   perceiver.getNeighborsInclusiveInPlace(neighbors, Vector3(-1.5, 0.0, 0.0));
   EXPECT_EQ(neighbors.size(), static_cast<size_t>(0));
 }
+
+namespace {
+
+// Points on a jittered grid, so that there are many pairs near the cutoff.
+Array<Vector3> jitteredGrid(int size, double spacing)
+{
+  Array<Vector3> points;
+  unsigned int seed = 12345;
+  for (int x = 0; x < size; ++x) {
+    for (int y = 0; y < size; ++y) {
+      for (int z = 0; z < size; ++z) {
+        Vector3 jitter;
+        for (int c = 0; c < 3; ++c) {
+          seed = seed * 1103515245u + 12345u;
+          jitter[c] = ((seed >> 16) % 1000) / 1000.0 - 0.5;
+        }
+        points.push_back(Vector3(x, y, z) * spacing + jitter);
+      }
+    }
+  }
+  return points;
+}
+
+} // namespace
+
+TEST(NeighborPerceiverTest, pairs)
+{
+  Array<Vector3> points = jitteredGrid(7, 1.2);
+  const float cutoff = 2.0f;
+  NeighborPerceiver perceiver(points, cutoff);
+  EXPECT_FALSE(perceiver.isPeriodic());
+
+  std::set<std::pair<Index, Index>> expected;
+  for (Index i = 0; i < points.size(); ++i)
+    for (Index j = i + 1; j < points.size(); ++j)
+      if ((points[j] - points[i]).norm() < cutoff)
+        expected.insert(std::make_pair(i, j));
+
+  std::set<std::pair<Index, Index>> found;
+  size_t visits = 0;
+  perceiver.forEachPair([&](Index i, Index j, const Vector3& delta) {
+    ++visits;
+    EXPECT_LT((delta - (points[j] - points[i])).norm(), 1e-10);
+    found.insert(std::make_pair(std::min(i, j), std::max(i, j)));
+  });
+  EXPECT_EQ(visits, expected.size());
+  EXPECT_TRUE(found == expected);
+
+  // Cell ranges split the pairs between them
+  size_t split = 0;
+  auto count = [&split](Index, Index, const Vector3&) { ++split; };
+  perceiver.forEachPair(count, 0, perceiver.cellCount() / 2);
+  perceiver.forEachPair(count, perceiver.cellCount() / 2,
+                        perceiver.cellCount());
+  EXPECT_EQ(split, expected.size());
+}
+
+TEST(NeighborPerceiverTest, periodic)
+{
+  // A triclinic cell, with the points spilling out of it
+  UnitCell cell(Vector3(8.4, 0.0, 0.0), Vector3(1.5, 8.4, 0.0),
+                Vector3(-1.0, 2.0, 8.4));
+  Array<Vector3> points = jitteredGrid(7, 1.2);
+  const float cutoff = 2.5f;
+  NeighborPerceiver perceiver(points, cutoff, &cell);
+  EXPECT_TRUE(perceiver.isPeriodic());
+
+  std::set<std::pair<Index, Index>> expected;
+  for (Index i = 0; i < points.size(); ++i)
+    for (Index j = i + 1; j < points.size(); ++j)
+      if (cell.distance(points[i], points[j]) < cutoff)
+        expected.insert(std::make_pair(i, j));
+
+  std::set<std::pair<Index, Index>> found;
+  size_t visits = 0;
+  perceiver.forEachPair([&](Index i, Index j, const Vector3& delta) {
+    ++visits;
+    Vector3 image = cell.minimumImage(points[j] - points[i]);
+    EXPECT_LT((delta - image).norm(), 1e-8);
+    found.insert(std::make_pair(std::min(i, j), std::max(i, j)));
+  });
+  EXPECT_EQ(visits, expected.size());
+  EXPECT_TRUE(found == expected);
+
+  // Queries wrap around the cell
+  Array<Index> neighbors =
+    perceiver.getNeighborsInclusive(Vector3(8.4, 0.0, 0.0));
+  EXPECT_NE(std::find(neighbors.begin(), neighbors.end(), Index(0)),
+            neighbors.end());
+
+  // A cell thinner than the cutoff pairs a point with several of the images
+  // of its neighbor, but never with its own images
+  UnitCell thin(Vector3(1.5, 0.0, 0.0), Vector3(0.0, 10.0, 0.0),
+                Vector3(0.0, 0.0, 10.0));
+  Array<Vector3> pair;
+  pair.push_back(Vector3(0.0, 5.0, 5.0));
+  pair.push_back(Vector3(0.5, 5.0, 5.0));
+  NeighborPerceiver thinPerceiver(pair, 2.2f, &thin);
+  std::vector<double> distances;
+  thinPerceiver.forEachPair([&](Index i, Index j, const Vector3& delta) {
+    EXPECT_NE(i, j);
+    distances.push_back(std::fabs(delta.x()));
+  });
+  std::sort(distances.begin(), distances.end());
+  ASSERT_EQ(distances.size(), static_cast<size_t>(3));
+  EXPECT_NEAR(distances[0], 0.5, 1e-10);
+  EXPECT_NEAR(distances[1], 1.0, 1e-10);
+  EXPECT_NEAR(distances[2], 2.0, 1e-10);
+}
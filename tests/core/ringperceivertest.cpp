@@ -57,3 +57,97 @@ TEST(RingPerceiverTest, ethanol)
   std::vector<std::vector<size_t>> rings = perceiver.rings();
   EXPECT_EQ(rings.size(), static_cast<size_t>(0));
 }
+
+TEST(RingPerceiverTest, naphthalene)
+{
+  // two fused rings sharing the bond between atoms 0 and 5, with a methyl
+  // group hanging off atom 2
+  Molecule molecule;
+  for (int i = 0; i < 11; ++i)
+    molecule.addAtom(6);
+  const size_t bonds[][2] = { { 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 4 },
+                              { 4, 5 }, { 5, 0 }, { 5, 6 }, { 6, 7 },
+                              { 7, 8 }, { 8, 9 }, { 9, 0 }, { 2, 10 } };
+  for (const auto& bond : bonds)
+    molecule.addBond(bond[0], bond[1], 1);
+
+  RingPerceiver perceiver(&molecule);
+  std::vector<std::vector<size_t>> rings = perceiver.rings();
+  ASSERT_EQ(rings.size(), static_cast<size_t>(2));
+  EXPECT_EQ(rings[0].size(), static_cast<size_t>(6));
+  EXPECT_EQ(rings[1].size(), static_cast<size_t>(6));
+
+  // consecutive atoms of each ring are bonded
+  for (const auto& ring : rings) {
+    for (size_t i = 0; i < ring.size(); ++i) {
+      EXPECT_TRUE(molecule.graph().containsEdge(ring[i],
+                                                ring[(i + 1) % ring.size()]));
+    }
+  }
+}
+
+TEST(RingPerceiverTest, cubane)
+{
+  // the cube has 12 edges and 8 vertices, so five independent four membered
+  // rings, while the sixth face is the sum of the others
+  Molecule molecule;
+  for (int i = 0; i < 8; ++i)
+    molecule.addAtom(6);
+  for (size_t i = 0; i < 8; ++i) {
+    for (size_t bit = 1; bit < 8; bit <<= 1) {
+      if (!(i & bit))
+        molecule.addBond(i, i | bit, 1);
+    }
+  }
+
+  RingPerceiver perceiver(&molecule);
+  std::vector<std::vector<size_t>> rings = perceiver.rings();
+  ASSERT_EQ(rings.size(), static_cast<size_t>(5));
+  for (const auto& ring : rings)
+    EXPECT_EQ(ring.size(), static_cast<size_t>(4));
+}
+
+TEST(RingPerceiverTest, bondsChanged)
+{
+  // cyclohexane, then bridged into bicyclo[2.2.0]hexane
+  Molecule molecule;
+  for (int i = 0; i < 6; ++i)
+    molecule.addAtom(6);
+  for (size_t i = 0; i < 6; ++i)
+    molecule.addBond(i, (i + 1) % 6, 1);
+
+  RingPerceiver perceiver(&molecule);
+  EXPECT_EQ(perceiver.rings().size(), static_cast<size_t>(1));
+
+  molecule.addBond(0, 3, 1);
+  std::vector<std::vector<size_t>> rings = perceiver.rings();
+  ASSERT_EQ(rings.size(), static_cast<size_t>(2));
+  EXPECT_EQ(rings[0].size(), static_cast<size_t>(4));
+  EXPECT_EQ(rings[1].size(), static_cast<size_t>(4));
+
+  molecule.removeBond(0, 3);
+  molecule.removeBond(1, 2);
+  EXPECT_EQ(perceiver.rings().size(), static_cast<size_t>(0));
+}
+
+TEST(RingPerceiverTest, ringChain)
+{
+  // a long chain of cyclopropane rings, connected by single bonds
+  const size_t count = 2000;
+  Molecule molecule;
+  for (size_t i = 0; i < 3 * count; ++i)
+    molecule.addAtom(6);
+  for (size_t i = 0; i < count; ++i) {
+    molecule.addBond(3 * i, 3 * i + 1, 1);
+    molecule.addBond(3 * i + 1, 3 * i + 2, 1);
+    molecule.addBond(3 * i + 2, 3 * i, 1);
+    if (i > 0)
+      molecule.addBond(3 * i - 1, 3 * i, 1);
+  }
+
+  RingPerceiver perceiver(&molecule);
+  std::vector<std::vector<size_t>> rings = perceiver.rings();
+  ASSERT_EQ(rings.size(), count);
+  for (const auto& ring : rings)
+    EXPECT_EQ(ring.size(), static_cast<size_t>(3));
+}
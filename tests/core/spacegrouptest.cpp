@@ -25,6 +25,7 @@
 
 using Avogadro::Matrix3;
 using Avogadro::Vector3;
+using Avogadro::Core::Array;
 using Avogadro::Core::AvoSpglib;
 using Avogadro::Core::Molecule;
 using Avogadro::Core::SpaceGroups;
@@ -505,3 +506,39 @@ TEST(SpaceGroupTest, reduceToAsymmetricUnit)
   ASSERT_EQ(mol2.atomCount(), 4);
   ASSERT_EQ(mol2.atomicNumbers().size(), 4);
 }
+
+TEST(SpaceGroupTest, fillUnitCellOperations)
+{
+  double cartTol = 1e-5;
+
+  // Rock salt, plus an atom in a general position. Hall number 523 is
+  // F m -3 m, with 192 operations.
+  unsigned short hallNumber = 523;
+  ASSERT_EQ(SpaceGroups::transformsCount(hallNumber), 192);
+
+  Molecule mol;
+  UnitCell* uc = new UnitCell(Vector3(5.64, 0.0, 0.0), Vector3(0.0, 5.64, 0.0),
+                              Vector3(0.0, 0.0, 5.64));
+  mol.setUnitCell(uc);
+  mol.addAtom(11).setPosition3d(uc->toCartesian(Vector3(0.0, 0.0, 0.0)));
+  mol.addAtom(17).setPosition3d(uc->toCartesian(Vector3(0.5, 0.0, 0.0)));
+  mol.addAtom(6).setPosition3d(uc->toCartesian(Vector3(0.11, 0.23, 0.37)));
+
+  // The transforms of a point are the rotations and translations applied
+  Array<Vector3> transforms =
+    SpaceGroups::getTransforms(hallNumber, Vector3(0.11, 0.23, 0.37));
+  ASSERT_EQ(transforms.size(), 192);
+  EXPECT_TRUE(transforms[0].isApprox(Vector3(0.11, 0.23, 0.37)));
+
+  // Images on the faces and corners of the cell are the same atom
+  SpaceGroups::fillUnitCell(mol, hallNumber, cartTol);
+  EXPECT_EQ(mol.atomCount(), 4 + 4 + 192);
+  EXPECT_EQ(mol.atomCount(11), 4);
+  EXPECT_EQ(mol.atomCount(17), 4);
+
+  SpaceGroups::reduceToAsymmetricUnit(mol, hallNumber, cartTol);
+  ASSERT_EQ(mol.atomCount(), 3);
+  EXPECT_EQ(mol.atomCount(11), 1);
+  EXPECT_EQ(mol.atomCount(17), 1);
+  EXPECT_EQ(mol.atomCount(6), 1);
+}
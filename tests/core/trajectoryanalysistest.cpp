@@ -0,0 +1,142 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/trajectoryanalysis.h>
+
+#include <cmath>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Matrix3;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::TrajectoryAnalysis;
+
+namespace {
+
+// An irregular tetrahedron of carbon atoms, with frames of it moved rigidly.
+Array<Vector3> tetrahedron()
+{
+  Array<Vector3> positions;
+  positions.push_back(Vector3(0.0, 0.0, 0.0));
+  positions.push_back(Vector3(1.5, 0.0, 0.0));
+  positions.push_back(Vector3(0.2, 1.4, 0.0));
+  positions.push_back(Vector3(0.3, 0.4, 1.6));
+  return positions;
+}
+
+Array<Vector3> moved(const Array<Vector3>& positions, double angle,
+                     const Vector3& shift)
+{
+  const Matrix3 rotation(
+    Eigen::AngleAxisd(angle, Vector3(1.0, 2.0, 3.0).normalized()));
+  Array<Vector3> result;
+  for (const Vector3& position : positions)
+    result.push_back(rotation * position + shift);
+  return result;
+}
+
+} // namespace
+
+TEST(TrajectoryAnalysisTest, superpose)
+{
+  const Array<Vector3> reference = tetrahedron();
+  const Array<Vector3> positions =
+    moved(reference, 1.1, Vector3(3.0, -2.0, 0.5));
+
+  Matrix3 rotation;
+  Vector3 translation;
+  EXPECT_NEAR(TrajectoryAnalysis::superpose(reference, positions, rotation,
+                                            translation),
+              0.0, 1e-10);
+  EXPECT_NEAR(rotation.determinant(), 1.0, 1e-10);
+  for (Index i = 0; i < reference.size(); ++i) {
+    EXPECT_NEAR(
+      (rotation * positions[i] + translation - reference[i]).norm(), 0.0,
+      1e-10);
+  }
+
+  // a mirror image cannot be superposed by a rotation
+  Array<Vector3> mirrored;
+  for (const Vector3& position : reference)
+    mirrored.push_back(Vector3(-position.x(), position.y(), position.z()));
+  EXPECT_GT(TrajectoryAnalysis::superpose(reference, mirrored, rotation,
+                                          translation),
+            0.01);
+  EXPECT_NEAR(rotation.determinant(), 1.0, 1e-10);
+}
+
+TEST(TrajectoryAnalysisTest, rigidFrames)
+{
+  Molecule molecule;
+  const Array<Vector3> reference = tetrahedron();
+  for (const Vector3& position : reference)
+    molecule.addAtom(6).setPosition3d(position);
+  for (int i = 0; i < 50; ++i) {
+    molecule.setCoordinate3d(
+      moved(reference, 0.1 * i, Vector3(0.2 * i, 0.0, -0.1 * i)), i);
+  }
+
+  TrajectoryAnalysis analysis(&molecule);
+  ASSERT_TRUE(analysis.compute());
+  ASSERT_EQ(analysis.frameCount(), 50);
+  const double rg = TrajectoryAnalysis::radiusOfGyration(reference);
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_NEAR(analysis.rmsd()[i], 0.0, 1e-8);
+    EXPECT_NEAR(analysis.radiusOfGyration()[i], rg, 1e-8);
+  }
+  ASSERT_EQ(analysis.rmsf().size(), reference.size());
+  for (double rmsf : analysis.rmsf())
+    EXPECT_NEAR(rmsf, 0.0, 1e-6);
+
+  // without superposition the moved frames deviate
+  analysis.setAligned(false);
+  ASSERT_TRUE(analysis.compute());
+  EXPECT_NEAR(analysis.rmsd()[0], 0.0, 1e-8);
+  EXPECT_GT(analysis.rmsd()[10], 0.1);
+
+  // the current positions are not touched
+  for (Index i = 0; i < reference.size(); ++i)
+    EXPECT_EQ(molecule.atomPosition3d(i), reference[i]);
+}
+
+TEST(TrajectoryAnalysisTest, fluctuations)
+{
+  // atom 3 moves back and forth along z, the others stay put
+  Molecule molecule;
+  const Array<Vector3> reference = tetrahedron();
+  for (const Vector3& position : reference)
+    molecule.addAtom(6).setPosition3d(position);
+  for (int i = 0; i < 20; ++i) {
+    Array<Vector3> positions = reference;
+    positions[3].z() += i % 2 ? 0.25 : -0.25;
+    molecule.setCoordinate3d(positions, i);
+  }
+  // a frame with the wrong number of atoms is skipped
+  molecule.setCoordinate3d(Array<Vector3>(2, Vector3::Zero()), 20);
+
+  TrajectoryAnalysis analysis(&molecule);
+  analysis.setAligned(false);
+  analysis.setAtoms(std::vector<Index>{ 3, 0 });
+  ASSERT_TRUE(analysis.compute());
+  ASSERT_EQ(analysis.frameCount(), 21);
+  // the reference frame has atom 3 at the other end
+  EXPECT_NEAR(analysis.rmsd()[1], 0.5 / std::sqrt(2.0), 1e-10);
+  EXPECT_TRUE(std::isnan(analysis.rmsd()[20]));
+  ASSERT_EQ(analysis.rmsf().size(), static_cast<size_t>(2));
+  EXPECT_NEAR(analysis.rmsf()[0], 0.25, 1e-10);
+  EXPECT_NEAR(analysis.rmsf()[1], 0.0, 1e-10);
+
+  // cancelling
+  analysis.setProgressFunction([](int done, int) { return done < 5; });
+  EXPECT_FALSE(analysis.compute());
+
+  analysis.setReferenceFrame(21);
+  EXPECT_FALSE(analysis.compute());
+}
@@ -0,0 +1,120 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/trajectoryprovider.h>
+
+#include <memory>
+#include <vector>
+
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::TrajectoryProvider;
+
+namespace {
+
+// Generates frames with every atom at (frame, atom, 0), counting the reads.
+class CountingProvider : public TrajectoryProvider
+{
+public:
+  CountingProvider(int frames, size_t atoms, size_t cacheSize)
+    : TrajectoryProvider(cacheSize), m_frames(frames), m_atoms(atoms),
+      m_reads(frames, 0)
+  {
+  }
+
+  int frameCount() const override { return m_frames; }
+  int reads(int index) const { return m_reads[index]; }
+
+protected:
+  bool readFrame(int index, Array<Vector3>& positions) override
+  {
+    ++m_reads[index];
+    positions.resize(m_atoms);
+    for (size_t i = 0; i < m_atoms; ++i)
+      positions[i] = Vector3(index, static_cast<double>(i), 0.0);
+    return true;
+  }
+
+private:
+  int m_frames;
+  size_t m_atoms;
+  std::vector<int> m_reads;
+};
+
+} // namespace
+
+TEST(TrajectoryProviderTest, cache)
+{
+  CountingProvider provider(10, 3, 2);
+  Array<Vector3> positions;
+
+  EXPECT_FALSE(provider.frame(-1, positions));
+  EXPECT_FALSE(provider.frame(10, positions));
+
+  ASSERT_TRUE(provider.frame(4, positions));
+  EXPECT_EQ(positions.size(), 3);
+  EXPECT_EQ(positions[2], Vector3(4.0, 2.0, 0.0));
+  ASSERT_TRUE(provider.frame(4, positions));
+  EXPECT_EQ(provider.reads(4), 1);
+
+  // The least recently used frame is dropped
+  provider.frame(5, positions);
+  provider.frame(4, positions);
+  provider.frame(6, positions);
+  provider.frame(4, positions);
+  provider.frame(5, positions);
+  EXPECT_EQ(provider.reads(4), 1);
+  EXPECT_EQ(provider.reads(5), 2);
+  EXPECT_EQ(provider.reads(6), 1);
+
+  provider.setCacheSize(0);
+  provider.frame(5, positions);
+  provider.frame(5, positions);
+  EXPECT_EQ(provider.reads(5), 4);
+}
+
+TEST(TrajectoryProviderTest, molecule)
+{
+  Molecule molecule;
+  for (int i = 0; i < 3; ++i)
+    molecule.addAtom(6);
+
+  auto provider = std::make_shared<CountingProvider>(5, 3, 4);
+  molecule.setTrajectoryProvider(provider);
+  EXPECT_EQ(molecule.coordinate3dCount(), 5);
+
+  ASSERT_TRUE(molecule.setCoordinate3d(3));
+  EXPECT_EQ(molecule.atomPositions3d()[1], Vector3(3.0, 1.0, 0.0));
+  EXPECT_EQ(molecule.coordinate3d(2)[2], Vector3(2.0, 2.0, 0.0));
+  EXPECT_FALSE(molecule.setCoordinate3d(5));
+
+  // Frames set explicitly take precedence, and can extend the trajectory
+  Array<Vector3> positions(3, Vector3(-1.0, -1.0, -1.0));
+  molecule.setCoordinate3d(positions, 1);
+  molecule.setCoordinate3d(positions, 6);
+  EXPECT_EQ(molecule.coordinate3dCount(), 7);
+  ASSERT_TRUE(molecule.setCoordinate3d(1));
+  EXPECT_EQ(molecule.atomPositions3d()[0], Vector3(-1.0, -1.0, -1.0));
+  ASSERT_TRUE(molecule.setCoordinate3d(4));
+  EXPECT_EQ(molecule.atomPositions3d()[0], Vector3(4.0, 0.0, 0.0));
+  EXPECT_TRUE(molecule.setCoordinate3d(6));
+  EXPECT_EQ(provider->reads(1), 0);
+
+  // Copies share the provider and its cache
+  Molecule copy(molecule);
+  EXPECT_EQ(copy.trajectoryProvider(), provider);
+  ASSERT_TRUE(copy.setCoordinate3d(3));
+  EXPECT_EQ(copy.atomPositions3d()[2], Vector3(3.0, 2.0, 0.0));
+  EXPECT_EQ(provider->reads(3), 1);
+
+  molecule.setTrajectoryProvider(nullptr);
+  EXPECT_EQ(molecule.coordinate3dCount(), 7);
+  EXPECT_FALSE(molecule.setCoordinate3d(3));
+  EXPECT_TRUE(molecule.setCoordinate3d(6));
+}
@@ -21,8 +21,11 @@
 using std::string;
 using Avogadro::Core::contains;
 using Avogadro::Core::lexicalCast;
+using Avogadro::Core::nextToken;
+using Avogadro::Core::parseNumber;
 using Avogadro::Core::split;
 using Avogadro::Core::startsWith;
+using Avogadro::Core::StringView;
 using Avogadro::Core::trimmed;
 
 TEST(UtilitiesTest, split)
@@ -37,6 +40,34 @@ TEST(UtilitiesTest, splitEmpty)
   EXPECT_EQ(split(test, ' ', false).size(), 7);
 }
 
+TEST(UtilitiesTest, splitView)
+{
+  string test(" trim white space    ");
+  std::vector<StringView> tokens;
+  split(test, ' ', tokens);
+  ASSERT_EQ(tokens.size(), 3);
+  EXPECT_EQ(string(tokens[0]), "trim");
+  EXPECT_EQ(string(tokens[2]), "space");
+
+  // The same items as the copying split, and the vector is reused
+  split(test, ' ', tokens, false);
+  std::vector<string> copies(split(test, ' ', false));
+  ASSERT_EQ(tokens.size(), copies.size());
+  for (size_t i = 0; i < tokens.size(); ++i)
+    EXPECT_EQ(string(tokens[i]), copies[i]);
+}
+
+TEST(UtilitiesTest, nextToken)
+{
+  string test(" 1.5\t-2  3e2\r\n");
+  StringView line(test);
+  EXPECT_EQ(string(nextToken(line)), "1.5");
+  EXPECT_EQ(string(nextToken(line)), "-2");
+  EXPECT_EQ(string(nextToken(line)), "3e2");
+  EXPECT_TRUE(nextToken(line).empty());
+  EXPECT_TRUE(nextToken(line).empty());
+}
+
 TEST(UtilitiesTest, trimmed)
 {
   string test(" trim white space \n\t\r");
@@ -67,6 +98,45 @@ TEST(UtilitiesTest, lexicalCastCheck)
   EXPECT_EQ(ok, false);
 }
 
+TEST(UtilitiesTest, parseNumber)
+{
+  double d(0.0);
+  EXPECT_TRUE(parseNumber("  -1.25E+02", d));
+  EXPECT_EQ(d, -125.0);
+  EXPECT_TRUE(parseNumber("+.5", d));
+  EXPECT_EQ(d, 0.5);
+  // Fixed width fields run into each other, the rest is ignored
+  EXPECT_TRUE(parseNumber(StringView("  12.345-67.890").substr(0, 8), d));
+  EXPECT_EQ(d, 12.345);
+  EXPECT_FALSE(parseNumber("    ", d));
+  EXPECT_FALSE(parseNumber("+-1", d));
+  EXPECT_FALSE(parseNumber("x1", d));
+
+  int i(0);
+  EXPECT_TRUE(parseNumber(" 42 ", i));
+  EXPECT_EQ(i, 42);
+  EXPECT_TRUE(parseNumber("7.9", i));
+  EXPECT_EQ(i, 7);
+  EXPECT_FALSE(parseNumber("", i));
+
+  size_t u(0);
+  EXPECT_TRUE(parseNumber("1000000", u));
+  EXPECT_EQ(u, 1000000);
+  EXPECT_FALSE(parseNumber("  -3", u));
+  EXPECT_FALSE(parseNumber("99999999999999999999999", u));
+}
+
+TEST(UtilitiesTest, lexicalCastNonNumeric)
+{
+  bool ok(false);
+  EXPECT_EQ(lexicalCast<string>(" ALA ", ok), "ALA");
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(lexicalCast<char>("A", ok), 'A');
+  EXPECT_TRUE(ok);
+  lexicalCast<string>("   ", ok);
+  EXPECT_FALSE(ok);
+}
+
 TEST(UtilitiesTest, contains)
 {
   EXPECT_TRUE(contains("hasFoo", "has"));
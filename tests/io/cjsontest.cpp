@@ -18,6 +18,7 @@
 
 #include <gtest/gtest.h>
 
+#include <avogadro/core/cube.h>
 #include <avogadro/core/matrix.h>
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/unitcell.h>
@@ -28,11 +29,15 @@ using Avogadro::PI_F;
 using Avogadro::Real;
 using Avogadro::Core::Atom;
 using Avogadro::Core::Bond;
+using Avogadro::Core::Cube;
 using Avogadro::Core::Molecule;
 using Avogadro::Core::UnitCell;
 using Avogadro::Core::Variant;
+using Avogadro::Io::BinaryCjsonFormat;
 using Avogadro::Io::CjsonFormat;
 using Avogadro::MatrixX;
+using Avogadro::Vector3;
+using Avogadro::Vector3i;
 
 TEST(CjsonTest, readFile)
 {
@@ -177,3 +182,44 @@ TEST(CjsonTest, saveFile)
   EXPECT_EQ(bond.atom2().index(), static_cast<size_t>(1));
   EXPECT_EQ(bond.order(), static_cast<unsigned char>(1));
 }
+
+TEST(CjsonTest, binary)
+{
+  CjsonFormat cjson;
+  BinaryCjsonFormat binary;
+  Molecule savedMolecule, molecule;
+  bool success = cjson.readFile(
+    std::string(AVOGADRO_DATA) + "/data/ethane.cjson", savedMolecule);
+  EXPECT_TRUE(success);
+
+  Cube* cube = savedMolecule.addCube();
+  cube->setLimits(Vector3(-1.0, -2.0, -3.0), Vector3i(2, 3, 4),
+                  Vector3(0.5, 0.25, 0.125));
+  for (size_t i = 0; i < cube->data()->size(); ++i)
+    (*cube->data())[i] = 0.1 * static_cast<double>(i);
+
+  std::string data;
+  success = binary.writeString(data, savedMolecule);
+  EXPECT_TRUE(success);
+  EXPECT_EQ(binary.error(), "");
+
+  // Plain CJSON reads the binary encoding as well.
+  success = cjson.readString(data, molecule);
+  EXPECT_TRUE(success);
+  EXPECT_EQ(cjson.error(), "");
+  EXPECT_EQ(molecule.data("name").toString(), "Ethane");
+  EXPECT_EQ(molecule.atomCount(), static_cast<size_t>(8));
+  EXPECT_EQ(molecule.bondCount(), static_cast<size_t>(7));
+  Atom atom = molecule.atom(7);
+  EXPECT_EQ(atom.atomicNumber(), static_cast<unsigned char>(1));
+  EXPECT_EQ(atom.position3d().x(), -1.184988);
+  EXPECT_EQ(atom.position3d().y(), 0.004424);
+  EXPECT_EQ(atom.position3d().z(), -0.987522);
+
+  ASSERT_EQ(molecule.cubeCount(), static_cast<size_t>(1));
+  const Cube* otherCube = molecule.cube(0);
+  EXPECT_EQ(otherCube->dimensions(), Vector3i(2, 3, 4));
+  EXPECT_EQ(otherCube->min(), Vector3(-1.0, -2.0, -3.0));
+  EXPECT_EQ(otherCube->spacing(), Vector3(0.5, 0.25, 0.125));
+  EXPECT_EQ(*otherCube->data(), *cube->data());
+}
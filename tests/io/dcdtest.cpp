@@ -0,0 +1,128 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "iotests.h"
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/vector.h>
+
+#include <avogadro/io/dcdformat.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Vector3;
+using Avogadro::Core::Molecule;
+using Avogadro::Io::DcdFormat;
+
+namespace {
+
+// Append a 32 bit value in the given byte order.
+template <typename T>
+void append(std::string& data, T value, bool bigEndian)
+{
+  char bytes[4];
+  std::memcpy(bytes, &value, 4);
+  const uint32_t one = 1;
+  bool hostBig = *reinterpret_cast<const char*>(&one) == 0;
+  if (bigEndian != hostBig)
+    std::reverse(bytes, bytes + 4);
+  data.append(bytes, 4);
+}
+
+// An X-PLOR style trajectory, atom i of frame f is at (f, i, -0.5 * i).
+std::string trajectory(int atoms, int frames, bool bigEndian)
+{
+  std::string data;
+  append<int32_t>(data, 84, bigEndian);
+  data += "CORD";
+  for (int i = 0; i < 20; ++i)
+    append<int32_t>(data, i == 0 ? frames : 0, bigEndian);
+  append<int32_t>(data, 84, bigEndian);
+
+  append<int32_t>(data, 84, bigEndian);
+  append<int32_t>(data, 1, bigEndian);
+  data += std::string(80, ' ');
+  append<int32_t>(data, 84, bigEndian);
+
+  append<int32_t>(data, 4, bigEndian);
+  append<int32_t>(data, atoms, bigEndian);
+  append<int32_t>(data, 4, bigEndian);
+
+  for (int f = 0; f < frames; ++f) {
+    for (int axis = 0; axis < 3; ++axis) {
+      append<int32_t>(data, 4 * atoms, bigEndian);
+      for (int i = 0; i < atoms; ++i) {
+        float value = axis == 0 ? f : (axis == 1 ? i : -0.5f * i);
+        append<float>(data, value, bigEndian);
+      }
+      append<int32_t>(data, 4 * atoms, bigEndian);
+    }
+  }
+  return data;
+}
+
+} // namespace
+
+TEST(DcdTest, readMapped)
+{
+  for (bool bigEndian : { false, true }) {
+    std::string fileName("DcdTest_readMapped.dcd");
+    std::string data = trajectory(6, 12, bigEndian);
+    std::ofstream(fileName.c_str(), std::ios::binary) << data;
+
+    // Strings are parsed from a stream, files are mapped
+    DcdFormat stream;
+    Molecule parsed;
+    ASSERT_TRUE(stream.readString(data, parsed));
+
+    DcdFormat eager;
+    eager.setOptions("{\"lazyFrames\": false}");
+    Molecule loaded;
+    ASSERT_TRUE(eager.readFile(fileName, loaded));
+    EXPECT_FALSE(loaded.trajectoryProvider());
+
+    DcdFormat lazy;
+    lazy.setOptions("{\"lazyFrames\": true}");
+    Molecule molecule;
+    ASSERT_TRUE(lazy.readFile(fileName, molecule));
+    EXPECT_TRUE(molecule.trajectoryProvider());
+
+    ASSERT_EQ(molecule.atomCount(), 6);
+    ASSERT_EQ(parsed.coordinate3dCount(), 12);
+    ASSERT_EQ(loaded.coordinate3dCount(), 12);
+    ASSERT_EQ(molecule.coordinate3dCount(), 12);
+
+    for (int frame : { 11, 0, 5 }) {
+      ASSERT_TRUE(parsed.setCoordinate3d(frame));
+      ASSERT_TRUE(loaded.setCoordinate3d(frame));
+      ASSERT_TRUE(molecule.setCoordinate3d(frame));
+      for (Index i = 0; i < 6; ++i) {
+        Vector3 expected(frame, i, -0.5 * i);
+        EXPECT_EQ(parsed.atomPositions3d()[i], expected);
+        EXPECT_EQ(loaded.atomPositions3d()[i], expected);
+        EXPECT_EQ(molecule.atomPositions3d()[i], expected);
+      }
+    }
+
+    // A truncated last frame is dropped
+    data.resize(data.size() - 10);
+    std::ofstream(fileName.c_str(), std::ios::binary) << data;
+    Molecule truncated;
+    ASSERT_TRUE(eager.readFile(fileName, truncated));
+    EXPECT_EQ(truncated.coordinate3dCount(), 11);
+
+    remove(fileName.c_str());
+  }
+}
@@ -18,10 +18,13 @@
 
 #include <gtest/gtest.h>
 
+#include <avogadro/core/array.h>
 #include <avogadro/io/hdf5dataformat.h>
 
 #include <cstdio>
 
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
 using Avogadro::Io::Hdf5DataFormat;
 
 namespace {
@@ -275,3 +278,87 @@ TEST(Hdf5Test, datasetInteraction)
 
   remove(tmpFileName.c_str());
 }
+
+TEST(Hdf5Test, frames)
+{
+  std::string tmpFileName("Hdf5Test_frames.hdf");
+
+  Hdf5DataFormat hdf5;
+  ASSERT_TRUE(hdf5.openFile(tmpFileName, Hdf5DataFormat::ReadWriteTruncate))
+    << "Opening test file '" << tmpFileName << "' failed.";
+
+  // A trajectory of 4 atoms, appended frame by frame.
+  std::vector<size_t> trajectoryDims = { 4, 3 };
+  ASSERT_TRUE(hdf5.createFrameDataset("/Trajectory/Positions", trajectoryDims))
+    << "Creating the trajectory dataset failed.";
+  for (int frame = 0; frame < 3; ++frame) {
+    Array<Vector3> positions;
+    for (int atom = 0; atom < 4; ++atom)
+      positions.push_back(Vector3(frame, atom, frame * atom));
+    EXPECT_TRUE(hdf5.appendFrame("/Trajectory/Positions", positions))
+      << "Appending frame " << frame << " failed.";
+  }
+  EXPECT_FALSE(hdf5.appendFrame("/Trajectory/Positions",
+                                std::vector<double>(5, 0.0)))
+    << "Appending a frame of the wrong size succeeded.";
+
+  std::vector<int> dims = hdf5.datasetDimensions("/Trajectory/Positions");
+  ASSERT_EQ(dims.size(), static_cast<size_t>(3));
+  EXPECT_EQ(dims[0], 3) << "Wrong number of frames.";
+  EXPECT_EQ(dims[1], 4);
+  EXPECT_EQ(dims[2], 3);
+
+  Array<Vector3> positions;
+  ASSERT_TRUE(hdf5.readFrame("/Trajectory/Positions", 2, positions))
+    << "Reading a frame failed.";
+  ASSERT_EQ(positions.size(), static_cast<size_t>(4));
+  for (int atom = 0; atom < 4; ++atom)
+    EXPECT_EQ(positions[atom], Vector3(2, atom, 2 * atom));
+  EXPECT_FALSE(hdf5.readFrame("/Trajectory/Positions", 3, positions))
+    << "Reading a frame past the end succeeded.";
+
+  // A series of 4 x 5 x 6 cubes, chunked into slices of 2 x 5 x 6.
+  std::vector<size_t> cubeDims = { 4, 5, 6 };
+  std::vector<size_t> chunkDims = { 2, 5, 6 };
+  ASSERT_TRUE(hdf5.createFrameDataset("/Cubes", cubeDims, 6, chunkDims))
+    << "Creating the cube dataset failed.";
+  for (int frame = 0; frame < 2; ++frame) {
+    std::vector<double> cube(120);
+    for (size_t i = 0; i < cube.size(); ++i)
+      cube[i] = 1000.0 * frame + i;
+    EXPECT_TRUE(hdf5.appendFrame("/Cubes", cube))
+      << "Appending cube " << frame << " failed.";
+  }
+
+  std::vector<double> cube;
+  dims = hdf5.readFrame("/Cubes", 1, cube);
+  ASSERT_EQ(dims.size(), static_cast<size_t>(3));
+  EXPECT_EQ(dims[0], 4);
+  EXPECT_EQ(dims[1], 5);
+  EXPECT_EQ(dims[2], 6);
+  ASSERT_EQ(cube.size(), static_cast<size_t>(120));
+  for (size_t i = 0; i < cube.size(); ++i)
+    EXPECT_EQ(cube[i], 1000.0 + i) << "Cube mismatch at index " << i << ".";
+
+  // The slab x = 1 ... 2, y = 3, z = 0 ... 5 of the second cube.
+  std::vector<size_t> offset = { 1, 1, 3, 0 };
+  std::vector<size_t> count = { 1, 2, 1, 6 };
+  std::vector<double> slab;
+  dims = hdf5.readHyperslab("/Cubes", offset, count, slab);
+  ASSERT_EQ(dims.size(), static_cast<size_t>(4));
+  ASSERT_EQ(slab.size(), static_cast<size_t>(12));
+  for (size_t x = 0; x < 2; ++x) {
+    for (size_t z = 0; z < 6; ++z) {
+      EXPECT_EQ(slab[x * 6 + z], 1000.0 + (x + 1) * 30 + 3 * 6 + z)
+        << "Hyperslab mismatch at " << x << ", " << z << ".";
+    }
+  }
+  count[1] = 4;
+  EXPECT_TRUE(hdf5.readHyperslab("/Cubes", offset, count, slab).empty())
+    << "Reading a hyperslab outside the dataset succeeded.";
+
+  ASSERT_TRUE(hdf5.closeFile())
+    << "Closing test file '" << tmpFileName << "' failed.";
+
+  remove(tmpFileName.c_str());
+}
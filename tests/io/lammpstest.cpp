@@ -99,6 +99,33 @@ TEST(LammpsTest, read)
   EXPECT_EQ(molecule.atom(4).position3d().z(), -0.0770097);
 }
 
+TEST(LammpsTest, readOnDemand)
+{
+  LammpsTrajectoryFormat eager;
+  eager.setOptions("{\"lazyFrames\": false}");
+  Molecule loaded;
+  ASSERT_TRUE(eager.readFile(AVOGADRO_DATA "/data/silicon_bulk.dump", loaded));
+
+  LammpsTrajectoryFormat lazy;
+  lazy.setOptions("{\"lazyFrames\": true}");
+  Molecule molecule;
+  ASSERT_TRUE(lazy.readFile(AVOGADRO_DATA "/data/silicon_bulk.dump", molecule));
+  ASSERT_TRUE(molecule.trajectoryProvider());
+  EXPECT_EQ(molecule.atomCount(), 1000);
+  ASSERT_EQ(molecule.coordinate3dCount(), 11);
+
+  bool status = true;
+  EXPECT_EQ(molecule.timeStep(10, status), 100);
+  EXPECT_EQ(molecule.unitCell()->aVector(), loaded.unitCell()->aVector());
+
+  for (int frame : { 10, 1, 0, 5 }) {
+    ASSERT_TRUE(molecule.setCoordinate3d(frame));
+    ASSERT_TRUE(loaded.setCoordinate3d(frame));
+    EXPECT_EQ(molecule.atomPositions3d()[1], loaded.atomPositions3d()[1]);
+    EXPECT_EQ(molecule.atomPositions3d()[999], loaded.atomPositions3d()[999]);
+  }
+}
+
 TEST(LammpsTest, modes)
 {
   // This tests some of the mode setting/checking code
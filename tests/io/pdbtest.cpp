@@ -0,0 +1,43 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include "iotests.h"
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/residue.h>
+
+#include <avogadro/io/pdbformat.h>
+
+#include <string>
+
+using Avogadro::Index;
+using Avogadro::Core::Molecule;
+using Avogadro::Io::PdbFormat;
+
+TEST(PdbTest, negativeResidueNumber)
+{
+  // Residue sequence numbers may be negative, e.g. for tags before a protein.
+  std::string pdb =
+    "ATOM      1  N   ALA A  -1      11.104   6.134  -6.504  1.00  0.00"
+    "           N\n"
+    "ATOM      2  CA  ALA A  -1      11.639   6.071  -5.147  1.00  0.00"
+    "           C\n"
+    "ATOM      3  N   GLY A   1      12.000   7.000  -4.000  1.00  0.00"
+    "           N\n"
+    "END\n";
+
+  PdbFormat format;
+  Molecule molecule;
+  EXPECT_TRUE(format.readString(pdb, molecule));
+  EXPECT_EQ(format.error(), "");
+  EXPECT_EQ(molecule.atomCount(), static_cast<size_t>(3));
+  ASSERT_EQ(molecule.residues().size(), static_cast<size_t>(2));
+  EXPECT_EQ(molecule.residues()[0].residueName(), "ALA");
+  EXPECT_EQ(molecule.residues()[0].residueId(), static_cast<Index>(-1));
+  EXPECT_EQ(molecule.residues()[1].residueName(), "GLY");
+  EXPECT_EQ(molecule.residues()[1].residueId(), static_cast<Index>(1));
+}
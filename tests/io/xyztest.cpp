@@ -28,6 +28,7 @@
 #include <sstream>
 #include <string>
 
+using Avogadro::Core::Array;
 using Avogadro::Core::Atom;
 using Avogadro::Core::Molecule;
 using Avogadro::Io::FileFormat;
@@ -134,6 +135,47 @@ TEST(XyzTest, write)
   EXPECT_TRUE(checkedSomething);
 }
 
+TEST(XyzTest, readTrajectoryOnDemand)
+{
+  std::string fileName("XyzTest_readTrajectoryOnDemand.xyz");
+  {
+    std::ofstream out(fileName.c_str());
+    for (int frame = 0; frame < 20; ++frame) {
+      out << "3\nframe " << frame << "\n";
+      for (int i = 0; i < 3; ++i)
+        out << "C " << frame << " " << i << " " << 0.5 * frame * i << "\n";
+    }
+  }
+
+  XyzFormat eager;
+  eager.setOptions("{\"lazyFrames\": false, \"perceiveBonds\": false}");
+  Molecule loaded;
+  ASSERT_TRUE(eager.readFile(fileName, loaded));
+  EXPECT_FALSE(loaded.trajectoryProvider());
+
+  XyzFormat lazy;
+  lazy.setOptions("{\"lazyFrames\": true, \"perceiveBonds\": false}");
+  Molecule molecule;
+  ASSERT_TRUE(lazy.readFile(fileName, molecule));
+  ASSERT_TRUE(molecule.trajectoryProvider());
+  EXPECT_EQ(molecule.atomCount(), 3);
+  ASSERT_EQ(molecule.coordinate3dCount(), 20);
+  ASSERT_EQ(loaded.coordinate3dCount(), 20);
+
+  // Frames can be visited in any order
+  for (int frame : { 7, 19, 0, 12, 13, 7 }) {
+    ASSERT_TRUE(molecule.setCoordinate3d(frame));
+    ASSERT_TRUE(loaded.setCoordinate3d(frame));
+    for (Avogadro::Index i = 0; i < 3; ++i) {
+      EXPECT_EQ(molecule.atomPositions3d()[i], loaded.atomPositions3d()[i]);
+    }
+  }
+  EXPECT_EQ(molecule.atomPositions3d()[2], Vector3(7.0, 2.0, 7.0));
+  EXPECT_FALSE(molecule.setCoordinate3d(20));
+
+  remove(fileName.c_str());
+}
+
 TEST(XyzTest, modes)
 {
   // This tests some of the mode setting/checking code, not explicitly Xyz but
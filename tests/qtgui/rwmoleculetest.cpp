@@ -587,6 +587,29 @@ TEST(RWMoleculeTest, clearBonds)
   EXPECT_TRUE(std::equal(ords.begin(), ords.end(), mol.bondOrders().begin()));
 }
 
+TEST(RWMoleculeTest, clearPerceivedBonds)
+{
+  // Perceived bonds must get unique ids, or they cannot be removed.
+  Molecule m;
+  m.addAtom(6).setPosition3d(Vector3(0, 0, 0));
+  m.addAtom(1).setPosition3d(Vector3(1.09, 0, 0));
+  m.addAtom(1).setPosition3d(Vector3(0, 1.09, 0));
+  m.addAtom(1).setPosition3d(Vector3(0, 0, 1.09));
+  m.perceiveBondsSimple();
+  ASSERT_EQ(3, m.bondCount());
+
+  RWMolecule mol(m);
+  EXPECT_TRUE(mol.removeBond(0));
+  EXPECT_EQ(2, mol.bondCount());
+
+  mol.clearBonds();
+  EXPECT_EQ(0, mol.bondCount());
+
+  mol.undoStack().undo();
+  mol.undoStack().undo();
+  EXPECT_EQ(3, mol.bondCount());
+}
+
 TEST(RWMoleculeTest, setBondOrders)
 {
   Molecule m;
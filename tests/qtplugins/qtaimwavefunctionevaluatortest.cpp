@@ -0,0 +1,154 @@
+/******************************************************************************
+  This source file is part of the Avogadro project.
+  This source code is released under the 3-Clause BSD License, (see "LICENSE").
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/qtgui/molecule.h>
+
+#include <qtaim/qtaimwavefunction.h>
+#include <qtaim/qtaimwavefunctionevaluator.h>
+
+#include <QVariantList>
+
+using Avogadro::QtGui::Molecule;
+using Avogadro::QtPlugins::QTAIMWavefunction;
+using Avogadro::QtPlugins::QTAIMWavefunctionEvaluator;
+
+namespace {
+
+// Two centers carrying s, p and d primitives, with two occupied orbitals, so
+// that every angular momentum branch of the evaluators is exercised.
+void setWavefunctionProperties(Molecule& mol)
+{
+  const qint64 nprim = 5;
+  const qint64 nmo = 2;
+  const double centers[2][3] = { { 0.0, 0.0, -0.7 }, { 0.1, 0.0, 0.7 } };
+  const int center[nprim] = { 0, 0, 1, 1, 1 };
+  const int amom[nprim][3] = {
+    { 0, 0, 0 }, { 0, 0, 1 }, { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }
+  };
+  const double alpha[nprim] = { 1.2, 0.8, 0.9, 0.6, 0.5 };
+  const double coef[nmo][nprim] = { { 0.6, 0.3, 0.5, 0.2, 0.1 },
+                                    { 0.4, -0.5, -0.3, 0.4, 0.3 } };
+
+  QVariantList nucX, nucY, nucZ, charges;
+  for (int i = 0; i < 2; ++i) {
+    nucX.append(centers[i][0]);
+    nucY.append(centers[i][1]);
+    nucZ.append(centers[i][2]);
+    charges.append(1);
+  }
+
+  QVariantList primX, primY, primZ, amomX, amomY, amomZ, exponents;
+  for (qint64 p = 0; p < nprim; ++p) {
+    primX.append(centers[center[p]][0]);
+    primY.append(centers[center[p]][1]);
+    primZ.append(centers[center[p]][2]);
+    amomX.append(amom[p][0]);
+    amomY.append(amom[p][1]);
+    amomZ.append(amom[p][2]);
+    exponents.append(alpha[p]);
+  }
+
+  QVariantList occupations, eigenvalues, coefficients;
+  for (qint64 m = 0; m < nmo; ++m) {
+    occupations.append(m == 0 ? 2.0 : 1.0);
+    eigenvalues.append(-0.5 + 0.1 * m);
+    for (qint64 p = 0; p < nprim; ++p)
+      coefficients.append(coef[m][p]);
+  }
+
+  mol.setProperty("QTAIMNumberOfMolecularOrbitals", nmo);
+  mol.setProperty("QTAIMNumberOfGaussianPrimitives", nprim);
+  mol.setProperty("QTAIMNumberOfNuclei", 2);
+  mol.setProperty("QTAIMXNuclearCoordinates", nucX);
+  mol.setProperty("QTAIMYNuclearCoordinates", nucY);
+  mol.setProperty("QTAIMZNuclearCoordinates", nucZ);
+  mol.setProperty("QTAIMNuclearCharges", charges);
+  mol.setProperty("QTAIMXGaussianPrimitiveCenterCoordinates", primX);
+  mol.setProperty("QTAIMYGaussianPrimitiveCenterCoordinates", primY);
+  mol.setProperty("QTAIMZGaussianPrimitiveCenterCoordinates", primZ);
+  mol.setProperty("QTAIMXGaussianPrimitiveAngularMomenta", amomX);
+  mol.setProperty("QTAIMYGaussianPrimitiveAngularMomenta", amomY);
+  mol.setProperty("QTAIMZGaussianPrimitiveAngularMomenta", amomZ);
+  mol.setProperty("QTAIMGaussianPrimitiveExponentCoefficients", exponents);
+  mol.setProperty("QTAIMMolecularOrbitalOccupationNumbers", occupations);
+  mol.setProperty("QTAIMMolecularOrbitalEigenvalues", eigenvalues);
+  mol.setProperty("QTAIMMolecularOrbitalCoefficients", coefficients);
+  mol.setProperty("QTAIMTotalEnergy", -1.0);
+  mol.setProperty("QTAIMVirialRatio", 2.0);
+}
+
+Matrix<qreal, Dynamic, 3> samplePoints()
+{
+  Matrix<qreal, Dynamic, 3> xyz(4, 3);
+  xyz << 0.3, -0.2, 0.1, -0.4, 0.5, -0.9, 0.8, 0.1, 0.6, 0.05, 0.3, 1.2;
+  return xyz;
+}
+} // namespace
+
+TEST(QTAIMWavefunctionEvaluatorTest, singlePointMatchesBatch)
+{
+  Molecule mol;
+  setWavefunctionProperties(mol);
+  Molecule* molPtr = &mol;
+  QTAIMWavefunction wfn;
+  ASSERT_TRUE(wfn.initializeWithMoleculeProperties(molPtr));
+  QTAIMWavefunctionEvaluator eval(wfn);
+
+  const Matrix<qreal, Dynamic, 3> xyz = samplePoints();
+  Matrix<qreal, Dynamic, 1> rho;
+  Matrix<qreal, Dynamic, 3> gradient;
+  Matrix<qreal, Dynamic, 6> hessian;
+  eval.electronDensityDerivatives(xyz, 2, rho, gradient, hessian);
+
+  const int pairs[3][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+  for (int i = 0; i < xyz.rows(); ++i) {
+    const Matrix<qreal, 3, 1> point = xyz.row(i).transpose();
+    EXPECT_NEAR(eval.electronDensity(point), rho(i), 1e-12);
+
+    const Matrix<qreal, 3, 1> g = eval.gradientOfElectronDensity(point);
+    const Matrix<qreal, 3, 3> h = eval.hessianOfElectronDensity(point);
+    const Matrix<qreal, 3, 4> gh =
+      eval.gradientAndHessianOfElectronDensity(point);
+    for (int c = 0; c < 3; ++c) {
+      EXPECT_NEAR(g(c), gradient(i, c), 1e-12);
+      EXPECT_NEAR(gh(c, 0), gradient(i, c), 1e-12);
+      EXPECT_NEAR(h(c, c), hessian(i, c), 1e-12);
+      EXPECT_NEAR(gh(c, 1 + c), hessian(i, c), 1e-12);
+      const int a = pairs[c][0];
+      const int b = pairs[c][1];
+      EXPECT_NEAR(h(a, b), hessian(i, 3 + c), 1e-12);
+      EXPECT_NEAR(gh(a, 1 + b), hessian(i, 3 + c), 1e-12);
+    }
+  }
+}
+
+TEST(QTAIMWavefunctionEvaluatorTest, gradientMatchesFiniteDifference)
+{
+  Molecule mol;
+  setWavefunctionProperties(mol);
+  Molecule* molPtr = &mol;
+  QTAIMWavefunction wfn;
+  ASSERT_TRUE(wfn.initializeWithMoleculeProperties(molPtr));
+  QTAIMWavefunctionEvaluator eval(wfn);
+
+  const qreal step = 1e-5;
+  const Matrix<qreal, Dynamic, 3> xyz = samplePoints();
+  for (int i = 0; i < xyz.rows(); ++i) {
+    const Matrix<qreal, 3, 1> point = xyz.row(i).transpose();
+    const Matrix<qreal, 3, 1> g = eval.gradientOfElectronDensity(point);
+    for (int c = 0; c < 3; ++c) {
+      Matrix<qreal, 3, 1> forward = point;
+      Matrix<qreal, 3, 1> backward = point;
+      forward(c) += step;
+      backward(c) -= step;
+      const qreal expected =
+        (eval.electronDensity(forward) - eval.electronDensity(backward)) /
+        (2 * step);
+      EXPECT_NEAR(g(c), expected, 1e-7);
+    }
+  }
+}
@@ -20,6 +20,7 @@
 
 #include <Eigen/Geometry>
 
+#include <cmath>
 #include <iostream>
 
 using Avogadro::Rendering::Camera;
@@ -123,3 +124,39 @@ TEST(CameraTest, unProjectPerspective)
     std::cout << "Error: No match\n" << position << std::endl;
   }
 }
+
+TEST(CameraTest, isInView)
+{
+  Camera camera;
+  camera.calculatePerspective(40, 1, 1, 100);
+  camera.preTranslate(Vector3f(0, 0, -10));
+  camera.setViewport(100, 100);
+
+  const Vector3f extent(1, 1, 1);
+  EXPECT_TRUE(camera.isInView(Eigen::AlignedBox3f(-extent, extent)));
+  // Off to the side, and behind the eye.
+  const Vector3f side(50, 0, 0);
+  EXPECT_FALSE(camera.isInView(Eigen::AlignedBox3f(side - extent,
+                                                   side + extent)));
+  const Vector3f behind(0, 0, 20);
+  EXPECT_FALSE(camera.isInView(Eigen::AlignedBox3f(behind - extent,
+                                                   behind + extent)));
+  // Partly in view.
+  EXPECT_TRUE(camera.isInView(Eigen::AlignedBox3f(-side, side)));
+}
+
+TEST(CameraTest, pixelScale)
+{
+  Camera camera;
+  camera.calculatePerspective(40, 1, 1, 100);
+  camera.preTranslate(Vector3f(0, 0, -10));
+  camera.setViewport(100, 100);
+
+  // Half the viewport height covers tan(20 degrees) * 10 at the origin.
+  EXPECT_NEAR(camera.pixelScale(Vector3f::Zero()),
+              50.0f / (std::tan(20.0f * float(M_PI) / 180.0f) * 10.0f),
+              1.0e-3f);
+  EXPECT_NEAR(camera.pixelScale(Vector3f(0, 0, -10)),
+              camera.pixelScale(Vector3f::Zero()) / 2.0f, 1.0e-3f);
+  EXPECT_TRUE(std::isinf(camera.pixelScale(Vector3f(0, 0, 20))));
+}
@@ -20,7 +20,11 @@
 #include <avogadro/rendering/geometrynode.h>
 #include <avogadro/rendering/spheregeometry.h>
 
+#include <limits>
+
+using Avogadro::Rendering::AtomType;
 using Avogadro::Rendering::GeometryNode;
+using Avogadro::Rendering::Identifier;
 using Avogadro::Rendering::SphereGeometry;
 using Avogadro::Vector3f;
 using Avogadro::Vector3ub;
@@ -73,3 +77,57 @@ TEST(SphereGeometryTest, clear)
   node.clear();
   EXPECT_EQ(node.size(), static_cast<size_t>(0));
 }
+
+TEST(SphereGeometryTest, hits)
+{
+  // A row of spheres along z, with one off to the side.
+  SphereGeometry node;
+  node.identifier().molecule = &node;
+  node.identifier().type = AtomType;
+  for (int i = 0; i < 20; ++i)
+    node.addSphere(Vector3f(0.0, 0.0, -2.0f * i), Vector3ub(0, 0, 0), 0.5);
+  node.addSphere(Vector3f(5.0, 0.0, 0.0), Vector3ub(0, 0, 0), 0.5, 42);
+
+  const Vector3f origin(0.0, 0.0, 10.0);
+  const Vector3f end(0.0, 0.0, -100.0);
+  const Vector3f direction(0.0, 0.0, -1.0);
+  std::multimap<float, Identifier> hits = node.hits(origin, end, direction);
+  ASSERT_EQ(hits.size(), static_cast<size_t>(20));
+  EXPECT_FLOAT_EQ(hits.begin()->first, 9.5f);
+  EXPECT_EQ(hits.begin()->second.index, static_cast<size_t>(0));
+
+  float depth = std::numeric_limits<float>::infinity();
+  Identifier closest = node.hit(origin, end, direction, depth);
+  EXPECT_EQ(closest.index, static_cast<size_t>(0));
+  EXPECT_FLOAT_EQ(depth, 9.5f);
+
+  // nothing closer than what was already hit
+  depth = 5.0f;
+  EXPECT_FALSE(node.hit(origin, end, direction, depth).isValid());
+
+  // moved spheres are found where they are now
+  node.setSpherePosition(20, Vector3f(0.0, 0.0, 5.0));
+  depth = std::numeric_limits<float>::infinity();
+  closest = node.hit(origin, end, direction, depth);
+  EXPECT_EQ(closest.index, static_cast<size_t>(42));
+  EXPECT_FLOAT_EQ(depth, 4.5f);
+}
+
+TEST(SphereGeometryTest, boundingBox)
+{
+  SphereGeometry node;
+  Eigen::AlignedBox3f box;
+  ASSERT_TRUE(node.boundingBox(box));
+  EXPECT_TRUE(box.isEmpty());
+
+  node.addSphere(Vector3f(1.0, 2.0, 3.0), Vector3ub(0, 0, 0), 0.5);
+  node.addSphere(Vector3f(-1.0, 0.0, 0.0), Vector3ub(0, 0, 0), 1.0);
+  ASSERT_TRUE(node.boundingBox(box));
+  EXPECT_TRUE(box.min().isApprox(Vector3f(-2.0, -1.0, -1.0)));
+  EXPECT_TRUE(box.max().isApprox(Vector3f(1.5, 2.5, 3.5)));
+
+  // the box follows moved spheres
+  node.setSpherePosition(0, Vector3f(0.0, 0.0, 0.0));
+  ASSERT_TRUE(node.boundingBox(box));
+  EXPECT_TRUE(box.max().isApprox(Vector3f(0.5, 1.0, 1.0)));
+}